@@ -32,6 +32,27 @@ CAFFE2_API int get_thread_num();
 // Checks whether the code runs in parallel region
 CAFFE2_API bool in_parallel_region();
 
+// Binds the intra-op worker threads (CPU and memory policy) to the given NUMA
+// node, so that memory they allocate, e.g. through the caching CPU allocator,
+// stays on that node. The calling thread is not bound; use c10::NUMABind for
+// it. With the native backend this has to be called before any parallel
+// work, like set_num_threads. A negative id leaves the threads unbound.
+CAFFE2_API void set_intraop_numa_node(int numa_node_id);
+
+// Returns the NUMA node the intra-op worker threads are bound to, or -1
+CAFFE2_API int get_intraop_numa_node();
+
+// Enables cooperative nested parallelism. By default parallel_for and
+// parallel_reduce run serially when called from inside a parallel region;
+// when enabled, the nested region is split into chunks that idle intra-op
+// threads may pick up, while the calling thread works through the remaining
+// chunks itself. No threads are added, so nested regions do not oversubscribe
+// the machine. Only supported by the native backend.
+CAFFE2_API void set_nested_parallelism(bool enabled);
+
+// Returns whether cooperative nested parallelism is enabled
+CAFFE2_API bool get_nested_parallelism();
+
 /*
 parallel_for
 
@@ -133,4 +154,6 @@ CAFFE2_API int intraop_default_num_threads();
 #include <ATen/ParallelNative.h>
 #elif AT_PARALLEL_NATIVE_TBB
 #include <ATen/ParallelNativeTBB.h>
+#elif AT_PARALLEL_NATIVE_WS
+#include <ATen/ParallelNativeWS.h>
 #endif
@@ -4,6 +4,7 @@
 #include <ATen/PTThreadPool.h>
 #include <ATen/Version.h>
 
+#include <atomic>
 #include <sstream>
 #include <thread>
 
@@ -40,8 +41,24 @@ size_t get_env_num_threads(const char* var_name, size_t def_value = 0) {
   return def_value;
 }
 
+std::atomic<bool> nested_parallelism{false};
+
 } // namespace
 
+void set_nested_parallelism(bool enabled) {
+#if AT_PARALLEL_NATIVE && !defined(C10_MOBILE)
+  nested_parallelism.store(enabled);
+#else
+  TORCH_CHECK(
+      !enabled,
+      "Nested parallelism is only supported by the native parallel backend");
+#endif
+}
+
+bool get_nested_parallelism() {
+  return nested_parallelism.load();
+}
+
 std::string get_parallel_info() {
   std::ostringstream ss;
 
@@ -78,12 +95,18 @@ std::string get_parallel_info() {
   ss << "native thread pool";
   #elif AT_PARALLEL_NATIVE_TBB
   ss << "native thread pool and TBB";
+  #elif AT_PARALLEL_NATIVE_WS
+  ss << "native thread pool and work-stealing thread pool";
   #endif
   #ifdef C10_MOBILE
   ss << " [mobile]";
   #endif
   ss << std::endl;
 
+  if (at::get_nested_parallelism()) {
+    ss << "Nested parallelism: enabled" << std::endl;
+  }
+
   #if AT_EXPERIMENTAL_SINGLE_THREAD_POOL
   ss << "Experimental: single thread pool" << std::endl;
   #endif
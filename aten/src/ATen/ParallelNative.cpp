@@ -10,6 +10,8 @@
 #endif // C10_MOBILE
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -36,10 +38,6 @@ void _set_thread_num(size_t thread_num) {
   thread_num_ = thread_num;
 }
 
-void _unset_thread_num() {
-  thread_num_ = 0;
-}
-
 #ifndef C10_MOBILE
 
 const int NOT_SET = -1;
@@ -55,6 +53,9 @@ const int CONSUMED = -2;
 //  - CONSUMED - pool is initialized
 std::atomic<int> num_intraop_threads{NOT_SET};
 
+// NUMA node the pool threads are bound to, -1 if unbound
+std::atomic<int> intraop_numa_node{-1};
+
 int _num_pool_threads(int nthreads) {
   if (nthreads == NOT_SET) {
     nthreads = intraop_default_num_threads();
@@ -65,51 +66,107 @@ int _num_pool_threads(int nthreads) {
   return nthreads - 1;
 }
 
+std::shared_ptr<TaskThreadPoolBase> _create_intraop_pool() {
+  int pool_size = _num_pool_threads(num_intraop_threads.exchange(CONSUMED));
+  int numa_node_id = intraop_numa_node.load();
+  if (numa_node_id >= 0) {
+    // the registry creator has no way to pass a NUMA node through
+    return std::make_shared<PTThreadPool>(pool_size, numa_node_id);
+  }
+  return ThreadPoolRegistry()->Create(
+      "C10",
+      /* device_id */ 0,
+      /* pool_size */ pool_size,
+      /* create_new */ true); // create a separate thread pool for intra-op
+}
+
 TaskThreadPoolBase& _get_intraop_pool() {
-  static std::shared_ptr<TaskThreadPoolBase> pool =
-      ThreadPoolRegistry()->Create(
-          "C10",
-          /* device_id */ 0,
-          /* pool_size */ _num_pool_threads(num_intraop_threads.exchange(CONSUMED)),
-          /* create_new */ true); // create a separate thread pool for intra-op
+  static std::shared_ptr<TaskThreadPoolBase> pool = _create_intraop_pool();
   return *pool;
 }
 
 #endif // C10_MOBILE
 
-// Run lambda function `fn` over `task_id` in [0, `range`) with threadpool.
-// `fn` will be called with params: (thread_pool_task_id, task_id).
-void _run_with_pool(const std::function<void(int, size_t)>& fn, size_t range) {
-#ifndef C10_MOBILE
-  for (size_t i = 1; i < range; ++i) {
-    _get_intraop_pool().run([fn, i]() { fn((int)i, i); });
-  }
-  // Run the first task on the current thread directly.
-  fn(0, 0);
-#else
-  caffe2::ThreadPool* pool = caffe2::mobile_threadpool();
-  if (pool) {
-    // caffe2::ThreadPool can utilize the current thread.
-    pool->run(fn, range);
-  } else {
-    for (size_t i = 0; i < range; ++i) {
-      fn(0, i);
-    }
-  }
-#endif // C10_MOBILE
-}
-
 // RAII guard helps to support in_parallel_region() and get_thread_num() API.
+// The previous values are restored on exit, as parallel regions may nest.
 struct ParallelRegionGuard {
-  ParallelRegionGuard(int64_t task_id) {
+  ParallelRegionGuard(int64_t task_id)
+      : prev_thread_num_(thread_num_),
+        prev_in_parallel_region_(in_parallel_region_) {
     _set_thread_num(task_id);
     _set_in_parallel_region(true);
   }
 
   ~ParallelRegionGuard() {
-    _set_in_parallel_region(false);
-    _unset_thread_num();
+    _set_in_parallel_region(prev_in_parallel_region_);
+    _set_thread_num(prev_thread_num_);
+  }
+
+ private:
+  size_t prev_thread_num_;
+  bool prev_in_parallel_region_;
+};
+
+// State of a single _parallel_run call, shared with the pool tasks it
+// enqueued. A pool task may only start after the call has returned, so the
+// state is reference counted and f is only touched while holding a claimed,
+// unfinished task (the caller waits for those).
+struct ParallelRunState {
+  ParallelRunState(
+      const std::function<void(int64_t, int64_t, size_t)>& f,
+      int64_t begin,
+      int64_t end,
+      size_t chunk_size,
+      size_t num_tasks)
+      : f(f),
+        begin(begin),
+        end(end),
+        chunk_size(chunk_size),
+        num_tasks(num_tasks),
+        next_task(0),
+        remaining(num_tasks) {}
+
+  // Claims and runs the next task; returns false if all tasks are claimed.
+  bool run_next_task() {
+    const size_t task_id = next_task.fetch_add(1);
+    if (task_id >= num_tasks) {
+      return false;
+    }
+    int64_t local_start = begin + task_id * chunk_size;
+    if (local_start < end) {
+      int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
+      try {
+        ParallelRegionGuard guard(task_id);
+        f(local_start, local_end, task_id);
+      } catch (...) {
+        if (!err_flag.test_and_set()) {
+          eptr = std::current_exception();
+        }
+      }
+    }
+    if (remaining.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done_cv.notify_all();
+    }
+    return true;
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return remaining.load() == 0; });
   }
+
+  const std::function<void(int64_t, int64_t, size_t)>& f;
+  const int64_t begin;
+  const int64_t end;
+  const size_t chunk_size;
+  const size_t num_tasks;
+  std::atomic<size_t> next_task;
+  std::atomic<size_t> remaining;
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::exception_ptr eptr;
+  std::mutex mutex;
+  std::condition_variable done_cv;
 };
 
 } // namespace
@@ -125,36 +182,37 @@ void _parallel_run(
   std::tie(num_tasks, chunk_size) =
       internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
 
-  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
-  std::exception_ptr eptr;
-  std::vector<std::shared_ptr<c10::ivalue::Future>> futures(num_tasks);
-  for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
-    futures[task_id] = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
+  auto state = std::make_shared<ParallelRunState>(
+      f, begin, end, chunk_size, num_tasks);
+#ifndef C10_MOBILE
+  // Pool tasks are not tied to a chunk: each one keeps claiming chunks until
+  // none are left. When the pool is busy, e.g. because this is a nested
+  // region, the calling thread ends up running most chunks itself instead of
+  // blocking on tasks queued behind the ones currently running.
+  for (size_t i = 1; i < num_tasks; ++i) {
+    _get_intraop_pool().run([state]() {
+      while (state->run_next_task()) {}
+    });
   }
-  auto task = [f, &eptr, &err_flag, &futures, begin, end, chunk_size]
-      (int /* unused */, size_t task_id) {
-    int64_t local_start = begin + task_id * chunk_size;
-    if (local_start < end) {
-      int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
-      try {
-        ParallelRegionGuard guard(task_id);
-        f(local_start, local_end, task_id);
-      } catch (...) {
-        if (!err_flag.test_and_set()) {
-          eptr = std::current_exception();
-        }
-      }
-    }
-    futures[task_id]->markCompleted();
-  };
-  _run_with_pool(task, num_tasks);
-
-  // Wait for all tasks to finish.
-  for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
-    futures[task_id]->wait();
+  while (state->run_next_task()) {}
+#else
+  caffe2::ThreadPool* pool = caffe2::mobile_threadpool();
+  if (pool) {
+    // caffe2::ThreadPool can utilize the current thread.
+    pool->run(
+        [state](int /* unused */, size_t /* unused */) {
+          state->run_next_task();
+        },
+        num_tasks);
+  } else {
+    while (state->run_next_task()) {}
   }
-  if (eptr) {
-    std::rethrow_exception(eptr);
+#endif // C10_MOBILE
+
+  // Wait for the tasks claimed by other threads to finish.
+  state->wait();
+  if (state->eptr) {
+    std::rethrow_exception(state->eptr);
   }
 }
 
@@ -222,6 +280,26 @@ int get_thread_num() {
   return thread_num_;
 }
 
+void set_intraop_numa_node(int numa_node_id) {
+#ifndef C10_MOBILE
+  TORCH_CHECK(
+      num_intraop_threads.load() != CONSUMED,
+      "Cannot set the NUMA node of intraop threads "
+      "after parallel work has started when using native parallel backend");
+  intraop_numa_node.store(numa_node_id);
+#else
+  TORCH_CHECK(false, "set_intraop_numa_node is not supported for mobile.");
+#endif // C10_MOBILE
+}
+
+int get_intraop_numa_node() {
+#ifndef C10_MOBILE
+  return intraop_numa_node.load();
+#else
+  return -1;
+#endif // C10_MOBILE
+}
+
 bool in_parallel_region() {
 #ifndef C10_MOBILE
   return in_parallel_region_ || (
@@ -22,6 +22,11 @@ inline std::tuple<size_t, size_t> calc_num_tasks_and_chunk_size(
   return std::make_tuple(num_tasks, chunk_size);
 }
 
+// Runs f over the chunks of [begin, end) given by
+// calc_num_tasks_and_chunk_size, passing the chunk index as the last argument.
+// Idle pool threads claim chunks one at a time; the calling thread claims
+// chunks too and only blocks on chunks already running elsewhere, which makes
+// it safe to call from a pool thread (nested parallelism).
 CAFFE2_API void _parallel_run(
   const int64_t begin,
   const int64_t end,
@@ -40,7 +45,8 @@ inline void parallel_for(
   if (begin >= end) {
     return;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
+  if ((end - begin) < grain_size ||
+      (in_parallel_region() && !get_nested_parallelism())) {
     f(begin, end);
     return;
   }
@@ -66,7 +72,8 @@ inline scalar_t parallel_reduce(
   if (begin >= end) {
     return ident;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
+  if ((end - begin) < grain_size ||
+      (in_parallel_region() && !get_nested_parallelism())) {
     return f(begin, end, ident);
   }
   size_t num_tasks, chunk_size;
@@ -76,6 +76,16 @@ bool in_parallel_region() {
   return tbb::this_task_arena::current_thread_index() != -1;
 }
 
+void set_intraop_numa_node(int numa_node_id) {
+  TORCH_CHECK(
+      numa_node_id < 0,
+      "set_intraop_numa_node is not supported with the TBB parallel backend");
+}
+
+int get_intraop_numa_node() {
+  return -1;
+}
+
 void intraop_launch(std::function<void()> func) {
   if (get_num_threads() > 1) {
     tg_.run(func);
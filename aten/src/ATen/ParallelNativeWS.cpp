@@ -0,0 +1,453 @@
+#if AT_PARALLEL_NATIVE_WS
+#include <ATen/Parallel.h>
+
+#include <c10/util/numa.h>
+#include <c10/util/thread_name.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef TH_BLAS_MKL
+#include <mkl.h>
+#endif
+
+namespace at {
+namespace {
+
+// A worker processes its range in pieces of about
+// range / (num_threads * kChunksPerThread) elements, so that a slow piece
+// leaves enough queued work for the other threads to steal.
+constexpr int64_t kChunksPerThread = 8;
+
+// set for pool threads, and for the calling thread while it takes part in
+// a parallel_for
+thread_local bool in_parallel_region_ = false;
+
+// 0 for the calling thread, 1..N-1 for pool threads
+thread_local int thread_num_ = 0;
+
+// RAII guard marking the calling thread as thread 0 of a parallel region.
+struct ParallelRegionGuard {
+  ParallelRegionGuard() {
+    in_parallel_region_ = true;
+    thread_num_ = 0;
+  }
+
+  ~ParallelRegionGuard() {
+    in_parallel_region_ = false;
+    thread_num_ = 0;
+  }
+};
+
+// One parallel_for call, or one task submitted through intraop_launch.
+struct Job {
+  Job(std::function<void(int64_t, int64_t)> fn_,
+      int64_t size,
+      int64_t grain_size_,
+      int64_t chunk_size_,
+      bool detached_)
+      : fn(std::move(fn_)),
+        grain_size(std::max<int64_t>(grain_size_, 1)),
+        chunk_size(std::max<int64_t>(chunk_size_, grain_size)),
+        detached(detached_),
+        remaining(size),
+        failed(false),
+        done(false) {}
+
+  const std::function<void(int64_t, int64_t)> fn;
+  const int64_t grain_size;
+  const int64_t chunk_size;
+  // Detached jobs are owned by the pool and deleted once completed.
+  const bool detached;
+
+  // Number of elements not processed yet
+  std::atomic<int64_t> remaining;
+  // Set once fn threw; the remaining elements are skipped.
+  std::atomic<bool> failed;
+  std::exception_ptr eptr;
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  bool done;
+};
+
+struct Range {
+  Job* job;
+  int64_t begin;
+  int64_t end;
+};
+
+class WorkStealingPool {
+ public:
+  WorkStealingPool(int num_workers, int numa_node_id)
+      : running_(true), pending_(0), idle_(0), next_queue_(0) {
+    for (int i = 0; i < num_workers; ++i) {
+      queues_.emplace_back(new Queue());
+    }
+    for (int i = 0; i < num_workers; ++i) {
+      threads_.emplace_back([this, i, numa_node_id]() {
+        c10::setThreadName("PTWorkStealing");
+        c10::NUMABind(numa_node_id);
+        init_num_threads();
+        main_loop(i);
+      });
+    }
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      running_ = false;
+    }
+    sleep_cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  size_t size() const {
+    return threads_.size();
+  }
+
+  // Runs job over [begin, end) and waits for it. The calling thread processes
+  // the first part itself and then helps with whatever is left of the job.
+  void run(Job& job, int64_t begin, int64_t end) {
+    const int64_t num_parts = std::min<int64_t>(
+        size() + 1, divup(end - begin, job.grain_size));
+    const int64_t part_size = divup(end - begin, num_parts);
+    for (int64_t part = 1; part < num_parts; ++part) {
+      const int64_t part_begin = begin + part * part_size;
+      if (part_begin < end) {
+        push((part - 1) % size(), {&job, part_begin, std::min(end, part_begin + part_size)});
+      }
+    }
+    execute({&job, begin, std::min(end, begin + part_size)}, -1);
+
+    Range range;
+    while (job.remaining.load() > 0 && steal(-1, range, &job)) {
+      execute(range, -1);
+    }
+    // Wait on `done` rather than `remaining`: the job must outlive the
+    // completion signal of whichever thread finishes it.
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done_cv.wait(lock, [&job]() { return job.done; });
+  }
+
+  // Queues a detached single-element job.
+  void submit(Job* job) {
+    push(next_queue(), {job, 0, 1});
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  size_t next_queue() {
+    return next_queue_++ % queues_.size();
+  }
+
+  void push(size_t queue, Range range) {
+    {
+      std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+      queues_[queue]->ranges.push_back(range);
+    }
+    ++pending_;
+    if (idle_.load() > 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      sleep_cv_.notify_one();
+    }
+  }
+
+  // The owner takes the most recently pushed range, which is the smallest
+  // and the most likely to still be in cache.
+  bool pop(size_t queue, Range& range) {
+    std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+    auto& ranges = queues_[queue]->ranges;
+    if (ranges.empty()) {
+      return false;
+    }
+    range = ranges.back();
+    ranges.pop_back();
+    --pending_;
+    return true;
+  }
+
+  // Thieves take the oldest, i.e. largest, range of another queue. With
+  // `only` set, only ranges of that job are taken.
+  bool steal(int thief, Range& range, const Job* only = nullptr) {
+    const size_t num_queues = queues_.size();
+    const size_t start = thief < 0 ? next_queue() : thief + 1;
+    for (size_t i = 0; i < num_queues; ++i) {
+      const size_t victim = (start + i) % num_queues;
+      if (static_cast<int>(victim) == thief) {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(queues_[victim]->mutex);
+      auto& ranges = queues_[victim]->ranges;
+      for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        if (!only || it->job == only) {
+          range = *it;
+          ranges.erase(it);
+          --pending_;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Processes a range, handing its upper half back to the queues whenever
+  // there are idle workers and the range is worth splitting.
+  void execute(Range range, int queue) {
+    Job* job = range.job;
+    int64_t begin = range.begin;
+    int64_t end = range.end;
+    while (begin < end) {
+      if (job->failed.load()) {
+        finish(job, end - begin);
+        return;
+      }
+      if (end - begin >= 2 * job->chunk_size && idle_.load() > 0) {
+        const int64_t mid = begin + (end - begin) / 2;
+        push(queue < 0 ? next_queue() : queue, {job, mid, end});
+        end = mid;
+        continue;
+      }
+      const int64_t chunk_end = std::min(end, begin + job->chunk_size);
+      try {
+        job->fn(begin, chunk_end);
+      } catch (...) {
+        if (!job->failed.exchange(true)) {
+          job->eptr = std::current_exception();
+        }
+      }
+      // `job` may be gone once its last elements are accounted for
+      finish(job, chunk_end - begin);
+      begin = chunk_end;
+    }
+  }
+
+  void finish(Job* job, int64_t num_elements) {
+    if (job->remaining.fetch_sub(num_elements) != num_elements) {
+      return;
+    }
+    if (job->detached) {
+      if (job->eptr) {
+        try {
+          std::rethrow_exception(job->eptr);
+        } catch (const std::exception& e) {
+          LOG(ERROR) << "Exception in intraop task: " << e.what();
+        } catch (...) {
+          LOG(ERROR) << "Exception in intraop task: unknown";
+        }
+      }
+      delete job;
+      return;
+    }
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->done = true;
+    job->done_cv.notify_all();
+  }
+
+  void main_loop(size_t index) {
+    in_parallel_region_ = true;
+    thread_num_ = index + 1;
+    while (true) {
+      Range range;
+      if (pop(index, range) || steal(index, range)) {
+        execute(range, index);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      ++idle_;
+      sleep_cv_.wait(lock, [this]() { return !running_ || pending_.load() > 0; });
+      --idle_;
+      if (!running_ && pending_.load() == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool running_;
+  // number of queued ranges
+  std::atomic<int64_t> pending_;
+  // number of sleeping workers
+  std::atomic<int> idle_;
+  std::atomic<size_t> next_queue_;
+};
+
+const int NOT_SET = -1;
+const int CONSUMED = -2;
+
+// Number of threads set by the user
+// NOT_SET -> positive value -> CONSUMED
+// or
+// NOT_SET -> CONSUMED
+// Meaning:
+//  - NOT_SET - pool not initialized, user value is not set
+//  - positive value - pool not initialized, user value set
+//  - CONSUMED - pool is initialized
+std::atomic<int> num_intraop_threads{NOT_SET};
+
+// NUMA node the pool threads are bound to, -1 if unbound
+std::atomic<int> intraop_numa_node{-1};
+
+WorkStealingPool& _get_intraop_pool() {
+  static std::unique_ptr<WorkStealingPool> pool = []() {
+    int nthreads = num_intraop_threads.exchange(CONSUMED);
+    if (nthreads == NOT_SET) {
+      nthreads = intraop_default_num_threads();
+    }
+    TORCH_INTERNAL_ASSERT(nthreads > 0);
+    // minus one because of the master thread
+    return std::unique_ptr<WorkStealingPool>(
+        new WorkStealingPool(nthreads - 1, intraop_numa_node.load()));
+  }();
+  return *pool;
+}
+
+} // namespace
+
+namespace internal {
+
+void _parallel_run(
+  const int64_t begin,
+  const int64_t end,
+  const int64_t grain_size,
+  const std::function<void(int64_t, int64_t)>& f) {
+  auto& pool = _get_intraop_pool();
+  if (pool.size() == 0) {
+    ParallelRegionGuard guard;
+    f(begin, end);
+    return;
+  }
+  const int64_t num_threads = pool.size() + 1;
+  Job job(
+      f,
+      end - begin,
+      grain_size,
+      divup(end - begin, num_threads * kChunksPerThread),
+      /* detached */ false);
+  {
+    ParallelRegionGuard guard;
+    pool.run(job, begin, end);
+  }
+  if (job.eptr) {
+    std::rethrow_exception(job.eptr);
+  }
+}
+
+} // namespace internal
+
+void init_num_threads() {
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif
+
+#ifdef TH_BLAS_MKL
+  mkl_set_num_threads(1);
+#endif
+}
+
+void set_num_threads(int nthreads) {
+  TORCH_CHECK(nthreads > 0, "Expected positive number of threads");
+  int no_value = NOT_SET;
+  if (!num_intraop_threads.compare_exchange_strong(no_value, nthreads)) {
+    // num_intraop_threads either stores a positive integer or CONSUMED,
+    // check that requested size is the same as the current one
+    int stored_nthreads = num_intraop_threads.load();
+    if (stored_nthreads <= 0) {
+      // plus one because of master thread
+      stored_nthreads = _get_intraop_pool().size() + 1;
+    }
+    if (stored_nthreads != nthreads) {
+      TORCH_WARN(
+        "Cannot set number of intraop threads "
+        "after parallel work has started or after set_num_threads call "
+        "when using work-stealing parallel backend");
+    }
+  }
+}
+
+int get_num_threads() {
+  // not initializing pool unnecessarily,
+  // because pool cannot be resized after initialization
+  int nthreads = num_intraop_threads.load();
+  if (nthreads > 0) {
+    return nthreads;
+  } else if (nthreads == NOT_SET) {
+    return intraop_default_num_threads();
+  } else {
+    TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
+    return _get_intraop_pool().size() + 1;
+  }
+}
+
+int get_thread_num() {
+  return thread_num_;
+}
+
+bool in_parallel_region() {
+  return in_parallel_region_;
+}
+
+void set_intraop_numa_node(int numa_node_id) {
+  TORCH_CHECK(
+      num_intraop_threads.load() != CONSUMED,
+      "Cannot set the NUMA node of intraop threads "
+      "after parallel work has started when using work-stealing parallel backend");
+  intraop_numa_node.store(numa_node_id);
+}
+
+int get_intraop_numa_node() {
+  return intraop_numa_node.load();
+}
+
+void intraop_launch(std::function<void()> func) {
+  if (!in_parallel_region() && get_num_threads() > 1) {
+    _get_intraop_pool().submit(new Job(
+        [func](int64_t /* unused */, int64_t /* unused */) { func(); },
+        1,
+        1,
+        1,
+        /* detached */ true));
+  } else {
+    // execute inline if we're in parallel region
+    func();
+  }
+}
+
+std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
+    std::function<void()> func) {
+  auto future = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
+  if (!in_parallel_region() && get_num_threads() > 1) {
+    intraop_launch(
+      [func, future]() {
+        func();
+        future->markCompleted();
+      }
+    );
+  } else {
+    func();
+    future->markCompleted();
+  }
+  return future;
+}
+
+} // namespace at
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <vector>
+
+#define INTRA_OP_PARALLEL
+
+namespace at {
+namespace internal {
+
+// Runs f over [begin, end) on the work-stealing intra-op pool. The range is
+// handed out in pieces of at least grain_size elements; pieces that are still
+// queued are split further while some workers are idle. The calling thread
+// takes part in the work and returns once the whole range is processed.
+CAFFE2_API void _parallel_run(
+  const int64_t begin,
+  const int64_t end,
+  const int64_t grain_size,
+  const std::function<void(int64_t, int64_t)>& f);
+
+} // namespace internal
+
+template <class F>
+inline void parallel_for(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const F& f) {
+  TORCH_CHECK(grain_size >= 0);
+  if (begin >= end) {
+    return;
+  }
+  if ((end - begin) < grain_size || in_parallel_region()) {
+    f(begin, end);
+    return;
+  }
+  internal::_parallel_run(begin, end, grain_size, f);
+}
+
+template <class scalar_t, class F, class SF>
+inline scalar_t parallel_reduce(
+    const int64_t begin,
+    const int64_t end,
+    const int64_t grain_size,
+    const scalar_t ident,
+    const F& f,
+    const SF& sf) {
+  TORCH_CHECK(grain_size >= 0);
+  if (begin >= end) {
+    return ident;
+  }
+  if ((end - begin) < grain_size || in_parallel_region()) {
+    return f(begin, end, ident);
+  }
+  // Partial results are computed over fixed chunks and combined in order, so
+  // that the result does not depend on how the chunks were scheduled. Only
+  // whole chunks are stolen.
+  int64_t num_tasks = std::min<int64_t>(
+      get_num_threads(), divup(end - begin, std::max<int64_t>(grain_size, 1)));
+  int64_t chunk_size = divup(end - begin, num_tasks);
+  std::vector<scalar_t> results(num_tasks, ident);
+  scalar_t* results_data = results.data();
+  internal::_parallel_run(
+      0,
+      num_tasks,
+      1,
+      [f, ident, results_data, begin, end, chunk_size](
+          int64_t task_begin, int64_t task_end) {
+        for (int64_t task_id = task_begin; task_id < task_end; ++task_id) {
+          int64_t local_start = begin + task_id * chunk_size;
+          int64_t local_end = std::min(end, local_start + chunk_size);
+          results_data[task_id] = f(local_start, local_end, ident);
+        }
+      }
+  );
+  scalar_t result = ident;
+  for (auto partial_result : results) {
+    result = sf(result, partial_result);
+  }
+  return result;
+}
+
+} // namespace at
@@ -1,5 +1,6 @@
 #if AT_PARALLEL_OPENMP
 #include <ATen/Parallel.h>
+#include <c10/util/numa.h>
 
 #include <atomic>
 
@@ -13,6 +14,9 @@ namespace {
 // Number of threads set by the user
 std::atomic<int> num_threads{-1};
 
+// NUMA node the OpenMP threads are bound to, -1 if unbound
+std::atomic<int> intraop_numa_node{-1};
+
 } // namespace
 
 void init_num_threads() {
@@ -78,6 +82,27 @@ bool in_parallel_region() {
 #endif
 }
 
+void set_intraop_numa_node(int numa_node_id) {
+  intraop_numa_node.store(numa_node_id);
+  if (numa_node_id < 0) {
+    return;
+  }
+#ifdef _OPENMP
+  // OpenMP keeps its worker threads alive, so binding them once is enough.
+  // Thread 0 is the calling thread, which is left alone.
+#pragma omp parallel
+  {
+    if (omp_get_thread_num() != 0) {
+      c10::NUMABind(numa_node_id);
+    }
+  }
+#endif
+}
+
+int get_intraop_numa_node() {
+  return intraop_numa_node.load();
+}
+
 void intraop_launch(std::function<void()> func) {
   // execute inline in openmp case
   func();
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+const int MODE_SUM = 0;
+const int MODE_MEAN = 1;
+const int MODE_MAX = 2;
+
+// All kernels below work on bags given by `offsets`: bag b covers the indices
+// [offsets[b], offsets[b + 1]), the last bag without a following offset ends
+// at indices.numel(). The number of bags is taken from the output (or grad),
+// so offsets may or may not include the last offset.
+
+// output[b] = reduce(weight[indices[i]] * per_sample_weights[i] for i in bag b)
+// max_indices is only used, and filled, for MODE_MAX. per_sample_weights may
+// be undefined. Empty bags produce zeros.
+using embedding_bag_fn = void(*)(
+    Tensor& output, Tensor& max_indices, const Tensor& weight,
+    const Tensor& indices, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t mode);
+
+// Dense backward of MODE_SUM / MODE_MEAN. sorted_indices are the indices in
+// ascending order and sort_perm the permutation that sorted them. Every
+// grad_weight row that is referenced is written by exactly one thread.
+using embedding_bag_backward_fn = void(*)(
+    Tensor& grad_weight, const Tensor& grad, const Tensor& sorted_indices,
+    const Tensor& sort_perm, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t mode, bool scale_grad_by_freq);
+
+// Dense backward of MODE_MAX, skipping bags with bag_size 0.
+using embedding_bag_max_backward_fn = void(*)(
+    Tensor& grad_weight, const Tensor& grad, const Tensor& max_indices,
+    const Tensor& bag_size);
+
+// index_grad[i] = grad[bag of i] * scale of i, the values of the sparse
+// gradient. Indices that belong to no bag get zeros.
+using embedding_bag_sparse_backward_fn = void(*)(
+    Tensor& index_grad, const Tensor& grad, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t mode);
+
+// output[i] = dot(grad[bag of i], weight[indices[i]])
+using embedding_bag_per_sample_weights_backward_fn = void(*)(
+    Tensor& output, const Tensor& grad, const Tensor& weight,
+    const Tensor& indices, const Tensor& offsets);
+
+DECLARE_DISPATCH(embedding_bag_fn, embedding_bag_stub);
+DECLARE_DISPATCH(embedding_bag_backward_fn, embedding_bag_backward_stub);
+DECLARE_DISPATCH(embedding_bag_max_backward_fn, embedding_bag_max_backward_stub);
+DECLARE_DISPATCH(embedding_bag_sparse_backward_fn, embedding_bag_sparse_backward_stub);
+DECLARE_DISPATCH(embedding_bag_per_sample_weights_backward_fn, embedding_bag_per_sample_weights_backward_stub);
+
+}} // at::native
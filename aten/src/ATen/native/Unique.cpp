@@ -2,7 +2,11 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/NumericUtils.h>
+#include <ATen/Parallel.h>
 
+#include <algorithm>
+#include <numeric>
 #include <set>
 #include <tuple>
 #include <unordered_map>
@@ -13,62 +17,300 @@ namespace native{
 
 namespace {
 
+// Number of chunks the parallel unique engine splits `numel` elements into.
+// Returns 1 when the input is too small to be worth parallelizing or when we
+// are already inside a parallel region.
+inline int64_t unique_num_chunks(int64_t numel) {
+  if (numel < at::internal::GRAIN_SIZE || at::in_parallel_region()) {
+    return 1;
+  }
+  return std::max<int64_t>(
+      1,
+      std::min<int64_t>(
+          at::get_num_threads(), numel / at::internal::GRAIN_SIZE));
+}
+
+inline std::vector<int64_t> unique_chunk_bounds(int64_t numel, int64_t num_chunks) {
+  std::vector<int64_t> bounds(num_chunks + 1);
+  for (int64_t c = 0; c <= num_chunks; ++c) {
+    bounds[c] = numel * c / num_chunks;
+  }
+  return bounds;
+}
+
+// Parallel merge sort: every chunk is sorted independently, then neighbouring
+// runs are merged pairwise in log2(num_chunks) parallel rounds.
+template <typename T, typename Comp>
+void unique_parallel_sort(T* data, int64_t numel, const Comp& comp) {
+  const int64_t num_chunks = unique_num_chunks(numel);
+  if (num_chunks <= 1) {
+    std::sort(data, data + numel, comp);
+    return;
+  }
+  const auto bounds = unique_chunk_bounds(numel, num_chunks);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      std::sort(data + bounds[c], data + bounds[c + 1], comp);
+    }
+  });
+  for (int64_t width = 1; width < num_chunks; width *= 2) {
+    const int64_t num_merges = divup(num_chunks, 2 * width);
+    at::parallel_for(0, num_merges, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t m = begin; m < end; ++m) {
+        const int64_t lo = bounds[2 * m * width];
+        const int64_t mid = bounds[std::min(2 * m * width + width, num_chunks)];
+        const int64_t hi = bounds[std::min(2 * m * width + 2 * width, num_chunks)];
+        if (mid < hi) {
+          std::inplace_merge(data + lo, data + mid, data + hi, comp);
+        }
+      }
+    });
+  }
+}
+
+// Strict weak ordering that places NaN after every other value.
 template <typename scalar_t>
-std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
-    const Tensor& self,
-    const bool sorted,
+inline bool unique_less(scalar_t a, scalar_t b) {
+  return (!_isnan<scalar_t>(a) && _isnan<scalar_t>(b)) || (a < b);
+}
+
+// Sorted unique. Sorts a copy of the input (paired with the original positions
+// when inverse indices are requested), then produces the unique values, the
+// inverse indices and the counts in a single fused parallel scan over the
+// sorted run boundaries.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> unique_cpu_sorted_template(
+    const Tensor& input,
     const bool return_inverse,
     const bool return_counts) {
-  const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data_ptr<scalar_t>();
-  int64_t numel = input.numel();
-  Tensor output;
-  Tensor inverse_indices = at::empty({0}, self.options().dtype(kLong));
-  Tensor counts = at::empty({0}, self.options().dtype(kLong));
-
-  std::unordered_set<scalar_t> set(input_data, input_data + numel);
-  output = at::empty({static_cast<int64_t>(set.size())}, input.options());
-  scalar_t *output_data = output.data_ptr<scalar_t>();
-
-  if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
+  const int64_t numel = input.numel();
+  Tensor inverse_indices = at::empty({0}, input.options().dtype(kLong));
+  Tensor counts = at::empty({0}, input.options().dtype(kLong));
+
+  using elem_t = std::pair<scalar_t, int64_t>;
+  std::vector<elem_t> pairs;
+  // A tensor rather than std::vector so that bool keeps a flat layout.
+  Tensor values;
+  scalar_t* values_data = nullptr;
+  if (return_inverse) {
+    pairs.resize(numel);
+    at::parallel_for(0, numel, at::internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        pairs[i] = elem_t(input_data[i], i);
+      }
+    });
+    unique_parallel_sort(pairs.data(), numel, [](const elem_t& x, const elem_t& y) {
+      return unique_less<scalar_t>(x.first, y.first);
+    });
   } else {
-    std::copy(set.begin(), set.end(), output_data);
+    values = input.clone();
+    values_data = values.data_ptr<scalar_t>();
+    unique_parallel_sort(values_data, numel, unique_less<scalar_t>);
   }
+  auto key = [&](int64_t i) -> scalar_t {
+    return return_inverse ? pairs[i].first : values_data[i];
+  };
+  // NaN != NaN, so every NaN starts a new run, matching the hash-based path.
+  auto is_run_start = [&](int64_t i) -> bool {
+    return i == 0 || key(i) != key(i - 1);
+  };
+
+  // Pass 1: number of runs starting in every chunk.
+  const int64_t num_chunks = unique_num_chunks(numel);
+  const auto bounds = unique_chunk_bounds(numel, num_chunks);
+  std::vector<int64_t> chunk_offsets(num_chunks + 1, 0);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t n = 0;
+      for (int64_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+        n += is_run_start(i);
+      }
+      chunk_offsets[c + 1] = n;
+    }
+  });
+  std::partial_sum(chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+  const int64_t num_unique = chunk_offsets[num_chunks];
 
-  if (return_inverse || return_counts) {
+  Tensor output = at::empty({num_unique}, input.options());
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  int64_t* inverse_data = nullptr;
+  int64_t* counts_data = nullptr;
+  if (return_inverse) {
     inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data_ptr<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int64_t i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
-    }
-    for(int64_t i = 0; i < numel; ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
+    inverse_data = inverse_indices.data_ptr<int64_t>();
+  }
+  if (return_counts) {
+    counts.resize_({num_unique});
+    counts_data = counts.data_ptr<int64_t>();
+  }
+
+  // Pass 2: write values, inverse indices and counts. A run is owned by the
+  // chunk containing its first element, which may scan past its chunk end.
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t pos = chunk_offsets[c] - 1;
+      int64_t i = bounds[c];
+      // Skip the tail of a run owned by the previous chunk.
+      while (i < bounds[c + 1] && !is_run_start(i)) {
+        ++i;
+      }
+      while (i < bounds[c + 1]) {
+        const int64_t run_begin = i;
+        ++pos;
+        output_data[pos] = key(i);
+        do {
+          if (return_inverse) {
+            inverse_data[pairs[i].second] = pos;
+          }
+          ++i;
+        } while (i < numel && !is_run_start(i));
+        if (return_counts) {
+          counts_data[pos] = i - run_begin;
+        }
+      }
     }
-    if (return_counts) {
-      std::unordered_map<scalar_t, int64_t> counts_map;
-      counts_map.reserve(output.numel());
-      for (int64_t i = 0; i < output.numel(); ++i) {
-        counts_map[output_data[i]] = 0;
+  });
+  return std::make_tuple(output, inverse_indices, counts);
+}
+
+// Unsorted unique. Elements are hash-partitioned so that every partition can
+// be deduplicated independently with its own hash map; the unique values of a
+// partition are emitted in first-occurrence order and partitions are
+// concatenated.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> unique_cpu_hashed_template(
+    const Tensor& input,
+    const bool return_inverse,
+    const bool return_counts) {
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const int64_t numel = input.numel();
+  Tensor inverse_indices = at::empty({0}, input.options().dtype(kLong));
+  Tensor counts = at::empty({0}, input.options().dtype(kLong));
+  int64_t* inverse_data = nullptr;
+  if (return_inverse) {
+    inverse_indices.resize_(input.sizes());
+    inverse_data = inverse_indices.data_ptr<int64_t>();
+  }
+
+  const int64_t num_chunks = unique_num_chunks(numel);
+  const int64_t num_partitions = num_chunks;
+  auto partition_of = [&](scalar_t v) -> int64_t {
+    // Fibonacci hashing on top of std::hash, which is the identity for
+    // integral types.
+    const uint64_t h = static_cast<uint64_t>(std::hash<scalar_t>()(v));
+    return static_cast<int64_t>(((h * 0x9E3779B97F4A7C15ULL) >> 32) % num_partitions);
+  };
+
+  // Pass 1: per-chunk histogram of partition sizes, turned into scatter
+  // offsets laid out as [partition][chunk].
+  const auto bounds = unique_chunk_bounds(numel, num_chunks);
+  std::vector<int64_t> offsets(num_partitions * num_chunks + 1, 0);
+  std::vector<int64_t> partition_indices;
+  if (num_partitions > 1) {
+    at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; ++c) {
+        for (int64_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+          offsets[partition_of(input_data[i]) * num_chunks + c + 1]++;
+        }
       }
-      for(int64_t i = 0; i < numel; i++) {
-        counts_map[input_data[i]] += 1;
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    // Pass 2: stable scatter of element positions into their partitions.
+    partition_indices.resize(numel);
+    at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; ++c) {
+        std::vector<int64_t> cursor(num_partitions);
+        for (int64_t p = 0; p < num_partitions; ++p) {
+          cursor[p] = offsets[p * num_chunks + c];
+        }
+        for (int64_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+          partition_indices[cursor[partition_of(input_data[i])]++] = i;
+        }
       }
-      counts.resize_(output.sizes());
-      counts.fill_(0);
-      int64_t *counts_data = counts.data_ptr<int64_t>();
-      for(int64_t i = 0; i < output.numel(); i++) {
-        counts_data[i] = counts_map[output_data[i]];
+    });
+  }
+  auto element = [&](int64_t p, int64_t j) -> int64_t {
+    return num_partitions > 1 ? partition_indices[offsets[p * num_chunks] + j] : j;
+  };
+  auto partition_size = [&](int64_t p) -> int64_t {
+    return num_partitions > 1
+        ? offsets[(p + 1) * num_chunks] - offsets[p * num_chunks]
+        : numel;
+  };
+
+  // Pass 3: deduplicate every partition. Inverse indices are partition-local
+  // until the partition offsets are known.
+  std::vector<std::vector<scalar_t>> partition_values(num_partitions);
+  std::vector<std::vector<int64_t>> partition_counts(num_partitions);
+  at::parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; ++p) {
+      auto& part_values = partition_values[p];
+      auto& part_counts = partition_counts[p];
+      std::unordered_map<scalar_t, int64_t> ids;
+      const int64_t n = partition_size(p);
+      for (int64_t j = 0; j < n; ++j) {
+        const int64_t i = element(p, j);
+        auto it = ids.emplace(input_data[i], static_cast<int64_t>(part_values.size()));
+        if (it.second) {
+          part_values.push_back(input_data[i]);
+          part_counts.push_back(0);
+        }
+        const int64_t id = it.first->second;
+        part_counts[id]++;
+        if (return_inverse) {
+          inverse_data[i] = id;
+        }
       }
     }
+  });
+
+  std::vector<int64_t> partition_offsets(num_partitions + 1, 0);
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    partition_offsets[p + 1] = partition_offsets[p] + partition_values[p].size();
   }
+  const int64_t num_unique = partition_offsets[num_partitions];
+  Tensor output = at::empty({num_unique}, input.options());
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  int64_t* counts_data = nullptr;
+  if (return_counts) {
+    counts.resize_({num_unique});
+    counts_data = counts.data_ptr<int64_t>();
+  }
+
+  // Pass 4: concatenate partitions and rebase the inverse indices.
+  at::parallel_for(0, num_partitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; ++p) {
+      const int64_t base = partition_offsets[p];
+      std::copy(partition_values[p].begin(), partition_values[p].end(), output_data + base);
+      if (return_counts) {
+        std::copy(partition_counts[p].begin(), partition_counts[p].end(), counts_data + base);
+      }
+      if (return_inverse && base != 0) {
+        const int64_t n = partition_size(p);
+        for (int64_t j = 0; j < n; ++j) {
+          inverse_data[element(p, j)] += base;
+        }
+      }
+    }
+  });
   return std::make_tuple(output, inverse_indices, counts);
 }
 
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
+    const Tensor& self,
+    const bool sorted,
+    const bool return_inverse,
+    const bool return_counts) {
+  const Tensor& input = self.contiguous();
+  if (sorted) {
+    return unique_cpu_sorted_template<scalar_t>(input, return_inverse, return_counts);
+  }
+  return unique_cpu_hashed_template<scalar_t>(input, return_inverse, return_counts);
+}
+
 template <typename scalar_t>
 std::tuple<Tensor, Tensor, Tensor> unique_consecutive_cpu_template(
     const Tensor& self,
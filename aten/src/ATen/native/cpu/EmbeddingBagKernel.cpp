@@ -0,0 +1,513 @@
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/native/EmbeddingBag.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace at { namespace native {
+
+namespace {
+
+using namespace vec256;
+
+// Half and BFloat16 rows are accumulated in float.
+template <typename scalar_t>
+struct AccType { using type = scalar_t; };
+template <>
+struct AccType<at::Half> { using type = float; };
+template <>
+struct AccType<at::BFloat16> { using type = float; };
+
+// Loads and stores Vec256<acc_t>::size() consecutive scalar_t as acc_t.
+template <typename scalar_t, typename acc_t>
+struct RowIO {
+  static Vec256<acc_t> load(const scalar_t* ptr) {
+    __at_align32__ acc_t buf[Vec256<acc_t>::size()];
+    for (int64_t k = 0; k < Vec256<acc_t>::size(); k++) {
+      buf[k] = static_cast<acc_t>(ptr[k]);
+    }
+    return Vec256<acc_t>::loadu(buf);
+  }
+  static void store(scalar_t* ptr, const Vec256<acc_t>& vec) {
+    __at_align32__ acc_t buf[Vec256<acc_t>::size()];
+    vec.store(buf);
+    for (int64_t k = 0; k < Vec256<acc_t>::size(); k++) {
+      ptr[k] = static_cast<scalar_t>(buf[k]);
+    }
+  }
+};
+
+template <typename scalar_t>
+struct RowIO<scalar_t, scalar_t> {
+  static Vec256<scalar_t> load(const scalar_t* ptr) {
+    return Vec256<scalar_t>::loadu(ptr);
+  }
+  static void store(scalar_t* ptr, const Vec256<scalar_t>& vec) {
+    vec.store(ptr);
+  }
+};
+
+// acc[0:n] += alpha * src[0:n]
+template <typename scalar_t, typename acc_t>
+inline void axpy_row(acc_t* acc, const scalar_t* src, acc_t alpha, int64_t n) {
+  using Vec = Vec256<acc_t>;
+  const Vec alpha_vec(alpha);
+  int64_t d = 0;
+  for (; d < n - (n % Vec::size()); d += Vec::size()) {
+    Vec sum = fmadd(RowIO<scalar_t, acc_t>::load(src + d), alpha_vec, Vec::loadu(acc + d));
+    sum.store(acc + d);
+  }
+  for (; d < n; d++) {
+    acc[d] += alpha * static_cast<acc_t>(src[d]);
+  }
+}
+
+// dst[0:n] = alpha * src[0:n]
+template <typename dst_t, typename src_t, typename acc_t>
+inline void scale_row(dst_t* dst, const src_t* src, acc_t alpha, int64_t n) {
+  using Vec = Vec256<acc_t>;
+  const Vec alpha_vec(alpha);
+  int64_t d = 0;
+  for (; d < n - (n % Vec::size()); d += Vec::size()) {
+    RowIO<dst_t, acc_t>::store(dst + d, RowIO<src_t, acc_t>::load(src + d) * alpha_vec);
+  }
+  for (; d < n; d++) {
+    dst[d] = static_cast<dst_t>(alpha * static_cast<acc_t>(src[d]));
+  }
+}
+
+// sum(a[0:n] * b[0:n])
+template <typename scalar_t, typename acc_t>
+inline acc_t dot_row(const scalar_t* a, const scalar_t* b, int64_t n) {
+  using Vec = Vec256<acc_t>;
+  Vec sum_vec(acc_t(0));
+  int64_t d = 0;
+  for (; d < n - (n % Vec::size()); d += Vec::size()) {
+    sum_vec = fmadd(RowIO<scalar_t, acc_t>::load(a + d), RowIO<scalar_t, acc_t>::load(b + d), sum_vec);
+  }
+  __at_align32__ acc_t buf[Vec::size()];
+  sum_vec.store(buf);
+  acc_t sum = 0;
+  for (int64_t k = 0; k < Vec::size(); k++) {
+    sum += buf[k];
+  }
+  for (; d < n; d++) {
+    sum += static_cast<acc_t>(a[d]) * static_cast<acc_t>(b[d]);
+  }
+  return sum;
+}
+
+// Number of bags per task so that a task touches about GRAIN_SIZE elements.
+inline int64_t bag_grain_size(int64_t num_bags, int64_t num_indices, int64_t ddim) {
+  const int64_t indices_per_bag = num_indices / std::max<int64_t>(num_bags, 1) + 1;
+  return std::max<int64_t>(1, at::internal::GRAIN_SIZE / (indices_per_bag * std::max<int64_t>(ddim, 1)));
+}
+
+struct BagBounds {
+  BagBounds(const int64_t* offsets_data, int64_t num_offsets, int64_t num_indices)
+      : offsets_data(offsets_data), num_offsets(num_offsets), num_indices(num_indices) {}
+
+  int64_t begin(int64_t bag) const {
+    return offsets_data[bag];
+  }
+  int64_t end(int64_t bag) const {
+    return bag + 1 < num_offsets ? offsets_data[bag + 1] : num_indices;
+  }
+
+  const int64_t* offsets_data;
+  const int64_t num_offsets;
+  const int64_t num_indices;
+};
+
+// Max over the rows of one bag, keeping the position of the winning row per
+// element. A row only replaces the running max where it is strictly greater,
+// so ties go to the first row and NaNs after the first row are ignored.
+// Positions are tracked as acc_t, which is exact for any realistic bag; longer
+// bags take the scalar path.
+template <typename scalar_t, typename acc_t>
+void max_bag(
+    scalar_t* output,
+    int64_t* max_indices,
+    const scalar_t* weight_data,
+    int64_t weight_stride0,
+    const int64_t* indices_data,
+    int64_t bag_begin,
+    int64_t bag_end,
+    int64_t ddim,
+    acc_t* max_buf,
+    acc_t* pos_buf) {
+  using Vec = Vec256<acc_t>;
+  if (bag_end == bag_begin) {
+    std::fill(output, output + ddim, scalar_t(0));
+    std::fill(max_indices, max_indices + ddim, int64_t(0));
+    return;
+  }
+  const int64_t bag_length = bag_end - bag_begin;
+  const scalar_t* first_row = weight_data + weight_stride0 * indices_data[bag_begin];
+  if (bag_length > (int64_t(1) << std::numeric_limits<acc_t>::digits)) {
+    for (int64_t d = 0; d < ddim; d++) {
+      scalar_t current = first_row[d];
+      int64_t current_index = indices_data[bag_begin];
+      for (int64_t i = bag_begin + 1; i < bag_end; i++) {
+        scalar_t item = weight_data[weight_stride0 * indices_data[i] + d];
+        if (item > current) {
+          current = item;
+          current_index = indices_data[i];
+        }
+      }
+      output[d] = current;
+      max_indices[d] = current_index;
+    }
+    return;
+  }
+
+  for (int64_t d = 0; d < ddim; d++) {
+    max_buf[d] = static_cast<acc_t>(first_row[d]);
+    pos_buf[d] = 0;
+  }
+  const int64_t vec_end = ddim - (ddim % Vec::size());
+  for (int64_t i = bag_begin + 1; i < bag_end; i++) {
+    const scalar_t* row = weight_data + weight_stride0 * indices_data[i];
+    const acc_t pos = static_cast<acc_t>(i - bag_begin);
+    const Vec pos_vec(pos);
+    int64_t d = 0;
+    for (; d < vec_end; d += Vec::size()) {
+      Vec item = RowIO<scalar_t, acc_t>::load(row + d);
+      Vec current = Vec::loadu(max_buf + d);
+      Vec mask = item > current;
+      Vec::blendv(current, item, mask).store(max_buf + d);
+      Vec::blendv(Vec::loadu(pos_buf + d), pos_vec, mask).store(pos_buf + d);
+    }
+    for (; d < ddim; d++) {
+      acc_t item = static_cast<acc_t>(row[d]);
+      if (item > max_buf[d]) {
+        max_buf[d] = item;
+        pos_buf[d] = pos;
+      }
+    }
+  }
+  for (int64_t d = 0; d < ddim; d++) {
+    output[d] = static_cast<scalar_t>(max_buf[d]);
+    max_indices[d] = indices_data[bag_begin + static_cast<int64_t>(pos_buf[d])];
+  }
+}
+
+template <typename scalar_t>
+void embedding_bag_kernel_impl(
+    Tensor& output,
+    Tensor& max_indices,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode) {
+  using acc_t = typename AccType<scalar_t>::type;
+  const int64_t num_bags = output.size(0);
+  const int64_t ddim = weight.size(1);
+  const int64_t num_indices = indices.numel();
+  const BagBounds bounds(offsets.data_ptr<int64_t>(), offsets.numel(), num_indices);
+
+  const scalar_t* weight_data = weight.data_ptr<scalar_t>();
+  const int64_t weight_stride0 = weight.stride(0);
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  int64_t* max_indices_data = mode == MODE_MAX ? max_indices.data_ptr<int64_t>() : nullptr;
+  const scalar_t* per_sample_weights_data = nullptr;
+  int64_t per_sample_weights_stride = 0;
+  if (per_sample_weights.defined()) {
+    per_sample_weights_data = per_sample_weights.data_ptr<scalar_t>();
+    per_sample_weights_stride = per_sample_weights.stride(0);
+  }
+
+  at::parallel_for(0, num_bags, bag_grain_size(num_bags, num_indices, ddim),
+      [&](int64_t begin, int64_t end) {
+    std::vector<acc_t> acc(ddim);
+    std::vector<acc_t> pos(mode == MODE_MAX ? ddim : 0);
+    for (int64_t bag = begin; bag < end; bag++) {
+      const int64_t bag_begin = bounds.begin(bag);
+      const int64_t bag_end = bounds.end(bag);
+      if (mode == MODE_MAX) {
+        max_bag<scalar_t, acc_t>(
+            output_data + bag * ddim, max_indices_data + bag * ddim,
+            weight_data, weight_stride0, indices_data, bag_begin, bag_end,
+            ddim, acc.data(), pos.data());
+        continue;
+      }
+      std::fill(acc.begin(), acc.end(), acc_t(0));
+      for (int64_t i = bag_begin; i < bag_end; i++) {
+        const acc_t scale = per_sample_weights_data
+            ? static_cast<acc_t>(per_sample_weights_data[i * per_sample_weights_stride])
+            : acc_t(1);
+        axpy_row(acc.data(), weight_data + weight_stride0 * indices_data[i], scale, ddim);
+      }
+      // Empty bags produce zeros in MODE_MEAN as well.
+      const acc_t out_scale = (mode == MODE_MEAN && bag_end > bag_begin)
+          ? acc_t(1) / (bag_end - bag_begin)
+          : acc_t(1);
+      scale_row(output_data + bag * ddim, acc.data(), out_scale, ddim);
+    }
+  });
+}
+
+void embedding_bag_kernel(
+    Tensor& output,
+    Tensor& max_indices,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      weight.scalar_type(), "embedding_bag_cpu", [&] {
+    embedding_bag_kernel_impl<scalar_t>(
+        output, max_indices, weight, indices, offsets, per_sample_weights, mode);
+  });
+}
+
+template <typename scalar_t>
+void embedding_bag_backward_kernel_impl(
+    Tensor& grad_weight,
+    const Tensor& grad,
+    const Tensor& sorted_indices,
+    const Tensor& sort_perm,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode,
+    bool scale_grad_by_freq) {
+  using acc_t = typename AccType<scalar_t>::type;
+  const int64_t num_bags = grad.size(0);
+  const int64_t num_indices = sorted_indices.numel();
+  const int64_t ddim = grad.size(1);
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const BagBounds bounds(offsets_data, offsets.numel(), num_indices);
+
+  const int64_t* indices_data = sorted_indices.data_ptr<int64_t>();
+  const int64_t* perm_data = sort_perm.data_ptr<int64_t>();
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  scalar_t* grad_weight_data = grad_weight.data_ptr<scalar_t>();
+  const scalar_t* per_sample_weights_data = nullptr;
+  int64_t per_sample_weights_stride = 0;
+  if (per_sample_weights.defined()) {
+    per_sample_weights_data = per_sample_weights.data_ptr<scalar_t>();
+    per_sample_weights_stride = per_sample_weights.stride(0);
+  }
+
+  // Every run of equal indices produces one grad_weight row.
+  std::vector<int64_t> run_starts;
+  for (int64_t i = 0; i < num_indices; i++) {
+    if (i == 0 || indices_data[i] != indices_data[i - 1]) {
+      run_starts.push_back(i);
+    }
+  }
+  const int64_t num_runs = run_starts.size();
+  run_starts.push_back(num_indices);
+
+  at::parallel_for(0, num_runs, bag_grain_size(num_runs, num_indices, ddim),
+      [&](int64_t begin, int64_t end) {
+    std::vector<acc_t> acc(ddim);
+    for (int64_t run = begin; run < end; run++) {
+      const int64_t run_begin = run_starts[run];
+      const int64_t run_end = run_starts[run + 1];
+      std::fill(acc.begin(), acc.end(), acc_t(0));
+      for (int64_t j = run_begin; j < run_end; j++) {
+        // The bag of an index is the last one starting at or before it.
+        const int64_t pos = perm_data[j];
+        const int64_t bag =
+            std::upper_bound(offsets_data, offsets_data + num_bags, pos) - offsets_data - 1;
+        if (pos >= bounds.end(bag)) {
+          // Past the last offset with include_last_offset.
+          continue;
+        }
+        acc_t scale = per_sample_weights_data
+            ? static_cast<acc_t>(per_sample_weights_data[pos * per_sample_weights_stride])
+            : acc_t(1);
+        if (mode == MODE_MEAN) {
+          scale /= bounds.end(bag) - bounds.begin(bag);
+        }
+        if (scale_grad_by_freq) {
+          scale /= run_end - run_begin;
+        }
+        axpy_row(acc.data(), grad_data + bag * ddim, scale, ddim);
+      }
+      scale_row(grad_weight_data + indices_data[run_begin] * ddim, acc.data(), acc_t(1), ddim);
+    }
+  });
+}
+
+void embedding_bag_backward_kernel(
+    Tensor& grad_weight,
+    const Tensor& grad,
+    const Tensor& sorted_indices,
+    const Tensor& sort_perm,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode,
+    bool scale_grad_by_freq) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      grad.scalar_type(), "embedding_bag_backward_cpu", [&] {
+    embedding_bag_backward_kernel_impl<scalar_t>(
+        grad_weight, grad, sorted_indices, sort_perm, offsets,
+        per_sample_weights, mode, scale_grad_by_freq);
+  });
+}
+
+template <typename scalar_t>
+void embedding_bag_max_backward_kernel_impl(
+    Tensor& grad_weight,
+    const Tensor& grad,
+    const Tensor& max_indices,
+    const Tensor& bag_size) {
+  using acc_t = typename AccType<scalar_t>::type;
+  const int64_t num_bags = grad.size(0);
+  const int64_t ddim = grad.size(1);
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  const int64_t* max_indices_data = max_indices.data_ptr<int64_t>();
+  const int64_t* bag_size_data = bag_size.data_ptr<int64_t>();
+  scalar_t* grad_weight_data = grad_weight.data_ptr<scalar_t>();
+
+  // Two bags may share a max row, so threads split the columns instead of
+  // the bags. Chunks of at least 16 columns keep threads off each other's
+  // cache lines.
+  const int64_t grain_size = std::max<int64_t>(
+      16, at::internal::GRAIN_SIZE / std::max<int64_t>(num_bags, 1));
+  at::parallel_for(0, ddim, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t bag = 0; bag < num_bags; bag++) {
+      if (bag_size_data[bag] == 0) {
+        continue;
+      }
+      const scalar_t* grad_row = grad_data + bag * ddim;
+      const int64_t* max_indices_row = max_indices_data + bag * ddim;
+      for (int64_t d = begin; d < end; d++) {
+        scalar_t& item = grad_weight_data[max_indices_row[d] * ddim + d];
+        item = static_cast<scalar_t>(static_cast<acc_t>(item) + static_cast<acc_t>(grad_row[d]));
+      }
+    }
+  });
+}
+
+void embedding_bag_max_backward_kernel(
+    Tensor& grad_weight,
+    const Tensor& grad,
+    const Tensor& max_indices,
+    const Tensor& bag_size) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      grad.scalar_type(), "embedding_bag_max_backward_cpu", [&] {
+    embedding_bag_max_backward_kernel_impl<scalar_t>(
+        grad_weight, grad, max_indices, bag_size);
+  });
+}
+
+template <typename scalar_t>
+void embedding_bag_sparse_backward_kernel_impl(
+    Tensor& index_grad,
+    const Tensor& grad,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode) {
+  using acc_t = typename AccType<scalar_t>::type;
+  const int64_t num_bags = grad.size(0);
+  const int64_t ddim = grad.size(1);
+  const int64_t num_indices = index_grad.size(0);
+  const BagBounds bounds(offsets.data_ptr<int64_t>(), offsets.numel(), num_indices);
+
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  scalar_t* index_grad_data = index_grad.data_ptr<scalar_t>();
+  const scalar_t* per_sample_weights_data = nullptr;
+  int64_t per_sample_weights_stride = 0;
+  if (per_sample_weights.defined()) {
+    per_sample_weights_data = per_sample_weights.data_ptr<scalar_t>();
+    per_sample_weights_stride = per_sample_weights.stride(0);
+  }
+
+  at::parallel_for(0, num_bags, bag_grain_size(num_bags, num_indices, ddim),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag < end; bag++) {
+      const int64_t bag_begin = bounds.begin(bag);
+      const int64_t bag_end = bounds.end(bag);
+      const acc_t bag_scale = mode == MODE_MEAN && bag_end > bag_begin
+          ? acc_t(1) / (bag_end - bag_begin)
+          : acc_t(1);
+      for (int64_t i = bag_begin; i < bag_end; i++) {
+        const acc_t scale = per_sample_weights_data
+            ? bag_scale * static_cast<acc_t>(per_sample_weights_data[i * per_sample_weights_stride])
+            : bag_scale;
+        scale_row(index_grad_data + i * ddim, grad_data + bag * ddim, scale, ddim);
+      }
+    }
+  });
+
+  // With include_last_offset the last offset may stop short of the end.
+  const int64_t covered = num_bags > 0 ? bounds.end(num_bags - 1) : 0;
+  std::fill(index_grad_data + covered * ddim, index_grad_data + num_indices * ddim, scalar_t(0));
+}
+
+void embedding_bag_sparse_backward_kernel(
+    Tensor& index_grad,
+    const Tensor& grad,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      grad.scalar_type(), "embedding_bag_sparse_backward_cpu", [&] {
+    embedding_bag_sparse_backward_kernel_impl<scalar_t>(
+        index_grad, grad, offsets, per_sample_weights, mode);
+  });
+}
+
+template <typename scalar_t>
+void embedding_bag_per_sample_weights_backward_kernel_impl(
+    Tensor& output,
+    const Tensor& grad,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets) {
+  using acc_t = typename AccType<scalar_t>::type;
+  const int64_t num_bags = grad.size(0);
+  const int64_t ddim = grad.size(1);
+  const int64_t num_indices = indices.numel();
+  const BagBounds bounds(offsets.data_ptr<int64_t>(), offsets.numel(), num_indices);
+
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  const scalar_t* weight_data = weight.data_ptr<scalar_t>();
+  const int64_t weight_stride0 = weight.stride(0);
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+
+  at::parallel_for(0, num_bags, bag_grain_size(num_bags, num_indices, ddim),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t bag = begin; bag < end; bag++) {
+      const scalar_t* grad_row = grad_data + bag * ddim;
+      for (int64_t i = bounds.begin(bag); i < bounds.end(bag); i++) {
+        output_data[i] = static_cast<scalar_t>(dot_row<scalar_t, acc_t>(
+            grad_row, weight_data + weight_stride0 * indices_data[i], ddim));
+      }
+    }
+  });
+}
+
+void embedding_bag_per_sample_weights_backward_kernel(
+    Tensor& output,
+    const Tensor& grad,
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(at::ScalarType::Half, at::ScalarType::BFloat16,
+      grad.scalar_type(), "embedding_bag_per_sample_weights_backward_cpu", [&] {
+    embedding_bag_per_sample_weights_backward_kernel_impl<scalar_t>(
+        output, grad, weight, indices, offsets);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(embedding_bag_stub, &embedding_bag_kernel);
+REGISTER_DISPATCH(embedding_bag_backward_stub, &embedding_bag_backward_kernel);
+REGISTER_DISPATCH(embedding_bag_max_backward_stub, &embedding_bag_max_backward_kernel);
+REGISTER_DISPATCH(embedding_bag_sparse_backward_stub, &embedding_bag_sparse_backward_kernel);
+REGISTER_DISPATCH(embedding_bag_per_sample_weights_backward_stub, &embedding_bag_per_sample_weights_backward_kernel);
+
+}} // at::native
@@ -5,10 +5,176 @@
 #include <ATen/native/Sorting.h>
 #include <ATen/native/SortingUtils.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace at { namespace native {
 
 namespace {
 
+// Comparators over (value, index) pairs. NaN is treated as the largest value
+// for numpy compatibility: last in ascending order, first in descending order.
+template <typename scalar_t>
+struct KeyValueCompAsc {
+  template <typename elem_t>
+  bool operator()(const elem_t& x, const elem_t& y) const {
+    return (!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first);
+  }
+};
+
+template <typename scalar_t>
+struct KeyValueCompDesc {
+  template <typename elem_t>
+  bool operator()(const elem_t& x, const elem_t& y) const {
+    return (_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first);
+  }
+};
+
+// Slices shorter than this are always sorted by a single thread.
+constexpr int64_t PARALLEL_SORT_MIN_SIZE = 4 * at::internal::GRAIN_SIZE;
+
+// Sorts `data` in place. Long inputs are split into one run per thread, the
+// runs are sorted concurrently and then merged pairwise in log2(#runs)
+// parallel rounds.
+template <typename elem_t, typename Comp>
+void parallel_sort(elem_t* data, int64_t n, const Comp& comp) {
+  const int64_t num_runs = (n < PARALLEL_SORT_MIN_SIZE || at::in_parallel_region())
+      ? 1
+      : std::min<int64_t>(at::get_num_threads(), n / at::internal::GRAIN_SIZE);
+  if (num_runs <= 1) {
+    std::sort(data, data + n, comp);
+    return;
+  }
+  std::vector<int64_t> bounds(num_runs + 1);
+  for (int64_t r = 0; r <= num_runs; ++r) {
+    bounds[r] = n * r / num_runs;
+  }
+  at::parallel_for(0, num_runs, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; ++r) {
+      std::sort(data + bounds[r], data + bounds[r + 1], comp);
+    }
+  });
+  for (int64_t width = 1; width < num_runs; width *= 2) {
+    at::parallel_for(0, divup(num_runs, 2 * width), 1, [&](int64_t begin, int64_t end) {
+      for (int64_t m = begin; m < end; ++m) {
+        const int64_t lo = bounds[2 * m * width];
+        const int64_t mid = bounds[std::min(2 * m * width + width, num_runs)];
+        const int64_t hi = bounds[std::min(2 * m * width + 2 * width, num_runs)];
+        if (mid < hi) {
+          std::inplace_merge(data + lo, data + mid, data + hi, comp);
+        }
+      }
+    });
+  }
+}
+
+// Calls f(self_ptr, values_ptr, indices_ptr) for every 1-d slice of `self`,
+// `values` and `indices` along `dim`; the three tensors agree in every other
+// dimension. Slices are distributed over threads when there are enough of
+// them; otherwise they are visited in order on the calling thread, which
+// leaves f free to parallelize within a slice.
+template <typename scalar_t, typename Fn>
+void sort_apply(
+    const Tensor& self,
+    Tensor& values,
+    Tensor& indices,
+    int64_t dim,
+    const Fn& f) {
+  const int64_t dim_size = self.size(dim);
+  if (self.numel() == 0) {
+    return;
+  }
+  const int64_t num_slices = self.numel() / dim_size;
+  std::vector<int64_t> sizes, self_strides, values_strides, indices_strides;
+  for (int64_t d = self.dim() - 1; d >= 0; --d) {
+    if (d != dim) {
+      sizes.push_back(self.size(d));
+      self_strides.push_back(self.stride(d));
+      values_strides.push_back(values.stride(d));
+      indices_strides.push_back(indices.stride(d));
+    }
+  }
+  const scalar_t* self_data = self.data_ptr<scalar_t>();
+  scalar_t* values_data = values.data_ptr<scalar_t>();
+  int64_t* indices_data = indices.data_ptr<int64_t>();
+
+  auto visit = [&](int64_t begin, int64_t end) {
+    for (int64_t slice = begin; slice < end; ++slice) {
+      int64_t self_offset = 0;
+      int64_t values_offset = 0;
+      int64_t indices_offset = 0;
+      int64_t linear = slice;
+      for (size_t d = 0; d < sizes.size(); ++d) {
+        const int64_t i = linear % sizes[d];
+        linear /= sizes[d];
+        self_offset += i * self_strides[d];
+        values_offset += i * values_strides[d];
+        indices_offset += i * indices_strides[d];
+      }
+      f(self_data + self_offset,
+        values_data + values_offset,
+        indices_data + indices_offset);
+    }
+  };
+  if (num_slices >= at::get_num_threads() || dim_size < PARALLEL_SORT_MIN_SIZE) {
+    at::parallel_for(
+        0,
+        num_slices,
+        std::max<int64_t>(1, at::internal::GRAIN_SIZE / dim_size),
+        visit);
+  } else {
+    visit(0, num_slices);
+  }
+}
+
+static void sort_kernel(
+    Tensor& values,
+    Tensor& indices,
+    int64_t dim,
+    bool descending) {
+  AT_DISPATCH_ALL_TYPES(values.scalar_type(), "sort_cpu", [&] {
+    const int64_t n = values.size(dim);
+    const int64_t values_stride = values.stride(dim);
+    const int64_t indices_stride = indices.stride(dim);
+    using elem_t = std::pair<scalar_t, int64_t>;
+    // values already holds a copy of the input, so it is sorted in place
+    sort_apply<scalar_t>(
+        values,
+        values,
+        indices,
+        dim,
+        [&](const scalar_t* /*self_ptr*/, scalar_t* values_ptr, int64_t* indices_ptr) {
+          std::vector<elem_t> queue(n);
+          for (int64_t j = 0; j < n; j++) {
+            queue[j].first = values_ptr[j * values_stride];
+            queue[j].second = j;
+          }
+          if (descending) {
+            parallel_sort(queue.data(), n, KeyValueCompDesc<scalar_t>());
+          } else {
+            parallel_sort(queue.data(), n, KeyValueCompAsc<scalar_t>());
+          }
+          for (int64_t j = 0; j < n; j++) {
+            values_ptr[j * values_stride] = queue[j].first;
+            indices_ptr[j * indices_stride] = queue[j].second;
+          }
+        });
+  });
+}
+
+template <typename scalar_t, typename Comp>
+void topk_slice(std::vector<std::pair<scalar_t, int64_t>>& queue, int64_t k, bool sorted, const Comp& comp) {
+  const int64_t n = queue.size();
+  if (k * 64 <= n) {
+    std::partial_sort(queue.begin(), queue.begin() + k, queue.end(), comp);
+  } else if (k > 0) {
+    std::nth_element(queue.begin(), queue.begin() + k - 1, queue.end(), comp);
+    if (sorted) {
+      parallel_sort(queue.data(), k - 1, comp);
+    }
+  }
+}
+
 static void topk_kernel(
     Tensor& values,
     Tensor& indices,
@@ -18,66 +184,33 @@ static void topk_kernel(
     bool largest,
     bool sorted) {
   AT_DISPATCH_ALL_TYPES(self.scalar_type(), "topk_cpu", [&] {
-    dim_apply(
-        {self, values, indices},
+    const int64_t n = self.size(dim);
+    const int64_t self_stride = self.stride(dim);
+    const int64_t values_stride = values.stride(dim);
+    const int64_t indices_stride = indices.stride(dim);
+    using elem_t = std::pair<scalar_t, int64_t>;
+    sort_apply<scalar_t>(
+        self,
+        values,
+        indices,
         dim,
-        [&](int64_t i, TensorList tl) {
-          auto tmp_values = tl[0].accessor<scalar_t, 1>();
-          auto mode_values = tl[1].accessor<scalar_t, 1>();
-          auto mode_indices = tl[2].accessor<int64_t, 1>();
-
-          auto n = tmp_values.size(0);
-          auto use_partial_sort = k * 64 <= n;
-
-          using elem_t = std::pair<scalar_t, int64_t>;
+        [&](const scalar_t* self_ptr, scalar_t* values_ptr, int64_t* indices_ptr) {
           std::vector<elem_t> queue(n);
           for (int64_t j = 0; j < n; j++) {
-            queue[j].first = tmp_values[j];
+            queue[j].first = self_ptr[j * self_stride];
             queue[j].second = j;
           }
 
           // we want NaN to be sorted as top for numpy compatibility
-          if (use_partial_sort) {
-            if (largest) {
-              std::partial_sort(queue.begin(), queue.begin() + k, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                });
-            } else {
-              std::partial_sort(queue.begin(), queue.begin() + k, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                });
-            }
+          if (largest) {
+            topk_slice(queue, k, sorted, KeyValueCompDesc<scalar_t>());
           } else {
-            if (largest) {
-              std::nth_element(queue.begin(), queue.begin() + k - 1, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                });
-              if (sorted) {
-                std::sort(queue.begin(), queue.begin() + k - 1,
-                  [](const elem_t& x, const elem_t& y) -> bool {
-                    return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                  });
-              }
-            } else {
-              std::nth_element(queue.begin(), queue.begin() + k -1, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                });
-              if (sorted) {
-                std::sort(queue.begin(), queue.begin() + k -1,
-                  [](const elem_t& x, const elem_t& y) -> bool {
-                    return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                  });
-              }
-            }
+            topk_slice(queue, k, sorted, KeyValueCompAsc<scalar_t>());
           }
 
           for (int64_t j = 0; j < k; j++) {
-            mode_values[j] = queue[j].first;
-            mode_indices[j] = queue[j].second;
+            values_ptr[j * values_stride] = queue[j].first;
+            indices_ptr[j * indices_stride] = queue[j].second;
           }
         });
   });
@@ -85,6 +218,7 @@ static void topk_kernel(
 
 } // anonymous namespace
 
+REGISTER_DISPATCH(sort_stub, &sort_kernel);
 REGISTER_DISPATCH(topk_stub, &topk_kernel);
 
 }} //at::native
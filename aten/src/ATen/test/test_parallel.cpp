@@ -4,9 +4,13 @@
 #include <ATen/DLConvertor.h>
 #include <ATen/Parallel.h>
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <string.h>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 using namespace at;
 
@@ -36,6 +40,116 @@ TEST(TestParallel, NestedParallel) {
   });
 }
 
+#if AT_PARALLEL_NATIVE
+TEST(TestParallel, CooperativeNestedParallel) {
+  at::set_nested_parallelism(true);
+  const int64_t outer = 16;
+  const int64_t inner = 1000;
+  std::vector<std::atomic<int>> visits(outer * inner);
+  for (auto& v : visits) {
+    v = 0;
+  }
+  std::atomic<int> errors{0};
+  at::parallel_for(0, outer, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int thread_num = at::get_thread_num();
+      at::parallel_for(0, inner, 1, [&](int64_t inner_begin, int64_t inner_end) {
+        for (int64_t j = inner_begin; j < inner_end; ++j) {
+          visits[i * inner + j]++;
+        }
+      });
+      // the outer region's state is restored after the nested one
+      if (at::get_thread_num() != thread_num || !at::in_parallel_region()) {
+        errors++;
+      }
+    }
+  });
+  at::set_nested_parallelism(false);
+  ASSERT_EQ(errors.load(), 0);
+  ASSERT_FALSE(at::in_parallel_region());
+  for (auto& v : visits) {
+    ASSERT_EQ(v.load(), 1);
+  }
+}
+#elif AT_PARALLEL_OPENMP
+TEST(TestParallel, NestedParallelOpenMP) {
+  // OpenMP rejects cooperative nested parallelism, and keeps running nested
+  // regions serially on the calling thread
+  ASSERT_THROW(at::set_nested_parallelism(true), c10::Error);
+  ASSERT_FALSE(at::get_nested_parallelism());
+  const int64_t outer = 16;
+  const int64_t inner = 1000;
+  std::vector<std::atomic<int>> visits(outer * inner);
+  for (auto& v : visits) {
+    v = 0;
+  }
+  std::atomic<int> errors{0};
+  at::parallel_for(0, outer, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int thread_num = at::get_thread_num();
+      bool in_parallel = at::in_parallel_region();
+      at::parallel_for(0, inner, 1, [&](int64_t inner_begin, int64_t inner_end) {
+        // a nested region inside an active one isn't split
+        if (in_parallel &&
+            (inner_begin != 0 || inner_end != inner ||
+             at::get_thread_num() != thread_num)) {
+          errors++;
+        }
+        for (int64_t j = inner_begin; j < inner_end; ++j) {
+          visits[i * inner + j]++;
+        }
+      });
+      if (at::get_thread_num() != thread_num ||
+          at::in_parallel_region() != in_parallel) {
+        errors++;
+      }
+    }
+  });
+  ASSERT_EQ(errors.load(), 0);
+  ASSERT_FALSE(at::in_parallel_region());
+  for (auto& v : visits) {
+    ASSERT_EQ(v.load(), 1);
+  }
+}
+#endif
+
+TEST(TestParallel, ImbalancedWork) {
+  // every index is visited exactly once, however the range gets split
+  const int64_t n = 10000;
+  std::vector<std::atomic<int>> visits(n);
+  for (auto& v : visits) {
+    v = 0;
+  }
+  at::parallel_for(0, n, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      if (i % 100 == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      visits[i]++;
+    }
+  });
+  for (auto& v : visits) {
+    ASSERT_EQ(v.load(), 1);
+  }
+
+  auto sum = [&]() {
+    return at::parallel_reduce(
+        0, n, 1, 0.0,
+        [](int64_t begin, int64_t end, double ident) {
+          double partial = ident;
+          for (int64_t i = begin; i < end; ++i) {
+            partial += 1.0 / (i + 1);
+          }
+          return partial;
+        },
+        [](double a, double b) { return a + b; });
+  };
+  const double expected = sum();
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(sum(), expected);
+  }
+}
+
 TEST(TestParallel, Exceptions) {
   // parallel case
   ASSERT_THROW(
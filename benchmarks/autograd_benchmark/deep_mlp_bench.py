@@ -0,0 +1,50 @@
+import argparse
+import timeit
+
+import torch
+
+
+def build_mlp(depth, width):
+    layers = []
+    for _ in range(depth):
+        layers.append(torch.nn.Linear(width, width))
+        layers.append(torch.nn.ReLU())
+    return torch.nn.Sequential(*layers)
+
+
+def run_deep_mlp_benchmark(args):
+    """
+    Time the backward pass of a deep MLP made of tiny layers. Each layer only
+    does a few microseconds of math, so the measured latency is dominated by
+    the autograd engine itself (ready queue, graph bookkeeping), which makes
+    this useful for evaluating changes to the engine.
+    """
+    torch.manual_seed(0)
+    model = build_mlp(args.depth, args.width)
+    x = torch.randn(args.batch_size, args.width, requires_grad=True)
+
+    def step():
+        model(x).sum().backward()
+
+    for _ in range(args.warmup):
+        step()
+    latencies = timeit.repeat(step, repeat=args.iters, number=1)
+    latencies = torch.tensor(latencies, dtype=torch.double) * 1e6
+    print("depth: {} width: {}".format(args.depth, args.width))
+    print("Iters: {} Backward latency (us): median {:.1f} mean {:.1f} min {:.1f}".format(
+        args.iters, latencies.median().item(), latencies.mean().item(),
+        latencies.min().item()))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Deep MLP backward benchmark")
+    parser.add_argument('--depth', type=int, default=500)
+    parser.add_argument('--width', type=int, default=16)
+    parser.add_argument('--batch-size', type=int, default=8)
+    parser.add_argument('--iters', type=int, default=100)
+    parser.add_argument('--warmup', type=int, default=10)
+    parser.add_argument('--num-threads', type=int, default=1,
+                        help='intra-op threads, 1 isolates engine overhead')
+    args = parser.parse_args()
+    torch.set_num_threads(args.num_threads)
+    run_deep_mlp_benchmark(args)
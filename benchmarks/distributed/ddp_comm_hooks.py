@@ -0,0 +1,126 @@
+"""
+Measures the training throughput of DistributedDataParallel with each of the
+built-in communication hooks, on a multi-process CPU Gloo process group.
+
+Every process trains the same MLP on random data, with and without gradient
+compression, and rank 0 reports iterations per second and the number of bytes
+each process sends per iteration for a bucket of the model.
+
+    python benchmarks/distributed/ddp_comm_hooks.py --world-size 4
+"""
+import argparse
+import os
+import tempfile
+import time
+
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+import torch.nn as nn
+from torch.nn.parallel import DistributedDataParallel
+
+
+def make_model(width, depth):
+    layers = []
+    for _ in range(depth):
+        layers += [nn.Linear(width, width), nn.ReLU()]
+    return nn.Sequential(*layers)
+
+
+def hooks(args):
+    return [
+        ("allreduce", None),
+        ("fp16", lambda pg: dist.FP16CompressHook(pg)),
+        ("topk {}".format(args.topk_ratio),
+         lambda pg: dist.TopKCompressHook(pg, ratio=args.topk_ratio)),
+        ("powersgd rank {}".format(args.powersgd_rank),
+         lambda pg: dist.PowerSGDHook(pg, matrix_approximation_rank=args.powersgd_rank)),
+    ]
+
+
+def bytes_per_bucket(name, numel, args):
+    """
+    Bytes one process sends for a float bucket of numel entries, counting
+    what goes into the collectives rather than what the algorithm moves.
+    """
+    if name.startswith("fp16"):
+        return numel * 2
+    if name.startswith("topk"):
+        # Values and int64 indices.
+        return max(1, int(numel * args.topk_ratio)) * (4 + 8)
+    if name.startswith("powersgd"):
+        side = int(numel ** 0.5 + 0.999999)
+        rank = min(args.powersgd_rank, side)
+        if 2 * side * rank < numel:
+            return 2 * side * rank * 4
+    return numel * 4
+
+
+def run_worker(rank, args, file_name):
+    torch.set_num_threads(args.num_threads)
+    store = dist.FileStore(file_name, args.world_size)
+    process_group = dist.ProcessGroupGloo(store, rank, args.world_size)
+
+    for name, make_hook in hooks(args):
+        torch.manual_seed(0)
+        model = DistributedDataParallel(
+            make_model(args.width, args.depth),
+            process_group=process_group,
+            bucket_cap_mb=args.bucket_cap_mb)
+        if make_hook is not None:
+            model.register_comm_hook(make_hook(process_group))
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.01)
+        input = torch.randn(args.batch_size, args.width)
+        target = torch.randn(args.batch_size, args.width)
+
+        def step():
+            optimizer.zero_grad()
+            loss = nn.functional.mse_loss(model(input), target)
+            loss.backward()
+            optimizer.step()
+
+        for _ in range(args.warmup_iters):
+            step()
+        process_group.barrier().wait()
+        start = time.time()
+        for _ in range(args.iters):
+            step()
+        process_group.barrier().wait()
+        elapsed = time.time() - start
+
+        if rank == 0:
+            bucket_numel = args.width * args.width
+            print("{:<20} {:>10.2f} iter/s {:>14} bytes per {}x{} weight".format(
+                name,
+                args.iters / elapsed,
+                bytes_per_bucket(name, bucket_numel, args),
+                args.width,
+                args.width))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--world-size", type=int, default=2)
+    parser.add_argument("--num-threads", type=int, default=1,
+                        help="intra-op threads per process")
+    parser.add_argument("--width", type=int, default=1024)
+    parser.add_argument("--depth", type=int, default=4)
+    parser.add_argument("--batch-size", type=int, default=32)
+    parser.add_argument("--bucket-cap-mb", type=float, default=25)
+    parser.add_argument("--warmup-iters", type=int, default=5)
+    parser.add_argument("--iters", type=int, default=20)
+    parser.add_argument("--topk-ratio", type=float, default=0.01)
+    parser.add_argument("--powersgd-rank", type=int, default=4)
+    args = parser.parse_args()
+
+    with tempfile.NamedTemporaryFile(delete=False) as f:
+        file_name = f.name
+    try:
+        mp.spawn(run_worker, args=(args, file_name), nprocs=args.world_size)
+    finally:
+        if os.path.exists(file_name):
+            os.remove(file_name)
+
+
+if __name__ == "__main__":
+    main()
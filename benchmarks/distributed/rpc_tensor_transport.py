@@ -0,0 +1,72 @@
+"""
+Measures how fast the ProcessGroup RPC agent moves tensors between two
+workers, by sending tensors of increasing size to the other worker and back.
+
+Rank 0 reports the round trip time and the throughput, counting the bytes of
+the tensor once in each direction. With both workers on the same host, tensors
+of at least 1MB are passed through shared memory.
+
+    python benchmarks/distributed/rpc_tensor_transport.py --max-mb 1024
+"""
+import argparse
+import os
+import tempfile
+import time
+
+import torch
+import torch.distributed.rpc as rpc
+import torch.multiprocessing as mp
+
+
+def identity(tensor):
+    return tensor
+
+
+def run_worker(rank, args, file_name):
+    torch.set_num_threads(args.num_threads)
+    options = rpc.ProcessGroupRpcBackendOptions(
+        init_method="file://{}".format(file_name))
+    rpc.init_rpc(
+        "worker{}".format(rank),
+        rank=rank,
+        world_size=2,
+        rpc_backend_options=options)
+
+    if rank == 0:
+        size = args.min_kb * 1024
+        while size <= args.max_mb * 1024 * 1024:
+            tensor = torch.ones(size, dtype=torch.uint8)
+            for _ in range(args.warmup_iters):
+                rpc.rpc_sync("worker1", identity, args=(tensor,))
+            start = time.time()
+            for _ in range(args.iters):
+                rpc.rpc_sync("worker1", identity, args=(tensor,))
+            elapsed = (time.time() - start) / args.iters
+            print("{:>12} bytes {:>10.3f} ms {:>10.2f} GB/s".format(
+                size, elapsed * 1e3, 2 * size / elapsed / 1e9))
+            size *= 4
+
+    rpc.shutdown()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--num-threads", type=int, default=1,
+                        help="intra-op threads per process")
+    parser.add_argument("--min-kb", type=int, default=1)
+    parser.add_argument("--max-mb", type=int, default=256)
+    parser.add_argument("--warmup-iters", type=int, default=2)
+    parser.add_argument("--iters", type=int, default=10)
+    args = parser.parse_args()
+
+    with tempfile.NamedTemporaryFile(delete=False) as f:
+        file_name = f.name
+    try:
+        mp.spawn(run_worker, args=(args, file_name), nprocs=2)
+    finally:
+        if os.path.exists(file_name):
+            os.remove(file_name)
+
+
+if __name__ == "__main__":
+    main()
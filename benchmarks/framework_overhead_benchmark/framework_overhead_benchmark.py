@@ -9,7 +9,8 @@ from pt_wrapper_module import WrapperModule
 """ Framework overhead benchmark script.
 Benchmark framework overhead.
 Currently supported ops: add.
-As of now runs only forward pass.
+Runs only the forward pass, unless --requires_grad is given, in which case every
+iteration also records the autograd graph and runs backward through it.
 Supports both graph mode and eager mode. In graph mode the module is traced via JIT tracing.
 Debug option prints the traced graph is graph_mode is enabled.
 Graph can be saved via save option. Saved in the directory where benchmark is run.
@@ -57,8 +58,9 @@ def benchmark_simple_fn(args, config, module_config, module_type, result):
     else:
         f_name = module_config.pt_fn.__name__ + ":Num Operands=" + str(module_config.num_params)
         graph_mode_str = "Graph mode" + ":" + str(module_config.graph_mode)
-        result_key = ','.join((f_name, graph_mode_str))
-        module = WrapperModule(module_type, module_config, args.debug, args.save)
+        requires_grad_str = "Requires grad" + ":" + str(args.requires_grad)
+        result_key = ','.join((f_name, graph_mode_str, requires_grad_str))
+        module = WrapperModule(module_type, module_config, args.debug, args.save, args.requires_grad)
         latency_per_iter_ms = benchmark_module(config, module, args.use_throughput_benchmark)
         result[result_key] = latency_per_iter_ms
 
@@ -70,6 +72,7 @@ def main():
     parser.add_argument("--debug", default=False, dest="debug", action="store_true")
     parser.add_argument("--save", default=False, dest="save", action="store_true")
     parser.add_argument("--eager_mode", default=False, dest="eager_mode", action="store_true")
+    parser.add_argument("--requires_grad", default=False, dest="requires_grad", action="store_true")
     parser.add_argument("--num_warmup_iters", type=int, default=100)
     parser.add_argument("--num_iters", type=int, default=1000)
     args = parser.parse_args()
@@ -79,6 +82,8 @@ def main():
         return
     assert not (args.benchmark_c2_net and args.use_throughput_benchmark), \
         "Benchmarking of C2 net via throughput benchmarking is not yet supported"
+    assert not (args.requires_grad and (args.benchmark_c2_net or args.use_throughput_benchmark)), \
+        "--requires_grad is only supported when benchmarking PyTorch without ThroughputBenchmark"
 
     num_warmup_iters = args.num_warmup_iters
     num_iters = args.num_iters
@@ -19,14 +19,19 @@ class WrapperModule(object):
             - Whether debug mode is enabled.
         save:
             - In graph mode, whether graph is to be saved.
+        requires_grad:
+            - Whether the inputs require grad. If so, every iteration records
+              the autograd graph and runs backward through it, which adds the
+              cost of creating and freeing autograd nodes to each op.
     """
-    def __init__(self, wrapped_type, module_config, debug, save=False):
+    def __init__(self, wrapped_type, module_config, debug, save=False, requires_grad=False):
         pt_fn = module_config.pt_fn
         self.module = wrapped_type(pt_fn)
         self.tensor_inputs = []
         self.module_name = wrapped_type.__name__
+        self.requires_grad = requires_grad
         for _ in range(module_config.num_params):
-            self.tensor_inputs.append(torch.randn(1))
+            self.tensor_inputs.append(torch.randn(1, requires_grad=requires_grad))
         if module_config.graph_mode:
             self.module = torch.jit.trace(self.module, self.tensor_inputs)
             if save:
@@ -39,6 +44,10 @@ class WrapperModule(object):
             print(self.module.code)
 
     def forward(self, niters):
+        if self.requires_grad:
+            for _ in range(niters):
+                self.module.forward(*self.tensor_inputs).sum().backward()
+            return
         with torch.no_grad():
             for _ in range(niters):
                 self.module.forward(*self.tensor_inputs)
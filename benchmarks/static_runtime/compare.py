@@ -0,0 +1,122 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+import argparse
+import time
+
+import torch
+
+""" Compares the static runtime against the GraphExecutor.
+Each model is scripted, put in eval mode and run on the same inputs by both
+executors under no_grad. Reports the mean latency per call and the number of
+nodes the static runtime dispatches to unboxed kernels.
+Example run:
+python benchmarks/static_runtime/compare.py --models resnet,bert --batch 1 --iters 1000
+"""
+
+
+class BasicBlock(torch.nn.Module):
+    def __init__(self, channels):
+        super(BasicBlock, self).__init__()
+        self.conv1 = torch.nn.Conv2d(channels, channels, 3, padding=1, bias=False)
+        self.bn1 = torch.nn.BatchNorm2d(channels)
+        self.conv2 = torch.nn.Conv2d(channels, channels, 3, padding=1, bias=False)
+        self.bn2 = torch.nn.BatchNorm2d(channels)
+
+    def forward(self, x):
+        out = torch.relu(self.bn1(self.conv1(x)))
+        out = self.bn2(self.conv2(out))
+        return torch.relu(out + x)
+
+
+class ResNetStyle(torch.nn.Module):
+    def __init__(self, channels=32, num_blocks=4, num_classes=100):
+        super(ResNetStyle, self).__init__()
+        self.stem = torch.nn.Conv2d(3, channels, 3, padding=1, bias=False)
+        self.bn = torch.nn.BatchNorm2d(channels)
+        self.blocks = torch.nn.Sequential(*[BasicBlock(channels) for _ in range(num_blocks)])
+        self.fc = torch.nn.Linear(channels, num_classes)
+
+    def forward(self, x):
+        out = torch.relu(self.bn(self.stem(x)))
+        out = torch.max_pool2d(out, 2)
+        out = self.blocks(out)
+        out = torch.adaptive_avg_pool2d(out, [1, 1])
+        return self.fc(torch.flatten(out, 1))
+
+
+class EncoderLayer(torch.nn.Module):
+    def __init__(self, hidden, heads):
+        super(EncoderLayer, self).__init__()
+        self.heads = heads
+        self.qkv = torch.nn.Linear(hidden, 3 * hidden)
+        self.proj = torch.nn.Linear(hidden, hidden)
+        self.norm1 = torch.nn.LayerNorm(hidden)
+        self.ff1 = torch.nn.Linear(hidden, 4 * hidden)
+        self.ff2 = torch.nn.Linear(4 * hidden, hidden)
+        self.norm2 = torch.nn.LayerNorm(hidden)
+
+    def forward(self, x):
+        batch, seq, hidden = x.size(0), x.size(1), x.size(2)
+        head_dim = hidden // self.heads
+        qkv = self.qkv(x).view([batch, seq, 3, self.heads, head_dim]).permute([2, 0, 3, 1, 4])
+        q, k, v = qkv[0], qkv[1], qkv[2]
+        scores = torch.softmax(torch.matmul(q, k.transpose(-2, -1)) / (head_dim ** 0.5), dim=-1)
+        attn = torch.matmul(scores, v).permute([0, 2, 1, 3]).reshape([batch, seq, hidden])
+        x = self.norm1(x + self.proj(attn))
+        return self.norm2(x + self.ff2(torch.gelu(self.ff1(x))))
+
+
+class BertStyle(torch.nn.Module):
+    def __init__(self, hidden=256, heads=4, num_layers=2):
+        super(BertStyle, self).__init__()
+        self.layers = torch.nn.Sequential(*[EncoderLayer(hidden, heads) for _ in range(num_layers)])
+
+    def forward(self, x):
+        return self.layers(x)
+
+
+MODELS = {
+    "resnet": (ResNetStyle, lambda batch: [torch.randn(batch, 3, 32, 32)]),
+    "bert": (BertStyle, lambda batch: [torch.randn(batch, 64, 256)]),
+}
+
+
+def time_per_call_us(fn, inputs, warmup, iters):
+    for _ in range(warmup):
+        fn(*inputs)
+    start = time.time()
+    for _ in range(iters):
+        fn(*inputs)
+    return (time.time() - start) / iters * 1e6
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Static runtime vs GraphExecutor")
+    parser.add_argument("--models", default="resnet,bert",
+                        help="comma separated models to run, from: " + ",".join(MODELS))
+    parser.add_argument("--batch", type=int, default=1)
+    parser.add_argument("--warmup", type=int, default=20)
+    parser.add_argument("--iters", type=int, default=200)
+    parser.add_argument("--threads", type=int, default=1,
+                        help="intra-op threads, 1 shows the framework overhead best")
+    args = parser.parse_args()
+
+    torch.set_num_threads(args.threads)
+    for name in args.models.split(","):
+        model_type, make_inputs = MODELS[name]
+        module = torch.jit.script(model_type().eval())
+        runtime = torch._C._jit_to_static_runtime(module._c)
+        inputs = make_inputs(args.batch)
+        with torch.no_grad():
+            torch.testing.assert_allclose(runtime.run(*inputs), module(*inputs))
+            graph_executor_us = time_per_call_us(module, inputs, args.warmup, args.iters)
+            static_runtime_us = time_per_call_us(runtime.run, inputs, args.warmup, args.iters)
+        print("===================================")
+        print("{}, batch {}: {} unboxed / {} boxed nodes".format(
+            name, args.batch, runtime.num_unboxed_nodes, runtime.num_boxed_nodes))
+        print("GraphExecutor,  latency per call (us): {:.1f}".format(graph_executor_us))
+        print("StaticRuntime,  latency per call (us): {:.1f}".format(static_runtime_us))
+        print("speedup: {:.2f}x".format(graph_executor_us / static_runtime_us))
+
+
+if __name__ == "__main__":
+    main()
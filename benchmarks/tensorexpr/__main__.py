@@ -4,6 +4,12 @@ from . import benchmark
 import os
 from . import tensor_engine
 
+from . import attention  # noqa: F401
+from . import broadcast  # noqa: F401
+from . import elementwise  # noqa: F401
+from . import swish  # noqa: F401
+from . import transpose  # noqa: F401
+
 # import normalization
 
 # import reduction
@@ -52,7 +58,13 @@ Works only with Python3.\n A few examples:
         "--jit_mode",
         type=str,
         default="trace",
-        help="the jit mode to use: one of {trace, none}",
+        help="a comma separated list of jit modes to use: trace, or none for eager",
+    )
+    parser.add_argument(
+        "--cpu_parallel_loops",
+        type=int,
+        default=None,
+        help="whether TensorExpr kernels may run loops on the CPU thread pool: 0 or 1",
     )
     parser.add_argument(
         "--cuda_pointwise_loop_levels",
@@ -97,6 +109,9 @@ Works only with Python3.\n A few examples:
         os.environ["MKL_NUM_THREADS"] = str(num_threads)
         os.environ["TVM_NUM_THREADS"] = str(num_threads)
         os.environ["NNC_NUM_THREADS"] = str(num_threads)
+        import torch
+
+        torch.set_num_threads(num_threads)
 
     devices = args.device.split(",")
     # accept 'gpu' as an alternative as the 'cuda' device
@@ -121,16 +136,17 @@ Works only with Python3.\n A few examples:
                 continue
 
     modes = args.mode.split(",")
+    jit_modes = args.jit_mode.split(",")
 
     tensor_engine.set_engine_mode(args.engine)
 
     def run_default_configs(bench_cls, allow_skip=True):
-        for mode, device, config in itertools.product(
-            modes, devices, bench_cls.default_configs()
+        for mode, device, config, jit_mode in itertools.product(
+            modes, devices, bench_cls.default_configs(), jit_modes
         ):
             bench = bench_cls(mode, device, *config)
             bench.output_type = args.output
-            bench.jit_mode = args.jit_mode
+            bench.jit_mode = jit_mode
             if not bench.is_supported():
                 if allow_skip:
                     continue
@@ -179,10 +195,11 @@ Works only with Python3.\n A few examples:
                             config[i] = value
                         except ValueError:
                             pass
-                    bench = bench_cls(*config)
-                    bench.jit_mode = args.jit_mode
-                    bench.output_type = args.output_type
-                    bench.run(args)
+                    for jit_mode in jit_modes:
+                        bench = bench_cls(*config)
+                        bench.jit_mode = jit_mode
+                        bench.output_type = args.output
+                        bench.run(args)
 
             if not match_class_name:
                 available_classes = ", ".join(
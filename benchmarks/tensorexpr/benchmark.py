@@ -13,6 +13,7 @@ class Benchmark(object):
         self.deterministic = False
         self.device = device
         self.output_type = "stdout"
+        self.jit_mode = "trace"
         if mode == "both":
             self.requires_grad = True
         elif mode == "fwd":
@@ -63,8 +64,9 @@ class Benchmark(object):
         if "NNC_NUM_THREADS" in os.environ:
             num_threads_str = os.environ["NNC_NUM_THREADS"]
             device += num_threads_str
-        return "%s: %s_%s_%s_%s" % (
+        return "%s_%s: %s_%s_%s_%s" % (
             self.engine.mode,
+            self.jit_mode,
             self.module(),
             self.mode,
             device,
@@ -115,7 +117,7 @@ class Benchmark(object):
             args.cuda_pointwise_loop_levels,
             args.cuda_pointwise_block_count,
             args.cuda_pointwise_block_size,
-        ):
+        ), cpu_parallel_loops_context(args.cpu_parallel_loops):
             return self.run_impl()
 
     def run_impl(self):
@@ -207,6 +209,18 @@ def cuda_pointwise_context(loop_levels, block_count, block_size):
         torch._C._jit_set_te_cuda_pointwise_block_size(old_block_size)
 
 
+@contextlib.contextmanager
+def cpu_parallel_loops_context(enabled):
+    if enabled is not None:
+        old_enabled = torch._C._jit_get_te_cpu_parallel_loops()
+        torch._C._jit_set_te_cpu_parallel_loops(bool(enabled))
+
+    yield
+
+    if enabled is not None:
+        torch._C._jit_set_te_cpu_parallel_loops(old_enabled)
+
+
 benchmark_classes = []
 
 
@@ -0,0 +1,51 @@
+from . import benchmark
+import torch
+
+
+# Adds a matrix to the transpose of another one. The innermost loop of the
+# fused kernel reads one of its operands with a stride of a whole row, which
+# is what loop tiling targets.
+class TransposeBench(benchmark.Benchmark):
+    def __init__(self, mode, device, M, N):
+        super().__init__(mode, device)
+        self.M = M
+        self.N = N
+        self.d1 = self.rand([M, N], device=device, requires_grad=self.requires_grad)
+        self.d2 = self.rand([N, M], device=device, requires_grad=self.requires_grad)
+        self.inputs = [self.d1, self.d2]
+        self.deterministic = True
+
+    def forward(self, d1, d2):
+        y = d1 + d2.t()
+        return y * y + 1.0
+
+    def reference(self):
+        return self.numpy(self.forward(self.d1, self.d2))
+
+    def config(self):
+        return [self.M, self.N]
+
+    @staticmethod
+    def module():
+        return "transpose"
+
+    def memory_workload(self):
+        if self.mode == "fwd":
+            sol_count = 2 + 1
+            algorithmic_count = 2 + 1
+        else:
+            sol_count = (2 + 1) + (1 + 2)
+            algorithmic_count = (2 + 1) + ((2 + 1) + (1 + 2))
+
+        buffer_size = self.M * self.N * 4
+        return {
+            "sol": buffer_size * sol_count,
+            "algorithmic": buffer_size * algorithmic_count,
+        }
+
+    @staticmethod
+    def default_configs():
+        return [[1 << 10, 1 << 10], [1 << 12, 1 << 12]]
+
+
+benchmark.register_benchmark_class(TransposeBench)
@@ -0,0 +1,117 @@
+#include "c10/util/Flags.h"
+#include "torch/csrc/jit/ir/irparser.h"
+#include "torch/csrc/jit/runtime/instruction.h"
+#include "torch/csrc/jit/runtime/interpreter.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+C10_DEFINE_int(iter, 1000000, "Number of loop iterations per run");
+C10_DEFINE_int(warmup_iter, 3, "Number of warmup runs");
+C10_DEFINE_int(benchmark_iter, 5, "Number of times to run benchmark");
+
+using namespace torch::jit;
+
+namespace {
+
+// A loop of cheap scalar ops, so the time goes into running instructions
+// rather than into the ops themselves. The loop body has no control flow, so
+// every iteration runs the same instructions.
+const auto graph_string = R"IR(
+  graph(%n : int, %x : int):
+    %true : bool = prim::Constant[value=1]()
+    %seven : int = prim::Constant[value=7]()
+    %mask : int = prim::Constant[value=1023]()
+    %y : int = prim::Loop(%n, %true, %x)
+      block0(%i : int, %acc : int):
+        %a : int = aten::add(%acc, %i)
+        %b : int = aten::__xor__(%a, %seven)
+        %c : int = aten::__and__(%b, %mask)
+        %d : int = aten::__or__(%c, %i)
+        %e : int = aten::__and__(%d, %mask)
+        -> (%true, %e)
+    return (%y))IR";
+
+// Number of instructions the interpreter dispatches to run [begin, end) of
+// instructions, which must have no control flow.
+size_t countDispatches(
+    const std::vector<Instruction>& instructions,
+    size_t begin,
+    size_t end) {
+  size_t dispatches = 0;
+  size_t pc = begin;
+  while (pc < end) {
+    const Instruction& inst = instructions[pc];
+    if (inst.op == LOAD_SEQ || inst.op == MOVE_SEQ || inst.op == LOADC_SEQ) {
+      pc += inst.N;
+    } else if (inst.op == OP_STORE || inst.op == OP_JF) {
+      pc += 2;
+    } else if (inst.op == JMP && inst.X > 0) {
+      pc += inst.X;
+    } else {
+      ++pc;
+    }
+    ++dispatches;
+  }
+  return dispatches;
+}
+
+void runBenchmark(const std::shared_ptr<Graph>& graph, bool superinstructions) {
+  getInterpreterSuperinstructions() = superinstructions;
+  Code code(graph, "loop");
+
+  // The loop runs its LOOP instruction up to the JMP back to it on every
+  // iteration, X instructions in all.
+  const auto& instructions = code.instructions();
+  size_t loop = 0;
+  while (instructions[loop].op != LOOP) {
+    ++loop;
+  }
+  const size_t instructions_per_iter = instructions[loop].X;
+  const size_t dispatches_per_iter = countDispatches(
+      code.run_instructions(), loop, loop + instructions_per_iter);
+
+  auto run = [&]() {
+    InterpreterState interp(code);
+    Stack stack{IValue(FLAGS_iter), IValue(0)};
+    interp.run(stack);
+  };
+  for (int i = 0; i < FLAGS_warmup_iter; ++i) {
+    run();
+  }
+
+  std::cout << (superinstructions ? "With" : "Without")
+            << " superinstructions: " << instructions_per_iter
+            << " instructions, " << dispatches_per_iter
+            << " dispatches per iteration" << std::endl;
+  typedef std::chrono::high_resolution_clock clock;
+  for (int i = 0; i < FLAGS_benchmark_iter; ++i) {
+    auto start_time = clock::now();
+    run();
+    std::chrono::duration<double> duration = clock::now() - start_time;
+    double instructions =
+        static_cast<double>(instructions_per_iter) * FLAGS_iter;
+    std::cout << "  " << duration.count() << " s, "
+              << instructions / duration.count() / 1e6
+              << " M instructions/s" << std::endl;
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cout << "Failed to parse command line flags" << std::endl;
+    return -1;
+  }
+
+  auto graph = std::make_shared<Graph>();
+  parseIR(graph_string, graph.get());
+
+  bool superinstructions = getInterpreterSuperinstructions();
+  runBenchmark(graph, false);
+  runBenchmark(graph, true);
+  getInterpreterSuperinstructions() = superinstructions;
+  return 0;
+}
@@ -94,27 +94,13 @@ void free_cpu(void* data) {
 #endif
 }
 
-// A virtual struct that is used to report C10's memory allocation and
-// deallocation status
-class C10_API MemoryAllocationReporter {
- public:
-  MemoryAllocationReporter() : allocated_(0) {}
-  void New(void* ptr, size_t nbytes);
-  void Delete(void* ptr);
-
- private:
-  std::mutex mutex_;
-  std::unordered_map<void*, size_t> size_table_;
-  size_t allocated_;
-};
-
 struct C10_API DefaultCPUAllocator final : at::Allocator {
   DefaultCPUAllocator() {}
   ~DefaultCPUAllocator() override {}
   at::DataPtr allocate(size_t nbytes) const override {
     void* data = alloc_cpu(nbytes);
     if (FLAGS_caffe2_report_cpu_memory_usage && nbytes > 0) {
-      getMemoryAllocationReporter().New(data, nbytes);
+      GetMemoryAllocationReporter().New(data, nbytes);
       return {data, data, &ReportAndDelete, at::Device(at::DeviceType::CPU)};
     }
     return {data, data, &free_cpu, at::Device(at::DeviceType::CPU)};
@@ -124,7 +110,7 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
     if (!ptr) {
       return;
     }
-    getMemoryAllocationReporter().Delete(ptr);
+    GetMemoryAllocationReporter().Delete(ptr);
     free_cpu(ptr);
   }
 
@@ -134,13 +120,6 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
     }
     return &free_cpu;
   }
-
- protected:
-  static MemoryAllocationReporter& getMemoryAllocationReporter() {
-    static MemoryAllocationReporter reporter_;
-    return reporter_;
-  }
-
 };
 
 void NoDelete(void*) {}
@@ -162,6 +141,11 @@ at::Allocator* GetDefaultCPUAllocator() {
 
 REGISTER_ALLOCATOR(DeviceType::CPU, &g_cpu_alloc);
 
+MemoryAllocationReporter& GetMemoryAllocationReporter() {
+  static MemoryAllocationReporter reporter_;
+  return reporter_;
+}
+
 void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
   std::lock_guard<std::mutex> guard(mutex_);
   size_table_[ptr] = nbytes;
@@ -180,4 +164,24 @@ void MemoryAllocationReporter::Delete(void* ptr) {
   size_table_.erase(it);
 }
 
+void MemoryAllocationReporter::CacheLookup(size_t bin_size, bool hit) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& stats = cache_stats_[bin_size];
+  if (hit) {
+    stats.hits++;
+  } else {
+    stats.misses++;
+  }
+}
+
+std::map<size_t, CacheBinStats> MemoryAllocationReporter::CacheStats() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return cache_stats_;
+}
+
+void MemoryAllocationReporter::ResetCacheStats() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  cache_stats_.clear();
+}
+
 } // namespace c10
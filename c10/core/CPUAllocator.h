@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include <c10/core/Allocator.h>
@@ -39,4 +42,35 @@ C10_API void SetCPUAllocator(at::Allocator* alloc);
 // Get the Default CPU Allocator
 C10_API at::Allocator* GetDefaultCPUAllocator();
 
+// Lookup counters of one size bin of a caching CPU allocator
+struct CacheBinStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+// A virtual struct that is used to report C10's memory allocation and
+// deallocation status. Allocators only report to it when
+// FLAGS_caffe2_report_cpu_memory_usage is set.
+class C10_API MemoryAllocationReporter {
+ public:
+  MemoryAllocationReporter() : allocated_(0) {}
+  void New(void* ptr, size_t nbytes);
+  void Delete(void* ptr);
+
+  // Records whether an allocation of a `bin_size` bytes block could be served
+  // from a caching allocator's cache.
+  void CacheLookup(size_t bin_size, bool hit);
+  // Hit/miss counters keyed by bin size
+  std::map<size_t, CacheBinStats> CacheStats();
+  void ResetCacheStats();
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<void*, size_t> size_table_;
+  size_t allocated_;
+  std::map<size_t, CacheBinStats> cache_stats_;
+};
+
+C10_API MemoryAllocationReporter& GetMemoryAllocationReporter();
+
 } // namespace c10
@@ -0,0 +1,360 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <c10/core/DeviceType.h>
+#include <c10/util/llvmMathExtras.h>
+#include <c10/util/numa.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+C10_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_cached_bytes,
+    0,
+    "Upper bound on the bytes kept cached by the caching CPU allocator, "
+    "0 means no limit");
+
+namespace c10 {
+
+namespace {
+
+// Smallest block, header included.
+constexpr int kMinBlockShift = 6;
+constexpr size_t kMinBlockSize = size_t(1) << kMinBlockShift;
+// Each power-of-two range (2^k, 2^(k+1)] is split into 2^kSubClassBits
+// equally sized classes.
+constexpr int kSubClassBits = 2;
+// Blocks larger than 2^kMaxBlockShift bytes go straight to the system.
+constexpr int kMaxBlockShift = 30;
+constexpr int kNumSizeClasses =
+    ((kMaxBlockShift - kMinBlockShift) << kSubClassBits) + 1;
+
+struct BlockHeader {
+  size_t block_size;
+  // -1 if the block is not cached.
+  int32_t size_class;
+  // Index of the arena the block belongs to.
+  int32_t arena;
+  // Whether the allocation was reported to the MemoryAllocationReporter,
+  // which must then see its deletion too, even if the flag changed since.
+  bool reported;
+};
+static_assert(
+    sizeof(BlockHeader) <= gAlignment,
+    "BlockHeader must fit into the alignment padding");
+
+// Rounds `nbytes` up to its size class. Returns the size class index, or -1
+// for blocks that are too large to be cached.
+int size_class(size_t nbytes, size_t* block_size) {
+  if (nbytes <= kMinBlockSize) {
+    *block_size = kMinBlockSize;
+    return 0;
+  }
+  // 2^shift < nbytes <= 2^(shift + 1)
+  const int shift = static_cast<int>(llvm::Log2_64(nbytes - 1));
+  if (shift >= kMaxBlockShift) {
+    *block_size = nbytes;
+    return -1;
+  }
+  const int step_shift = shift - kSubClassBits;
+  const size_t step = size_t(1) << step_shift;
+  *block_size = (nbytes + step - 1) & ~(step - 1);
+  const int sub_class =
+      static_cast<int>(*block_size >> step_shift) - (1 << kSubClassBits);
+  return ((shift - kMinBlockShift) << kSubClassBits) + sub_class;
+}
+
+// Only blocks up to this size are kept in per-thread free lists, at most
+// kMaxThreadCacheBlocks of them per size class.
+constexpr size_t kMaxThreadCacheBlockSize = size_t(1) << 20;
+constexpr size_t kMaxThreadCacheBlocks = 4;
+
+struct Arena {
+  Arena() : free_blocks(kNumSizeClasses) {}
+
+  std::mutex mutex;
+  // Cached blocks, indexed by size class.
+  std::vector<std::vector<void*>> free_blocks;
+};
+
+struct ThreadCache {
+  ThreadCache();
+  ~ThreadCache();
+
+  // Only contended by emptyCache() and the owning thread.
+  std::mutex mutex;
+  std::vector<std::vector<void*>> free_blocks;
+};
+
+enum class ThreadCacheStatus { Uninitialized, Alive, Destroyed };
+// Plain thread_local so that it can be read after the ThreadCache of an
+// exiting thread has been destroyed.
+thread_local ThreadCacheStatus thread_cache_status =
+    ThreadCacheStatus::Uninitialized;
+
+// Returns the calling thread's cache, or nullptr if it is already destroyed.
+ThreadCache* thread_cache() {
+  if (thread_cache_status == ThreadCacheStatus::Destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+BlockHeader* header_of(void* block) {
+  return static_cast<BlockHeader*>(block);
+}
+
+class CachingAllocatorState {
+ public:
+  CachingAllocatorState()
+      : arenas_(std::max(1, GetNumNUMANodes())),
+        cached_bytes_(0),
+        max_cached_bytes_(static_cast<size_t>(std::max<int64_t>(
+            0, FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes))) {}
+
+  void* allocate(size_t nbytes) {
+    size_t block_size = 0;
+    const int cls = size_class(nbytes + gAlignment, &block_size);
+    const int arena_id = current_arena();
+
+    void* block = nullptr;
+    if (cls >= 0) {
+      block = pop_thread_cache(cls);
+      if (!block) {
+        Arena& arena = arenas_[arena_id];
+        std::lock_guard<std::mutex> guard(arena.mutex);
+        auto& free_list = arena.free_blocks[cls];
+        if (!free_list.empty()) {
+          block = free_list.back();
+          free_list.pop_back();
+        }
+      }
+    }
+    const bool report = FLAGS_caffe2_report_cpu_memory_usage;
+    // Blocks too large to be cached are neither hits nor misses.
+    if (report && cls >= 0) {
+      GetMemoryAllocationReporter().CacheLookup(block_size, block != nullptr);
+    }
+    if (block) {
+      cached_bytes_ -= block_size;
+      fill(static_cast<char*>(block) + gAlignment, nbytes);
+    } else {
+      // alloc_cpu places fresh memory on the calling thread's NUMA node.
+      block = alloc_cpu(block_size);
+      auto* header = header_of(block);
+      header->block_size = block_size;
+      header->size_class = cls;
+      header->arena = arena_id;
+    }
+    header_of(block)->reported = report;
+    void* data = static_cast<char*>(block) + gAlignment;
+    if (report) {
+      GetMemoryAllocationReporter().New(data, nbytes);
+    }
+    return data;
+  }
+
+  void free(void* ptr) {
+    if (!ptr) {
+      return;
+    }
+    void* block = static_cast<char*>(ptr) - gAlignment;
+    auto* header = header_of(block);
+    if (header->reported) {
+      GetMemoryAllocationReporter().Delete(ptr);
+    }
+    const size_t block_size = header->block_size;
+    if (header->size_class < 0 || !reserve_cache_space(block_size)) {
+      free_cpu(block);
+      return;
+    }
+    if (header->arena == current_arena() && push_thread_cache(block)) {
+      return;
+    }
+    Arena& arena = arenas_[header->arena];
+    std::lock_guard<std::mutex> guard(arena.mutex);
+    arena.free_blocks[header->size_class].push_back(block);
+  }
+
+  // Moves the blocks of an exiting thread's cache to the shared arenas.
+  void flush(ThreadCache& cache) {
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    for (auto& free_list : cache.free_blocks) {
+      for (void* block : free_list) {
+        auto* header = header_of(block);
+        Arena& arena = arenas_[header->arena];
+        std::lock_guard<std::mutex> arena_guard(arena.mutex);
+        arena.free_blocks[header->size_class].push_back(block);
+      }
+      free_list.clear();
+    }
+  }
+
+  void emptyCache() {
+    std::lock_guard<std::mutex> guard(thread_caches_mutex_);
+    for (ThreadCache* cache : thread_caches_) {
+      std::lock_guard<std::mutex> cache_guard(cache->mutex);
+      release(cache->free_blocks);
+    }
+    for (Arena& arena : arenas_) {
+      std::lock_guard<std::mutex> arena_guard(arena.mutex);
+      release(arena.free_blocks);
+    }
+  }
+
+  size_t cachedBytes() const {
+    return cached_bytes_.load();
+  }
+
+  void setMaxCachedBytes(size_t max_cached_bytes) {
+    max_cached_bytes_ = max_cached_bytes;
+  }
+
+  void register_thread_cache(ThreadCache* cache) {
+    std::lock_guard<std::mutex> guard(thread_caches_mutex_);
+    thread_caches_.push_back(cache);
+  }
+
+  void unregister_thread_cache(ThreadCache* cache) {
+    std::lock_guard<std::mutex> guard(thread_caches_mutex_);
+    thread_caches_.erase(
+        std::remove(thread_caches_.begin(), thread_caches_.end(), cache),
+        thread_caches_.end());
+  }
+
+ private:
+  int current_arena() const {
+    const int node = GetCurrentNUMANode();
+    if (node < 0 || static_cast<size_t>(node) >= arenas_.size()) {
+      return 0;
+    }
+    return node;
+  }
+
+  // Accounts for a block about to be cached. Returns false if that would
+  // exceed the cap.
+  bool reserve_cache_space(size_t block_size) {
+    const size_t max_cached_bytes = max_cached_bytes_.load();
+    size_t cached = cached_bytes_.load();
+    do {
+      if (max_cached_bytes > 0 && cached + block_size > max_cached_bytes) {
+        return false;
+      }
+    } while (!cached_bytes_.compare_exchange_weak(cached, cached + block_size));
+    return true;
+  }
+
+  void* pop_thread_cache(int cls) {
+    ThreadCache* cache = thread_cache();
+    if (!cache) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(cache->mutex);
+    auto& free_list = cache->free_blocks[cls];
+    if (free_list.empty()) {
+      return nullptr;
+    }
+    void* block = free_list.back();
+    free_list.pop_back();
+    return block;
+  }
+
+  bool push_thread_cache(void* block) {
+    auto* header = header_of(block);
+    if (header->block_size > kMaxThreadCacheBlockSize) {
+      return false;
+    }
+    ThreadCache* cache = thread_cache();
+    if (!cache) {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard(cache->mutex);
+    auto& free_list = cache->free_blocks[header->size_class];
+    if (free_list.size() >= kMaxThreadCacheBlocks) {
+      return false;
+    }
+    free_list.push_back(block);
+    return true;
+  }
+
+  void release(std::vector<std::vector<void*>>& free_blocks) {
+    for (auto& free_list : free_blocks) {
+      for (void* block : free_list) {
+        cached_bytes_ -= header_of(block)->block_size;
+        free_cpu(block);
+      }
+      free_list.clear();
+    }
+  }
+
+  static void fill(void* data, size_t nbytes) {
+    if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+      memset(data, 0, nbytes);
+    } else if (FLAGS_caffe2_cpu_allocator_do_junk_fill) {
+      memset_junk(data, nbytes);
+    }
+  }
+
+  std::vector<Arena> arenas_;
+  std::atomic<size_t> cached_bytes_;
+  std::atomic<size_t> max_cached_bytes_;
+  std::mutex thread_caches_mutex_;
+  std::vector<ThreadCache*> thread_caches_;
+};
+
+// Leaked on purpose: tensors may still be freed during static destruction.
+CachingAllocatorState& state() {
+  static auto* state = new CachingAllocatorState();
+  return *state;
+}
+
+ThreadCache::ThreadCache() : free_blocks(kNumSizeClasses) {
+  thread_cache_status = ThreadCacheStatus::Alive;
+  state().register_thread_cache(this);
+}
+
+ThreadCache::~ThreadCache() {
+  state().unregister_thread_cache(this);
+  state().flush(*this);
+  thread_cache_status = ThreadCacheStatus::Destroyed;
+}
+
+void CachingDelete(void* ptr) {
+  state().free(ptr);
+}
+
+} // namespace
+
+at::DataPtr CPUCachingAllocator::allocate(size_t nbytes) const {
+  if (nbytes == 0) {
+    return {nullptr, nullptr, &CachingDelete, at::Device(at::DeviceType::CPU)};
+  }
+  void* data = state().allocate(nbytes);
+  return {data, data, &CachingDelete, at::Device(at::DeviceType::CPU)};
+}
+
+at::DeleterFnPtr CPUCachingAllocator::raw_deleter() const {
+  return &CachingDelete;
+}
+
+void CPUCachingAllocator::emptyCache() {
+  state().emptyCache();
+}
+
+size_t CPUCachingAllocator::cachedBytes() const {
+  return state().cachedBytes();
+}
+
+void CPUCachingAllocator::setMaxCachedBytes(size_t max_cached_bytes) {
+  state().setMaxCachedBytes(max_cached_bytes);
+}
+
+CPUCachingAllocator* GetCPUCachingAllocator() {
+  static CPUCachingAllocator allocator;
+  return &allocator;
+}
+
+} // namespace c10
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <c10/core/Allocator.h>
+#include <c10/core/CPUAllocator.h>
+
+C10_DECLARE_int64(caffe2_cpu_caching_allocator_max_cached_bytes);
+
+namespace c10 {
+
+// A caching allocator for CPU memory.
+//
+// Freed blocks are not returned to the system allocator but kept in
+// per-NUMA-node arenas, bucketed into size classes (four classes per power of
+// two, so at most 25% of a block is padding). An allocation is served from the
+// arena of the NUMA node the calling thread currently runs on; a freed block
+// always goes back to the arena of the node it was placed on, so reused memory
+// stays local to the threads of that node. New blocks are placed on the
+// calling thread's node (see alloc_cpu / NUMAMove).
+//
+// Every block carries a gAlignment-sized header in front of the returned
+// pointer, which keeps the returned pointer gAlignment-aligned and lets the
+// deleter find the block's size class and node without a lookup table.
+//
+// Small blocks are additionally kept in short per-thread free lists, so that
+// a thread that repeatedly allocates and frees the same shapes does not touch
+// the shared arena locks at all.
+//
+// The total number of cached bytes is capped by setMaxCachedBytes (initially
+// FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes, 0 meaning no limit);
+// blocks freed while the cache is full are returned to the system.
+// When FLAGS_caffe2_report_cpu_memory_usage is set, allocations and per size
+// class hits/misses are recorded in the MemoryAllocationReporter.
+//
+// The allocator is opt-in:
+//
+//   c10::SetCPUAllocator(c10::GetCPUCachingAllocator());
+//
+// Blocks larger than the largest size class are not cached.
+class C10_API CPUCachingAllocator final : public at::Allocator {
+ public:
+  at::DataPtr allocate(size_t nbytes) const override;
+  at::DeleterFnPtr raw_deleter() const override;
+
+  // Returns all cached blocks, including those in per-thread free lists, to
+  // the system. Blocks in use are not affected.
+  void emptyCache();
+  // Bytes currently held in the cache (not in use by any tensor)
+  size_t cachedBytes() const;
+  // Sets the cap on cached bytes; 0 means no limit. Does not evict blocks
+  // that are already cached, call emptyCache() for that.
+  void setMaxCachedBytes(size_t max_cached_bytes);
+};
+
+// Returns the process-wide caching CPU allocator.
+C10_API CPUCachingAllocator* GetCPUCachingAllocator();
+
+} // namespace c10
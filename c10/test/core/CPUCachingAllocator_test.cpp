@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace c10;
+
+TEST(CPUCachingAllocator, Alignment) {
+  auto* allocator = GetCPUCachingAllocator();
+  for (size_t nbytes : {1, 63, 64, 65, 1000, 4096, 1 << 20}) {
+    auto ptr = allocator->allocate(nbytes);
+    ASSERT_NE(ptr.get(), nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr.get()) % gAlignment, 0);
+    memset(ptr.get(), 0xff, nbytes);
+  }
+}
+
+TEST(CPUCachingAllocator, ZeroBytes) {
+  auto ptr = GetCPUCachingAllocator()->allocate(0);
+  ASSERT_EQ(ptr.get(), nullptr);
+}
+
+TEST(CPUCachingAllocator, ReusesBlocksOfSameSizeClass) {
+  auto* allocator = GetCPUCachingAllocator();
+  void* first = nullptr;
+  {
+    auto ptr = allocator->allocate(1000);
+    first = ptr.get();
+  }
+  // 1000 and 1010 bytes round up to the same size class
+  auto ptr = allocator->allocate(1010);
+  ASSERT_EQ(ptr.get(), first);
+}
+
+TEST(CPUCachingAllocator, RawAllocate) {
+  auto* allocator = GetCPUCachingAllocator();
+  void* ptr = allocator->raw_allocate(12345);
+  ASSERT_NE(ptr, nullptr);
+  memset(ptr, 0, 12345);
+  allocator->raw_deallocate(ptr);
+  void* again = allocator->raw_allocate(12345);
+  ASSERT_EQ(again, ptr);
+  allocator->raw_deallocate(again);
+}
+
+TEST(CPUCachingAllocator, FreeOnOtherThread) {
+  auto* allocator = GetCPUCachingAllocator();
+  std::vector<DataPtr> ptrs;
+  for (int i = 0; i < 64; i++) {
+    ptrs.push_back(allocator->allocate(128 * (i + 1)));
+  }
+  std::thread t([&]() { ptrs.clear(); });
+  t.join();
+  for (int i = 0; i < 64; i++) {
+    ptrs.push_back(allocator->allocate(128 * (i + 1)));
+  }
+}
+
+TEST(CPUCachingAllocator, EmptyCache) {
+  auto* allocator = GetCPUCachingAllocator();
+  allocator->emptyCache();
+  ASSERT_EQ(allocator->cachedBytes(), 0);
+  {
+    auto small = allocator->allocate(100);
+    auto large = allocator->allocate(4 << 20);
+  }
+  ASSERT_GT(allocator->cachedBytes(), 4 << 20);
+  // blocks freed by other threads are dropped as well
+  std::thread t([&]() { auto ptr = allocator->allocate(200); });
+  t.join();
+  allocator->emptyCache();
+  ASSERT_EQ(allocator->cachedBytes(), 0);
+}
+
+TEST(CPUCachingAllocator, MaxCachedBytes) {
+  auto* allocator = GetCPUCachingAllocator();
+  allocator->emptyCache();
+  allocator->setMaxCachedBytes(1 << 20);
+  {
+    auto first = allocator->allocate(600 << 10);
+    auto second = allocator->allocate(600 << 10);
+  }
+  // only one of the two blocks fits under the cap
+  ASSERT_GT(allocator->cachedBytes(), 600 << 10);
+  ASSERT_LE(allocator->cachedBytes(), 1 << 20);
+  allocator->setMaxCachedBytes(0);
+  allocator->emptyCache();
+}
+
+TEST(CPUCachingAllocator, ReportsCacheStats) {
+  auto* allocator = GetCPUCachingAllocator();
+  auto& reporter = GetMemoryAllocationReporter();
+  allocator->emptyCache();
+  reporter.ResetCacheStats();
+  FLAGS_caffe2_report_cpu_memory_usage = true;
+  for (int i = 0; i < 3; i++) {
+    auto ptr = allocator->allocate(3000);
+  }
+  FLAGS_caffe2_report_cpu_memory_usage = false;
+  auto stats = reporter.CacheStats();
+  ASSERT_EQ(stats.size(), 1);
+  ASSERT_EQ(stats.begin()->second.misses, 1);
+  ASSERT_EQ(stats.begin()->second.hits, 2);
+}
+
+TEST(CPUCachingAllocator, ReportsOnlyReportedAllocations) {
+  auto* allocator = GetCPUCachingAllocator();
+  auto& reporter = GetMemoryAllocationReporter();
+  reporter.ResetCacheStats();
+  // Allocated while not reporting, freed while reporting, and the other way
+  // around.
+  auto unreported = allocator->allocate(3000);
+  FLAGS_caffe2_report_cpu_memory_usage = true;
+  auto reported = allocator->allocate(3000);
+  unreported.clear();
+  // Too large to be cached, so not a cache miss.
+  auto uncached = allocator->allocate((size_t(1) << 30) + 1);
+  uncached.clear();
+  FLAGS_caffe2_report_cpu_memory_usage = false;
+  reported.clear();
+  auto stats = reporter.CacheStats();
+  ASSERT_EQ(stats.size(), 1);
+  ASSERT_EQ(stats.begin()->second.hits + stats.begin()->second.misses, 1);
+  allocator->emptyCache();
+}
@@ -1,5 +1,12 @@
 #include "test/cpp/jit/test_base.h"
 #include "test/cpp/jit/test_utils.h"
+#include "torch/csrc/jit/passes/bailout_graph.h"
+#include "torch/csrc/jit/passes/insert_guards.h"
+#include "torch/csrc/jit/runtime/instruction.h"
+#include "torch/csrc/jit/runtime/profiling_record.h"
+#include "torch/jit.h"
+
+#include <algorithm>
 
 namespace torch {
 namespace jit {
@@ -27,5 +34,104 @@ void testInterp() {
   ASSERT_TRUE(exactlyEqual(outputs[0], hx));
   ASSERT_TRUE(exactlyEqual(outputs[1], cx));
 }
+
+void testInterpSuperinstructions() {
+  const auto graph_string = R"IR(
+    graph(%n : int, %x : int):
+      %true : bool = prim::Constant[value=1]()
+      %zero : int = prim::Constant[value=0]()
+      %one : int = prim::Constant[value=1]()
+      %y : int = prim::Loop(%n, %true, %x)
+        block0(%i : int, %acc : int):
+          %a : int = aten::add(%acc, %i)
+          %b : int = aten::mul(%a, %i)
+          %c : bool = aten::gt(%b, %zero)
+          %d : int = prim::If(%c)
+            block0():
+              %e : int = aten::sub(%b, %one)
+              -> (%e)
+            block1():
+              -> (%a)
+          -> (%true, %d)
+      return (%y))IR";
+  auto graph = std::make_shared<Graph>();
+  parseIR(graph_string, graph.get());
+
+  int64_t expected = 3;
+  for (int64_t i = 0; i < 10; ++i) {
+    int64_t a = expected + i;
+    int64_t b = a * i;
+    expected = b > 0 ? b - 1 : a;
+  }
+
+  auto is_superinstruction = [](const Instruction& inst) {
+    return inst.op == LOAD_SEQ || inst.op == MOVE_SEQ ||
+        inst.op == LOADC_SEQ || inst.op == OP_STORE || inst.op == OP_JF;
+  };
+  bool old_superinstructions = getInterpreterSuperinstructions().exchange(true);
+  for (bool superinstructions : {true, false}) {
+    getInterpreterSuperinstructions() = superinstructions;
+    Code code(graph, "");
+    const auto& instructions = code.instructions();
+    const auto& run_instructions = code.run_instructions();
+    ASSERT_EQ(instructions.size(), run_instructions.size());
+    ASSERT_TRUE(std::none_of(
+        instructions.begin(), instructions.end(), is_superinstruction));
+    ASSERT_EQ(
+        superinstructions,
+        std::any_of(
+            run_instructions.begin(),
+            run_instructions.end(),
+            is_superinstruction));
+
+    InterpreterState interp(code);
+    Stack stack{IValue(10), IValue(3)};
+    interp.run(stack);
+    ASSERT_EQ(stack.size(), 1);
+    ASSERT_EQ(stack[0].toInt(), expected);
+  }
+  getInterpreterSuperinstructions() = old_superinstructions;
+}
+
+void testInterpFailGuard() {
+  static const auto src = R"JIT(
+  def scale(x):
+    return x * 2 + 1
+  )JIT";
+
+  auto cu = compile(src);
+  auto& fun = cu->get_function("scale");
+  auto pr = ProfilingRecord::instrumentGraph(fun.graph());
+  auto x = at::randn({2, 3}, at::kCPU);
+  auto stack = createStack({x});
+  Code profiling_code(pr->profiled_graph_, "");
+  InterpreterState profiling_interp{profiling_code};
+  profiling_interp.run(stack);
+
+  auto copy = pr->profiled_graph_->copy();
+  InsertGuards(copy);
+  InsertBailOuts(copy);
+  Code code(copy, "", /*remaining_bailout_depth=*/1);
+  ASSERT_GT(code.num_bailouts(), 0);
+
+  // A requested bailout is taken once, and its guard is restored in both the
+  // instructions and the instructions the interpreter runs.
+  auto is_fail_guard = [](const Instruction& inst) {
+    return inst.op == FAIL_GUARD;
+  };
+  code.request_bailout(0);
+  ASSERT_TRUE(std::any_of(
+      code.instructions().begin(), code.instructions().end(), is_fail_guard));
+  InterpreterState interp{code};
+  stack = createStack({x});
+  interp.run(stack);
+  ASSERT_TRUE(almostEqual(stack[0].toTensor(), x * 2 + 1));
+  ASSERT_TRUE(std::none_of(
+      code.instructions().begin(), code.instructions().end(), is_fail_guard));
+  ASSERT_TRUE(std::none_of(
+      code.run_instructions().begin(),
+      code.run_instructions().end(),
+      is_fail_guard));
+}
 } // namespace jit
 } // namespace torch
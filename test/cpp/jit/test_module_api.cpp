@@ -1,5 +1,6 @@
 #include <test/cpp/jit/test_base.h>
 #include <test/cpp/jit/test_utils.h>
+#include <torch/csrc/jit/api/batching_module.h>
 #include <torch/torch.h>
 
 namespace torch {
@@ -97,5 +98,90 @@ void testModuleParameter() {
   ASSERT_TRUE(m.hasattr("none_param2"));
 }
 
+void testBatchingModule() {
+  Module m("m");
+  m.register_parameter("w", torch::arange(3, at::kFloat), false);
+  m.define(R"(
+    def forward(self, x, y):
+      return x * self.w + y, (x + y).sum(1, keepdim=True)
+  )");
+
+  BatchingOptions options;
+  options.max_batch_size = 4;
+  options.max_latency = std::chrono::milliseconds(20);
+  BatchingModule batching(m, options);
+
+  std::vector<at::Tensor> xs;
+  std::vector<at::Tensor> ys;
+  std::vector<c10::intrusive_ptr<c10::ivalue::Future>> futures;
+  // The last request holds two examples
+  for (int64_t i = 0; i < 10; ++i) {
+    int64_t batch_size = i == 9 ? 2 : 1;
+    xs.push_back(torch::randn({batch_size, 3}));
+    ys.push_back(torch::randn({batch_size, 3}));
+    futures.push_back(batching.submit({xs.back(), ys.back()}));
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    futures[i]->wait();
+    auto output = futures[i]->value().toTuple()->elements();
+    ASSERT_EQ(output.size(), 2);
+    ASSERT_TRUE(output[0].toTensor().allclose(
+        xs[i] * torch::arange(3, at::kFloat) + ys[i]));
+    ASSERT_TRUE(
+        output[1].toTensor().allclose((xs[i] + ys[i]).sum(1, true)));
+  }
+
+  // A batch that fails sets an error on the futures of all its requests
+  auto bad = batching.submit({torch::randn({1, 4}), torch::randn({1, 4})});
+  bad->wait();
+  ASSERT_ANY_THROW(bad->value());
+
+  auto stats = batching.stats();
+  ASSERT_EQ(stats.num_requests, 11);
+  ASSERT_GE(stats.num_batches, 4);
+  ASSERT_LE(stats.avg_batch_size, 4);
+  ASSERT_GE(stats.max_latency_ms, stats.avg_latency_ms);
+  ASSERT_GE(stats.avg_latency_ms, stats.avg_queue_time_ms);
+
+  batching.resetStats();
+  ASSERT_EQ(batching.stats().num_requests, 0);
+
+  // A request whose inputs can't be concatenated with the others runs in a
+  // batch of its own, and only that one fails
+  futures.clear();
+  for (int64_t i = 0; i < 4; ++i) {
+    int64_t width = i == 1 ? 4 : 3;
+    futures.push_back(batching.submit(
+        {torch::randn({1, width}), torch::randn({1, width})}));
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    futures[i]->wait();
+    if (i == 1) {
+      ASSERT_ANY_THROW(futures[i]->value());
+    } else {
+      ASSERT_NO_THROW(futures[i]->value());
+    }
+  }
+
+  // A throwing callback neither keeps the other requests of its batch from
+  // completing nor the destructor from returning
+  {
+    BatchingModule throwing(m, options);
+    auto first = throwing.submit({torch::randn({1, 3}), torch::randn({1, 3})});
+    // Only throw from the batch, not if the batch already finished and the
+    // callback runs right here
+    const auto test_thread = std::this_thread::get_id();
+    first->addCallback([test_thread]() {
+      if (std::this_thread::get_id() != test_thread) {
+        throw std::runtime_error("callback");
+      }
+    });
+    auto second =
+        throwing.submit({torch::randn({1, 3}), torch::randn({1, 3})});
+    second->wait();
+    ASSERT_NO_THROW(second->value());
+  }
+}
+
 } // namespace jit
 } // namespace torch
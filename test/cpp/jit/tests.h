@@ -49,6 +49,8 @@ namespace jit {
   _(Profiler)                          \
   _(InsertAndEliminateRedundantGuards) \
   _(InsertBailOuts)                    \
+  _(InterpSuperinstructions)           \
+  _(InterpFailGuard)                   \
   _(PeepholeOptimize)                  \
   _(RecordFunction)                    \
   _(ThreadLocalDebugInfo)              \
@@ -59,6 +61,7 @@ namespace jit {
   _(ModuleConstant)                    \
   _(ModuleParameter)                   \
   _(ModuleDefine)                      \
+  _(BatchingModule)                    \
   _(QualifiedName)                     \
   _(ClassImport)                       \
   _(ProfiledTensorTypeHashing)         \
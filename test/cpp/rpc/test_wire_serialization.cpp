@@ -68,6 +68,57 @@ TEST(WireSerialize, CloneSparseTensors) {
   EXPECT_TRUE(v3.get(0).is_same(sparse));
 }
 
+TEST(WireSerialize, WithBuffers) {
+  auto run = [](const std::string& payload,
+                const std::vector<at::Tensor>& tensors) {
+    std::vector<char> mpayload(payload.begin(), payload.end());
+    auto ser =
+        torch::distributed::rpc::wireSerializeWithBuffers(mpayload, tensors);
+    auto deser = torch::distributed::rpc::wireDeserializeWithBuffers(
+        ser.first.data(), ser.first.size(), ser.second);
+    EXPECT_EQ(payload.size(), deser.first.size());
+    EXPECT_EQ(tensors.size(), deser.second.size());
+    if (payload.size() > 0) {
+      EXPECT_TRUE(
+          memcmp(deser.first.data(), payload.data(), payload.size()) == 0);
+    }
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      EXPECT_TRUE(torch::equal(tensors[i], deser.second[i]));
+    }
+  };
+  run("", {});
+  run("hi", {});
+  run("", {torch::randn({5, 5})});
+  run("hi", {torch::randn({5, 5})});
+  run("more", {torch::randn({5, 5}), torch::rand({10, 10})});
+}
+
+TEST(WireSerialize, WithBuffersNoCopy) {
+  constexpr size_t k1K = 1024;
+  at::Tensor big = torch::randn({k1K, k1K});
+  auto ser = torch::distributed::rpc::wireSerializeWithBuffers({}, {big});
+  // The tensor data is neither in the header nor copied into the buffer.
+  EXPECT_LT(ser.first.size(), k1K);
+  ASSERT_EQ(ser.second.size(), 1u);
+  EXPECT_EQ(ser.second[0].data_ptr(), big.data_ptr());
+
+  // Nor is it copied out of the buffer.
+  std::vector<at::Tensor> buffers = {ser.second[0].clone()};
+  auto deser = torch::distributed::rpc::wireDeserializeWithBuffers(
+      ser.first.data(), ser.first.size(), buffers);
+  EXPECT_EQ(deser.second[0].data_ptr(), buffers[0].data_ptr());
+  EXPECT_TRUE(torch::equal(big, deser.second[0]));
+
+  // Views of a small part of a large storage are still cloned.
+  at::Tensor tiny = big.select(0, 2);
+  ser = torch::distributed::rpc::wireSerializeWithBuffers({}, {tiny});
+  ASSERT_EQ(ser.second.size(), 1u);
+  EXPECT_EQ(ser.second[0].numel(), tiny.element_size() * tiny.numel());
+  deser = torch::distributed::rpc::wireDeserializeWithBuffers(
+      ser.first.data(), ser.first.size(), ser.second);
+  EXPECT_TRUE(torch::equal(tiny, deser.second[0]));
+}
+
 // Enable this once JIT Pickler supports sparse tensors.
 TEST(WireSerialize, DISABLED_Sparse) {
   at::Tensor main =
@@ -1040,6 +1040,76 @@ void testLLVMComputeMul() {
   assertAllEqual(c_vec, 42.0f);
 }
 
+void testLLVMParallelFor() {
+  KernelScope kernel_scope;
+  const int M = 32;
+  const int N = 1024;
+  Buffer a(VarHandle("a", kHandle), kFloat, {M, N});
+  VarHandle scale("scale", kFloat);
+  Tensor* c = Compute(
+      "c", {{M, "i"}, {N, "j"}}, [&](const VarHandle& i, const VarHandle& j) {
+        return Load::make(a, i * N + j, 1) * scale + cast<float>(i);
+      });
+
+  Buffer c_buf(VarHandle(c->func_var()), kFloat, {M, N});
+  LoopNest l({c});
+  std::vector<For*> loops = l.getLoopStmtsFor(c);
+  l.setParallel(loops[0]);
+  l.prepareForCodegen();
+  Stmt* s = l.root_stmt();
+
+  LLVMCodeGen cg(s, {a, scale, c_buf});
+
+  std::vector<float> a_vec(M * N, 3.0f);
+  std::vector<float> c_vec(M * N, 0.0f);
+  float scale_v = 2.0f;
+  std::vector<void*> args({a_vec.data(), &scale_v, c_vec.data()});
+  ASSERT_EQ(cg.value<int>(args), 0);
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < N; j++) {
+      ASSERT_EQ(c_vec[i * N + j], 6.0f + i);
+    }
+  }
+}
+
+void testLLVMReduceIntermediate() {
+  KernelScope kernel_scope;
+  const int M = 4;
+  const int N = 64;
+  Buffer a(VarHandle("a", kHandle), kFloat, {M, N});
+  Tensor* max = Reduce(
+      "max",
+      {{M, "i"}},
+      Maximum(kFloat),
+      [&](const std::vector<VarHandle>& v) {
+        return Load::make(a, v[0] * N + v[1], 1);
+      },
+      {{N, "j"}});
+  Tensor* c = Compute(
+      "c", {{M, "i"}, {N, "j"}}, [&](const VarHandle& i, const VarHandle& j) {
+        return Load::make(a, i * N + j, 1) - max->call(i);
+      });
+
+  // The reduction is not an output, so it is held in a temporary buffer.
+  Buffer c_buf(VarHandle(c->func_var()), kFloat, {M, N});
+  LoopNest l({c});
+  l.prepareForCodegen();
+  Stmt* s = l.root_stmt();
+
+  LLVMCodeGen cg(s, {a, c_buf});
+
+  std::vector<float> a_vec(M * N);
+  std::iota(a_vec.begin(), a_vec.end(), 0);
+  std::vector<float> c_vec(M * N, 0.0f);
+  std::vector<void*> args({a_vec.data(), c_vec.data()});
+  ASSERT_EQ(cg.value<int>(args), 0);
+  for (int i = 0; i < M; i++) {
+    for (int j = 0; j < N; j++) {
+      ASSERT_EQ(c_vec[i * N + j], j - (N - 1));
+    }
+  }
+}
+
 void testLLVMBroadcastAdd() {
   KernelScope kernel_scope;
   const int M = 32;
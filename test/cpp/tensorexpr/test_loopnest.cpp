@@ -219,6 +219,81 @@ void testExprSplitWithMask01() {
   ExpectAllNear(c_v, c_ref, 1e-5);
 }
 
+void testExprTile01() {
+  KernelScope kernel_scope;
+  const int M = 64;
+  const int N = 32;
+  Buffer a_buf("a", kFloat, {M, N});
+  Buffer b_buf("b", kFloat, {N, M});
+  Tensor* tensor = Compute(
+      "f", {{M, "m"}, {N, "n"}}, [&](const ExprHandle& m, const ExprHandle& n) {
+        return a_buf(m, n) + b_buf(n, m);
+      });
+
+  LoopNest l({tensor});
+  std::vector<For*> loops = l.getLoopStmtsFor(tensor);
+  l.setParallel(loops[0]);
+  l.tile(loops[0], loops[1], 16, 8);
+
+  // The tile loops are innermost and the loop over the rows of tiles keeps
+  // the options of the loop it was split from.
+  Stmt* stmt = l.root_stmt();
+  std::vector<For*> tiled = l.getLoopStmtsFor(tensor);
+  ASSERT_EQ(tiled.size(), 4);
+  ASSERT_TRUE(tiled[0]->loop_options().is_parallel());
+  ASSERT_FALSE(tiled[1]->loop_options().is_parallel());
+  ASSERT_EQ(dynamic_cast<const IntImm*>(tiled[2]->stop())->value(), 16);
+  ASSERT_EQ(dynamic_cast<const IntImm*>(tiled[3]->stop())->value(), 8);
+
+  PaddedBuffer<float> a_v(M, N, "a");
+  PaddedBuffer<float> b_v(N, M, "b");
+  PaddedBuffer<float> c_v(M, N, "c");
+  PaddedBuffer<float> c_ref(M, N, "c_ref");
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      a_v(m, n) = 2 * m;
+      b_v(n, m) = 3 * n + m;
+      c_ref(m, n) = a_v(m, n) + b_v(n, m);
+    }
+  }
+
+  SimpleIREvaluator(stmt, a_buf, b_buf, tensor)(a_v, b_v, c_v);
+
+  ExpectAllNear(c_v, c_ref, 1e-5);
+}
+
+void testReduceSum2D() {
+  KernelScope kernel_scope;
+  const int M = 8;
+  const int N = 17;
+  Buffer a_buf("a", kFloat, {M, N});
+  Tensor* tensor = Reduce(
+      "sum",
+      {{M, "m"}},
+      Sum(kFloat),
+      [&](const std::vector<VarHandle>& v) { return a_buf(v[0], v[1]); },
+      {{N, "n"}});
+
+  LoopNest l({tensor});
+  l.prepareForCodegen();
+  Stmt* stmt = l.root_stmt();
+
+  PaddedBuffer<float> a_v(M, N, "a");
+  PaddedBuffer<float> c_v(M, "c");
+  PaddedBuffer<float> c_ref(M, "c_ref");
+  for (int m = 0; m < M; m++) {
+    c_ref(m) = 0;
+    for (int n = 0; n < N; n++) {
+      a_v(m, n) = m * N + n;
+      c_ref(m) += a_v(m, n);
+    }
+  }
+
+  SimpleIREvaluator(stmt, a_buf, tensor)(a_v, c_v);
+
+  ExpectAllNear(c_v, c_ref, 1e-5);
+}
+
 void testScheduleBroadcastAddBuffer() {
   KernelScope kernel_scope;
   const int M = 4;
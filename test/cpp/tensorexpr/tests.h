@@ -41,6 +41,8 @@ namespace jit {
   _(ExprSimple02)                \
   _(ExprSplitWithTailNone)       \
   _(ExprSplitWithMask01)         \
+  _(ExprTile01)                  \
+  _(ReduceSum2D)                 \
   _(ScheduleBroadcastAddBuffer)  \
   _(ScheduleFunctionCall01)      \
   _(ScheduleInlineFunc01)        \
@@ -220,6 +222,8 @@ namespace jit {
   _(LLVMStoreFloat)                \
   _(LLVMSimpleMath01)              \
   _(LLVMComputeMul)                \
+  _(LLVMParallelFor)               \
+  _(LLVMReduceIntermediate)        \
   _(LLVMBroadcastAdd)              \
   _(LLVMBitwiseOps)                \
   _(LLVMDynamicShapeAdd)           \
@@ -755,9 +755,9 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
             opts = c10d.AllreduceOptions()
             pg.allreduce([t1, t3], opts)
 
-    def _test_allreduce_basics(self, fn):
+    def _test_allreduce_basics(self, fn, opts=None):
         store = c10d.FileStore(self.file_name, self.world_size)
-        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts or self.opts())
 
         # Single input tests
         tests = simple_reduce_tests(self.rank, self.world_size)
@@ -793,6 +793,118 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
     def test_allreduce_basics_cuda(self):
         self._test_allreduce_basics(lambda t: t.clone().cuda())
 
+    def test_allreduce_basics_ring(self):
+        opts = self.opts()
+        opts.ring_allreduce_min_bytes = 0
+        opts.ring_segment_bytes = 4
+        self._test_allreduce_basics(lambda t: t.clone(), opts)
+
+    def test_allreduce_ring_large(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = self.opts()
+        opts.ring_segment_bytes = 1024
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # Larger than the default ring_allreduce_min_bytes, with a number of
+        # elements that doesn't divide evenly into chunks and segments.
+        numel = 1024 * 1024 + 7
+        tensor = torch.arange(numel, dtype=torch.float64) + self.rank
+        pg.allreduce(tensor).wait()
+        expected = (torch.arange(numel, dtype=torch.float64) * self.world_size +
+                    self.world_size * (self.world_size - 1) / 2)
+        self.assertEqual(expected, tensor)
+
+    def test_allreduce_ring_segment_multiple(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = self.opts()
+        opts.ring_allreduce_min_bytes = 0
+        opts.ring_segment_bytes = 16
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # Chunks of 8 and 9 floats, the short ones being exactly two segments
+        # and the long ones needing a third, partial one.
+        numel = 34
+        tensor = torch.arange(numel, dtype=torch.float32) + self.rank
+        pg.allreduce(tensor).wait()
+        expected = (torch.arange(numel, dtype=torch.float32) * self.world_size +
+                    self.world_size * (self.world_size - 1) / 2)
+        self.assertEqual(expected, tensor)
+
+    def test_allreduce_ring_non_contiguous(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = self.opts()
+        opts.ring_allreduce_min_bytes = 0
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        # Only the first input is contiguous. The storage between the elements
+        # of the second one holds values that change the result if the
+        # reductions that work on raw pointers read it as if it were.
+        for op, expected, poison in [
+            (c10d.ReduceOp.MAX, self.world_size, 1000.0),
+            (c10d.ReduceOp.MIN, 1, -1000.0),
+            (c10d.ReduceOp.PRODUCT, math.factorial(self.world_size) ** 2, 0.0),
+        ]:
+            opts = c10d.AllreduceOptions()
+            opts.reduceOp = op
+            first = torch.full([4, 4], self.rank + 1.0)
+            second = torch.full([4, 8], poison)[:, ::2]
+            second.fill_(self.rank + 1.0)
+            pg.allreduce([first, second], opts).wait()
+            self.assertEqual(torch.full([4, 4], float(expected)), first)
+            self.assertEqual(torch.full([4, 4], float(expected)), second)
+
+    def test_reduce_scatter_checks(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        t1 = torch.zeros([1], dtype=torch.float32)
+        t2 = torch.zeros([1], dtype=torch.float64)
+        t3 = torch.zeros([2], dtype=torch.float32)
+
+        with self.assertRaisesRegex(ValueError, "requires a single-element output"):
+            pg.reduce_scatter([], [[t1] * self.world_size])
+
+        with self.assertRaisesRegex(ValueError, "requires an input tensor for every rank"):
+            pg.reduce_scatter([t1], [[t1] * (self.world_size + 1)])
+
+        with self.assertRaisesRegex(ValueError, "invalid tensor type"):
+            pg.reduce_scatter([t1], [[t2] * self.world_size])
+
+        with self.assertRaisesRegex(ValueError, "invalid tensor size"):
+            pg.reduce_scatter([t1], [[t3] * self.world_size])
+
+    def test_reduce_scatter_basics(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        for (op, expected) in [
+            (c10d.ReduceOp.SUM, lambda i: sum(r * 10 + i for r in range(self.world_size))),
+            (c10d.ReduceOp.MAX, lambda i: (self.world_size - 1) * 10 + i),
+            (c10d.ReduceOp.MIN, lambda i: i),
+        ]:
+            # Rank r contributes r * 10 + i to the output of rank i.
+            inputs = [torch.full([3, 5], float(self.rank * 10 + i))
+                      for i in range(self.world_size)]
+            output = torch.empty([3, 5])
+            opts = c10d.ReduceScatterOptions()
+            opts.reduceOp = op
+            pg.reduce_scatter([output], [inputs], opts).wait()
+            self.assertEqual(torch.full([3, 5], float(expected(self.rank))), output)
+
+    def test_allgather_base_basics(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        input = torch.full([2, 3], float(self.rank))
+        output = torch.empty([self.world_size * 2, 3])
+        pg._allgather_base(output, input).wait()
+        self.assertEqual(
+            torch.arange(self.world_size, dtype=torch.float).repeat_interleave(6).view(-1, 3),
+            output)
+
+        with self.assertRaisesRegex(ValueError, "must hold world size"):
+            pg._allgather_base(torch.empty([2, 3]), input)
+
     def _test_allreduce_stress(self, inputs):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts(threads=8))
@@ -1545,6 +1657,114 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
             del pg
 
 
+@requires_gloo()
+@unittest.skipIf(TEST_WITH_TSAN, "TSAN is not fork-safe since we're forking in a multi-threaded environment")
+class ProcessGroupGlooHierarchicalTest(MultiProcessTestCase):
+    def setUp(self):
+        super(ProcessGroupGlooHierarchicalTest, self).setUp()
+        self._fork_processes()
+
+    def _create_process_group(self, processes_per_host, buffer_bytes=None):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = c10d.ProcessGroupGlooHierarchical.Options()
+        opts.gloo.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+        opts.gloo.timeout = 5.0
+        # Simulate hosts by grouping consecutive ranks.
+        opts.host = "host%d" % (self.rank // processes_per_host)
+        if buffer_bytes is not None:
+            opts.buffer_bytes = buffer_bytes
+        return c10d.ProcessGroupGlooHierarchical(store, self.rank, self.world_size, opts)
+
+    def test_topology(self):
+        pg = self._create_process_group(processes_per_host=2)
+        self.assertEqual(2, pg.local_size())
+        self.assertEqual(self.rank % 2, pg.local_rank())
+        self.assertEqual(self.world_size // 2, pg.num_hosts())
+        self.assertEqual(self.rank // 2, pg.host_index())
+
+    def _test_allreduce_basics(self, processes_per_host):
+        pg = self._create_process_group(processes_per_host)
+
+        # Single input tests
+        tests = simple_reduce_tests(self.rank, self.world_size)
+        for (op, input, output) in tests:
+            opts = c10d.AllreduceOptions()
+            opts.reduceOp = op
+            tensor = input.clone()
+            pg.allreduce([tensor], opts).wait()
+            self.assertEqual(output, tensor)
+
+        # Multi input tests
+        tests = simple_multi_input_reduce_tests(self.rank, self.world_size)
+        for (op, inputs, output) in tests:
+            opts = c10d.AllreduceOptions()
+            opts.reduceOp = op
+            tensors = [input.clone() for input in inputs]
+            pg.allreduce(tensors, opts).wait()
+            for tensor in tensors:
+                self.assertEqual(output, tensor)
+
+    def test_allreduce_basics(self):
+        self._test_allreduce_basics(processes_per_host=2)
+
+    def test_allreduce_basics_single_host(self):
+        self._test_allreduce_basics(processes_per_host=self.world_size)
+
+    def test_allreduce_basics_single_process_per_host(self):
+        self._test_allreduce_basics(processes_per_host=1)
+
+    def test_allreduce_chunks(self):
+        # Tensors span multiple chunks of the shared memory buffer, with a
+        # partial last chunk.
+        pg = self._create_process_group(processes_per_host=2, buffer_bytes=256)
+        for numel in [1, 63, 64, 1000]:
+            tensor = torch.arange(numel, dtype=torch.float64) * (self.rank + 1)
+            pg.allreduce(tensor).wait()
+            expected = (torch.arange(numel, dtype=torch.float64) *
+                        self.world_size * (self.world_size + 1) / 2)
+            self.assertEqual(expected, tensor)
+
+    def test_fallback_ops(self):
+        pg = self._create_process_group(processes_per_host=2)
+
+        # Not contiguous, so the flat process group runs it.
+        tensor = torch.full([4, 4], float(self.rank)).t()
+        pg.allreduce(tensor).wait()
+        self.assertEqual(torch.full([4, 4], float(self.world_size * (self.world_size - 1) / 2)), tensor)
+
+        tensor = torch.full([3], float(self.rank))
+        pg.broadcast(tensor, 1).wait()
+        self.assertEqual(torch.full([3], 1.0), tensor)
+
+        pg.barrier().wait()
+
+    def test_unmapped_segment_is_unlinked(self):
+        # Rank 1 joins the flat process group but never maps the shared
+        # memory segment of its host, so the leader times out.
+        if self.rank == 1:
+            store = c10d.FileStore(self.file_name, self.world_size)
+            store.set("hierarchical/host/1", "host0")
+            opts = c10d.ProcessGroupGloo.Options()
+            opts.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+            opts.timeout = 5.0
+            c10d.ProcessGroupGloo(
+                c10d.PrefixStore("hierarchical/global", store),
+                self.rank,
+                self.world_size,
+                opts)
+            return
+
+        if self.rank != 0:
+            self._create_process_group(processes_per_host=2)
+            return
+
+        with self.assertRaisesRegex(RuntimeError, "[Tt]imeout"):
+            self._create_process_group(processes_per_host=2)
+        prefix = "torch_c10d_%d_" % os.getpid()
+        self.assertEqual(
+            [], [name for name in os.listdir("/dev/shm") if name.startswith(prefix)])
+
+
 @requires_nccl()
 class ProcessGroupNCCLTest(TestCase):
     MAIN_PROCESS_RANK = 0
@@ -1989,6 +2209,102 @@ class DistributedDataParallelTest(MultiProcessTestCase):
     def test_gloo_backend_cpu_module(self):
         self._test_gloo_backend([torch.device('cpu')], [])
 
+    def _run_ddp_comm_hook(self, make_hook):
+        """
+        Runs a backward pass of a model and of its DDP version using the hook
+        returned by `make_hook`, on a CPU Gloo process group. Returns the
+        gradients of both, the process group and the DDP model.
+        """
+        store = c10d.FileStore(self.file_name, self.world_size)
+        options = c10d.ProcessGroupGloo.Options()
+        options.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size, options)
+
+        torch.manual_seed(1337)
+        model, ddp_model, input, target = self._prepare_single_device_module(
+            process_group, [torch.device('cpu')], [], self.world_size)
+        ddp_model.register_comm_hook(make_hook(process_group))
+
+        F.mse_loss(model(input), target).backward()
+        ddp_input = input[self.rank:self.rank + 1]
+        ddp_target = target[self.rank:self.rank + 1]
+        F.mse_loss(ddp_model(ddp_input), ddp_target).backward()
+
+        grads = [p.grad for p in model.parameters()]
+        ddp_grads = [p.grad for p in ddp_model.parameters()]
+        return grads, ddp_grads, process_group, ddp_model
+
+    def _assert_same_across_processes(self, process_group, tensors):
+        for tensor in tensors:
+            total = tensor.clone()
+            process_group.allreduce([total]).wait()
+            self.assertEqual(total, tensor * self.world_size)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_fp16_compress(self):
+        grads, ddp_grads, _, _ = self._run_ddp_comm_hook(c10d.FP16CompressHook)
+        for grad, ddp_grad in zip(grads, ddp_grads):
+            self.assertEqual(grad, ddp_grad, prec=1e-3)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_topk_compress(self):
+        # Communicating all entries is exact.
+        grads, ddp_grads, _, _ = self._run_ddp_comm_hook(
+            lambda pg: c10d.TopKCompressHook(pg, ratio=1.0))
+        for grad, ddp_grad in zip(grads, ddp_grads):
+            self.assertEqual(grad, ddp_grad)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_topk_compress_sparsifies(self):
+        _, ddp_grads, process_group, _ = self._run_ddp_comm_hook(
+            lambda pg: c10d.TopKCompressHook(pg, ratio=0.1))
+        self._assert_same_across_processes(process_group, ddp_grads)
+        numel = sum(grad.numel() for grad in ddp_grads)
+        nonzero = sum(int((grad != 0).sum()) for grad in ddp_grads)
+        self.assertLess(nonzero, numel)
+
+    @requires_gloo()
+    def test_ddp_comm_hook_powersgd(self):
+        _, ddp_grads, process_group, ddp_model = self._run_ddp_comm_hook(
+            lambda pg: c10d.PowerSGDHook(pg, matrix_approximation_rank=1))
+        self._assert_same_across_processes(process_group, ddp_grads)
+        for grad in ddp_grads:
+            self.assertTrue(torch.isfinite(grad).all())
+
+        with self.assertRaisesRegex(RuntimeError, "only be registered once"):
+            ddp_model.register_comm_hook(c10d.FP16CompressHook(process_group))
+
+    @requires_gloo()
+    def test_ddp_comm_hook_powersgd_full_rank(self):
+        # With a rank as large as the matrices, the approximation is exact
+        # and leaves no error to feed back, so training with the hook has to
+        # match training with a plain allreduce, step after step.
+        store = c10d.FileStore(self.file_name, self.world_size)
+        options = c10d.ProcessGroupGloo.Options()
+        options.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size, options)
+
+        torch.manual_seed(1337)
+        model, ddp_model, input, target = self._prepare_single_device_module(
+            process_group, [torch.device('cpu')], [], self.world_size)
+        ddp_model.register_comm_hook(c10d.PowerSGDHook(
+            process_group, matrix_approximation_rank=1000, min_compression_rate=0))
+        allreduce_model = DistributedDataParallel(
+            copy.deepcopy(model), process_group=process_group, bucket_cap_mb=0.001)
+
+        ddp_input = input[self.rank:self.rank + 1]
+        ddp_target = target[self.rank:self.rank + 1]
+        for _ in range(5):
+            for m in [ddp_model, allreduce_model]:
+                F.mse_loss(m(ddp_input), ddp_target).backward()
+                with torch.no_grad():
+                    for param in m.parameters():
+                        param -= 0.1 * param.grad
+                        param.grad = None
+            for param, allreduce_param in zip(
+                    ddp_model.parameters(), allreduce_model.parameters()):
+                self.assertEqual(param, allreduce_param, prec=1e-4)
+
     @requires_gloo()
     @skip_if_not_multigpu
     def test_gloo_backend_1gpu_module_device_ids_integer_list(self):
@@ -3067,6 +3383,40 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def test_rebuild_buckets(self):
+        batch_size = 10
+        model = ReducerModule()
+        parameters = list(model.parameters())
+        # Buckets in the order the parameters are defined, the reverse of the
+        # order in which their gradients are ready.
+        reducer = dist.Reducer(
+            [parameters], [[i] for i in range(len(parameters))], self.process_group)
+        loss = nn.CrossEntropyLoss()
+
+        def step():
+            input = torch.rand([batch_size, 2])
+            target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+            output = loss(model(input), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+
+        # Nothing to rebuild from before the first backward pass.
+        self.assertFalse(reducer.rebuild_buckets([1]))
+        step()
+        self.assertEqual([[0], [1], [2]], reducer.get_bucket_indices())
+
+        # With a 1 byte limit every parameter gets its own bucket again, but
+        # the buckets are now in the order gradients were ready.
+        self.assertTrue(reducer.rebuild_buckets([1]))
+        self.assertEqual([[2], [1], [0]], reducer.get_bucket_indices())
+        self.assertFalse(reducer.rebuild_buckets([1]))
+
+        step()
+        stats = reducer.get_bucket_stats()
+        self.assertEqual(3, len(stats))
+        for ready_time, launch_time in stats:
+            self.assertGreaterEqual(launch_time, ready_time)
+
 
 class ComputeBucketAssignmentTest(TestCase):
     def test_single_limit_single_dtype(self):
@@ -6002,6 +6002,49 @@ class TestMultithreadAutograd(TestCase):
         self._run_py_multithread_fn(train_fn_grad, (x,))
 
 
+    def test_parallel_cpu_backward(self):
+        # independent branches may run on CPU workers, results must not change
+        def wide_backward(num_branches, reentrant):
+            torch.manual_seed(0)
+            x = torch.randn(32, 32, requires_grad=True)
+            ws = [torch.randn(32, 32, requires_grad=True) for _ in range(num_branches)]
+            outs = []
+            for i, w in enumerate(ws):
+                y = torch.tanh(x.mm(w))
+                if reentrant and i % 4 == 0:
+                    y = checkpoint(lambda t: t.sigmoid() * 2, y)
+                outs.append(y.sum())
+            torch.stack(outs).sum().backward()
+            return [x.grad] + [w.grad for w in ws]
+
+        prev = torch.autograd._get_num_cpu_workers()
+        try:
+            for reentrant in [False, True]:
+                torch.autograd._set_num_cpu_workers(0)
+                expected = wide_backward(64, reentrant)
+                torch.autograd._set_num_cpu_workers(4)
+                for _ in range(3):
+                    actual = wide_backward(64, reentrant)
+                    for a, e in zip(actual, expected):
+                        self.assertEqual(a, e)
+
+            # errors are reported to the calling thread
+            class Fail(Function):
+                @staticmethod
+                def forward(ctx, x):
+                    return x.clone()
+
+                @staticmethod
+                def backward(ctx, grad):
+                    raise RuntimeError("branch failed")
+
+            x = torch.randn(4, requires_grad=True)
+            outs = [(x * i).sum() for i in range(16)] + [Fail.apply(x).sum()]
+            with self.assertRaisesRegex(RuntimeError, "branch failed"):
+                torch.stack(outs).sum().backward()
+        finally:
+            torch.autograd._set_num_cpu_workers(prev)
+
     def test_python_thread_in_middle(self):
         # User might write a network that starts on one CPU thread, then runs its second half
         # concurrently with other threads (either via python threading or fork/join calls),
@@ -2547,6 +2547,91 @@ graph(%Ra, %Rb):
         torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
         FileCheck().check("Double(4, 3, 8, 5)").run(str(graph))
 
+    def test_plan_memory(self):
+        def fn(x, y):
+            a = torch.mm(x, y)
+            b = a + x
+            c = torch.mm(b, y)
+            d = c * b
+            e = torch.mm(d, y)
+            return e + 1
+
+        x = torch.randn(8, 8)
+        y = torch.randn(8, 8)
+
+        graph = torch.jit.script(fn).graph
+        torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
+        stats = torch._C._jit_pass_plan_memory(graph)
+        self.assertEqual(stats["planned_values"], 5)
+        self.assertLess(stats["arena_bytes"], stats["unplanned_bytes"])
+        FileCheck().check_count("prim::MemoryPlanArena", 1, exactly=True) \
+            .check_count("prim::PlannedTensor", 5, exactly=True).run(str(graph))
+
+        planned = torch._C._create_function_from_graph("forward", graph)
+        with torch.no_grad():
+            for _ in range(3):
+                self.assertEqual(planned(x, y), fn(x, y))
+
+    def test_static_runtime(self):
+        class Block(torch.nn.Module):
+            def __init__(self):
+                super(Block, self).__init__()
+                self.linear = torch.nn.Linear(16, 16)
+                self.norm = torch.nn.LayerNorm(16)
+
+            def forward(self, x, y):
+                h = torch.relu(self.linear(x)) + y
+                return self.norm(torch.softmax(h, dim=-1) * h), h.t()
+
+        block = Block().eval()
+        runtime = torch._C._jit_to_static_runtime(torch.jit.script(block)._c)
+        self.assertGreater(runtime.num_unboxed_nodes, 0)
+        with torch.no_grad():
+            for batch in [4, 4, 7]:
+                x = torch.randn(batch, 16)
+                y = torch.randn(batch, 16)
+                # outputs of a previous run must not be overwritten
+                outputs = runtime.run(x, y)
+                self.assertEqual(outputs, block(x, y))
+                runtime.run(x + 1, y)
+                self.assertEqual(outputs, block(x, y))
+
+        def branch(x):
+            if bool(x.sum() > 0):
+                return x + 1
+            return x - 1
+
+        with self.assertRaisesRegex(RuntimeError, "without control flow"):
+            torch._C._jit_to_static_runtime(torch.jit.script(branch).graph)
+
+    def test_static_runtime_plan_memory(self):
+        def fn(x, y):
+            a = torch.mm(x, y)
+            b = a + x
+            c = torch.mm(b, y)
+            d = c * b
+            return torch.mm(d, y) + 1
+
+        x = torch.randn(8, 8)
+        y = torch.randn(8, 8)
+        graph = torch.jit.script(fn).graph
+        torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
+
+        runtime = torch._C._jit_to_static_runtime(graph, plan_memory=True)
+        self.assertGreater(runtime.arena_bytes, 0)
+        FileCheck().check("prim::MemoryPlanArena").check("prim::PlannedTensor") \
+            .run(str(runtime.graph))
+        self.assertEqual(torch._C._jit_to_static_runtime(graph).arena_bytes, 0)
+        with torch.no_grad():
+            outputs = runtime.run(x, y)
+            for _ in range(3):
+                self.assertEqual(runtime.run(x + 1, y), fn(x + 1, y))
+            # the output never lives in the arena
+            self.assertEqual(outputs, fn(x, y))
+
+            with self.assertRaises(RuntimeError):
+                runtime.run(torch.randn(16, 8), y)
+
     # TODO: update verify to work with GraphExecutors
     @unittest.skip("verify needs to be updated to work with GraphExecutors")
     def test_verify(self):
@@ -3,13 +3,19 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import ast
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
 import unittest
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
 from torch.testing import FileCheck
 
-from torch.testing._internal.common_utils import run_tests, IS_SANDCASTLE, ProfilingMode, GRAPH_EXECUTOR, \
+from torch.testing._internal.common_utils import run_tests, IS_SANDCASTLE, IS_WINDOWS, ProfilingMode, GRAPH_EXECUTOR, \
     enable_profiling_mode
 from textwrap import dedent
 from itertools import product, permutations
@@ -80,6 +86,75 @@ class TestFuser(JitTestCase):
     def test_abs_cuda(self):
         self._test_fused_abs(device="cuda")
 
+    def _kernel_disk_cache_stats(self, openmp=True, enabled=True):
+        # Kernels are compiled once per process, so the cache only shows
+        # across processes. Runs a fused function in two processes sharing a
+        # cache and returns the cache stats of both, and the cache directory.
+        # Without openmp, the compiler fails with -fopenmp, after which the
+        # fuser compiles without it.
+        script = dedent("""
+            import torch
+            torch._C._jit_override_can_fuse_on_cpu(True)
+
+            @torch.jit.script
+            def fn(x, y):
+                return (x * y + x).sigmoid() * 3
+
+            x = torch.randn(4, 4)
+            for _ in range(5):
+                fn(x, x)
+            print(torch._C._jit_fuser_cache_stats())
+        """)
+        tmp_dir = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, tmp_dir)
+        cache_dir = os.path.join(tmp_dir, "cache")
+        env = dict(os.environ)
+        env.pop("PYTORCH_FUSER_CACHE_DIR", None)
+        if enabled:
+            env["PYTORCH_FUSER_CACHE_DIR"] = cache_dir
+        if not openmp:
+            cxx = os.path.join(tmp_dir, "cxx_without_openmp")
+            with open(cxx, "w") as f:
+                f.write(dedent("""\
+                    #!/bin/sh
+                    case "$*" in *-fopenmp*) exit 1;; esac
+                    exec {} "$@"
+                """.format(os.environ.get("CXX", "g++"))))
+            os.chmod(cxx, 0o755)
+            env["CXX"] = cxx
+        first, second = [
+            ast.literal_eval(subprocess.check_output(
+                [sys.executable, "-c", script], env=env, stderr=subprocess.DEVNULL).decode())
+            for _ in range(2)]
+        return first, second, cache_dir
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @unittest.skipIf(IS_WINDOWS, "the fuser kernel cache is not supported on Windows")
+    def test_kernel_disk_cache_cpu(self):
+        first, second, cache_dir = self._kernel_disk_cache_stats()
+        self.assertGreater(first["misses"], 0)
+        self.assertEqual(first["hits"], 0)
+        self.assertEqual(first["stores"], first["misses"])
+        self.assertEqual(second["hits"], first["misses"])
+        self.assertEqual(second["misses"], 0)
+        self.assertTrue(any(name.endswith(".so") for name in os.listdir(cache_dir)))
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @unittest.skipIf(IS_WINDOWS, "the fuser kernel cache is not supported on Windows")
+    def test_kernel_disk_cache_without_openmp_cpu(self):
+        # The next process must still find the kernel compiled without OpenMP.
+        first, second, _ = self._kernel_disk_cache_stats(openmp=False)
+        self.assertGreater(first["stores"], 0)
+        self.assertEqual(second["hits"], first["misses"])
+        self.assertEqual(second["misses"], 0)
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @unittest.skipIf(IS_WINDOWS, "the fuser kernel cache is not supported on Windows")
+    def test_kernel_disk_cache_disabled_by_default_cpu(self):
+        first, second, _ = self._kernel_disk_cache_stats(enabled=False)
+        for stats in (first, second):
+            self.assertEqual(stats, {"hits": 0, "misses": 0, "stores": 0, "evictions": 0})
+
     @unittest.skipIf(not RUN_CUDA, "requires CUDA")
     def test_zero_element_tensors(self):
         def decode(sin_t, cos_t):
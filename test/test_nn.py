@@ -48,7 +48,7 @@ from torch.testing._internal.common_nn import NNTestCase, NewModuleTest, NewCrit
     module_tests, criterion_tests, new_criterion_tests, loss_reference_fns, \
     ctcloss_reference, new_module_tests
 from torch.testing._internal.common_device_type import instantiate_device_type_tests, dtypes, \
-    dtypesIfCUDA, skipCUDAIfNoCudnn, skipCUDAIfCudnnVersionLessThan, onlyCUDA, \
+    dtypesIfCUDA, skipCUDAIfNoCudnn, skipCUDAIfCudnnVersionLessThan, onlyCUDA, onlyCPU, \
     skipCUDAIfRocm, skipCUDAIf, skipCUDAIfNotRocm, largeCUDATensorTest
 
 from torch.nn import MultiheadAttention
@@ -10064,6 +10064,47 @@ class TestNNDeviceType(NNTestCase):
         self._test_EmbeddingBag(device, 'mean', True, dtype, test_backward=test_backward)
 
 
+    @onlyCPU
+    @dtypes(torch.half, torch.bfloat16)
+    def test_embedding_bag_reduced_precision_cpu(self, device, dtype):
+        # Reduced precision tables are accumulated in float, so they should
+        # match a float computation up to the rounding of inputs and outputs.
+        num_embeddings, embedding_dim = 20, 19
+        input = torch.randint(num_embeddings, (30,), dtype=torch.long)
+        offsets = torch.tensor([0, 0, 4, 11, 11, 25], dtype=torch.long)
+        weight = torch.randn(num_embeddings, embedding_dim).to(dtype)
+        prec = 2e-2 if dtype == torch.half else 1e-1
+        for mode, sparse, include_last_offset, weighted in itertools.product(
+                ('sum', 'mean', 'max'), (False, True), (False, True), (False, True)):
+            if (weighted and mode != 'sum') or (sparse and mode == 'max'):
+                continue
+            bag_offsets = offsets
+            if include_last_offset:
+                bag_offsets = torch.cat((offsets, torch.tensor([input.numel()])))
+            per_sample_weights = torch.randn(input.numel()).to(dtype) if weighted else None
+
+            ref_weight = weight.float().requires_grad_()
+            ref_per_sample_weights = per_sample_weights.float() if weighted else None
+            expected = F.embedding_bag(input, ref_weight, bag_offsets, mode=mode, sparse=sparse,
+                                       per_sample_weights=ref_per_sample_weights,
+                                       include_last_offset=include_last_offset)
+            test_weight = weight.clone().requires_grad_()
+            result = F.embedding_bag(input, test_weight, bag_offsets, mode=mode, sparse=sparse,
+                                     per_sample_weights=per_sample_weights,
+                                     include_last_offset=include_last_offset)
+            self.assertEqual(result.dtype, dtype)
+            self.assertEqual(result.float(), expected, prec)
+
+            grad = torch.randn_like(expected)
+            expected.backward(grad)
+            result.backward(grad.to(dtype))
+            expected_grad, test_grad = ref_weight.grad, test_weight.grad
+            if sparse:
+                expected_grad = expected_grad.to_dense()
+                test_grad = torch.sparse_coo_tensor(
+                    test_grad._indices(), test_grad._values().float(), test_grad.size()).to_dense()
+            self.assertEqual(test_grad.float(), expected_grad, prec)
+
     @onlyCUDA
     @skipCUDAIfNotRocm
     def test_embedding_bag_bfloat16(self, device):
@@ -1,9 +1,11 @@
 import contextlib
+import io
 import numpy as np
 import torch
 import torch.nn.functional as F
 import unittest
 
+from torch.testing import FileCheck
 from torch.testing._internal.common_utils import suppress_warnings
 
 from te_utils import CudaCodeGenCreated, CudaCodeGenExecuted, \
@@ -1220,5 +1222,164 @@ class TestTensorExprFuser(BaseTestClass):
         assert torch.allclose(scripted(a), 2 * a)
         assert cx.elapsed_value() == 1
 
+    def test_aot_kernels(self):
+        class M(torch.nn.Module):
+            def forward(self, x, y):
+                return (x + y) * y + x
+
+        def ref(x, y):
+            return ((x + y) * y + x).numpy()
+
+        module = torch.jit.script(M())
+        x = torch.rand(4, 16)
+        y = torch.rand(4, 16)
+        with num_profiled_runs(1):
+            try:
+                num_kernels = torch._C._jit_compile_tensorexpr_aot(module._c, "forward", [(x, y)])
+            except RuntimeError as e:
+                if "needs LLVM" in str(e) or "needs the profiling executor" in str(e):
+                    raise unittest.SkipTest(str(e))
+                raise
+            self.assertEqual(num_kernels, 1)
+            buffer = io.BytesIO()
+            torch.jit.save(module, buffer)
+            buffer.seek(0)
+
+            # Loading kernels is opt-in.
+            self.assertFalse(torch._C._jit_tensorexpr_aot_loading_enabled())
+            torch._C._jit_reset_tensorexpr_aot_stats()
+            not_linked = torch.jit.load(buffer)
+            self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["registered"], 0)
+
+            buffer.seek(0)
+            torch._C._jit_set_tensorexpr_aot_loading_enabled(True)
+            try:
+                loaded = torch.jit.load(buffer)
+            finally:
+                torch._C._jit_set_tensorexpr_aot_loading_enabled(False)
+            self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["registered"], 1)
+            for _ in range(3):
+                np.testing.assert_allclose(loaded(x, y).numpy(), ref(x, y), rtol=1e-6)
+            self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["hits"], 1)
+
+            # Kernels belong to the module they were loaded with, other
+            # modules with the same graphs don't use them.
+            for _ in range(3):
+                np.testing.assert_allclose(not_linked(x, y).numpy(), ref(x, y), rtol=1e-6)
+            self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["hits"], 1)
+
+            # Inputs of other shapes are compiled by the JIT.
+            z = torch.rand(8, 16)
+            for _ in range(3):
+                np.testing.assert_allclose(loaded(z, z).numpy(), ref(z, z), rtol=1e-6)
+            self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["hits"], 1)
+
+            # Neither are kernels compiled with other lowering options.
+            old_parallel = torch._C._jit_get_te_cpu_parallel_loops()
+            torch._C._jit_set_te_cpu_parallel_loops(not old_parallel)
+            try:
+                buffer.seek(0)
+                torch._C._jit_reset_tensorexpr_aot_stats()
+                torch._C._jit_set_tensorexpr_aot_loading_enabled(True)
+                loaded = torch.jit.load(buffer)
+                for _ in range(3):
+                    np.testing.assert_allclose(loaded(x, y).numpy(), ref(x, y), rtol=1e-6)
+                self.assertEqual(torch._C._jit_tensorexpr_aot_stats()["hits"], 0)
+            finally:
+                torch._C._jit_set_tensorexpr_aot_loading_enabled(False)
+                torch._C._jit_set_te_cpu_parallel_loops(old_parallel)
+
+    def test_reductions(self):
+        def softmax(x, y):
+            return torch.softmax(x * y, dim=-1)
+
+        def log_softmax(x, y):
+            return torch.log_softmax(x + y, dim=0)
+
+        def layer_norm(x, y):
+            return F.layer_norm(x + y, [16], y[0], y[1])
+
+        def sum_mean(x, y):
+            return (x - x.mean(1, keepdim=True)) * y.sum(0)
+
+        def bias_gelu_sum(x, y):
+            return F.gelu(x + y[0]).sum([1])
+
+        def sum_no_dims(x, y):
+            # An empty list of dims reduces over all of them.
+            return (x * y).sum([]) + (x + y).mean([], keepdim=True)
+
+        x = torch.randn(8, 16)
+        y = torch.randn(8, 16)
+        for fn, reductions in [
+            (softmax, ["aten::softmax"]),
+            (log_softmax, ["aten::log_softmax"]),
+            (layer_norm, ["aten::layer_norm"]),
+            (sum_mean, ["aten::mean", "aten::sum"]),
+            (bias_gelu_sum, ["aten::sum"]),
+            (sum_no_dims, ["aten::sum", "aten::mean"]),
+        ]:
+            traced = torch.jit.trace(fn, (torch.randn(8, 16), torch.randn(8, 16)))
+            llvm = LLVMCodeGenExecuted()
+            interp = SimpleIREvalExecuted()
+            for _ in range(3):
+                np.testing.assert_allclose(
+                    traced(x, y).numpy(), fn(x, y).numpy(), rtol=1e-5, atol=1e-5)
+            assert llvm.elapsed_value() >= 1 or interp.elapsed_value() >= 1
+
+            # Every reduction runs inside a fusion group, none is left in the
+            # graph around them.
+            graph = traced.graph_for(x, y)
+            groups = [n for n in graph.nodes() if n.kind() == "tensorexpr::Group"]
+            self.assertGreater(len(groups), 0)
+            subgraphs = "".join(str(n.g("Subgraph")) for n in groups)
+            outer = "".join(str(n) for n in graph.nodes() if n.kind() != "tensorexpr::Group")
+            for reduction in reductions:
+                FileCheck().check(reduction + "(").run(subgraphs)
+                FileCheck().check_not(reduction + "(").run(outer)
+
+    def test_dynamic_shapes(self):
+        def bias_gelu(x, b):
+            return F.gelu(x + b) * x
+
+        old_mode = torch._C._jit_set_dynamic_shapes_mode(True)
+        try:
+            scripted = torch.jit.script(bias_gelu)
+            torch._C._jit_reset_te_kernel_stats()
+            torch._C._jit_reset_guard_stats()
+            llvm = LLVMCodeGenExecuted()
+            interp = SimpleIREvalExecuted()
+            for seq_len in [16, 16, 7, 33, 128, 1]:
+                x = torch.randn(4, seq_len, 8)
+                b = torch.randn(8)
+                np.testing.assert_allclose(
+                    scripted(x, b).numpy(), bias_gelu(x, b).numpy(),
+                    rtol=1e-5, atol=1e-5)
+            # One kernel serves all sequence lengths, without any bailouts.
+            assert llvm.elapsed_value() >= 1 or interp.elapsed_value() >= 1
+            self.assertEqual(torch._C._jit_get_te_kernel_stats()["compilations"], 1)
+            self.assertEqual(torch._C._jit_get_guard_stats()["guard_failures"], 0)
+        finally:
+            torch._C._jit_set_dynamic_shapes_mode(old_mode)
+
+    def test_dynamic_shapes_squeeze(self):
+        def squeeze_add(x, y):
+            return (x.squeeze() + y) * 2
+
+        old_mode = torch._C._jit_set_dynamic_shapes_mode(True)
+        try:
+            scripted = torch.jit.script(squeeze_add)
+            # The rank of the squeezed tensor changes with the sizes that
+            # are 1, which the guard on its output must catch.
+            for x_sizes, y_sizes in [((4, 3), (3,)), ((4, 3), (3,)),
+                                     ((1, 3), (3,)), ((4, 1), (1,)),
+                                     ((5, 3), (3,))]:
+                x = torch.randn(*x_sizes)
+                y = torch.randn(*y_sizes)
+                np.testing.assert_allclose(
+                    scripted(x, y).numpy(), squeeze_add(x, y).numpy())
+        finally:
+            torch._C._jit_set_dynamic_shapes_mode(old_mode)
+
 if __name__ == '__main__':
     unittest.main()
@@ -74,5 +74,37 @@ class TestThroughputBenchmark(TestCase):
     def test_module(self):
         self.linear_test(TwoLayerNetModule)
 
+    def test_worker_threads(self):
+        D_in = 10
+        H = 5
+        D_out = 15
+        B = 8
+
+        module = TwoLayerNet(D_in, H, D_out)
+        bench = ThroughputBenchmark(module)
+        bench.add_input(torch.randn(B, D_in), torch.randn(B, D_in))
+
+        curve = bench.benchmark_concurrency(
+            [1, 4],
+            num_warmup_iters=10,
+            num_iters=200,
+            num_worker_threads=2,
+            profile_ops=True,
+        )
+        self.assertEqual([n for n, _ in curve], [1, 4])
+        for _, stats in curve:
+            self.assertEqual(stats.num_iters, 200)
+            self.assertGreater(stats.iters_per_second, 0)
+            self.assertLessEqual(stats.latency_p50_ms, stats.latency_p90_ms)
+            self.assertLessEqual(stats.latency_p90_ms, stats.latency_p99_ms)
+            self.assertTrue(stats.op_stats)
+            for op in stats.op_stats:
+                self.assertGreater(op.num_calls, 0)
+                self.assertLessEqual(op.self_time_ms, op.total_time_ms + 1e-6)
+            print(stats)
+
+        stats = bench.benchmark(num_iters=100)
+        self.assertEqual(stats.op_stats, [])
+
 if __name__ == '__main__':
     run_tests()
@@ -1900,6 +1900,33 @@ class _TestTorchMixin(object):
         self.assertIsOrdered('descending', x, res2val, res2ind,
                              'random with NaNs')
 
+    def test_sort_large(self):
+        # long enough slices to be sorted by several threads
+        x = torch.randn(300000)
+        x[::1000] = float('NaN')
+        num_nan = x.isnan().sum().item()
+        for descending in [False, True]:
+            val, ind = torch.sort(x, descending=descending)
+            self.assertEqual(x[ind], val, 0)
+            self.assertEqual(ind.sort()[0], torch.arange(x.numel()), 0)
+            finite = val[num_nan:] if descending else val[:-num_nan]
+            nans = val[:num_nan] if descending else val[-num_nan:]
+            self.assertTrue(nans.isnan().all())
+            diff = finite[1:] - finite[:-1]
+            self.assertTrue((diff <= 0).all() if descending else (diff >= 0).all())
+
+        # strided slices and a non-contiguous out= pair
+        x = torch.randint(100, (200000, 3))
+        val = torch.empty(3, 200000, dtype=torch.long).t()
+        ind = torch.empty(3, 200000, dtype=torch.long).t()
+        torch.sort(x, 0, out=(val, ind))
+        self.assertEqual(x.gather(0, ind), val, 0)
+        self.assertTrue((val[1:] >= val[:-1]).all())
+        self.assertEqual(torch.argsort(x, 0), ind)
+
+        topk_val, _ = x.t().topk(150000, 1, sorted=True)
+        self.assertEqual(topk_val, val.t().flip(1)[:, :150000], 0)
+
     def test_topk(self):
         def topKViaSort(t, k, dim, dir):
             sorted, indices = t.sort(dim, dir)
@@ -12975,6 +13002,27 @@ class TestTorchDeviceType(TestCase):
                                     count += 1
                             self.assertEqual(j, count)
 
+    @unittest.skipIf(not TEST_NUMPY, 'Numpy not found')
+    @dtypes(torch.int64, torch.float)
+    def test_unique_large(self, device, dtype):
+        # large enough to take the multi-chunk sorted and hash-partitioned paths on CPU
+        x = torch.randint(1000, (4, 50000), device=device).to(dtype)
+        x[0, ::7] = 1001
+        x_np = x.cpu().numpy()
+        expected_unique, expected_inverse, expected_counts = np.unique(
+            x_np, return_inverse=True, return_counts=True)
+
+        unique, inverse, counts = torch.unique(x, sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(unique.cpu().numpy(), expected_unique)
+        self.assertEqual(inverse.cpu().numpy(), expected_inverse.reshape(x.shape))
+        self.assertEqual(counts.cpu().numpy(), expected_counts)
+
+        unique, inverse, counts = torch.unique(x, sorted=False, return_inverse=True, return_counts=True)
+        self.assertEqual(unique[inverse], x)
+        perm = unique.argsort()
+        self.assertEqual(unique[perm].cpu().numpy(), expected_unique)
+        self.assertEqual(counts[perm].cpu().numpy(), expected_counts)
+
     @dtypes(*set(torch.testing.get_all_dtypes()) - {torch.bfloat16})
     def test_unique_consecutive(self, device, dtype):
         if dtype is torch.half and self.device_type == 'cpu':
@@ -46,6 +46,7 @@ libtorch_sources = [
     "torch/csrc/autograd/functions/tensor.cpp",
     "torch/csrc/autograd/functions/utils.cpp",
     "torch/csrc/autograd/input_buffer.cpp",
+    "torch/csrc/autograd/node_pool.cpp",
     "torch/csrc/autograd/profiler.cpp",
     "torch/csrc/autograd/record_function.cpp",
     "torch/csrc/autograd/record_function_ops.cpp",
@@ -97,6 +98,7 @@ libtorch_sources = [
     "torch/csrc/jit/serialization/import_export_helpers.cpp",
     "torch/csrc/jit/runtime/instruction.cpp",
     "torch/csrc/jit/runtime/interpreter.cpp",
+    "torch/csrc/jit/runtime/static_runtime.cpp",
     "torch/csrc/jit/ir/ir.cpp",
     "torch/csrc/jit/ir/irparser.cpp",
     "torch/csrc/jit/jit_log.cpp",
@@ -136,6 +138,7 @@ libtorch_sources = [
     "torch/csrc/jit/passes/lower_grad_of.cpp",
     "torch/csrc/jit/passes/lower_graph.cpp",
     "torch/csrc/jit/passes/lower_tuples.cpp",
+    "torch/csrc/jit/passes/memory_planning.cpp",
     "torch/csrc/jit/passes/peephole.cpp",
     "torch/csrc/jit/serialization/python_print.cpp",
     "torch/csrc/jit/passes/quantization.cpp",
@@ -176,6 +179,7 @@ libtorch_sources = [
     "torch/csrc/jit/serialization/import_source.cpp",
     "torch/csrc/jit/testing/hooks_for_testing.cpp",
     "torch/csrc/jit/frontend/builtin_functions.cpp",
+    "torch/csrc/jit/api/batching_module.cpp",
     "torch/csrc/jit/api/module.cpp",
     "torch/csrc/jit/api/module_save.cpp",
     "torch/csrc/jit/api/object.cpp",
@@ -186,6 +190,7 @@ libtorch_sources = [
     "torch/csrc/jit/codegen/fuser/executor.cpp",
     "torch/csrc/jit/codegen/fuser/codegen.cpp",
     "torch/csrc/jit/codegen/fuser/fallback.cpp",
+    "torch/csrc/jit/codegen/fuser/cpu/disk_cache.cpp",
     "torch/csrc/jit/codegen/fuser/cpu/fused_kernel.cpp",
     "torch/csrc/jit/codegen/fuser/interface.cpp",
     "torch/csrc/jit/runtime/vararg_functions.cpp",
@@ -200,6 +205,7 @@ libtorch_sources = [
     "torch/csrc/utils/byte_order.cpp",
     "torch/csrc/utils/tensor_flatten.cpp",
     "torch/csrc/utils/variadic.cpp",
+    "torch/csrc/jit/tensorexpr/aot.cpp",
     "torch/csrc/jit/tensorexpr/codegen.cpp",
     "torch/csrc/jit/tensorexpr/eval.cpp",
     "torch/csrc/jit/tensorexpr/expr.cpp",
@@ -342,6 +348,7 @@ def add_torch_libs():
         "torch/csrc/autograd/python_variable_indexing.cpp",
         "torch/csrc/distributed/autograd/init.cpp",
         "torch/csrc/distributed/c10d/comm.cpp",
+        "torch/csrc/distributed/c10d/comm_hooks.cpp",
         "torch/csrc/distributed/c10d/init.cpp",
         "torch/csrc/distributed/c10d/reducer.cpp",
         "torch/csrc/distributed/rpc/init.cpp",
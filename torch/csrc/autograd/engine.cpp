@@ -17,11 +17,13 @@
 #include <c10/util/Optional.h>
 #include <c10/core/StreamGuard.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -155,6 +157,29 @@ static thread_local std::shared_ptr<ReadyQueue> local_ready_queue = nullptr;
 // the leaf streams with the default streams is sufficient to implement
 // the historic behavior.
 
+// Note [Parallel CPU backward]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// By default all CPU work of a backward pass runs on the thread that called
+// backward(), so independent branches of the graph run one after the other.
+// With Engine::set_num_cpu_workers(n), up to n CPU workers, running as
+// inter-op tasks (at::launch), help the owning thread with the GraphTask's
+// cpu_ready_queue_. A worker is launched when a CPU task becomes ready while
+// the queue already holds another one, i.e. when there is more ready work
+// than the owning thread is about to pick up. Dependencies are still tracked
+// under GraphTask::mutex_ in evaluate_function, so a task is only pushed, and
+// thus only visible to the workers, once all its inputs are accumulated.
+//
+// Workers never block: they pop tasks with try_pop() and return to the pool
+// once the queue is empty. The owning thread keeps blocking on pop() and
+// remains the one that observes the completion of the GraphTask. For that,
+// workers never bring outstanding_tasks_ to zero themselves: when finishing
+// the last outstanding task they first push a dummy task to the owner, see
+// release_task_from_cpu_worker. Nested backward calls made from a worker are
+// not reentrant, they run as an independent backward pass on the worker.
+//
+// Workers are only used for backward calls made from a CPU thread, and not
+// in the async mode used by distributed autograd.
+
 int NodeTask::getReentrantDepth() const {
   std::shared_ptr<GraphTask> graph_task = base_.lock();
   if (graph_task) {
@@ -172,51 +197,198 @@ bool graph_task_completed(const std::shared_ptr<GraphTask>& graph_task) {
       (graph_task->exit_on_error_ && graph_task->has_error_.load());
 }
 
+namespace {
+
+struct EntryFreeList {
+  static constexpr size_t kMaxEntries = 64;
+
+  ~EntryFreeList() {
+    for (void* ptr : entries) {
+      ::operator delete(ptr);
+    }
+  }
+
+  std::vector<void*> entries;
+};
+
+// Set once the calling thread's free list has been destroyed at thread exit;
+// entries freed after that go straight to the system allocator.
+thread_local bool entry_free_list_destroyed = false;
+
+EntryFreeList* entry_free_list() {
+  if (entry_free_list_destroyed) {
+    return nullptr;
+  }
+  static thread_local struct Holder {
+    ~Holder() { entry_free_list_destroyed = true; }
+    EntryFreeList list;
+  } holder;
+  return &holder.list;
+}
+
+} // namespace
+
+void* ReadyQueue::Entry::operator new(size_t size) {
+  EntryFreeList* free_list = entry_free_list();
+  if (free_list && !free_list->entries.empty()) {
+    void* ptr = free_list->entries.back();
+    free_list->entries.pop_back();
+    return ptr;
+  }
+  return ::operator new(size);
+}
+
+void ReadyQueue::Entry::operator delete(void* ptr) {
+  EntryFreeList* free_list = entry_free_list();
+  if (free_list && free_list->entries.size() < EntryFreeList::kMaxEntries) {
+    free_list->entries.push_back(ptr);
+    return;
+  }
+  ::operator delete(ptr);
+}
+
+ReadyQueue::Entry::Entry(NodeTask task, int reentrant_depth)
+    : task_(std::move(task)),
+      kind_(task_.isShutdownTask_ ? 2 : (!task_.fn_ ? 1 : 0)),
+      reentrant_depth_(kind_ == 0 ? reentrant_depth : 0),
+      sequence_nr_(kind_ == 0 ? task_.fn_->sequence_nr() : 0),
+      next_(nullptr) {}
+
+ReadyQueue::~ReadyQueue() {
+  Entry* entry = inbox_.exchange(nullptr);
+  while (entry) {
+    Entry* next = entry->next_;
+    delete entry;
+    entry = next;
+  }
+  for (Entry* heap_entry : heap_) {
+    delete heap_entry;
+  }
+}
+
+void ReadyQueue::drain_inbox() {
+  // Skip the exchange when the inbox is empty, as it is whenever the tasks
+  // were pushed through the fast path of push(). The load is sequentially
+  // consistent as it pairs with the load of sleepers_ in notify_consumer().
+  if (inbox_.load() == nullptr) {
+    return;
+  }
+  Entry* entry = inbox_.exchange(nullptr);
+  while (entry) {
+    Entry* next = entry->next_;
+    heap_.push_back(entry);
+    std::push_heap(heap_.begin(), heap_.end(), CompareEntries());
+    entry = next;
+  }
+}
+
+auto ReadyQueue::pop_locked() -> NodeTask {
+  std::pop_heap(heap_.begin(), heap_.end(), CompareEntries());
+  std::unique_ptr<Entry> entry(heap_.back());
+  heap_.pop_back();
+  // Only consumers write popped_, and they all hold mutex_
+  popped_.store(
+      popped_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  return std::move(entry->task_);
+}
+
+void ReadyQueue::notify_consumer() {
+  // Pairs with the increment of sleepers_ in pop(): either the consumer sees
+  // the new task when it drains the inbox, or we see it sleeping. Taking the
+  // mutex makes sure it is actually waiting before we notify.
+  if (sleepers_.load() > 0) {
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    not_empty_.notify_one();
+  }
+}
+
 auto ReadyQueue::push(NodeTask item, bool incrementOutstandingTasks) -> void {
-  {
-    // Lock mutex for writing to heap_
-    std::lock_guard<std::mutex> lock(mutex_);
+  int reentrant_depth = 0;
+  // Lock the GraphTask once, for both the task count and the priority
+  if (incrementOutstandingTasks || (item.fn_ && !item.isShutdownTask_)) {
+    std::shared_ptr<GraphTask> graph_task = item.base_.lock();
     if (incrementOutstandingTasks) {
-      std::shared_ptr<GraphTask> graph_task = item.base_.lock();
       TORCH_INTERNAL_ASSERT(graph_task, "GraphTask is no longer valid!");
       ++graph_task->outstanding_tasks_;
     }
-    heap_.push(std::move(item));
+    // See NodeTask::getReentrantDepth for tasks whose GraphTask is gone
+    reentrant_depth = graph_task ? graph_task->reentrant_depth_
+                                 : std::numeric_limits<int>::max();
   }
-  not_empty_.notify_one();
+  auto* entry = new Entry(std::move(item), reentrant_depth);
+  // Fast path for the uncontended case, e.g. the CPU queue of a backward pass
+  // that is pushed and popped by the same thread: with mutex_ free, add the
+  // task to heap_ directly instead of going through the inbox.
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    // Only writers of heap_ write pushed_to_heap_, and they all hold mutex_
+    pushed_to_heap_.store(
+        pushed_to_heap_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_release);
+    heap_.push_back(entry);
+    std::push_heap(heap_.begin(), heap_.end(), CompareEntries());
+    lock.unlock();
+    // A consumer increments sleepers_ under mutex_ before it waits, so we
+    // either see it here or it sees the task.
+    if (sleepers_.load() > 0) {
+      not_empty_.notify_one();
+    }
+    return;
+  }
+  // Count the task before publishing it, so that a consumer can never pop it
+  // before it is counted and size() never sees more pops than pushes.
+  pushed_.fetch_add(1, std::memory_order_release);
+  entry->next_ = inbox_.load(std::memory_order_relaxed);
+  while (!inbox_.compare_exchange_weak(entry->next_, entry)) {}
+  notify_consumer();
 }
 
 auto ReadyQueue::pushShutdownTask() -> void {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    heap_.push(NodeTask({}, nullptr, InputBuffer(0), true));
-  }
-  not_empty_.notify_one();
+  push(NodeTask({}, nullptr, InputBuffer(0), true), false);
 }
 
 size_t ReadyQueue::size() const {
-  // Lock mutex for accesses to heap_
-  std::unique_lock<std::mutex> lock(mutex_);
-  return heap_.size();
+  // Load popped_ first: every pop it counts was pushed, and so was counted
+  // in pushed_ or pushed_to_heap_, before the later loads of those.
+  size_t popped = popped_.load(std::memory_order_acquire);
+  return pushed_to_heap_.load(std::memory_order_acquire) +
+      pushed_.load(std::memory_order_acquire) - popped;
 }
 
 auto ReadyQueue::pop() -> NodeTask {
   // Lock mutex for accesses to heap_
   std::unique_lock<std::mutex> lock(mutex_);
-  not_empty_.wait(lock, [this]{ return !heap_.empty(); });
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-  auto task = std::move(const_cast<NodeTask&>(heap_.top())); heap_.pop();
-  return task;
+  drain_inbox();
+  if (heap_.empty()) {
+    ++sleepers_;
+    not_empty_.wait(lock, [this] {
+      drain_inbox();
+      return !heap_.empty();
+    });
+    --sleepers_;
+  }
+  return pop_locked();
 }
 
-bool ReadyQueue::empty() const {
+auto ReadyQueue::try_pop() -> c10::optional<NodeTask> {
   // Lock mutex for accesses to heap_
   std::unique_lock<std::mutex> lock(mutex_);
-  return heap_.empty();
+  drain_inbox();
+  if (heap_.empty()) {
+    return c10::nullopt;
+  }
+  return pop_locked();
+}
+
+bool ReadyQueue::empty() const {
+  return size() == 0;
 }
 
 // This limit is based on the default python recursion limit which is 1000
-Engine::Engine() : max_recursion_depth_(100), non_reentrant_device_thread_count_(0) {}
+Engine::Engine()
+    : max_recursion_depth_(100),
+      num_cpu_workers_(0),
+      non_reentrant_device_thread_count_(0) {}
 
 // Send shutdown tasks to all device_ready_queues_ if no backward tasks are running
 // Even though readyQueue should be empty, shutdown tasks have the highest priority
@@ -248,6 +420,15 @@ void Engine::release_workers() {
   non_reentrant_device_thread_finish_.notify_one();
 }
 
+void Engine::set_num_cpu_workers(int num_workers) {
+  TORCH_CHECK(num_workers >= 0, "Expected a non-negative number of CPU workers");
+  num_cpu_workers_.store(num_workers);
+}
+
+int Engine::num_cpu_workers() const {
+  return num_cpu_workers_.load();
+}
+
 void Engine::set_device(int device) {
   // NB: We MUST NOT construct the guard for device CPU,
   // as in some settings we compile with cuda, but
@@ -465,6 +646,76 @@ void Engine::reentrant_thread_init() {
   }
 }
 
+// Decrements outstanding_tasks_ on behalf of a CPU worker. The worker never
+// brings it to zero: if its task is the last outstanding one, a dummy task is
+// pushed to the owning thread first, which then completes the GraphTask.
+// See Note [Parallel CPU backward]
+static void release_task_from_cpu_worker(
+    const std::shared_ptr<GraphTask>& graph_task,
+    const std::shared_ptr<ReadyQueue>& owner_queue) {
+  auto& outstanding_tasks = graph_task->outstanding_tasks_;
+  uint64_t num_tasks = outstanding_tasks.load();
+  while (true) {
+    if (num_tasks == 1) {
+      owner_queue->push(NodeTask(graph_task, nullptr, InputBuffer(0)));
+      num_tasks = outstanding_tasks.load();
+    } else if (outstanding_tasks.compare_exchange_weak(
+                   num_tasks, num_tasks - 1)) {
+      return;
+    }
+  }
+}
+
+void Engine::maybe_launch_cpu_worker(
+    const std::shared_ptr<GraphTask>& graph_task) {
+  int num_workers = graph_task->num_cpu_workers_.load();
+  do {
+    if (num_workers >= graph_task->max_cpu_workers_) {
+      return;
+    }
+  } while (!graph_task->num_cpu_workers_.compare_exchange_weak(
+      num_workers, num_workers + 1));
+  at::launch([this, graph_task]() { cpu_worker_main(graph_task); });
+}
+
+void Engine::cpu_worker_main(const std::shared_ptr<GraphTask>& graph_task) {
+  std::shared_ptr<ReadyQueue> queue = graph_task->cpu_ready_queue_;
+  while (!graph_task_completed(graph_task)) {
+    std::shared_ptr<GraphTask> local_graph_task;
+    bool is_dummy_task = false;
+    {
+      // Scope this block of execution since NodeTask is not needed after this
+      // block and can be deallocated.
+      c10::optional<NodeTask> task = queue->try_pop();
+      if (!task) {
+        break;
+      }
+      if (!(local_graph_task = task->base_.lock())) {
+        continue;
+      }
+      is_dummy_task = !task->fn_;
+      if (task->fn_ && !local_graph_task->has_error_.load()) {
+        AutoGradMode grad_mode(local_graph_task->grad_mode_);
+        try {
+          GraphTaskGuard guard(local_graph_task);
+          evaluate_function(local_graph_task, task->fn_.get(), task->inputs_);
+        } catch (std::exception& e) {
+          thread_on_exception(local_graph_task, task->fn_, e);
+        }
+      }
+    }
+    release_task_from_cpu_worker(
+        local_graph_task,
+        ready_queue_by_index(local_graph_task, local_graph_task->owner_));
+    // Dummy tasks are only there to wake up the owning thread, which may now
+    // be waiting for the one pushed by release_task_from_cpu_worker.
+    if (is_dummy_task) {
+      break;
+    }
+  }
+  --graph_task->num_cpu_workers_;
+}
+
 void Engine::thread_on_exception(
     std::shared_ptr<GraphTask> graph_task,
     const std::shared_ptr<Node>& fn,
@@ -721,6 +972,9 @@ void Engine::evaluate_function(
         auto queue = ready_queue(graph_task, input_buffer.device());
         queue->push(
             NodeTask(graph_task, next.function, std::move(input_buffer)));
+        if (queue == graph_task->cpu_ready_queue_ && queue->size() > 1) {
+          maybe_launch_cpu_worker(graph_task);
+        }
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
       }
@@ -739,6 +993,9 @@ void Engine::evaluate_function(
         queue->push(
             NodeTask(graph_task, next.function, std::move(input_buffer)));
         not_ready.erase(not_ready_it);
+        if (queue == graph_task->cpu_ready_queue_ && queue->size() > 1) {
+          maybe_launch_cpu_worker(graph_task);
+        }
       }
     }
   }
@@ -788,6 +1045,12 @@ auto Engine::execute(const edge_list& roots,
       /* depth */ not_reentrant_backward_call ? 0 : total_depth + 1,
       /* cpu_ready_queue */ local_ready_queue);
 
+  // Only backward calls made from CPU threads use CPU workers: a reentrant
+  // backward on a device thread shares that device's ready queue.
+  if (worker_device == NO_DEVICE || worker_device == CPU_DEVICE) {
+    graph_task->max_cpu_workers_ = num_cpu_workers_.load();
+  }
+
   // Now compute the dependencies for all executable functions and queue the root
   auto graph_root = std::make_shared<GraphRoot>(roots, inputs);
   compute_dependencies(graph_root.get(), *graph_task);
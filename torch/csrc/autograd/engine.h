@@ -10,11 +10,15 @@
 #include <torch/csrc/autograd/functions/basic_ops.h>
 #include <torch/csrc/autograd/input_buffer.h>
 #include <torch/csrc/utils/future.h>
+#include <c10/util/Optional.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <unordered_map>
 #include <utility>
@@ -118,6 +122,13 @@ struct GraphTask {
   // and but next NodeTask should be run on CPU.
   std::shared_ptr<ReadyQueue> cpu_ready_queue_;
 
+  // Maximum number of CPU workers that may help the owning thread process
+  // cpu_ready_queue_, 0 if only the owning thread does.
+  // See Note [Parallel CPU backward]
+  int max_cpu_workers_;
+  // Number of CPU workers currently running for this graph task
+  std::atomic<int> num_cpu_workers_;
+
   // Future representing the completion of the graph task. Notified when all
   // tasks are done.
   std::shared_ptr<FutureVariableList> future_result_;
@@ -142,6 +153,8 @@ struct GraphTask {
         reentrant_depth_(reentrant_depth),
         exit_on_error_(exit_on_error),
         cpu_ready_queue_(std::move(cpu_ready_queue)),
+        max_cpu_workers_(0),
+        num_cpu_workers_(0),
         future_result_(std::make_shared<FutureVariableList>()) {
           TORCH_INTERNAL_ASSERT(cpu_ready_queue_ != nullptr);
         }
@@ -172,34 +185,75 @@ struct NodeTask {
 };
 
 
+// Producers never wait for a lock: push() adds the task to the heap directly
+// when mutex_ is free, and otherwise prepends it to a lock-free inbox (a
+// Treiber stack). Consumers drain the whole inbox into the heap under mutex_
+// before popping, so pop() still returns the highest priority task among all
+// tasks pushed before it, exactly as a single locked heap would.
 struct ReadyQueue {
  private:
-  // Returns true when t2 should be (weakly) BEFORE t1 in the queue.
-  // Shutdown tasks are first and then empty NodeTask are next.
-  struct CompareNodeTaskTime {
-    bool operator()(NodeTask const & t1, NodeTask const & t2) {
-      if (t2.isShutdownTask_) {
-        return true;
-      } else if (!t1.fn_ || t1.isShutdownTask_) {
-        return false;
-      } else if (!t2.fn_) {
-        return true;
-      } else if (t1.getReentrantDepth() == t2.getReentrantDepth()) {
-        return t1.fn_->sequence_nr() < t2.fn_->sequence_nr();
+  struct Entry {
+    Entry(NodeTask task, int reentrant_depth);
+
+    // Entries are recycled through a small per-thread free list, as the
+    // CPU queue of a backward pass is usually pushed and popped by one thread.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
+    NodeTask task_;
+    // Priority of task_, computed once at push time so that heap operations
+    // don't need to lock the GraphTask to get the reentrant depth.
+    // Shutdown tasks are first and then empty NodeTask are next.
+    int kind_;
+    int reentrant_depth_;
+    uint64_t sequence_nr_;
+    Entry* next_;
+  };
+
+  // Returns true when e2 should be (weakly) BEFORE e1 in the queue.
+  struct CompareEntries {
+    bool operator()(const Entry* e1, const Entry* e2) const {
+      if (e1->kind_ != e2->kind_) {
+        return e1->kind_ < e2->kind_;
+      } else if (e1->reentrant_depth_ != e2->reentrant_depth_) {
+        return e1->reentrant_depth_ < e2->reentrant_depth_;
       } else {
-        return t1.getReentrantDepth() < t2.getReentrantDepth();
+        return e1->sequence_nr_ < e2->sequence_nr_;
       }
     }
   };
 
-  // To notify threads waiting on the ReadyQueue of available tasks on the heap_
+  // Moves all tasks from inbox_ to heap_. Must hold mutex_.
+  void drain_inbox();
+  // Pops the top of a non-empty heap_. Must hold mutex_.
+  NodeTask pop_locked();
+  void notify_consumer();
+
+  // Tasks pushed but not yet seen by a consumer, most recent first
+  std::atomic<Entry*> inbox_{nullptr};
+  // Number of tasks ever pushed through the inbox, pushed directly to heap_,
+  // and popped; size() is the difference. Kept as separate counters so that
+  // producers and consumers don't share an atomic read-modify-write on every
+  // task, and so that the ones only written under mutex_ need none at all.
+  std::atomic<size_t> pushed_{0};
+  std::atomic<size_t> pushed_to_heap_{0};
+  std::atomic<size_t> popped_{0};
+  // Number of consumers waiting on not_empty_
+  std::atomic<int> sleepers_{0};
+
+  // To notify threads waiting on the ReadyQueue of available tasks
   std::condition_variable not_empty_;
   // To protect read and writes to heap_
-  mutable std::mutex mutex_;
+  std::mutex mutex_;
 
-  std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
+  std::vector<Entry*> heap_;
 
  public:
+  ReadyQueue() = default;
+  ReadyQueue(const ReadyQueue&) = delete;
+  ReadyQueue& operator=(const ReadyQueue&) = delete;
+  ~ReadyQueue();
+
   // incrementOutstandingTasks indicates whether or not we should increment
   // 'outstanding_tasks_' for the associated GraphTask. This should mostly
   // always be true, see the doc for 'enqueue_blocked_task_on_cpu' for when we
@@ -207,6 +261,8 @@ struct ReadyQueue {
   void push(NodeTask item, bool incrementOutstandingTasks = true);
   void pushShutdownTask();
   NodeTask pop();
+  // Pops the highest priority task if there is one, without blocking.
+  c10::optional<NodeTask> try_pop();
   bool empty() const;
   size_t size() const;
 };
@@ -276,6 +332,13 @@ struct TORCH_API Engine {
   // Should be called after fork to notify that worker threads are gone
   void release_workers();
 
+  // Sets the number of inter-op threads that may execute ready CPU tasks of a
+  // backward pass alongside the thread that called backward(), 0 (the
+  // default) to run all CPU tasks on the calling thread.
+  // See Note [Parallel CPU backward]
+  void set_num_cpu_workers(int num_workers);
+  int num_cpu_workers() const;
+
  protected:
   Engine();
   void compute_dependencies(Node* root, GraphTask& task);
@@ -308,6 +371,9 @@ struct TORCH_API Engine {
       bool reentrant_thread);
   void reentrant_thread_init();
   void add_thread_pool_task(const std::weak_ptr<GraphTask>& graph_task);
+  // Launches a CPU worker for graph_task if it may use another one
+  void maybe_launch_cpu_worker(const std::shared_ptr<GraphTask>& graph_task);
+  void cpu_worker_main(const std::shared_ptr<GraphTask>& graph_task);
   void set_device(int device);
   void initialize_device_threads_pool();
 
@@ -323,6 +389,9 @@ struct TORCH_API Engine {
   // How many nested reentrant calls are allowed until a new thread is used
   int max_recursion_depth_;
 
+  // Value of GraphTask::max_cpu_workers_ for new backward calls
+  std::atomic<int> num_cpu_workers_;
+
   struct ThreadPoolShared {
     // Data structures used by the threads for executing reentrant backwards
     // tasks. See Note [Reentrant backwards]
@@ -2,6 +2,7 @@
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/utils/pybind.h>
+#include <torch/csrc/autograd/engine.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <ATen/autocast_mode.h>
 #include <torch/csrc/autograd/profiler.h>
@@ -55,6 +56,13 @@ PyObject* THPAutograd_initExtension(PyObject* _unused, PyObject *unused) {
 
   m.def("_run_before_callbacks", runBeforeCallbacks);
 
+  m.def("_set_num_cpu_workers", [](int num_workers) {
+    torch::autograd::Engine::get_default_engine().set_num_cpu_workers(num_workers);
+  });
+  m.def("_get_num_cpu_workers", []() {
+    return torch::autograd::Engine::get_default_engine().num_cpu_workers();
+  });
+
   py::class_<RecordFunction, std::shared_ptr<RecordFunction>>(m, "_RecordFunction")
     .def(py::init<>());
 
@@ -0,0 +1,87 @@
+#include <torch/csrc/autograd/node_pool.h>
+
+#include <array>
+#include <new>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+constexpr size_t kSizeClassGranularity = 16;
+// Blocks larger than this are not pooled; all generated Nodes are smaller.
+constexpr size_t kMaxPooledSize = 1024;
+constexpr size_t kNumSizeClasses = kMaxPooledSize / kSizeClassGranularity;
+// Upper bound of cached blocks per size class and thread
+constexpr size_t kMaxBlocksPerClass = 512;
+
+size_t size_class(size_t nbytes) {
+  return (nbytes + kSizeClassGranularity - 1) / kSizeClassGranularity - 1;
+}
+
+struct NodePool {
+  ~NodePool() {
+    for (auto& free_list : free_lists) {
+      for (void* ptr : free_list) {
+        ::operator delete(ptr);
+      }
+    }
+  }
+
+  std::array<std::vector<void*>, kNumSizeClasses> free_lists;
+};
+
+// Set once the calling thread's pool has been destroyed at thread exit; nodes
+// freed after that go straight to the system allocator.
+thread_local bool node_pool_destroyed = false;
+
+NodePool* node_pool() {
+  if (node_pool_destroyed) {
+    return nullptr;
+  }
+  static thread_local struct Holder {
+    ~Holder() { node_pool_destroyed = true; }
+    NodePool pool;
+  } holder;
+  return &holder.pool;
+}
+
+} // namespace
+
+void* node_pool_allocate(size_t nbytes) {
+  if (nbytes == 0 || nbytes > kMaxPooledSize) {
+    return ::operator new(nbytes);
+  }
+  NodePool* pool = node_pool();
+  if (pool) {
+    auto& free_list = pool->free_lists[size_class(nbytes)];
+    if (!free_list.empty()) {
+      void* ptr = free_list.back();
+      free_list.pop_back();
+      return ptr;
+    }
+  }
+  // Round up so that the block can be reused for any size of its class.
+  return ::operator new((size_class(nbytes) + 1) * kSizeClassGranularity);
+}
+
+void node_pool_free(void* ptr, size_t nbytes) {
+  if (!ptr) {
+    return;
+  }
+  if (nbytes == 0 || nbytes > kMaxPooledSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  NodePool* pool = node_pool();
+  if (pool) {
+    auto& free_list = pool->free_lists[size_class(nbytes)];
+    if (free_list.size() < kMaxBlocksPerClass) {
+      free_list.push_back(ptr);
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
+}} // namespace torch::autograd
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace torch { namespace autograd {
+
+// Memory for autograd graph nodes.
+//
+// Every differentiable op allocates a Node and the control block of the
+// shared_ptr owning it, and frees both once the graph is released, usually
+// in large batches at the end of each backward pass. These allocations are
+// served from per-thread free lists bucketed by size, so that steady-state
+// training reuses the memory of the previous iteration's graph without going
+// through the system allocator. A block freed on another thread, e.g. by an
+// autograd device thread, goes into that thread's free lists. Each list is
+// capped; blocks beyond the cap, and blocks too large for any size class,
+// are returned to the system.
+//
+// SavedVariables are members of the generated Nodes, so they live in the
+// Node's block. The edge_list of a Node is a plain std::vector<Edge>, which
+// is part of the Node API, and is not pooled.
+//
+// Node overloads operator new/delete with these functions, which covers all
+// Nodes created with `new`. Use NodePoolAllocator for the control block:
+//
+//   std::shared_ptr<MyNode>(new MyNode(), deleteNode, NodePoolAllocator<MyNode>())
+TORCH_API void* node_pool_allocate(size_t nbytes);
+TORCH_API void node_pool_free(void* ptr, size_t nbytes);
+
+// Standard allocator on top of node_pool_allocate
+template <typename T>
+struct NodePoolAllocator {
+  using value_type = T;
+
+  NodePoolAllocator() = default;
+  template <typename U>
+  NodePoolAllocator(const NodePoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(node_pool_allocate(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    node_pool_free(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const NodePoolAllocator<T>&, const NodePoolAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const NodePoolAllocator<T>&, const NodePoolAllocator<U>&) {
+  return false;
+}
+
+}} // namespace torch::autograd
@@ -627,7 +627,8 @@ PyObject *THPFunction_apply(PyObject *cls, PyObject *inputs)
   if (!ctx_obj) return nullptr;
   THPFunction* ctx = (THPFunction*)ctx_obj.get();
 
-  auto cdata = std::shared_ptr<PyNode>(new PyNode(std::move(ctx_obj)), deleteNode);
+  auto cdata = std::shared_ptr<PyNode>(
+      new PyNode(std::move(ctx_obj)), deleteNode, NodePoolAllocator<PyNode>());
   ctx->cdata = cdata;
 
   // Prepare inputs and allocate context (grad fn)
@@ -0,0 +1,254 @@
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+#include <ATen/CPUGenerator.h>
+#include <c10/util/Exception.h>
+
+namespace c10d {
+namespace {
+
+// Orthonormalizes the columns of a matrix in place (Gram-Schmidt).
+void orthogonalize(at::Tensor& matrix, double epsilon = 1e-8) {
+  const auto columns = matrix.size(1);
+  for (int64_t i = 0; i < columns; i++) {
+    auto column = matrix.narrow(1, i, 1);
+    // The epsilon keeps a column of zeros from turning into NaNs.
+    column.div_(column.norm().add_(epsilon));
+    if (i + 1 < columns) {
+      auto rest = matrix.narrow(1, i + 1, columns - i - 1);
+      rest.sub_((column * rest).sum(0, /* keepdim */ true) * column);
+    }
+  }
+}
+
+// Shape of the matrix a bucket of numel entries is viewed as: as close to
+// square as possible, so that P and Q are small, while padding as little as
+// possible. Uses an exact factorization with both sides within a factor of 2
+// of sqrt(numel) if there is one; otherwise pads fewer than rows entries.
+std::pair<int64_t, int64_t> matrix_shape(int64_t numel) {
+  const auto root = std::sqrt(static_cast<double>(numel));
+  for (auto rows = static_cast<int64_t>(root); rows > 0 && rows >= root / 2;
+       rows--) {
+    if (numel % rows == 0) {
+      return {rows, numel / rows};
+    }
+  }
+  const auto rows = std::max<int64_t>(1, std::ceil(root));
+  return {rows, (numel + rows - 1) / rows};
+}
+
+void check_single_replica(
+    const std::vector<at::Tensor>& tensors,
+    const char* hook) {
+  TORCH_CHECK(
+      tensors.size() == 1,
+      hook,
+      " only supports a single model replica, got ",
+      tensors.size(),
+      " replicas.");
+}
+
+} // namespace
+
+FP16CompressHook::FP16CompressHook(std::shared_ptr<ProcessGroup> process_group)
+    : process_group_(std::move(process_group)) {}
+
+std::shared_ptr<ProcessGroup::Work> FP16CompressHook::run(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  auto& compressed = compressed_[bucket_index];
+  compressed.clear();
+  compressed.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    compressed.push_back(tensor.to(at::kHalf));
+  }
+  return process_group_->allreduce(compressed);
+}
+
+void FP16CompressHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors,
+    ProcessGroup::Work& /* unused */) {
+  auto it = compressed_.find(bucket_index);
+  TORCH_INTERNAL_ASSERT(it != compressed_.end());
+  TORCH_INTERNAL_ASSERT(it->second.size() == tensors.size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].copy_(it->second[i]);
+  }
+  compressed_.erase(it);
+}
+
+void FP16CompressHook::reset() {
+  compressed_.clear();
+}
+
+TopKCompressHook::TopKCompressHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    double ratio)
+    : process_group_(std::move(process_group)), ratio_(ratio) {
+  TORCH_CHECK(
+      ratio_ > 0 && ratio_ <= 1,
+      "Expected the ratio of entries to communicate to be in (0, 1], got ",
+      ratio_);
+}
+
+std::shared_ptr<ProcessGroup::Work> TopKCompressHook::run(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  check_single_replica(tensors, "TopKCompressHook");
+  const auto& grad = tensors[0];
+  auto& state = buckets_[bucket_index];
+  if (!state.residual.defined() || state.residual.numel() != grad.numel()) {
+    state.residual = at::zeros_like(grad);
+  }
+
+  // The residual becomes the error-corrected gradient, and then, once the
+  // entries that are communicated are zeroed, the residual again.
+  state.residual.add_(grad);
+  const auto numel = grad.numel();
+  const auto k = std::min<int64_t>(
+      numel,
+      std::max<int64_t>(
+          1, static_cast<int64_t>(std::ceil(numel * ratio_))));
+  auto indices = std::get<1>(state.residual.abs().topk(
+      k, /* dim */ 0, /* largest */ true, /* sorted */ false));
+  auto values = state.residual.index_select(0, indices);
+  state.residual.index_fill_(0, indices, 0);
+
+  // Every process selects the same number of entries, so a plain allgather
+  // of fixed size tensors does.
+  const auto world_size = process_group_->getSize();
+  state.values = {values};
+  state.indices = {indices};
+  state.gathered_values = {std::vector<at::Tensor>(world_size)};
+  state.gathered_indices = {std::vector<at::Tensor>(world_size)};
+  for (int i = 0; i < world_size; i++) {
+    state.gathered_values[0][i] = at::empty_like(values);
+    state.gathered_indices[0][i] = at::empty_like(indices);
+  }
+  state.indices_work =
+      process_group_->allgather(state.gathered_indices, state.indices);
+  return process_group_->allgather(state.gathered_values, state.values);
+}
+
+void TopKCompressHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors,
+    ProcessGroup::Work& /* unused */) {
+  auto& state = buckets_.at(bucket_index);
+  TORCH_INTERNAL_ASSERT(state.indices_work);
+  state.indices_work->wait();
+
+  // Processes may select the same entries, whose values then add up.
+  auto& grad = tensors[0];
+  grad.zero_();
+  for (size_t i = 0; i < state.gathered_values[0].size(); i++) {
+    grad.index_add_(
+        0, state.gathered_indices[0][i], state.gathered_values[0][i]);
+  }
+
+  state.values.clear();
+  state.indices.clear();
+  state.gathered_values.clear();
+  state.gathered_indices.clear();
+  state.indices_work.reset();
+}
+
+void TopKCompressHook::reset() {
+  buckets_.clear();
+}
+
+PowerSGDHook::PowerSGDHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    int64_t matrix_approximation_rank,
+    uint64_t seed,
+    double min_compression_rate)
+    : process_group_(std::move(process_group)),
+      matrix_approximation_rank_(matrix_approximation_rank),
+      seed_(seed),
+      min_compression_rate_(min_compression_rate) {
+  TORCH_CHECK(
+      matrix_approximation_rank_ > 0,
+      "Expected a positive matrix approximation rank, got ",
+      matrix_approximation_rank_);
+  TORCH_CHECK(
+      min_compression_rate_ >= 0,
+      "Expected a non-negative minimum compression rate, got ",
+      min_compression_rate_);
+}
+
+std::shared_ptr<ProcessGroup::Work> PowerSGDHook::run(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors) {
+  check_single_replica(tensors, "PowerSGDHook");
+  const auto& grad = tensors[0];
+  auto& state = buckets_[bucket_index];
+
+  const auto numel = grad.numel();
+  int64_t rows, cols;
+  std::tie(rows, cols) = matrix_shape(numel);
+  const auto rank =
+      std::min(matrix_approximation_rank_, std::min(rows, cols));
+
+  // P and Q together hold (rows + cols) * rank entries.
+  state.compressed = (rows + cols) * rank * min_compression_rate_ < numel;
+  if (!state.compressed) {
+    return process_group_->allreduce(tensors);
+  }
+
+  if (!state.matrix.defined() || state.matrix.size(0) != rows ||
+      state.matrix.size(1) != cols) {
+    state.matrix = at::zeros({rows, cols}, grad.options());
+    // Q must start out the same on all processes, hence the fixed seed.
+    auto generator = at::detail::createCPUGenerator(seed_ + bucket_index);
+    state.q = at::randn(
+                  {cols, rank},
+                  generator,
+                  at::TensorOptions().dtype(grad.scalar_type()))
+                  .to(grad.device());
+  }
+
+  state.matrix.view({-1}).narrow(0, 0, numel).add_(grad);
+  state.p = {at::mm(state.matrix, state.q)};
+  return process_group_->allreduce(state.p);
+}
+
+void PowerSGDHook::finalize(
+    size_t bucket_index,
+    std::vector<at::Tensor>& tensors,
+    ProcessGroup::Work& /* unused */) {
+  auto& state = buckets_.at(bucket_index);
+  if (!state.compressed) {
+    return;
+  }
+
+  auto& p = state.p[0];
+  orthogonalize(p);
+  state.q = at::mm(state.matrix.t(), p);
+  std::vector<at::Tensor> q = {state.q};
+  process_group_->allreduce(q)->wait();
+
+  // P and Q are sums over processes, so the approximation is one of the sum
+  // of their matrices, which is the averaged gradient as the reducer divides
+  // the bucket by the world size before running the hook. Each process keeps
+  // what the approximation misses of its own share for the next iteration.
+  // The padding never holds any gradient, so it doesn't hold any error
+  // either.
+  auto approximation = at::mm(p, state.q.t());
+  const auto numel = tensors[0].numel();
+  state.matrix.sub_(approximation / process_group_->getSize());
+  auto flat_matrix = state.matrix.view({-1});
+  flat_matrix.narrow(0, numel, flat_matrix.numel() - numel).zero_();
+  tensors[0].copy_(approximation.view({-1}).narrow(0, 0, numel));
+  state.p.clear();
+}
+
+void PowerSGDHook::reset() {
+  buckets_.clear();
+}
+
+} // namespace c10d
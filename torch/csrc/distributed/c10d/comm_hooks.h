@@ -0,0 +1,155 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// A communication hook takes over the reduction of the dense buckets of a
+// Reducer, so that gradients can be transformed (e.g. compressed) before they
+// are communicated and restored afterwards. Buckets expecting a sparse
+// gradient are always reduced by a plain allreduce.
+//
+// Hooks are invoked with the Reducer's mutex held, for the buckets in the
+// order they are reduced, which is identical across processes. Collectives
+// issued by a hook must therefore be issued in the same order by all
+// processes as well.
+class CommHookInterface {
+ public:
+  virtual ~CommHookInterface() = default;
+
+  // Kicks off the reduction of the bucket with the given index. `tensors`
+  // holds the flattened contents of the bucket for every model replica,
+  // already divided by the world size, so that their sum across processes
+  // is the average gradient. The hook owns the contents until `finalize`
+  // is called for the bucket.
+  virtual std::shared_ptr<ProcessGroup::Work> run(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) = 0;
+
+  // Called at the end of the backward pass, once the work returned by `run`
+  // for the bucket has completed. Must leave the reduced gradients in
+  // `tensors`.
+  virtual void finalize(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors,
+      ProcessGroup::Work& work) = 0;
+
+  // Called when the Reducer reassigns its buckets. Hooks that keep state per
+  // bucket must drop it.
+  virtual void reset() {}
+};
+
+// Casts the buckets to fp16 for the allreduce, halving the bytes sent.
+class FP16CompressHook : public CommHookInterface {
+ public:
+  explicit FP16CompressHook(std::shared_ptr<ProcessGroup> process_group);
+
+  std::shared_ptr<ProcessGroup::Work> run(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors,
+      ProcessGroup::Work& work) override;
+
+  void reset() override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> process_group_;
+
+  // The fp16 copies of the buckets being reduced.
+  std::unordered_map<size_t, std::vector<at::Tensor>> compressed_;
+};
+
+// Only communicates the `ratio` largest magnitude entries of every bucket,
+// as values and indices gathered from all processes. Entries that were left
+// out are accumulated locally (error feedback) and added to the bucket in the
+// next iteration, so that no part of the gradient is lost, only delayed.
+//
+// Only supports a single model replica.
+class TopKCompressHook : public CommHookInterface {
+ public:
+  TopKCompressHook(std::shared_ptr<ProcessGroup> process_group, double ratio);
+
+  std::shared_ptr<ProcessGroup::Work> run(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors,
+      ProcessGroup::Work& work) override;
+
+  void reset() override;
+
+ protected:
+  struct BucketState {
+    // What previous iterations left out of the communicated gradients.
+    at::Tensor residual;
+
+    std::vector<at::Tensor> values;
+    std::vector<at::Tensor> indices;
+    std::vector<std::vector<at::Tensor>> gathered_values;
+    std::vector<std::vector<at::Tensor>> gathered_indices;
+    std::shared_ptr<ProcessGroup::Work> indices_work;
+  };
+
+  std::shared_ptr<ProcessGroup> process_group_;
+  const double ratio_;
+  std::unordered_map<size_t, BucketState> buckets_;
+};
+
+// Low-rank compression as in PowerSGD (Vogels et al., 2019). The bucket,
+// viewed as a near-square matrix M (zero-padded if its size has no factors
+// close to its square root), is approximated by P Q^T where P and Q
+// have `matrix_approximation_rank` columns, computed by one step of power
+// iteration: P = M Q is allreduced and orthogonalized, then Q = M^T P is
+// allreduced. Q is reused as the starting point of the next iteration, and
+// what the approximation misses is fed back into the next iteration.
+//
+// Buckets for which P and Q are not at least `min_compression_rate` times
+// smaller than the bucket are allreduced as they are. Only supports a single
+// model replica.
+class PowerSGDHook : public CommHookInterface {
+ public:
+  PowerSGDHook(
+      std::shared_ptr<ProcessGroup> process_group,
+      int64_t matrix_approximation_rank,
+      uint64_t seed = 0,
+      double min_compression_rate = 1);
+
+  std::shared_ptr<ProcessGroup::Work> run(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors) override;
+
+  void finalize(
+      size_t bucket_index,
+      std::vector<at::Tensor>& tensors,
+      ProcessGroup::Work& work) override;
+
+  void reset() override;
+
+ protected:
+  struct BucketState {
+    bool compressed = false;
+    // The matrix M of this process. Holds the approximation error left over
+    // for the next iteration in between iterations.
+    at::Tensor matrix;
+    std::vector<at::Tensor> p;
+    at::Tensor q;
+  };
+
+  std::shared_ptr<ProcessGroup> process_group_;
+  const int64_t matrix_approximation_rank_;
+  const uint64_t seed_;
+  const double min_compression_rate_;
+  std::unordered_map<size_t, BucketState> buckets_;
+};
+
+} // namespace c10d
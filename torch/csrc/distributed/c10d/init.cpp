@@ -6,6 +6,7 @@
 
 #ifdef USE_C10D_GLOO
 #include <c10d/ProcessGroupGloo.hpp>
+#include <c10d/ProcessGroupGlooHierarchical.hpp>
 #endif
 
 #ifdef USE_C10D_NCCL
@@ -23,6 +24,7 @@
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/distributed/c10d/comm.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 #include <torch/csrc/distributed/c10d/ddp.h>
 #include <torch/csrc/distributed/c10d/reducer.h>
 #include <torch/csrc/utils/object_ptr.h>
@@ -140,7 +142,53 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def("get_bucket_indices", &::c10d::Reducer::get_bucket_indices)
+      .def("get_bucket_stats", &::c10d::Reducer::get_bucket_stats)
+      .def(
+          "rebuild_buckets",
+          &::c10d::Reducer::rebuild_buckets,
+          py::arg("bucket_size_limits"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "register_comm_hook",
+          &::c10d::Reducer::register_comm_hook,
+          py::arg("comm_hook"),
+          py::call_guard<py::gil_scoped_release>());
+
+  shared_ptr_class_<::c10d::CommHookInterface>(module, "_CommHook");
+
+  py::class_<
+      ::c10d::FP16CompressHook,
+      ::c10d::CommHookInterface,
+      std::shared_ptr<::c10d::FP16CompressHook>>(module, "FP16CompressHook")
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>>(),
+          py::arg("process_group"));
+
+  py::class_<
+      ::c10d::TopKCompressHook,
+      ::c10d::CommHookInterface,
+      std::shared_ptr<::c10d::TopKCompressHook>>(module, "TopKCompressHook")
+      .def(
+          py::init<std::shared_ptr<::c10d::ProcessGroup>, double>(),
+          py::arg("process_group"),
+          py::arg("ratio"));
+
+  py::class_<
+      ::c10d::PowerSGDHook,
+      ::c10d::CommHookInterface,
+      std::shared_ptr<::c10d::PowerSGDHook>>(module, "PowerSGDHook")
+      .def(
+          py::init<
+              std::shared_ptr<::c10d::ProcessGroup>,
+              int64_t,
+              uint64_t,
+              double>(),
+          py::arg("process_group"),
+          py::arg("matrix_approximation_rank"),
+          py::arg("seed") = 0,
+          py::arg("min_compression_rate") = 1.0);
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class for available reduction operations: ``SUM``, ``PRODUCT``,
@@ -389,6 +437,14 @@ They are used in specifying strategies for reduction collectives, e.g.,
               py::arg("input_tensor"),
               py::call_guard<py::gil_scoped_release>())
 
+          .def(
+              "_allgather_base",
+              &::c10d::ProcessGroup::allgather_base,
+              py::arg("output"),
+              py::arg("input"),
+              py::arg("opts") = ::c10d::AllgatherOptions(),
+              py::call_guard<py::gil_scoped_release>())
+
           .def(
               "allgather_coalesced",
               &::c10d::ProcessGroup::allgather_coalesced,
@@ -515,7 +571,13 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "ring_allreduce_min_bytes",
+          &::c10d::ProcessGroupGloo::Options::ringAllreduceMinBytes)
+      .def_readwrite(
+          "ring_segment_bytes",
+          &::c10d::ProcessGroupGloo::Options::ringSegmentBytes);
 
   processGroupGloo.def_static(
       "create_device",
@@ -570,6 +632,40 @@ They are used in specifying strategies for reduction collectives, e.g.,
           py::arg("rank"),
           py::arg("size"),
           py::arg("timeout") = std::chrono::milliseconds(10 * 1000));
+
+  auto processGroupGlooHierarchical =
+      shared_ptr_class_<::c10d::ProcessGroupGlooHierarchical>(
+          module, "ProcessGroupGlooHierarchical", processGroup);
+
+  shared_ptr_class_<::c10d::ProcessGroupGlooHierarchical::Options>(
+      processGroupGlooHierarchical, "Options")
+      .def(py::init<>())
+      .def_readwrite(
+          "gloo", &::c10d::ProcessGroupGlooHierarchical::Options::gloo)
+      .def_readwrite(
+          "host", &::c10d::ProcessGroupGlooHierarchical::Options::host)
+      .def_readwrite(
+          "buffer_bytes",
+          &::c10d::ProcessGroupGlooHierarchical::Options::bufferBytes);
+
+  processGroupGlooHierarchical
+      .def(
+          py::init<
+              const std::shared_ptr<::c10d::Store>&,
+              int,
+              int,
+              ::c10d::ProcessGroupGlooHierarchical::Options>(),
+          py::arg("store"),
+          py::arg("rank"),
+          py::arg("size"),
+          py::arg("options"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "local_rank", &::c10d::ProcessGroupGlooHierarchical::getLocalRank)
+      .def(
+          "local_size", &::c10d::ProcessGroupGlooHierarchical::getLocalSize)
+      .def("num_hosts", &::c10d::ProcessGroupGlooHierarchical::getNumHosts)
+      .def("host_index", &::c10d::ProcessGroupGlooHierarchical::getHostIndex);
 #endif
 
 #ifdef USE_C10D_NCCL
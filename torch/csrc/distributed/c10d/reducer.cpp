@@ -52,6 +52,7 @@ Reducer::Reducer(
       next_bucket_(0),
       has_marked_unused_parameters_(false),
       local_used_maps_reduced_(false),
+      has_rebuilt_buckets_(false),
       backward_stats_base_(0) {
   TORCH_CHECK(replicas_.size() >= 1, "Expected at least one model replica.");
   TORCH_CHECK(replicas_[0].size() >= 1, "Expected at least one parameter.");
@@ -307,6 +308,11 @@ void Reducer::mark_variable_ready(VariableIndex index) {
   backward_stats_[replica_index][variable_index] =
       current_time_in_nanos() - backward_stats_base_;
 
+  // Record the order in which gradients become ready, to rebuild buckets.
+  if (!has_rebuilt_buckets_ && replica_index == 0) {
+    rebuilt_params_.push_back(variable_index);
+  }
+
   // Any time we mark a variable ready (be it in line due to unused parameters,
   // or via an autograd hook), we require a call to the finalize function. If
   // this doesn't happen before the next iteration (or call to
@@ -360,6 +366,7 @@ void Reducer::mark_variable_ready(VariableIndex index) {
     replica.contents.div_(process_group_->getSize());
     // Kick off reduction if all replicas for this bucket are ready.
     if (--bucket.pending == 0) {
+      bucket.ready_time = current_time_in_nanos() - backward_stats_base_;
       mark_bucket_ready(bucket_index.bucket_index);
     }
   }
@@ -412,8 +419,106 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
-    bucket.work = process_group_->allreduce(tensors);
+    bucket.launch_time = current_time_in_nanos() - backward_stats_base_;
+    if (comm_hook_ && !bucket.expect_sparse_gradient) {
+      bucket.work = comm_hook_->run(next_bucket_, tensors);
+    } else {
+      bucket.work = process_group_->allreduce(tensors);
+    }
+  }
+}
+
+std::vector<std::vector<size_t>> Reducer::get_bucket_indices() const {
+  std::vector<std::vector<size_t>> bucket_indices;
+  bucket_indices.reserve(buckets_.size());
+  for (const auto& bucket : buckets_) {
+    bucket_indices.push_back(bucket.variable_indices);
+  }
+  return bucket_indices;
+}
+
+std::vector<std::pair<int64_t, int64_t>> Reducer::get_bucket_stats() const {
+  std::vector<std::pair<int64_t, int64_t>> stats;
+  stats.reserve(buckets_.size());
+  for (const auto& bucket : buckets_) {
+    stats.emplace_back(bucket.ready_time, bucket.launch_time);
+  }
+  return stats;
+}
+
+bool Reducer::rebuild_buckets(const std::vector<size_t>& bucket_size_limits) {
+  std::vector<size_t> order;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The order is only complete after a backward pass that marked all
+    // variables ready.
+    if (has_rebuilt_buckets_ || expect_autograd_hooks_ ||
+        rebuilt_params_.size() != replicas_[0].size()) {
+      return false;
+    }
+    has_rebuilt_buckets_ = true;
+    order = std::move(rebuilt_params_);
+    rebuilt_params_.clear();
+  }
+
+  // Processes may observe different orders, use the one of process 0.
+  const auto variable_count = replicas_[0].size();
+  {
+    auto order_tensor = at::empty(
+        {static_cast<long>(variable_count)},
+        at::TensorOptions().dtype(at::kLong));
+    auto order_accessor = order_tensor.accessor<int64_t, 1>();
+    for (size_t i = 0; i < variable_count; i++) {
+      order_accessor[i] = order[i];
+    }
+    // Backends such as NCCL may not support CPU tensors.
+    std::vector<at::Tensor> tensors = {
+        order_tensor.to(replicas_[0][0].device())};
+    process_group_->broadcast(tensors)->wait();
+    order_tensor = tensors[0].to(at::kCPU);
+    order_accessor = order_tensor.accessor<int64_t, 1>();
+    for (size_t i = 0; i < variable_count; i++) {
+      TORCH_CHECK(
+          order_accessor[i] >= 0 &&
+              static_cast<size_t>(order_accessor[i]) < variable_count,
+          "Out of range variable index in gradient ready order.");
+      order[i] = order_accessor[i];
+    }
+  }
+
+  // Assign buckets to the variables in ready order, then map their
+  // positions in that order back to variable indices. Buckets come out
+  // sorted by the first position they include, i.e. in ready order.
+  std::vector<at::Tensor> tensors;
+  std::vector<bool> expect_sparse_gradient;
+  tensors.reserve(variable_count);
+  expect_sparse_gradient.reserve(variable_count);
+  for (const auto variable_index : order) {
+    tensors.push_back(replicas_[0][variable_index]);
+    expect_sparse_gradient.push_back(
+        expect_sparse_gradients_[0][variable_index]);
+  }
+  auto bucket_indices = compute_bucket_assignment_by_size(
+      tensors, bucket_size_limits, expect_sparse_gradient);
+  for (auto& bucket : bucket_indices) {
+    for (auto& index : bucket) {
+      index = order[index];
+    }
   }
+  initialize_buckets(std::move(bucket_indices));
+  return true;
+}
+
+void Reducer::register_comm_hook(
+    std::shared_ptr<CommHookInterface> comm_hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TORCH_CHECK(comm_hook, "Expected a communication hook.");
+  TORCH_CHECK(
+      !comm_hook_, "A communication hook can only be registered once.");
+  TORCH_CHECK(
+      !expect_autograd_hooks_,
+      "`register_comm_hook` must NOT be called during autograd execution.");
+  comm_hook_ = std::move(comm_hook);
 }
 
 void Reducer::initialize_buckets(
@@ -429,6 +534,11 @@ void Reducer::initialize_buckets(
   buckets_.clear();
   variable_locators_.clear();
 
+  // Any state a communication hook keeps per bucket no longer applies.
+  if (comm_hook_) {
+    comm_hook_->reset();
+  }
+
   // Ensure we have a bucket index for every variable.
   variable_locators_.resize(replicas_[0].size());
 
@@ -567,6 +677,9 @@ void Reducer::prepare_for_backward(
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
   backward_stats_base_ = current_time_in_nanos();
+  if (!has_rebuilt_buckets_) {
+    rebuilt_params_.clear();
+  }
   for (auto& bucket : buckets_) {
     for (auto& replica : bucket.replicas) {
       replica.pending = replica.variables.size();
@@ -706,12 +819,22 @@ void Reducer::finalize_backward() {
   TORCH_INTERNAL_ASSERT(next_bucket_ == buckets_.size());
 
   // Wait for asynchronous reduction to complete and unflatten contents.
-  for (auto& bucket : buckets_) {
+  for (size_t bucket_index = 0; bucket_index < buckets_.size();
+       bucket_index++) {
+    auto& bucket = buckets_[bucket_index];
     TORCH_INTERNAL_ASSERT(bucket.work);
     bucket.work->wait();
     if (bucket.expect_sparse_gradient) {
       finalize_bucket_sparse(bucket);
     } else {
+      if (comm_hook_) {
+        std::vector<at::Tensor> tensors;
+        tensors.reserve(bucket.replicas.size());
+        for (const auto& replica : bucket.replicas) {
+          tensors.push_back(replica.contents);
+        }
+        comm_hook_->finalize(bucket_index, tensors, *bucket.work);
+      }
       finalize_bucket_dense(bucket);
     }
   }
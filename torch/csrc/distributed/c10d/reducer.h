@@ -10,6 +10,7 @@
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 
 namespace c10d {
 
@@ -47,6 +48,31 @@ class Reducer {
     return backward_stats_;
   }
 
+  // Returns the bucket assignment, as the indices of the variables in every
+  // bucket, in the order the buckets are reduced.
+  std::vector<std::vector<size_t>> get_bucket_indices() const;
+
+  // Returns, for every bucket, the relative time in nanoseconds (see
+  // `get_backward_stats`) when all of its gradients were ready and when its
+  // reduction was launched in the last backward pass. Buckets are launched
+  // in order, so a bucket that is ready early waits for the ones before it.
+  std::vector<std::pair<int64_t, int64_t>> get_bucket_stats() const;
+
+  // Rebuilds the buckets once, in the order in which gradients became ready
+  // in the last backward pass rather than in the reverse order of the
+  // parameters, using `compute_bucket_assignment_by_size` with the specified
+  // size limits. The order recorded by process 0 is broadcast so that all
+  // processes end up with the same buckets; this must be called by all
+  // processes in the same iteration. Returns true if the buckets were
+  // rebuilt, false if they were rebuilt before or no complete backward pass
+  // has been recorded yet.
+  bool rebuild_buckets(const std::vector<size_t>& bucket_size_limits);
+
+  // Registers a hook that takes over the reduction of dense buckets, see
+  // CommHookInterface. Can only be called once, and not during autograd
+  // execution.
+  void register_comm_hook(std::shared_ptr<CommHookInterface> comm_hook);
+
  protected:
   // Forward declaration.
   struct Bucket;
@@ -92,6 +118,14 @@ class Reducer {
   // Work handle for allreduce on local_used_maps_
   std::shared_ptr<c10d::ProcessGroup::Work> local_used_work_;
 
+  // Reduces dense buckets instead of a plain allreduce if set.
+  std::shared_ptr<CommHookInterface> comm_hook_;
+
+  // Indices of the variables of the first replica in the order they were
+  // marked ready in the current backward pass, until buckets are rebuilt.
+  std::vector<size_t> rebuilt_params_;
+  bool has_rebuilt_buckets_;
+
   void mark_variable_ready_dense(VariableIndex index);
 
   void mark_variable_ready_sparse(VariableIndex index);
@@ -163,6 +197,11 @@ class Reducer {
     // If this bucket should expect a single sparse gradient.
     // Implies: replicas[i].variables.size() == 1.
     bool expect_sparse_gradient = false;
+
+    // Relative times when the bucket became ready and when its reduction
+    // was launched, see `get_bucket_stats`.
+    int64_t ready_time = 0;
+    int64_t launch_time = 0;
   };
 
   std::vector<Bucket> buckets_;
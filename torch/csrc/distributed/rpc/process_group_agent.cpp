@@ -1,5 +1,6 @@
 #include <torch/csrc/distributed/rpc/process_group_agent.h>
 
+#include <TH/THAllocator.h>
 #include <c10/util/C++17.h>
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/distributed/rpc/request_callback_impl.h>
@@ -7,10 +8,97 @@
 
 #include <Python.h>
 
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
 namespace torch {
 namespace distributed {
 namespace rpc {
 
+namespace {
+
+// Number of int64 values describing a buffer of a message: its size, and
+// the pid and id naming the shared memory segment holding it (both zero if
+// the buffer is sent through the ProcessGroup).
+constexpr int64_t kBufferDescriptorSize = 3;
+
+// Upper bound on the length of the string returned by getHostId().
+constexpr int64_t kMaxHostIdLen = 256;
+
+// Processes with the same host id share /dev/shm. The hostname alone may be
+// reused across machines, hence the boot id.
+std::string getHostId() {
+  char hostname[HOST_NAME_MAX + 1] = {0};
+  if (gethostname(hostname, HOST_NAME_MAX) != 0) {
+    return "";
+  }
+  std::string hostId(hostname);
+  std::ifstream bootIdFile("/proc/sys/kernel/random/boot_id");
+  std::string bootId;
+  if (bootIdFile >> bootId) {
+    hostId += "/" + bootId;
+  }
+  return hostId.substr(0, kMaxHostIdLen - 1);
+}
+
+std::string sharedMemoryName(int64_t pid, int64_t id) {
+  return "/torch_rpc_" + c10::to_string(pid) + "_" + c10::to_string(id);
+}
+
+// Copies `buffer` into a new shared memory segment, which the receiver maps
+// and unlinks, see readSharedMemory(). Returns false if the segment can't
+// be created, e.g. if /dev/shm is too small, in which case the buffer has to
+// be sent through the ProcessGroup instead.
+bool writeSharedMemory(const std::string& name, const torch::Tensor& buffer) {
+  const size_t size = buffer.numel();
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    return false;
+  }
+  // Allocate the pages upfront, writing to a sparse segment that doesn't
+  // fit into /dev/shm raises SIGBUS.
+  if (ftruncate(fd, size) == -1 || posix_fallocate(fd, 0, size) != 0) {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return false;
+  }
+  torch::from_blob(data, {static_cast<int64_t>(size)}, {torch::kChar})
+      .copy_(buffer);
+  munmap(data, size);
+  return true;
+}
+
+// Maps a segment written by writeSharedMemory() as the storage of a byte
+// tensor, without copying it, and unlinks it.
+torch::Tensor readSharedMemory(const std::string& name, int64_t size) {
+  auto dataPtr = THMapAllocator::makeDataPtr(
+      name.c_str(),
+      TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE |
+          TH_ALLOCATOR_MAPPED_UNLINK,
+      size,
+      nullptr);
+  auto data = dataPtr.get();
+  auto deleteWhenDone = new at::DataPtr(std::move(dataPtr));
+  return torch::from_blob(
+      data,
+      {size},
+      [deleteWhenDone](void*) { delete deleteWhenDone; },
+      {torch::kChar});
+}
+
+} // namespace
+
 //////////////////////////  MessageCounter  /////////////////////////////////
 
 ProcessGroupAgent::MessageCounter::MessageCounter(int worldSize)
@@ -57,6 +145,8 @@ const std::string kGilAverageWaitTime = "agent.gil_average_wait_time_us";
 const std::string kClientActiveCalls = "agent.client_active_calls";
 const std::string kServerActiveCalls = "agent.server_active_calls";
 const std::string kServerActiveAsyncCalls = "agent.server_active_async_calls";
+const std::string kSharedMemoryBuffers = "agent.shared_memory_buffers";
+const std::string kSharedMemoryFallbacks = "agent.shared_memory_fallbacks";
 
 void ProcessGroupAgent::collectNames() {
   const std::string& workerName = workerInfo_.name_;
@@ -89,6 +179,27 @@ void ProcessGroupAgent::collectNames() {
   }
 }
 
+void ProcessGroupAgent::collectHosts() {
+  const auto hostId = getHostId();
+  const auto worldSize = pg_->getSize();
+
+  torch::Tensor hostTensor = torch::zeros({kMaxHostIdLen}, torch::kChar);
+  memcpy(hostTensor.storage().data(), hostId.c_str(), hostId.length());
+  std::vector<torch::Tensor> inputHost = {hostTensor};
+  std::vector<std::vector<torch::Tensor>> outputHosts(1);
+  for (int i = 0; i < worldSize; ++i) {
+    outputHosts[0].emplace_back(torch::empty({kMaxHostIdLen}, {torch::kChar}));
+  }
+  pg_->allgather(outputHosts, inputHost)->wait();
+
+  sameHost_.resize(worldSize);
+  for (int i = 0; i < worldSize; ++i) {
+    std::string peerHostId(
+        (const char*)outputHosts[0][i].storage().data<signed char>());
+    sameHost_[i] = !hostId.empty() && peerHostId == hostId;
+  }
+}
+
 ProcessGroupAgent::ProcessGroupAgent(
     std::string workerName,
     std::shared_ptr<c10d::ProcessGroup> pg,
@@ -99,6 +210,7 @@ ProcessGroupAgent::ProcessGroupAgent(
           std::make_unique<RequestCallbackImpl>(),
           rpcTimeout),
       pg_(std::move(pg)),
+      nextSharedMemoryId_(0),
       sendCounts_(pg_->getSize()),
       recvCounts_(pg_->getSize()),
       nextId_(0),
@@ -109,6 +221,7 @@ ProcessGroupAgent::ProcessGroupAgent(
   metrics_[ProcessGroupAgentMetrics::GIL_WAIT_TIME] =
       std::make_unique<AverageMetricsTracker>(kGilAverageWaitTime);
   collectNames();
+  collectHosts();
   TORCH_CHECK(
       nameMap_.size() > 1,
       "ProcessGroupAgent requires world_size to "
@@ -365,9 +478,17 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
           // data outlives the scope of this function. It's shared_ptr<> due
           // to c++11 lambda capture limitations with unique_ptr<>.
           std::unique_ptr<std::string> payload;
+          std::vector<torch::Tensor> buffers;
           try {
-            payload = std::make_unique<std::string>(
-                wireSerialize(message.payload(), message.tensors()));
+            auto serialized =
+                wireSerializeWithBuffers(message.payload(), message.tensors());
+            payload =
+                std::make_unique<std::string>(std::move(serialized.first));
+            // The buffers alias the storages of the tensors in the message,
+            // which the receiving end must not share.
+            for (const auto& buffer : serialized.second) {
+              buffers.push_back(buffer.clone());
+            }
             // only increment sendCounts when the message is indeed added into
             // local recv.
             sendCounts_.increment(pg_->getRank());
@@ -386,7 +507,8 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
                   (void*)data,
                   len,
                   [delete_when_done](void*) { delete delete_when_done; },
-                  {torch::kChar})));
+                  {torch::kChar}),
+              std::move(buffers)));
         },
         std::move(message)));
     return future;
@@ -406,20 +528,55 @@ std::shared_ptr<FutureMessage> ProcessGroupAgent::send(
 }
 
 void ProcessGroupAgent::handleSend(const SendWork& work) {
-  auto serializedPayload = std::make_unique<std::string>(std::move(
-      wireSerialize(work.message_.payload(), work.message_.tensors())));
+  // The tensor data is not copied into the serialized payload, but sent as
+  // separate buffers straight from the storages of the tensors.
+  auto serialized = wireSerializeWithBuffers(
+      work.message_.payload(), work.message_.tensors());
+  auto serializedPayload =
+      std::make_unique<std::string>(std::move(serialized.first));
+  auto& buffers = serialized.second;
+  const auto dst = work.to_.id_;
+
+  // Large buffers for peers on the same host are passed through shared
+  // memory, costing a single copy on the sending side.
+  const auto numBuffers = static_cast<int64_t>(buffers.size());
+  std::vector<torch::Tensor> sendBuffers;
+  std::vector<std::string> sharedMemoryNames;
+  torch::Tensor descriptors =
+      torch::zeros({numBuffers * kBufferDescriptorSize}, {torch::kInt64});
+  auto descriptor = descriptors.data_ptr<int64_t>();
+  for (const auto& buffer : buffers) {
+    descriptor[0] = buffer.numel();
+    if (sameHost_[dst] && buffer.numel() >= kSharedMemoryMinBytes) {
+      const int64_t pid = getpid();
+      const int64_t id = nextSharedMemoryId_++;
+      auto name = sharedMemoryName(pid, id);
+      if (writeSharedMemory(name, buffer)) {
+        descriptor[1] = pid;
+        descriptor[2] = id;
+        sharedMemoryNames.push_back(std::move(name));
+        ++sharedMemoryBuffers_;
+      } else {
+        ++sharedMemoryFallbacks_;
+      }
+    }
+    if (descriptor[1] == 0 && buffer.numel() > 0) {
+      sendBuffers.push_back(buffer);
+    }
+    descriptor += kBufferDescriptorSize;
+  }
 
   std::vector<torch::Tensor> preamble = {torch::tensor(
       {(int64_t)pg_->getRank(),
        (int64_t)serializedPayload->length(),
        (int64_t)work.message_.type(),
-       (int64_t)work.message_.id()},
+       (int64_t)work.message_.id(),
+       numBuffers},
       {torch::kInt64})};
 
   // ProcessGroup is not thread-safe when sending with the same tag,
   // hence the lock
   std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
-  const auto dst = work.to_.id_;
 
   auto serializedPayloadData = const_cast<char*>(serializedPayload->data());
   auto serializedPayloadSize = serializedPayload->size();
@@ -429,14 +586,29 @@ void ProcessGroupAgent::handleSend(const SendWork& work) {
       serializedPayloadSize,
       [deleteWhenDone](void*) { delete deleteWhenDone; },
       {torch::kChar})};
-  pendingSends.reserve(2);
+  std::vector<torch::Tensor> descriptorsList = {descriptors};
+  pendingSends.reserve(3 + sendBuffers.size());
 
   sendCounts_.increment(dst);
 
-  {
+  try {
     std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
     pendingSends.emplace_back(pg_->send(preamble, dst, dst /* channelTag */));
+    if (numBuffers > 0) {
+      pendingSends.emplace_back(
+          pg_->send(descriptorsList, dst, dst /* channelTag */));
+    }
     pendingSends.emplace_back(pg_->send(payload, dst, dst /* channelTag */));
+    for (auto& buffer : sendBuffers) {
+      std::vector<torch::Tensor> tensors = {buffer};
+      pendingSends.emplace_back(pg_->send(tensors, dst, dst /* channelTag */));
+    }
+  } catch (...) {
+    // The receiver won't map the segments if the message isn't sent.
+    for (const auto& name : sharedMemoryNames) {
+      shm_unlink(name.c_str());
+    }
+    throw;
   }
   // Write pendingSends to a global map so that they can be interrupted by
   // ::shutdown().
@@ -494,7 +666,8 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
 
 bool ProcessGroupAgent::handleRecv(RecvWork& work) {
   torch::Tensor& payload = work.payload_;
-  auto data = wireDeserialize(payload.storage().data(), payload.numel());
+  auto data = wireDeserializeWithBuffers(
+      payload.storage().data(), payload.numel(), work.buffers_);
   Message message(
       std::move(data.first), std::move(data.second), work.type_, work.id_);
   if (message.isRequest()) {
@@ -694,8 +867,8 @@ void ProcessGroupAgent::listenLoop() {
 
 void ProcessGroupAgent::listenLoopInternal() {
   while (rpcRunning_.load()) {
-    // rank, tensor size, message type
-    std::vector<torch::Tensor> preamble = {torch::empty({4}, {torch::kInt64})};
+    // rank, tensor size, message type, message id, number of buffers
+    std::vector<torch::Tensor> preamble = {torch::empty({5}, {torch::kInt64})};
     auto work = pg_->recvAnysource(preamble, pg_->getRank());
     {
       std::lock_guard<std::mutex> guard(recvWorkMutex_);
@@ -712,12 +885,47 @@ void ProcessGroupAgent::listenLoopInternal() {
     auto size = preamble_items[1];
     MessageType type = MessageType(preamble_items[2]);
     int64_t id = preamble_items[3];
+    int64_t numBuffers = preamble_items[4];
+
+    std::vector<torch::Tensor> descriptors = {
+        torch::empty({numBuffers * kBufferDescriptorSize}, {torch::kInt64})};
+    if (numBuffers > 0) {
+      pg_->recv(descriptors, srcRank, pg_->getRank())->wait();
+    }
 
     std::vector<torch::Tensor> tensors = {torch::empty({size}, {torch::kChar})};
     pg_->recv(tensors, srcRank, pg_->getRank())->wait();
 
-    enqueueRecv(
-        RecvWork(allWorkerInfo_[srcRank], type, id, std::move(tensors[0])));
+    // Buffers are received into the tensors that become the storages of the
+    // tensors in the message, or mapped if they are in shared memory.
+    std::vector<torch::Tensor> buffers;
+    std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingRecvs;
+    auto descriptor = descriptors.front().data_ptr<int64_t>();
+    for (int64_t i = 0; i < numBuffers; ++i) {
+      const auto bufferSize = descriptor[0];
+      if (descriptor[1] != 0) {
+        buffers.push_back(readSharedMemory(
+            sharedMemoryName(descriptor[1], descriptor[2]), bufferSize));
+      } else {
+        buffers.push_back(torch::empty({bufferSize}, {torch::kChar}));
+        if (bufferSize > 0) {
+          std::vector<torch::Tensor> recvTensors = {buffers.back()};
+          pendingRecvs.push_back(
+              pg_->recv(recvTensors, srcRank, pg_->getRank()));
+        }
+      }
+      descriptor += kBufferDescriptorSize;
+    }
+    for (auto& pendingRecv : pendingRecvs) {
+      pendingRecv->wait();
+    }
+
+    enqueueRecv(RecvWork(
+        allWorkerInfo_[srcRank],
+        type,
+        id,
+        std::move(tensors[0]),
+        std::move(buffers)));
   }
 }
 
@@ -832,6 +1040,9 @@ std::unordered_map<std::string, std::string> ProcessGroupAgent::getMetrics() {
   metrics[kServerActiveCalls] = c10::to_string(serverActiveCalls_.load());
   metrics[kServerActiveAsyncCalls] =
       c10::to_string(serverActiveAsyncCalls_.load());
+  metrics[kSharedMemoryBuffers] = c10::to_string(sharedMemoryBuffers_.load());
+  metrics[kSharedMemoryFallbacks] =
+      c10::to_string(sharedMemoryFallbacks_.load());
   if (isGILProfilingEnabled()) {
     // Add time-series based metrics, just GIL wait times for now.
     {
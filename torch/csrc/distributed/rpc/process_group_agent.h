@@ -14,6 +14,10 @@ namespace rpc {
 
 constexpr auto kDefaultNumSendRecvThreads = 4;
 
+// Tensor data of at least this many bytes is passed to peers on the same host
+// through shared memory rather than through the ProcessGroup.
+constexpr int64_t kSharedMemoryMinBytes = 1024 * 1024;
+
 struct ProcessGroupRpcBackendOptions : public RpcBackendOptions {
   ProcessGroupRpcBackendOptions(
       int num_send_recv_threads,
@@ -41,20 +45,28 @@ struct SendWork {
   Message message_;
 };
 
-// SendWork wraps a Message and RecvWork wraps a Tensor. The difference here is
+// SendWork wraps a Message and RecvWork wraps Tensors. The difference here is
 // to allow us to run serialization/deserialization in the worker threads.
+// The payload holds the header written by wireSerializeWithBuffers(), and
+// the buffers hold the data of the tensors in the message.
 struct RecvWork {
   RecvWork(
       const WorkerInfo& from,
       MessageType type,
       int64_t id,
-      torch::Tensor&& payload)
-      : from_(from), type_(type), id_(id), payload_(payload) {}
+      torch::Tensor&& payload,
+      std::vector<torch::Tensor>&& buffers)
+      : from_(from),
+        type_(type),
+        id_(id),
+        payload_(payload),
+        buffers_(std::move(buffers)) {}
 
   const WorkerInfo& from_;
   const MessageType type_;
   const int64_t id_;
   torch::Tensor payload_;
+  std::vector<torch::Tensor> buffers_;
 };
 
 class ProcessGroupAgent : public RpcAgent {
@@ -144,6 +156,8 @@ class ProcessGroupAgent : public RpcAgent {
   };
 
   void collectNames();
+  // find out which peers run on the same host, see sameHost_.
+  void collectHosts();
   // put SendWork into a queue and notify the worker thread
   void enqueueSend(SendWork work);
   // handle a SendWork request. This serializes the payload inside the work
@@ -212,6 +226,16 @@ class ProcessGroupAgent : public RpcAgent {
   // worker name -> rank
   std::unordered_map<std::string, int> nameMap_;
   std::vector<WorkerInfo> allWorkerInfo_;
+  // whether a peer runs on the same host, indexed by rank. Large tensors sent
+  // to these peers go through shared memory.
+  std::vector<bool> sameHost_;
+  // used to name the shared memory segments of this process.
+  std::atomic<int64_t> nextSharedMemoryId_;
+  // number of buffers sent through shared memory, and of buffers that were
+  // large enough but sent through the ProcessGroup as no segment could be
+  // created.
+  std::atomic<int64_t> sharedMemoryBuffers_{0};
+  std::atomic<int64_t> sharedMemoryFallbacks_{0};
   // record the number of messages sent to and received from each peer. The recv
   // counter is only marked after the message is processed. Join uses allgather
   // to collect all counts from all peers, uses these counters to detect global
@@ -238,9 +238,19 @@ c10::List<at::Tensor> cloneSparseTensors(
   return pTensors;
 }
 
-std::string wireSerialize(
-    const std::vector<char>& payload,
-    const std::vector<at::Tensor>& tensors) {
+namespace {
+
+struct WireEntry {
+  std::string name;
+  const char* data;
+  size_t size;
+};
+
+// Pickles `tensors` into `meta`. Returns the storages the unpickler asks for
+// when reading it back, the i-th one as section "i".
+std::vector<jit::WriteableTensorData> pickleTensors(
+    const std::vector<at::Tensor>& tensors,
+    std::string& meta) {
   for (const auto& tensor : tensors) {
     TORCH_CHECK(
         tensor.device().is_cpu(),
@@ -250,39 +260,20 @@ std::string wireSerialize(
         tensor.device());
   }
 
-  struct Ent {
-    std::string name;
-    const char* data;
-    size_t size;
-  };
-  std::vector<Ent> entries;
-  std::string metaEntry;
-  std::vector<jit::WriteableTensorData> tensorData;
-
-  if (!payload.empty()) {
-    entries.push_back({kPayload, payload.data(), payload.size()});
-  }
-
-  if (!tensors.empty()) {
-    torch::jit::Pickler pickler(
-        [&](const void* buf, size_t sz) -> size_t {
-          metaEntry.append(static_cast<const char*>(buf), sz);
-          return sz;
-        },
-        nullptr);
-    pickler.protocol();
-    pickler.pushIValue(cloneSparseTensors(tensors));
-    pickler.stop();
-    // tensorData is in function scope so that the data() pointers stay valid.
-    tensorData = pickler.tensorData();
-    entries.push_back({kMeta, metaEntry.data(), metaEntry.size()});
-    for (size_t i = 0; i < tensorData.size(); i++) {
-      entries.push_back({c10::to_string(i),
-                         tensorData[i].data(),
-                         tensorData[i].sizeInBytes()});
-    }
-  }
+  torch::jit::Pickler pickler(
+      [&](const void* buf, size_t sz) -> size_t {
+        meta.append(static_cast<const char*>(buf), sz);
+        return sz;
+      },
+      nullptr);
+  pickler.protocol();
+  pickler.pushIValue(cloneSparseTensors(tensors));
+  pickler.stop();
+  return pickler.tensorData();
+}
 
+// Writes the header followed by the sections, see parseWireSections().
+std::string writeWireSections(const std::vector<WireEntry>& entries) {
   std::string header;
   size_t tot = 0;
   for (const auto& e : entries) {
@@ -303,11 +294,37 @@ std::string wireSerialize(
   return out;
 }
 
-std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
-    const void* data,
-    size_t data_size) {
-  auto sections = parseWireSections(data, data_size);
+// Reads back what pickleTensors() wrote into the "meta" section, calling
+// `readRecord` for the storages.
+std::vector<at::Tensor> unpickleTensors(
+    const std::pair<const char*, size_t>& metaData,
+    const std::function<at::DataPtr(const std::string&)>& readRecord) {
+  size_t metaDataPos = 0;
+  auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
+    if (metaDataPos >= metaData.second || n == 0) {
+      return 0;
+    }
+    size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
+    memcpy(buf, metaData.first + metaDataPos, toCopy);
+    metaDataPos += toCopy;
+    return toCopy;
+  };
+
+  // No need to pass typeResolver here, as it always processes string and
+  // tensors only
+  torch::jit::Unpickler unpickler(
+      metaDataReadFunc, nullptr, nullptr, readRecord, {});
+  auto ival = unpickler.parse_ivalue();
+  std::vector<at::Tensor> tensors;
+  for (auto&& t : ival.toTensorList()) {
+    tensors.emplace_back(std::move(t));
+  }
+  return tensors;
+}
 
+std::vector<char> readPayload(
+    const std::unordered_map<std::string, std::pair<const char*, size_t>>&
+        sections) {
   std::vector<char> payload;
   auto payloadIt = sections.find(kPayload);
   if (payloadIt != sections.end() && payloadIt->second.second != 0) {
@@ -315,21 +332,45 @@ std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
         payloadIt->second.first,
         payloadIt->second.first + payloadIt->second.second);
   }
+  return payload;
+}
+
+} // namespace
+
+std::string wireSerialize(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors) {
+  std::vector<WireEntry> entries;
+  std::string metaEntry;
+  std::vector<jit::WriteableTensorData> tensorData;
+
+  if (!payload.empty()) {
+    entries.push_back({kPayload, payload.data(), payload.size()});
+  }
+
+  if (!tensors.empty()) {
+    // tensorData is in function scope so that the data() pointers stay valid.
+    tensorData = pickleTensors(tensors, metaEntry);
+    entries.push_back({kMeta, metaEntry.data(), metaEntry.size()});
+    for (size_t i = 0; i < tensorData.size(); i++) {
+      entries.push_back({c10::to_string(i),
+                         tensorData[i].data(),
+                         tensorData[i].sizeInBytes()});
+    }
+  }
+
+  return writeWireSections(entries);
+}
+
+std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
+    const void* data,
+    size_t data_size) {
+  auto sections = parseWireSections(data, data_size);
+  auto payload = readPayload(sections);
 
   std::vector<at::Tensor> tensors;
   auto metaIt = sections.find(kMeta);
   if (metaIt != sections.end()) {
-    const auto& metaData = metaIt->second;
-    size_t metaDataPos = 0;
-    auto metaDataReadFunc = [&](char* buf, size_t n) -> size_t {
-      if (metaDataPos >= metaData.second || n == 0) {
-        return 0;
-      }
-      size_t toCopy = std::min(metaDataPos + n, metaData.second) - metaDataPos;
-      memcpy(buf, metaData.first + metaDataPos, toCopy);
-      metaDataPos += toCopy;
-      return toCopy;
-    };
     auto sectionReadFunc = [&](const std::string& ename) -> at::DataPtr {
       auto it = sections.find(ename);
       if (it == sections.end()) {
@@ -342,16 +383,74 @@ std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
       }
       return dptr;
     };
+    tensors = unpickleTensors(metaIt->second, sectionReadFunc);
+  }
+  return {std::move(payload), std::move(tensors)};
+}
+
+std::pair<std::string, std::vector<at::Tensor>> wireSerializeWithBuffers(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors) {
+  std::vector<WireEntry> entries;
+  std::string metaEntry;
+  std::vector<at::Tensor> buffers;
 
-    // No need to pass typeResolver here, as it always processes string and
-    // tensors only
-    torch::jit::Unpickler unpickler(
-        metaDataReadFunc, nullptr, nullptr, sectionReadFunc, {});
-    auto ival = unpickler.parse_ivalue();
-    for (auto&& t : ival.toTensorList()) {
-      tensors.emplace_back(std::move(t));
+  if (!payload.empty()) {
+    entries.push_back({kPayload, payload.data(), payload.size()});
+  }
+
+  if (!tensors.empty()) {
+    auto tensorData = pickleTensors(tensors, metaEntry);
+    entries.push_back({kMeta, metaEntry.data(), metaEntry.size()});
+    buffers.reserve(tensorData.size());
+    for (const auto& data : tensorData) {
+      // The buffer keeps the storage alive, which may be a clone made by
+      // cloneSparseTensors() that nothing else holds on to.
+      auto* keepAlive = new jit::WriteableTensorData(data);
+      buffers.push_back(at::from_blob(
+          const_cast<char*>(data.data()),
+          {static_cast<int64_t>(data.sizeInBytes())},
+          [keepAlive](void*) { delete keepAlive; },
+          at::TensorOptions().dtype(at::kChar)));
     }
   }
+
+  return {writeWireSections(entries), std::move(buffers)};
+}
+
+std::pair<std::vector<char>, std::vector<at::Tensor>>
+wireDeserializeWithBuffers(
+    const void* data,
+    size_t data_size,
+    const std::vector<at::Tensor>& buffers) {
+  auto sections = parseWireSections(data, data_size);
+  auto payload = readPayload(sections);
+
+  std::vector<at::Tensor> tensors;
+  auto metaIt = sections.find(kMeta);
+  if (metaIt != sections.end()) {
+    auto bufferReadFunc = [&](const std::string& ename) -> at::DataPtr {
+      const auto index = c10::stoll(ename);
+      TORCH_CHECK(
+          index >= 0 && index < static_cast<int64_t>(buffers.size()),
+          "Couldn't find buffer ",
+          ename,
+          " of ",
+          buffers.size());
+      const auto& buffer = buffers[index];
+      TORCH_CHECK(
+          buffer.device().is_cpu() && buffer.is_contiguous(),
+          "Expected contiguous CPU buffers");
+      // The tensor takes over the buffer, without copying its data.
+      auto* keepAlive = new at::Tensor(buffer);
+      return at::DataPtr(
+          buffer.data_ptr(),
+          keepAlive,
+          [](void* ctx) { delete static_cast<at::Tensor*>(ctx); },
+          at::kCPU);
+    };
+    tensors = unpickleTensors(metaIt->second, bufferReadFunc);
+  }
   return {std::move(payload), std::move(tensors)};
 }
 
@@ -39,6 +39,23 @@ TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>> wireDeserialize(
     const void* data,
     size_t data_size);
 
+// Like wireSerialize(), but leaves the tensor data out of the returned
+// header. It is returned as separate byte tensors instead, which alias the
+// tensor storages rather than copying them, so that a transport can send
+// them straight from where they are.
+TORCH_API std::pair<std::string, std::vector<at::Tensor>>
+wireSerializeWithBuffers(
+    const std::vector<char>& payload,
+    const std::vector<at::Tensor>& tensors);
+
+// Reverses wireSerializeWithBuffers(). The returned tensors take over the
+// storage of the contiguous CPU byte tensors in `buffers`, without copying.
+TORCH_API std::pair<std::vector<char>, std::vector<at::Tensor>>
+wireDeserializeWithBuffers(
+    const void* data,
+    size_t data_size,
+    const std::vector<at::Tensor>& buffers);
+
 // Some Tensors are effectively views of larger Tensors, where only a small
 // subset of the Storage data is referenced. This normally is good and avoids
 // copies when kept locally, but if we naively push the whole Storage over the
@@ -0,0 +1,310 @@
+#include <torch/csrc/jit/api/batching_module.h>
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/WrapDimUtils.h>
+#include <ATen/core/functional.h>
+#include <c10/core/GradMode.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+double elapsedMs(
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+std::vector<at::Tensor> splitOutput(
+    const at::Tensor& output,
+    int64_t batch_dim,
+    at::IntArrayRef sizes) {
+  TORCH_CHECK(
+      output.dim() > 0, "Expected batched outputs, got a 0-dim tensor");
+  return output.split_with_sizes(
+      sizes, at::maybe_wrap_dim(batch_dim, output.dim()));
+}
+
+// Whether the inputs of two requests can be concatenated along batch_dim:
+// they must match in everything but their size along it.
+bool batchable(
+    const std::vector<IValue>& a,
+    const std::vector<IValue>& b,
+    int64_t batch_dim) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    const at::Tensor& x = a[i].toTensor();
+    const at::Tensor& y = b[i].toTensor();
+    if (x.dim() != y.dim() || x.scalar_type() != y.scalar_type() ||
+        x.device() != y.device() || x.layout() != y.layout()) {
+      return false;
+    }
+    const int64_t dim = at::maybe_wrap_dim(batch_dim, x.dim());
+    for (int64_t d = 0; d < x.dim(); ++d) {
+      if (d != dim && x.size(d) != y.size(d)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+BatchingModule::BatchingModule(Module module, BatchingOptions options)
+    : module_(std::move(module)),
+      options_(std::move(options)),
+      stats_start_(Clock::now()) {
+  TORCH_CHECK(options_.max_batch_size > 0, "Expected a positive batch size");
+  const auto& schema = module_.get_method("forward").function().getSchema();
+  const auto& returns = schema.returns();
+  output_type_ = returns.size() == 1
+      ? returns[0].type()
+      : c10::TupleType::create(c10::fmap(
+            returns, [](const c10::Argument& a) { return a.type(); }));
+  batcher_ = std::thread([this]() { runBatcher(); });
+}
+
+BatchingModule::~BatchingModule() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  batcher_.join();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&]() { return running_batches_ == 0; });
+}
+
+c10::intrusive_ptr<c10::ivalue::Future> BatchingModule::submit(
+    std::vector<IValue> inputs) {
+  TORCH_CHECK(!inputs.empty(), "Expected at least one input");
+  int64_t batch_size = -1;
+  for (const IValue& input : inputs) {
+    TORCH_CHECK(
+        input.isTensor(),
+        "Batched requests only take tensors, got ",
+        input.tagKind());
+    const at::Tensor& tensor = input.toTensor();
+    TORCH_CHECK(
+        tensor.dim() > 0, "Expected batched inputs, got a 0-dim tensor");
+    int64_t size =
+        tensor.size(at::maybe_wrap_dim(options_.batch_dim, tensor.dim()));
+    TORCH_CHECK(
+        batch_size == -1 || size == batch_size,
+        "All inputs of a request must have the same size along the batch "
+        "dimension, got ",
+        batch_size,
+        " and ",
+        size);
+    batch_size = size;
+  }
+
+  auto future = c10::make_intrusive<c10::ivalue::Future>(output_type_);
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    TORCH_CHECK(!shutdown_, "BatchingModule is shutting down");
+    queue_.push_back({std::move(inputs), batch_size, future, Clock::now()});
+    queued_examples_ += batch_size;
+  }
+  queue_cv_.notify_one();
+  return future;
+}
+
+void BatchingModule::runBatcher() {
+  const auto max_batch_size = static_cast<int64_t>(options_.max_batch_size);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queue_cv_.wait(lock, [&]() { return shutdown_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    // On shutdown, what is left in the queue runs right away
+    queue_cv_.wait_until(
+        lock, queue_.front().submit_time + options_.max_latency, [&]() {
+          return shutdown_ || queued_examples_ >= max_batch_size;
+        });
+
+    // The batch starts with the oldest request, and takes the requests
+    // after it whose inputs can be concatenated with its own, so that a
+    // mismatching request doesn't fail the others. A request larger than
+    // max_batch_size runs in a batch of its own.
+    std::vector<Request> batch;
+    int64_t batch_size = 0;
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      if (!batch.empty() &&
+          (batch_size + it->batch_size > max_batch_size ||
+           !batchable(batch[0].inputs, it->inputs, options_.batch_dim))) {
+        ++it;
+        continue;
+      }
+      batch_size += it->batch_size;
+      queued_examples_ -= it->batch_size;
+      batch.push_back(std::move(*it));
+      it = queue_.erase(it);
+      if (batch_size >= max_batch_size) {
+        break;
+      }
+    }
+    ++running_batches_;
+    lock.unlock();
+    launchBatch(std::move(batch));
+    lock.lock();
+  }
+}
+
+void BatchingModule::launchBatch(std::vector<Request> batch) {
+  auto shared_batch = std::make_shared<std::vector<Request>>(std::move(batch));
+  auto task = [this, shared_batch]() {
+    // The destructor waits for running_batches_ to drop to zero, even if the
+    // batch throws.
+    struct Done {
+      ~Done() {
+        std::lock_guard<std::mutex> guard(self->mutex_);
+        --self->running_batches_;
+        self->done_cv_.notify_all();
+      }
+      BatchingModule* self;
+    } done{this};
+    runBatch(*shared_batch);
+  };
+  if (options_.thread_pool) {
+    options_.thread_pool->run(task);
+  } else {
+    at::launch(task);
+  }
+}
+
+void BatchingModule::runBatch(std::vector<Request>& batch) {
+  const Clock::time_point start = Clock::now();
+  std::vector<IValue> results;
+  std::string error;
+  try {
+    c10::AutoGradMode no_grad(false);
+    std::vector<IValue> inputs;
+    if (batch.size() == 1) {
+      inputs = std::move(batch[0].inputs);
+    } else {
+      // The batcher only batches requests with matching inputs.
+      const size_t num_inputs = batch[0].inputs.size();
+      for (size_t i = 0; i < num_inputs; ++i) {
+        std::vector<at::Tensor> tensors;
+        tensors.reserve(batch.size());
+        for (const Request& request : batch) {
+          tensors.push_back(request.inputs[i].toTensor());
+        }
+        inputs.emplace_back(at::cat(
+            tensors,
+            at::maybe_wrap_dim(options_.batch_dim, tensors[0].dim())));
+      }
+    }
+
+    Module module = module_;
+    IValue output = module.forward(std::move(inputs));
+
+    std::vector<int64_t> sizes;
+    sizes.reserve(batch.size());
+    for (const Request& request : batch) {
+      sizes.push_back(request.batch_size);
+    }
+    if (output.isTensor()) {
+      for (at::Tensor& part :
+           splitOutput(output.toTensor(), options_.batch_dim, sizes)) {
+        results.emplace_back(std::move(part));
+      }
+    } else {
+      TORCH_CHECK(
+          output.isTuple(),
+          "Batched forward must return a tensor or a tuple of tensors, got ",
+          output.tagKind());
+      std::vector<std::vector<IValue>> elements(batch.size());
+      for (const IValue& element : output.toTuple()->elements()) {
+        TORCH_CHECK(
+            element.isTensor(),
+            "Batched forward must return a tensor or a tuple of tensors, "
+            "got a tuple with a ",
+            element.tagKind());
+        auto parts =
+            splitOutput(element.toTensor(), options_.batch_dim, sizes);
+        for (size_t k = 0; k < batch.size(); ++k) {
+          elements[k].emplace_back(std::move(parts[k]));
+        }
+      }
+      for (auto& request_elements : elements) {
+        results.emplace_back(
+            c10::ivalue::Tuple::create(std::move(request_elements)));
+      }
+    }
+  } catch (const std::exception& e) {
+    results.clear();
+    error = e.what();
+  }
+
+  // Callbacks of the futures run inline. Their exceptions must neither be
+  // reported to other requests nor keep them from completing.
+  for (size_t k = 0; k < batch.size(); ++k) {
+    try {
+      if (results.empty()) {
+        batch[k].future->markCompleted(
+            c10::ivalue::Future::FutureError(std::string(error)));
+      } else {
+        batch[k].future->markCompleted(std::move(results[k]));
+      }
+    } catch (const std::exception& e) {
+      TORCH_WARN("Callback of a batched request threw: ", e.what());
+    }
+  }
+
+  const Clock::time_point end = Clock::now();
+  std::lock_guard<std::mutex> guard(stats_mutex_);
+  ++num_batches_;
+  for (const Request& request : batch) {
+    double latency_ms = elapsedMs(request.submit_time, end);
+    ++num_requests_;
+    num_examples_ += request.batch_size;
+    total_latency_ms_ += latency_ms;
+    max_latency_ms_ = std::max(max_latency_ms_, latency_ms);
+    total_queue_time_ms_ += elapsedMs(request.submit_time, start);
+  }
+}
+
+BatchingStats BatchingModule::stats() const {
+  std::lock_guard<std::mutex> guard(stats_mutex_);
+  BatchingStats stats;
+  stats.num_requests = num_requests_;
+  stats.num_batches = num_batches_;
+  if (num_batches_ > 0) {
+    stats.avg_batch_size = static_cast<double>(num_examples_) / num_batches_;
+  }
+  if (num_requests_ > 0) {
+    stats.avg_latency_ms = total_latency_ms_ / num_requests_;
+    stats.avg_queue_time_ms = total_queue_time_ms_ / num_requests_;
+  }
+  stats.max_latency_ms = max_latency_ms_;
+  double elapsed_ms = elapsedMs(stats_start_, Clock::now());
+  if (elapsed_ms > 0) {
+    stats.requests_per_second = num_requests_ * 1000.0 / elapsed_ms;
+  }
+  return stats;
+}
+
+void BatchingModule::resetStats() {
+  std::lock_guard<std::mutex> guard(stats_mutex_);
+  stats_start_ = Clock::now();
+  num_requests_ = 0;
+  num_batches_ = 0;
+  num_examples_ = 0;
+  total_latency_ms_ = 0;
+  max_latency_ms_ = 0;
+  total_queue_time_ms_ = 0;
+}
+
+} // namespace jit
+} // namespace torch
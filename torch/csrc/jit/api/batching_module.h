@@ -0,0 +1,118 @@
+#pragma once
+
+#include <ATen/core/ivalue.h>
+#include <c10/core/thread_pool.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/api/module.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+struct BatchingOptions {
+  // Most examples coalesced into one call to forward.
+  size_t max_batch_size = 16;
+  // Longest a request waits for other requests to be batched with, once
+  // there is one. A full batch runs right away.
+  std::chrono::microseconds max_latency{1000};
+  // Dimension of every input and output tensor along which requests are
+  // concatenated and split.
+  int64_t batch_dim = 0;
+  // Pool that batches run on, the inter-op pool of at::launch if null.
+  std::shared_ptr<c10::TaskThreadPoolBase> thread_pool;
+};
+
+struct BatchingStats {
+  uint64_t num_requests = 0;
+  uint64_t num_batches = 0;
+  // Examples per batch.
+  double avg_batch_size = 0;
+  // From submit until the result is set.
+  double avg_latency_ms = 0;
+  double max_latency_ms = 0;
+  // From submit until the batch starts running.
+  double avg_queue_time_ms = 0;
+  // Completed requests per second, since construction or resetStats().
+  double requests_per_second = 0;
+};
+
+// Runs the forward method of a module on batches of the requests submitted
+// to it, to amortize the cost of a call under load.
+//
+// A request is the list of inputs to forward of one or more examples: every
+// input must be a tensor, holding the examples along batch_dim. The inputs of
+// the requests in a batch are concatenated along batch_dim, forward runs on
+// the concatenated inputs with gradients disabled, and its output, a tensor
+// or a tuple of tensors, is split back along batch_dim into the results of
+// the requests.
+//
+// Requests wait in a queue for at most max_latency. A batcher thread takes up
+// to max_batch_size of them from it as soon as there are enough or the
+// oldest one has waited long enough, and runs the batch on the thread pool,
+// so several batches may run at the same time. Only requests whose inputs
+// match in dtype, device and all sizes but the one along batch_dim are
+// batched together.
+class TORCH_API BatchingModule {
+ public:
+  explicit BatchingModule(Module module, BatchingOptions options = {});
+  // Runs the requests still queued and waits for all batches to finish.
+  ~BatchingModule();
+
+  BatchingModule(const BatchingModule&) = delete;
+  BatchingModule& operator=(const BatchingModule&) = delete;
+
+  // Returns a future completed with the output of forward for this request,
+  // or with an error if the batch it ran in failed.
+  c10::intrusive_ptr<c10::ivalue::Future> submit(std::vector<IValue> inputs);
+
+  BatchingStats stats() const;
+  void resetStats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    std::vector<IValue> inputs;
+    int64_t batch_size;
+    c10::intrusive_ptr<c10::ivalue::Future> future;
+    Clock::time_point submit_time;
+  };
+
+  void runBatcher();
+  void launchBatch(std::vector<Request> batch);
+  void runBatch(std::vector<Request>& batch);
+
+  Module module_;
+  const BatchingOptions options_;
+  TypePtr output_type_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Request> queue_;
+  // Number of examples of the requests in queue_
+  int64_t queued_examples_ = 0;
+  size_t running_batches_ = 0;
+  bool shutdown_ = false;
+  std::thread batcher_;
+
+  mutable std::mutex stats_mutex_;
+  Clock::time_point stats_start_;
+  uint64_t num_requests_ = 0;
+  uint64_t num_batches_ = 0;
+  uint64_t num_examples_ = 0;
+  double total_latency_ms_ = 0;
+  double max_latency_ms_ = 0;
+  double total_queue_time_ms_ = 0;
+};
+
+} // namespace jit
+} // namespace torch
@@ -8,6 +8,7 @@
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/inliner.h>
 #include <torch/csrc/jit/runtime/operator.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 
 namespace torch {
 namespace jit {
@@ -106,11 +107,13 @@ Module Method::owner() const {
   return Module(owner_);
 }
 void Method::run(Stack& stack) {
+  tensorexpr::AotKernelScope aot_scope(owner().type());
   stack.insert(stack.begin(), owner()._ivalue());
   function_->run(stack);
 }
 
 IValue Method::operator()(std::vector<IValue> stack, const Kwargs& kwargs) {
+  tensorexpr::AotKernelScope aot_scope(owner().type());
   stack.insert(stack.begin(), owner()._ivalue());
   return (*function_)(std::move(stack), kwargs);
 }
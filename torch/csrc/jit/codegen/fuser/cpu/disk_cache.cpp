@@ -0,0 +1,282 @@
+#include <torch/csrc/jit/codegen/fuser/cpu/disk_cache.h>
+
+#include <c10/util/Exception.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+namespace {
+
+// Temporary files older than this were left behind by a process that died
+// while storing an entry.
+constexpr time_t kStaleTempFileSeconds = 60 * 60;
+
+std::atomic<uint64_t> num_hits{0};
+std::atomic<uint64_t> num_misses{0};
+std::atomic<uint64_t> num_stores{0};
+std::atomic<uint64_t> num_evictions{0};
+
+struct CacheConfig {
+  CacheConfig() {
+#ifndef _WIN32
+    if (const char* dir_env = getenv("PYTORCH_FUSER_CACHE_DIR")) {
+      dir = dir_env;
+    }
+#endif
+    if (const char* size_env = getenv("PYTORCH_FUSER_CACHE_SIZE_MB")) {
+      size_limit = std::strtoull(size_env, nullptr, 10) << 20;
+    }
+  }
+
+  std::mutex mutex;
+  std::string dir;
+  uint64_t size_limit = uint64_t(256) << 20;
+};
+
+CacheConfig& getCacheConfig() {
+  static CacheConfig config;
+  return config;
+}
+
+#ifndef _WIN32
+
+// FNV-1a. A collision only costs a miss, as the full key is compared on
+// lookup and entries of other keys are never overwritten.
+std::string hashKey(const std::string& key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    hash = (hash ^ c) * 1099511628211ULL;
+  }
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+  return buf;
+}
+
+c10::optional<std::string> readFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return c10::nullopt;
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+      s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool makeDirs(const std::string& dir) {
+  for (size_t pos = 1; pos <= dir.size(); ++pos) {
+    if (pos == dir.size() || dir[pos] == '/') {
+      std::string prefix = dir.substr(0, pos);
+      if (mkdir(prefix.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Writes contents to a temporary file next to path, then renames it to path.
+bool writeAtomically(const std::string& path, const std::string& contents) {
+  std::string tmpl = path + ".XXXXXX";
+  std::vector<char> tmp_name(tmpl.c_str(), tmpl.c_str() + tmpl.size() + 1);
+  int fd = mkstemp(tmp_name.data());
+  if (fd == -1) {
+    return false;
+  }
+  bool ok = true;
+  size_t written = 0;
+  while (ok && written < contents.size()) {
+    ssize_t r = write(fd, contents.data() + written, contents.size() - written);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    ok = r > 0;
+    written += ok ? r : 0;
+  }
+  ok = close(fd) == 0 && ok;
+  ok = ok && rename(tmp_name.data(), path.c_str()) == 0;
+  if (!ok) {
+    unlink(tmp_name.data());
+  }
+  return ok;
+}
+
+struct Entry {
+  std::string base;
+  uint64_t size;
+  time_t last_used;
+};
+
+// Removes the least recently used entries until the libraries in dir take at
+// most size_limit bytes. Other processes may be evicting concurrently, so
+// files that are already gone are skipped.
+void evict(const std::string& dir, uint64_t size_limit) {
+  DIR* d = opendir(dir.c_str());
+  if (!d) {
+    return;
+  }
+  std::vector<Entry> entries;
+  uint64_t total_size = 0;
+  const time_t now = time(nullptr);
+  while (struct dirent* ent = readdir(d)) {
+    const std::string name = ent->d_name;
+    const std::string path = dir + "/" + name;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    if (endsWith(name, ".so")) {
+      entries.push_back(
+          {path.substr(0, path.size() - 3),
+           static_cast<uint64_t>(st.st_size),
+           st.st_mtime});
+      total_size += st.st_size;
+    } else if (
+        name.find(".so.") != std::string::npos ||
+        name.find(".key.") != std::string::npos) {
+      if (now - st.st_mtime > kStaleTempFileSeconds) {
+        unlink(path.c_str());
+      }
+    }
+  }
+  closedir(d);
+  if (total_size <= size_limit) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.last_used < b.last_used;
+  });
+  for (const Entry& entry : entries) {
+    if (total_size <= size_limit) {
+      break;
+    }
+    // The key goes first so that no lookup finds a key without its library.
+    unlink((entry.base + ".key").c_str());
+    if (unlink((entry.base + ".so").c_str()) == 0) {
+      ++num_evictions;
+    }
+    total_size -= entry.size;
+  }
+}
+
+#endif // _WIN32
+
+} // namespace
+
+void setKernelDiskCacheDir(std::string dir) {
+#ifdef _WIN32
+  TORCH_CHECK(
+      dir.empty(), "The fuser kernel cache is not supported on Windows");
+#endif
+  auto& config = getCacheConfig();
+  std::lock_guard<std::mutex> guard(config.mutex);
+  config.dir = std::move(dir);
+}
+
+std::string getKernelDiskCacheDir() {
+  auto& config = getCacheConfig();
+  std::lock_guard<std::mutex> guard(config.mutex);
+  return config.dir;
+}
+
+void setKernelDiskCacheSizeLimit(uint64_t bytes) {
+  auto& config = getCacheConfig();
+  std::lock_guard<std::mutex> guard(config.mutex);
+  config.size_limit = bytes;
+}
+
+uint64_t getKernelDiskCacheSizeLimit() {
+  auto& config = getCacheConfig();
+  std::lock_guard<std::mutex> guard(config.mutex);
+  return config.size_limit;
+}
+
+KernelDiskCacheStats getKernelDiskCacheStats() {
+  KernelDiskCacheStats stats;
+  stats.hits = num_hits.load();
+  stats.misses = num_misses.load();
+  stats.stores = num_stores.load();
+  stats.evictions = num_evictions.load();
+  return stats;
+}
+
+void resetKernelDiskCacheStats() {
+  num_hits = 0;
+  num_misses = 0;
+  num_stores = 0;
+  num_evictions = 0;
+}
+
+c10::optional<std::string> lookupCachedKernel(const std::string& key) {
+#ifndef _WIN32
+  const std::string dir = getKernelDiskCacheDir();
+  if (dir.empty()) {
+    return c10::nullopt;
+  }
+  const std::string base = dir + "/" + hashKey(key);
+  auto stored_key = readFile(base + ".key");
+  // Touching the library marks it as recently used, and fails if the entry
+  // was evicted since reading the key.
+  if (stored_key && *stored_key == key &&
+      utime((base + ".so").c_str(), nullptr) == 0) {
+    ++num_hits;
+    return base + ".so";
+  }
+  ++num_misses;
+#endif
+  return c10::nullopt;
+}
+
+void storeCachedKernel(const std::string& key, const std::string& so_file) {
+#ifndef _WIN32
+  const std::string dir = getKernelDiskCacheDir();
+  if (dir.empty() || !makeDirs(dir)) {
+    return;
+  }
+  auto library = readFile(so_file);
+  if (!library) {
+    return;
+  }
+  const std::string base = dir + "/" + hashKey(key);
+  // Never replace the library of a different key: a process that has just
+  // matched that key could load this library instead.
+  auto stored_key = readFile(base + ".key");
+  if (stored_key && *stored_key != key) {
+    return;
+  }
+  if (writeAtomically(base + ".so", *library) &&
+      writeAtomically(base + ".key", key)) {
+    ++num_stores;
+  }
+  evict(dir, getKernelDiskCacheSizeLimit());
+#endif
+}
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <c10/util/Optional.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstdint>
+#include <string>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace cpu {
+
+// A persistent cache of compiled CPU fusion kernels, shared by all processes
+// using the same directory.
+//
+// Entries are keyed on the generated source together with the compile command
+// and the version of the compiler, so a library is only reused if compiling
+// the kernel again would produce the same one. An entry is a shared library
+// <hash>.so next to a <hash>.key file holding the full key, which is compared
+// on lookup, so a hash collision is a miss rather than the wrong kernel.
+// Both files are written under temporary names and published with rename,
+// library first, so a process never loads a partially written library. Once
+// the libraries in the directory exceed the size limit, the least recently
+// used ones are evicted.
+//
+// The cache is off unless a directory is given, through
+// $PYTORCH_FUSER_CACHE_DIR or setKernelDiskCacheDir; an empty directory
+// disables it again. The size limit defaults to
+// $PYTORCH_FUSER_CACHE_SIZE_MB megabytes, 256 if not set. Cached libraries are
+// loaded into the process, so the directory must only be writable by trusted
+// users. The cache is not available on Windows.
+
+struct KernelDiskCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t stores = 0;
+  uint64_t evictions = 0;
+};
+
+TORCH_API void setKernelDiskCacheDir(std::string dir);
+TORCH_API std::string getKernelDiskCacheDir();
+
+TORCH_API void setKernelDiskCacheSizeLimit(uint64_t bytes);
+TORCH_API uint64_t getKernelDiskCacheSizeLimit();
+
+// Counters of this process, not of the whole cache.
+TORCH_API KernelDiskCacheStats getKernelDiskCacheStats();
+TORCH_API void resetKernelDiskCacheStats();
+
+// Returns the path of the library cached under key, if any.
+c10::optional<std::string> lookupCachedKernel(const std::string& key);
+
+// Adds a copy of the library so_file to the cache under key, evicting old
+// entries if needed. Failing to write to the cache is not an error.
+void storeCachedKernel(const std::string& key, const std::string& so_file);
+
+} // namespace cpu
+} // namespace fuser
+} // namespace jit
+} // namespace torch
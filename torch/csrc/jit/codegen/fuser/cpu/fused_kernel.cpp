@@ -2,12 +2,17 @@
 #include <c10/util/Exception.h>
 #include <c10/util/Optional.h>
 #include <torch/csrc/jit/codegen/fuser/compiler.h>
+#include <torch/csrc/jit/codegen/fuser/cpu/disk_cache.h>
 #include <torch/csrc/jit/codegen/fuser/cpu/temp_file.h>
 #include <torch/csrc/jit/frontend/code_template.h>
 #include <torch/csrc/utils/memory.h>
 
+#include <array>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -193,6 +198,40 @@ struct CompilerConfig {
   const std::string openmp_flags = "-fopenmp";
 #endif
   bool openmp = true;
+
+  // Output of `cxx --version`, part of the key of the kernel disk cache.
+  // Only run the compiler for it once the cache is used.
+  const std::string& version() {
+#ifndef _MSC_VER
+    std::call_once(version_once_, [this] {
+      if (!cxx.empty()) {
+        version_ = compilerVersion(cxx);
+      }
+    });
+#endif
+    return version_;
+  }
+
+ private:
+  std::once_flag version_once_;
+  std::string version_;
+
+#ifndef _MSC_VER
+  static std::string compilerVersion(const std::string& cxx) {
+    std::string cmd = "\"" + cxx + "\" --version 2> /dev/null";
+    std::unique_ptr<FILE, decltype(&pclose)> pipe(
+        popen(cmd.c_str(), "r"), pclose);
+    std::string result;
+    if (!pipe) {
+      return result;
+    }
+    std::array<char, 128> buffer;
+    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
+      result += buffer.data();
+    }
+    return result;
+  }
+#endif
 };
 
 static CompilerConfig& getConfig() {
@@ -269,6 +308,18 @@ static void runCompiler(
   TORCH_CHECK(r == 0, "Failed to compile a fused CPU kernel");
 }
 
+// Everything the compiled library depends on: the compile command without
+// the file names, the compiler version and the source.
+static std::string diskCacheKey(const std::string& code) {
+  auto& config = getConfig();
+  TemplateEnv env;
+  env.s("cxx", config.cxx);
+  env.s("fopenmp", config.openmp ? config.openmp_flags : "");
+  env.s("cpp_file", "");
+  env.s("so_file", "");
+  return format(compile_string, env) + "\n" + config.version() + "\n" + code;
+}
+
 #ifdef _MSC_VER
 static const std::string disas_string =
     "dumpbin /DISASM:NOBYTES \"${so_file}\"";
@@ -299,18 +350,41 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(chunk_desc),
           std::move(concat_desc),
           has_random) {
-  TempFile so_file(so_template, so_suffix_len);
-  TempFile cpp_file(cpp_template, cpp_suffix_len);
-  cpp_file.write(code_);
-  cpp_file.sync();
+  // The key is computed before compiling, which may disable OpenMP. The
+  // library is stored under this key even then, since compiling the kernel
+  // again with this compiler would fall back the same way.
+  const bool use_disk_cache = !getKernelDiskCacheDir().empty();
+  const std::string cache_key = use_disk_cache ? diskCacheKey(code_) : "";
+  c10::optional<std::string> cached;
+  if (use_disk_cache) {
+    cached = lookupCachedKernel(cache_key);
+  }
+  if (cached) {
+    try {
+      so_lib = make_unique<at::DynamicLibrary>(cached->c_str());
+      if (debugFuser() >= 2)
+        disas(*cached);
+    } catch (const c10::Error&) {
+      // e.g. evicted by another process since the lookup; compile it again
+    }
+  }
+  if (!so_lib) {
+    TempFile so_file(so_template, so_suffix_len);
+    TempFile cpp_file(cpp_template, cpp_suffix_len);
+    cpp_file.write(code_);
+    cpp_file.sync();
 #ifdef _MSC_VER
-  so_file.close();
-  cpp_file.close();
+    so_file.close();
+    cpp_file.close();
 #endif
-  runCompiler(cpp_file.name(), so_file.name());
-  if (debugFuser() >= 2)
-    disas(so_file.name());
-  so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+    runCompiler(cpp_file.name(), so_file.name());
+    if (debugFuser() >= 2)
+      disas(so_file.name());
+    if (use_disk_cache) {
+      storeCachedKernel(cache_key, so_file.name());
+    }
+    so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+  }
 #pragma GCC diagnostic ignored "-Wpedantic"
   kernel =
       reinterpret_cast<void (*)(uint32_t, void**)>(so_lib->sym(name_.c_str()));
@@ -159,18 +159,31 @@ struct GuardElimination {
     }
   }
 
+  // In dynamic shapes mode, guards only check the rank of a tensor and which
+  // of its dimensions are 1 (see `getDynamicShapesMode`). For operations whose
+  // outputs have a dimension of 1 only if some input does, this still
+  // determines what the guard on the output checks.
+  static bool isSymbolicShapeGuard(const TensorTypePtr& type) {
+    return getDynamicShapesMode() && type->scalarType() && type->device() &&
+        type->dim() && type->requiresGrad().has_value() &&
+        type->undefined().has_value();
+  }
+
   // `checkInputs` check the invariants specified in `removableGuard`
   // on inputs to `n`. The invariants must hold, or an input must
   // be a `prim::Constant` or be included as an exception in `except`
   bool checkInputs(
       Node* n,
       const std::unordered_set<size_t>& except,
-      bool allow_numbers) {
+      bool allow_numbers,
+      bool allow_symbolic_shapes = true) {
     bool all_inputs_guarded = true;
     size_t i = 0;
     for (auto input : n->inputs()) {
       if ((input->node()->kind() == prim::Guard &&
-           !input->type()->expect<TensorType>()->isSummarized()) ||
+           (!input->type()->expect<TensorType>()->isSummarized() ||
+            (allow_symbolic_shapes &&
+             isSymbolicShapeGuard(input->type()->expect<TensorType>())))) ||
           input->node()->kind() == prim::Constant ||
           (allow_numbers && input->type()->isSubtypeOf(NumberType::get())) ||
           except.count(i) != 0) {
@@ -256,7 +269,6 @@ struct GuardElimination {
       case aten::eq:
       case aten::ne:
       case aten::neg:
-      case prim::ConstantChunk:
       case aten::size:
       case aten::abs:
       case aten::sign:
@@ -268,6 +280,7 @@ struct GuardElimination {
       case aten::rand_like:
       case aten::erf:
       case aten::erfc:
+      case aten::gelu:
       case aten::exp:
       case aten::expm1:
       case aten::log:
@@ -293,19 +306,31 @@ struct GuardElimination {
       case aten::bitwise_or:
       case aten::bitwise_xor:
         return checkInputs(n, no_exceptions, true);
+      case prim::ConstantChunk:
+        return checkInputs(
+            n, no_exceptions, true, /*allow_symbolic_shapes=*/false);
       case aten::softmax:
         return checkInputs(n, std::unordered_set<size_t>{1}, true);
       case aten::multinomial:
         return checkInputs(n, std::unordered_set<size_t>{2, 3}, false);
+      // The output rank of squeeze depends on which dimensions are 1 at
+      // runtime, which symbolic guards don't pin down.
       case aten::flatten:
       case aten::argmax:
       case aten::squeeze:
+        return checkInputs(
+            n, no_exceptions, false, /*allow_symbolic_shapes=*/false);
       case aten::avg_pool2d:
-        return checkInputs(n, no_exceptions, false);
+        return checkInputs(
+            n, no_exceptions, false, /*allow_symbolic_shapes=*/false);
       case aten::conv1d:
       case aten::conv2d:
       case aten::conv3d:
-        return checkInputs(n, std::unordered_set<size_t>{2, 6}, false);
+        return checkInputs(
+            n,
+            std::unordered_set<size_t>{2, 6},
+            false,
+            /*allow_symbolic_shapes=*/false);
       case aten::slice:
         return !n->input(0)->type()->expect<TensorType>()->isSummarized() &&
             // check that the dimension argument is constant
@@ -374,7 +399,8 @@ struct GuardElimination {
         if (chunk->kind() != aten::chunk) {
           return false;
         }
-        return checkInputs(chunk, no_exceptions, false);
+        return checkInputs(
+            chunk, no_exceptions, false, /*allow_symbolic_shapes=*/false);
       }
       // this is checked by one of the tests in test_jit_fuser.py
       case aten::broadcast_tensors: {
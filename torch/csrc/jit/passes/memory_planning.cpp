@@ -0,0 +1,358 @@
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/runtime/custom_operator.h>
+#include <torch/csrc/jit/runtime/operator.h>
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Planned buffers start at multiples of the CPU allocator alignment.
+constexpr size_t kArenaAlignment = 64;
+
+const Symbol& arenaSymbol() {
+  static Symbol s = Symbol::fromQualString("prim::MemoryPlanArena");
+  return s;
+}
+
+const Symbol& plannedTensorSymbol() {
+  static Symbol s = Symbol::fromQualString("prim::PlannedTensor");
+  return s;
+}
+
+const Symbol kNbytesAttr = Symbol::attr("nbytes");
+const Symbol kOffsetAttr = Symbol::attr("offset");
+const Symbol kSizesAttr = Symbol::attr("sizes");
+const Symbol kStridesAttr = Symbol::attr("strides");
+const Symbol kDtypeAttr = Symbol::attr("dtype");
+
+size_t alignUp(size_t nbytes) {
+  return (nbytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+struct PlannedValue {
+  Value* value;
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+  at::ScalarType dtype;
+  size_t nbytes;
+  // Positions of the defining node and of the last node reading the value or
+  // any of its aliases, both inclusive.
+  size_t begin;
+  size_t end;
+  size_t offset = 0;
+};
+
+// Does n have an out= overload taking the same arguments plus a trailing
+// `Tensor(a!) out`? Views and in-place ops are never rewritten.
+bool hasOutVariant(Node* n) {
+  const FunctionSchema* schema = n->maybeSchema();
+  if (!schema || schema->is_mutable() || schema->is_vararg() ||
+      schema->returns().size() != 1 || schema->returns()[0].alias_info()) {
+    return false;
+  }
+  const auto& args = schema->arguments();
+  for (const auto& op : getAllOperatorsFor(n->kind())) {
+    const auto& out_args = op->schema().arguments();
+    if (out_args.size() != args.size() + 1) {
+      continue;
+    }
+    const auto& out = out_args.back();
+    if (out.name() != "out" || !out.alias_info() ||
+        !out.alias_info()->isWrite()) {
+      continue;
+    }
+    bool same_args = true;
+    for (size_t i = 0; i < args.size() && same_args; ++i) {
+      same_args = args[i].name() == out_args[i].name() &&
+          *args[i].type() == *out_args[i].type();
+    }
+    if (same_args) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Fills in the layout of v if it is a CPU tensor with a complete type.
+bool completeLayout(Value* v, PlannedValue& planned) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || !type->isComplete() || !type->device()->is_cpu() ||
+      type->requiresGrad().value_or(true)) {
+    return false;
+  }
+  planned.value = v;
+  planned.sizes = *type->sizes().concrete_sizes();
+  planned.strides = *type->strides().concrete_sizes();
+  planned.dtype = *type->scalarType();
+  size_t numel = 1;
+  for (size_t i = 0; i < planned.sizes.size(); ++i) {
+    if (planned.sizes[i] == 0) {
+      return false;
+    }
+    numel += (planned.sizes[i] - 1) * planned.strides[i];
+  }
+  planned.nbytes = numel * elementSize(planned.dtype);
+  return true;
+}
+
+// Assigns offsets first-fit, largest buffers first, so that buffers whose
+// lifetimes overlap never overlap in memory. Returns the arena size.
+size_t assignOffsets(std::vector<PlannedValue>& planned) {
+  std::vector<PlannedValue*> order;
+  for (auto& p : planned) {
+    order.push_back(&p);
+  }
+  std::stable_sort(
+      order.begin(), order.end(), [](PlannedValue* a, PlannedValue* b) {
+        return a->nbytes > b->nbytes;
+      });
+  size_t arena_bytes = 0;
+  std::vector<PlannedValue*> placed;
+  for (PlannedValue* p : order) {
+    std::vector<PlannedValue*> live;
+    for (PlannedValue* q : placed) {
+      if (!(q->end < p->begin || p->end < q->begin)) {
+        live.push_back(q);
+      }
+    }
+    std::sort(live.begin(), live.end(), [](PlannedValue* a, PlannedValue* b) {
+      return a->offset < b->offset;
+    });
+    size_t offset = 0;
+    for (PlannedValue* q : live) {
+      if (offset + p->nbytes <= q->offset) {
+        break;
+      }
+      offset = std::max(offset, alignUp(q->offset + q->nbytes));
+    }
+    p->offset = offset;
+    arena_bytes = std::max(arena_bytes, alignUp(offset + p->nbytes));
+    placed.push_back(p);
+  }
+  return arena_bytes;
+}
+
+void collectValues(Block* block, std::vector<Value*>& values) {
+  for (Node* n : block->nodes()) {
+    for (Value* v : n->outputs()) {
+      values.push_back(v);
+    }
+    for (Block* b : n->blocks()) {
+      collectValues(b, values);
+    }
+  }
+}
+
+// Arenas handed out by one prim::MemoryPlanArena node. The pool is created
+// with the node's Operation, which the interpreter builds once per Code, so
+// all runs of an executor plan share it. Every concurrent run takes its own
+// arena, which returns to the pool once the last planned tensor of that run
+// is freed.
+struct ArenaPool : std::enable_shared_from_this<ArenaPool> {
+  explicit ArenaPool(size_t nbytes) : nbytes(nbytes) {}
+
+  at::Tensor acquire();
+  void release(at::DataPtr block) {
+    std::lock_guard<std::mutex> guard(mutex);
+    free_blocks.push_back(std::move(block));
+  }
+
+  const size_t nbytes;
+  std::mutex mutex;
+  std::vector<at::DataPtr> free_blocks;
+};
+
+at::Tensor ArenaPool::acquire() {
+  at::DataPtr block;
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!free_blocks.empty()) {
+      block = std::move(free_blocks.back());
+      free_blocks.pop_back();
+    }
+  }
+  if (!block) {
+    block = c10::GetCPUAllocator()->allocate(nbytes);
+  }
+  void* data = block.get();
+  auto pool = shared_from_this();
+  auto holder = std::make_shared<at::DataPtr>(std::move(block));
+  return at::from_blob(
+      data,
+      {static_cast<int64_t>(nbytes)},
+      [pool, holder](void*) { pool->release(std::move(*holder)); },
+      at::TensorOptions(at::kByte));
+}
+
+RegisterOperators reg({
+    Operator(
+        "prim::MemoryPlanArena() -> Tensor",
+        [](const Node* node) -> Operation {
+          auto pool = std::make_shared<ArenaPool>(node->i(kNbytesAttr));
+          return [pool](Stack& stack) {
+            push(stack, pool->acquire());
+            return 0;
+          };
+        },
+        c10::AliasAnalysisKind::FROM_SCHEMA),
+    Operator(
+        "prim::PlannedTensor(Tensor(a) arena) -> Tensor(a)",
+        [](const Node* node) -> Operation {
+          const int64_t offset = node->i(kOffsetAttr);
+          const std::vector<int64_t> sizes = node->is(kSizesAttr);
+          const std::vector<int64_t> strides = node->is(kStridesAttr);
+          const auto options = at::TensorOptions(
+              static_cast<at::ScalarType>(node->i(kDtypeAttr)));
+          return [offset, sizes, strides, options](Stack& stack) {
+            at::Tensor arena = pop(stack).toTensor();
+            void* data = arena.data_ptr<uint8_t>() + offset;
+            // The deleter keeps the arena alive; from_blob storage cannot be
+            // resized, so running with larger shapes than planned for fails
+            // in the out= op instead of corrupting the arena.
+            push(
+                stack,
+                at::from_blob(
+                    data, sizes, strides, [arena](void*) {}, options));
+            return 0;
+          };
+        },
+        c10::AliasAnalysisKind::FROM_SCHEMA),
+});
+
+} // namespace
+
+bool IsMemoryPlanArena(const Node* n) {
+  return n->kind() == arenaSymbol();
+}
+
+bool IsPlannedTensor(const Node* n) {
+  return n->kind() == plannedTensorSymbol();
+}
+
+size_t ArenaBytes(const Node* arena) {
+  TORCH_INTERNAL_ASSERT(IsMemoryPlanArena(arena));
+  return arena->i(kNbytesAttr);
+}
+
+at::Tensor PlannedTensorIn(const Node* planned_tensor, void* arena) {
+  TORCH_INTERNAL_ASSERT(IsPlannedTensor(planned_tensor));
+  return at::from_blob(
+      static_cast<uint8_t*>(arena) + planned_tensor->i(kOffsetAttr),
+      planned_tensor->is(kSizesAttr),
+      planned_tensor->is(kStridesAttr),
+      at::TensorOptions(
+          static_cast<at::ScalarType>(planned_tensor->i(kDtypeAttr))));
+}
+
+MemoryPlanStats PlanMemory(std::shared_ptr<Graph>& graph) {
+  MemoryPlanStats stats;
+  AliasDb alias_db(graph);
+
+  std::unordered_map<Node*, size_t> position;
+  for (Node* n : graph->nodes()) {
+    position.emplace(n, position.size());
+  }
+  // Uses inside a sub-block count as uses by the top-level node owning it.
+  auto topLevelPosition = [&](Node* n) {
+    while (n->owningBlock() != graph->block()) {
+      n = n->owningBlock()->owningNode();
+    }
+    return position.at(n);
+  };
+  auto lastUse = [&](Value* v) {
+    size_t last = topLevelPosition(v->node());
+    for (const Use& use : v->uses()) {
+      if (use.user == graph->return_node()) {
+        return std::numeric_limits<size_t>::max();
+      }
+      last = std::max(last, topLevelPosition(use.user));
+    }
+    return last;
+  };
+
+  std::vector<Value*> all_values;
+  collectValues(graph->block(), all_values);
+
+  std::vector<PlannedValue> planned;
+  for (Node* n : graph->nodes()) {
+    if (n->outputs().size() != 1 || !hasOutVariant(n)) {
+      continue;
+    }
+    Value* v = n->output();
+    PlannedValue p;
+    if (!completeLayout(v, p) || alias_db.escapesScope({v}) ||
+        alias_db.mayContainAlias({v}, graph->outputs())) {
+      continue;
+    }
+    // The buffer lives until the last use of anything that may alias it or
+    // hold a reference to it, e.g. views or lists.
+    p.begin = position.at(n);
+    p.end = p.begin;
+    for (Value* w : all_values) {
+      if (w == v ||
+          (AliasDb::mutableType(w) && alias_db.mayContainAlias(v, w))) {
+        p.end = std::max(p.end, lastUse(w));
+      }
+    }
+    if (p.end == std::numeric_limits<size_t>::max()) {
+      continue;
+    }
+    planned.push_back(std::move(p));
+  }
+  if (planned.empty()) {
+    return stats;
+  }
+
+  stats.planned_values = planned.size();
+  for (const auto& p : planned) {
+    stats.unplanned_bytes += p.nbytes;
+  }
+  stats.arena_bytes = assignOffsets(planned);
+
+  Node* arena = graph->create(arenaSymbol(), 1);
+  arena->i_(kNbytesAttr, stats.arena_bytes);
+  arena->output()->setType(TensorType::get());
+  graph->prependNode(arena);
+
+  for (const auto& p : planned) {
+    Node* n = p.value->node();
+    WithInsertPoint guard(n);
+    Node* buffer = graph->create(plannedTensorSymbol(), {arena->output()});
+    buffer->i_(kOffsetAttr, p.offset)
+        ->is_(kSizesAttr, p.sizes)
+        ->is_(kStridesAttr, p.strides)
+        ->i_(kDtypeAttr, static_cast<int64_t>(p.dtype));
+    buffer->output()->setType(p.value->type());
+    graph->insertNode(buffer);
+
+    std::vector<Value*> inputs(n->inputs().begin(), n->inputs().end());
+    inputs.push_back(buffer->output());
+    Node* out_node = graph->insertNode(graph->create(n->kind(), inputs));
+    out_node->setSourceRange(n->sourceRange());
+    out_node->setScope(n->scope());
+    out_node->output()->copyMetadata(p.value);
+    GRAPH_UPDATE(
+        "Writing ", p.value->debugName(), " into the arena at offset ",
+        p.offset, " with ", out_node->kind().toQualString(), " out=");
+    p.value->replaceAllUsesWith(out_node->output());
+    n->destroy();
+  }
+  GRAPH_DEBUG(
+      "Planned ", stats.planned_values, " values taking ",
+      stats.unplanned_bytes, " bytes into an arena of ", stats.arena_bytes,
+      " bytes");
+  GRAPH_DUMP("After PlanMemory: ", graph);
+  return stats;
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,63 @@
+/** \brief Static memory planning for inference graphs with known shapes.
+ *
+ * For a graph whose intermediate tensors all have complete types (e.g. a
+ * frozen module after _jit_pass_complete_shape_analysis with example inputs),
+ * the size and lifetime of every intermediate is known ahead of time. This
+ * pass assigns each eligible intermediate a slice of a single arena, letting
+ * values with disjoint lifetimes share memory, and rewrites the producing ops
+ * to their out= variants writing into those slices.
+ *
+ * Only the top-level block of the graph is planned. Values defined inside
+ * loops and ifs are left to the allocator, though planned values may be read
+ * from inside them.
+ *
+ * StaticRuntime runs this pass when created with plan_memory. It allocates the
+ * arena once, together with the runtime, and creates the planned tensors in it
+ * ahead of the first run, so runs make no allocations for planned values.
+ *
+ * The interpreter can also run a planned graph. There the arena is taken from
+ * a pool built with the interpreter code for the graph, i.e. once per executor
+ * plan, and each thread running the plan concurrently holds its own arena. The
+ * planned tensors are still created on every run, as views keeping that arena
+ * alive.
+ *
+ * Either way, running the graph with larger inputs than planned for is an
+ * error, as the planned buffers cannot be resized. The GraphExecutor never
+ * runs this pass by itself: neither the legacy nor the profiling executor
+ * gives intermediates complete types, and under the profiling executor's
+ * guards a shape change would fail in an out= op instead of bailing out.
+ */
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+struct MemoryPlanStats {
+  // Number of intermediates placed in the arena, i.e. allocations saved per
+  // run.
+  size_t planned_values = 0;
+  // Bytes the planned values would take if each had its own allocation.
+  size_t unplanned_bytes = 0;
+  // Size of the arena, i.e. the peak memory of the planned values.
+  size_t arena_bytes = 0;
+};
+
+// Plans the tensors produced by ops with an out= variant in the top-level
+// block of graph; values defined inside loops and ifs are left to the
+// allocator. Only CPU tensors with complete types that do not escape through
+// the graph outputs are planned.
+TORCH_API MemoryPlanStats PlanMemory(std::shared_ptr<Graph>& graph);
+
+// For executors that own the arena of a planned graph instead of running the
+// prim::MemoryPlanArena and prim::PlannedTensor nodes. The arena node gives the
+// size of the arena. Each planned tensor node gives a tensor in an arena of
+// that size, which does not own its memory.
+TORCH_API bool IsMemoryPlanArena(const Node* n);
+TORCH_API bool IsPlannedTensor(const Node* n);
+TORCH_API size_t ArenaBytes(const Node* arena);
+TORCH_API at::Tensor PlannedTensorIn(const Node* planned_tensor, void* arena);
+
+} // namespace jit
+} // namespace torch
@@ -7,6 +7,7 @@
 #include <torch/csrc/jit/passes/pass_manager.h>
 #include <torch/csrc/jit/passes/utils/subgraph_utils.h>
 #include <torch/csrc/jit/runtime/custom_operator.h>
+#include <torch/csrc/jit/runtime/graph_executor.h>
 #include <torch/csrc/jit/runtime/operator_options.h>
 #include <torch/csrc/jit/tensorexpr/kernel.h>
 
@@ -18,7 +19,7 @@ void setTensorExprFuserEnabled(bool val) {
   texpr_fuser_enabled_ = val;
 }
 
-static bool tensorExprFuserEnabled() {
+bool tensorExprFuserEnabled() {
   static const char* enable_c_str = std::getenv("PYTORCH_TENSOREXPR");
   if (!enable_c_str) {
     return texpr_fuser_enabled_;
@@ -121,12 +122,123 @@ bool isSupported(Node* node) {
     case aten::__lshift__:
     case aten::__rshift__:
     case aten::where:
+    case aten::gelu:
+    case aten::sum:
+    case aten::mean:
+    case aten::softmax:
+    case aten::log_softmax:
+    case aten::layer_norm:
       return true;
     default:
       return false;
   }
 }
 
+// Reductions are only lowered for the CPU, with constant axes and the default
+// dtype, and their input and output shapes need to be known.
+bool isSupportedReduction(Node* node) {
+  static const OperatorSet reductions{
+      "aten::sum(Tensor self, *, ScalarType? dtype=None) -> Tensor",
+      "aten::sum.dim_IntList(Tensor self, int[1] dim, bool keepdim=False, *, ScalarType? dtype=None) -> Tensor",
+      "aten::mean(Tensor self, *, ScalarType? dtype=None) -> Tensor",
+      "aten::mean.dim(Tensor self, int[1] dim, bool keepdim=False, *, ScalarType? dtype=None) -> Tensor",
+      "aten::softmax.int(Tensor self, int dim, ScalarType? dtype=None) -> Tensor",
+      "aten::log_softmax.int(Tensor self, int dim, ScalarType? dtype=None) -> Tensor",
+      "aten::layer_norm(Tensor input, int[] normalized_shape, Tensor? weight=None, Tensor? bias=None, float eps=1e-05, bool cudnn_enable=True) -> Tensor",
+  };
+  if (!node->isMemberOf(reductions)) {
+    return false;
+  }
+
+  auto input = node->input(0);
+  if (!input->isCompleteTensor() || !node->output()->isCompleteTensor() ||
+      !input->type()->expect<TensorType>()->device()->is_cpu()) {
+    return false;
+  }
+  // Averages and normalizations of integer tensors are errors in aten, or
+  // differ in rounding from what the lowering computes.
+  const auto input_type = input->type()->expect<TensorType>();
+  if (node->kind() != aten::sum &&
+      !isFloatingType(*input_type->scalarType())) {
+    return false;
+  }
+  if (node->kind() == aten::layer_norm) {
+    if (node->input(1)->node()->kind() != prim::Constant ||
+        node->input(4)->node()->kind() != prim::Constant) {
+      return false;
+    }
+    // normalized_shape must be the trailing sizes of the input, and weight
+    // and bias, when given, must have that shape too. Anything else is an
+    // error in aten, leave it to it.
+    const auto normalized_shape = toIValue(node->input(1))->toIntVector();
+    const auto sizes = *input_type->sizes().concrete_sizes();
+    if (normalized_shape.empty() || normalized_shape.size() > sizes.size() ||
+        !std::equal(
+            normalized_shape.begin(),
+            normalized_shape.end(),
+            sizes.end() - normalized_shape.size())) {
+      return false;
+    }
+    for (size_t i : {2, 3}) {
+      Value* affine = node->input(i);
+      if (affine->type()->kind() == TypeKind::NoneType) {
+        continue;
+      }
+      if (!affine->isCompleteTensor() ||
+          *affine->type()->expect<TensorType>()->sizes().concrete_sizes() !=
+              normalized_shape) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (size_t i = 1; i < node->inputs().size(); i++) {
+    if (node->input(i)->node()->kind() != prim::Constant) {
+      return false;
+    }
+  }
+  // aten rejects a dim that appears more than once, leave that error to it.
+  if ((node->kind() == aten::sum || node->kind() == aten::mean) &&
+      node->inputs().size() == 4) {
+    const int64_t rank = *input->type()->expect<TensorType>()->dim();
+    std::vector<int64_t> dims;
+    for (int64_t dim : toIValue(node->input(1))->toIntVector()) {
+      dim = dim < 0 ? dim + rank : dim;
+      if (std::find(dims.begin(), dims.end(), dim) != dims.end()) {
+        return false;
+      }
+      dims.push_back(dim);
+    }
+  }
+  return toIValue(node->namedInput(Symbol::attr("dtype")))->isNone();
+}
+
+// In dynamic shapes mode, the kernel takes the sizes of a tensor that are not
+// known at compile time as arguments, so it only needs to know its rank.
+bool isSymbolicShapeTensor(Value* v) {
+  auto tt = v->type()->cast<TensorType>();
+  return getDynamicShapesMode() && tt && tt->scalarType() && tt->device() &&
+      tt->dim();
+}
+
+// Operations that index into their inputs with offsets derived from the
+// shapes need these shapes at compile time.
+bool hasCompleteShapes(Node* node) {
+  auto inputs = node->kind() == aten::cat ? node->input(0)->node()->inputs()
+                                          : node->inputs();
+  for (Value* input : inputs) {
+    if (input->type()->cast<TensorType>() && !input->isCompleteTensor()) {
+      return false;
+    }
+  }
+  for (Value* output : node->outputs()) {
+    if (!output->isCompleteTensor()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool canHandle(Node* node, AliasDb& aliasDb) {
   if (node->kind() == prim::Constant) {
     return true;
@@ -134,7 +246,21 @@ bool canHandle(Node* node, AliasDb& aliasDb) {
   if (node->kind() == prim::Loop) {
     return false; // TODO
   }
-  return isSupported(node);
+  switch (node->kind()) {
+    case aten::sum:
+    case aten::mean:
+    case aten::softmax:
+    case aten::log_softmax:
+    case aten::layer_norm:
+      return isSupportedReduction(node);
+    case prim::ConstantChunk:
+    case aten::cat:
+    case aten::slice:
+    case aten::unsqueeze:
+      return hasCompleteShapes(node);
+    default:
+      return isSupported(node);
+  }
 }
 
 #define REQ(cond)                           \
@@ -144,9 +270,10 @@ bool canHandle(Node* node, AliasDb& aliasDb) {
   }
 
 bool canMerge(Node* consumer, Node* producer, AliasDb& aliasDb) {
-  // Only handle complete tensor types
+  // Only handle complete tensor types, or tensors of known rank in dynamic
+  // shapes mode
   for (torch::jit::Value* output : consumer->outputs()) {
-    REQ(output->isCompleteTensor());
+    REQ(output->isCompleteTensor() || isSymbolicShapeTensor(output));
   }
 
   // Only fuse within a block
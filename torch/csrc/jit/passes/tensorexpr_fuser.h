@@ -15,6 +15,7 @@ TORCH_API void fuseTensorExprs(std::shared_ptr<Graph>& graph);
 TORCH_API void registerTensorExprFuser();
 
 TORCH_API void setTensorExprFuserEnabled(bool val);
+TORCH_API bool tensorExprFuserEnabled();
 
 } // namespace jit
 } // namespace torch
@@ -1,6 +1,7 @@
 #include <torch/csrc/utils/pybind.h>
 
 #include <torch/csrc/jit/api/module.h>
+#include <torch/csrc/jit/codegen/fuser/cpu/disk_cache.h>
 #include <torch/csrc/jit/codegen/fuser/interface.h>
 #include <torch/csrc/jit/codegen/fuser/kernel_cache.h>
 #include <torch/csrc/jit/frontend/ir_emitter.h>
@@ -25,6 +26,7 @@
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_graph.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
 #include <torch/csrc/jit/passes/onnx.h>
 #include <torch/csrc/jit/passes/onnx/cast_all_constant_to_floating.h>
 #include <torch/csrc/jit/passes/onnx/constant_fold.h>
@@ -58,8 +60,10 @@
 #include <torch/csrc/jit/runtime/jit_exception.h>
 #include <torch/csrc/jit/runtime/operator.h>
 #include <torch/csrc/jit/runtime/print_handler.h>
+#include <torch/csrc/jit/runtime/static_runtime.h>
 #include <torch/csrc/jit/serialization/export.h>
 #include <torch/csrc/jit/serialization/import.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 #include <torch/csrc/jit/tensorexpr/execution_counter.h>
 #include <torch/csrc/jit/tensorexpr/kernel.h>
 
@@ -117,6 +121,32 @@ void initJITBindings(PyObject* module) {
       .def(
           "_jit_debug_fuser_num_cached_kernel_specs",
           torch::jit::fuser::debugNumCachedKernelSpecs)
+      .def(
+          "_jit_set_fuser_cache_dir",
+          torch::jit::fuser::cpu::setKernelDiskCacheDir)
+      .def(
+          "_jit_get_fuser_cache_dir",
+          torch::jit::fuser::cpu::getKernelDiskCacheDir)
+      .def(
+          "_jit_set_fuser_cache_size_limit",
+          torch::jit::fuser::cpu::setKernelDiskCacheSizeLimit)
+      .def(
+          "_jit_get_fuser_cache_size_limit",
+          torch::jit::fuser::cpu::getKernelDiskCacheSizeLimit)
+      .def(
+          "_jit_fuser_cache_stats",
+          []() {
+            auto stats = torch::jit::fuser::cpu::getKernelDiskCacheStats();
+            py::dict result;
+            result["hits"] = stats.hits;
+            result["misses"] = stats.misses;
+            result["stores"] = stats.stores;
+            result["evictions"] = stats.evictions;
+            return result;
+          })
+      .def(
+          "_jit_reset_fuser_cache_stats",
+          torch::jit::fuser::cpu::resetKernelDiskCacheStats)
       .def("_jit_pass_onnx_remove_print", RemovePrintOps)
       .def("_jit_pass_onnx_preprocess_caffe2", PreprocessCaffe2Ops)
       .def("_jit_pass_onnx", ToONNX)
@@ -308,6 +338,16 @@ void initJITBindings(PyObject* module) {
             return LowerGraph(*graph, self._ivalue());
           })
       .def("_jit_pass_loop_unrolling", UnrollLoops)
+      .def(
+          "_jit_pass_plan_memory",
+          [](std::shared_ptr<Graph>& graph) {
+            auto stats = PlanMemory(graph);
+            py::dict result;
+            result["planned_values"] = stats.planned_values;
+            result["unplanned_bytes"] = stats.unplanned_bytes;
+            result["arena_bytes"] = stats.arena_bytes;
+            return result;
+          })
       .def(
           "_jit_pass_constant_propagation",
           [](std::shared_ptr<Graph>& g) { return ConstantPropagation(g); })
@@ -400,6 +440,23 @@ void initJITBindings(PyObject* module) {
             getBailoutDepth() = depth;
             return old_depth;
           })
+      .def(
+          "_jit_set_dynamic_shapes_mode",
+          [](bool enabled) {
+            bool old_state = getDynamicShapesMode();
+            getDynamicShapesMode() = enabled;
+            return old_state;
+          })
+      .def(
+          "_jit_get_guard_stats",
+          []() {
+            auto stats = getGuardStats();
+            py::dict result;
+            result["guard_failures"] = stats.guard_failures;
+            result["optimized_graphs"] = stats.optimized_graphs;
+            return result;
+          })
+      .def("_jit_reset_guard_stats", resetGuardStats)
       .def(
           "_jit_set_inline_everything_mode",
           [](bool enabled) { getInlineEverythingMode() = enabled; })
@@ -459,7 +516,65 @@ void initJITBindings(PyObject* module) {
             using namespace torch::jit::tensorexpr;
             return getTECudaPointwiseBlockSize() = block_size;
           })
+      .def(
+          "_jit_get_te_cpu_parallel_loops",
+          []() -> bool {
+            using namespace torch::jit::tensorexpr;
+            return getTECPUParallelLoops();
+          })
+      .def(
+          "_jit_set_te_cpu_parallel_loops",
+          [](bool enabled) {
+            using namespace torch::jit::tensorexpr;
+            return getTECPUParallelLoops() = enabled;
+          })
+      .def(
+          "_jit_get_te_kernel_stats",
+          []() {
+            auto stats = tensorexpr::getTEKernelStats();
+            py::dict result;
+            result["compilations"] = stats.compilations;
+            result["shape_mismatches"] = stats.shape_mismatches;
+            return result;
+          })
+      .def("_jit_reset_te_kernel_stats", tensorexpr::resetTEKernelStats)
       .def("_jit_set_texpr_fuser_enabled", &setTensorExprFuserEnabled)
+      .def(
+          "_jit_compile_tensorexpr_aot",
+          [](const Module& module,
+             const std::string& method_name,
+             const std::vector<py::tuple>& example_inputs) {
+            const auto& schema =
+                module.get_method(method_name).function().getSchema();
+            std::vector<Stack> stacks;
+            for (const auto& inputs : example_inputs) {
+              auto stack = createStackForSchema(
+                  schema, inputs, py::kwargs(), module._ivalue());
+              // The method pushes self itself.
+              stack.erase(stack.begin());
+              stacks.push_back(std::move(stack));
+            }
+            pybind11::gil_scoped_release no_gil;
+            return CompileTensorExprAot(module, method_name, stacks);
+          })
+      .def(
+          "_jit_tensorexpr_aot_stats",
+          []() {
+            auto stats = tensorexpr::getAotKernelStats();
+            py::dict result;
+            result["registered"] = stats.registered;
+            result["rejected"] = stats.rejected;
+            result["hits"] = stats.hits;
+            result["misses"] = stats.misses;
+            return result;
+          })
+      .def("_jit_reset_tensorexpr_aot_stats", tensorexpr::resetAotKernelStats)
+      .def(
+          "_jit_set_tensorexpr_aot_loading_enabled",
+          &tensorexpr::setAotKernelLoadingEnabled)
+      .def(
+          "_jit_tensorexpr_aot_loading_enabled",
+          &tensorexpr::aotKernelLoadingEnabled)
       .def(
           "_jit_fuser_get_fused_kernel_code",
           [](Graph& g, std::vector<at::Tensor> inps) {
@@ -549,6 +664,42 @@ void initJITBindings(PyObject* module) {
       .def_property_readonly(
           "fallback", [](GraphExecutorState& s) { return s.fallback; });
 
+  py::class_<StaticRuntime>(m, "StaticRuntime")
+      .def(
+          "run",
+          [](StaticRuntime& self, py::args args) {
+            const auto& graph_inputs = self.graph()->inputs();
+            TORCH_CHECK(
+                args.size() == graph_inputs.size(),
+                "Expected ",
+                graph_inputs.size(),
+                " inputs but got ",
+                args.size());
+            std::vector<IValue> inputs;
+            for (size_t i = 0; i < args.size(); ++i) {
+              inputs.push_back(toIValue(args[i], graph_inputs[i]->type()));
+            }
+            // Keeps the GIL: a StaticRuntime holds per-run state, so runs
+            // from several Python threads must not overlap.
+            return toPyObject(self.run(std::move(inputs)));
+          })
+      .def_property_readonly("graph", &StaticRuntime::graph)
+      .def_property_readonly(
+          "num_unboxed_nodes", &StaticRuntime::num_unboxed_nodes)
+      .def_property_readonly("num_boxed_nodes", &StaticRuntime::num_boxed_nodes)
+      .def_property_readonly("arena_bytes", &StaticRuntime::arena_bytes);
+
+  m.def(
+       "_jit_to_static_runtime",
+       [](const Module& module) { return StaticRuntime(module); })
+      .def(
+          "_jit_to_static_runtime",
+          [](std::shared_ptr<Graph> graph, bool plan_memory) {
+            return StaticRuntime(std::move(graph), plan_memory);
+          },
+          py::arg("graph"),
+          py::arg("plan_memory") = false);
+
   py::class_<PyTorchStreamWriter>(m, "PyTorchFileWriter")
       .def(py::init<std::string>())
       .def(py::init([](const py::object& buffer) {
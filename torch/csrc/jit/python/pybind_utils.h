@@ -18,6 +18,7 @@
 #include <torch/csrc/jit/python/python_tracer.h>
 #include <torch/csrc/jit/resource_guard.h>
 #include <torch/csrc/jit/runtime/operator.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 #include <torch/csrc/utils/auto_gil.h>
 #include <torch/csrc/utils/pybind.h>
 #include <torch/csrc/utils/six.h>
@@ -1023,6 +1024,7 @@ inline py::object invokeScriptMethodFromPython(
     tuple_slice args,
     py::kwargs kwargs) {
   auto self = callee.owner()._ivalue();
+  tensorexpr::AotKernelScope aot_scope(callee.owner().type());
   return runAndInsertCall(
       callee.function(),
       args,
@@ -80,6 +80,24 @@ TORCH_API std::atomic<bool>& getExecutorMode();
 TORCH_API std::atomic<size_t>& getNumProfiledRuns();
 TORCH_API std::atomic<size_t>& getBailoutDepth();
 
+// In dynamic shapes mode, the profiling executor only records the rank of a
+// tensor and which of its dimensions are 1, so that the graph it optimizes,
+// and the fusion groups in it, serve inputs of any size that broadcast the
+// same way.
+TORCH_API std::atomic<bool>& getDynamicShapesMode();
+
+// Counters for diagnosing recompilations in the profiling executor. Every
+// failed guard bails out to a copy of the graph that is profiled and
+// optimized anew, until the bailout depth is exhausted.
+struct GuardStats {
+  uint64_t guard_failures = 0;
+  uint64_t optimized_graphs = 0;
+};
+
+TORCH_API GuardStats getGuardStats();
+TORCH_API void resetGuardStats();
+TORCH_API void recordGuardFailure();
+
 struct TORCH_API GraphOptimizerEnabledGuard {
   GraphOptimizerEnabledGuard(bool state)
       : old_state_(getGraphExecutorOptimize()) {
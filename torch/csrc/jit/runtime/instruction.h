@@ -17,6 +17,11 @@ namespace jit {
 // T - index into the type table, used for guard instructions
 // S - index into object slots
 // C - index into code table
+//
+// The *_SEQ, OP_STORE and OP_JF superinstructions never appear in
+// Code::instructions(). They only appear in the instructions the interpreter
+// runs, where they replace the first instruction of a sequence that they run
+// with a single dispatch (see CodeImpl::insertSuperinstructions).
 
 #define FORALL_OPCODES(_)                                                   \
   _(OP, "O") /* invoke operator X */                                        \
@@ -50,7 +55,12 @@ namespace jit {
   _(ISINSTANCE, "TI") /* check object is one of  types[X:X+N]  */           \
   _(TUPLE_SLICE, "II") /* slice tup[X:(X+N)] */                             \
   _(FORK, "CN") /* launch a thread to run code entry x with N inputs  */    \
-  _(WARN, "") /* emit a warning with line information */
+  _(WARN, "") /* emit a warning with line information */                    \
+  _(LOAD_SEQ, "RI") /* LOAD X, then run the N-1 loads that follow */        \
+  _(MOVE_SEQ, "RI") /* MOVE X, then run the N-1 loads that follow */        \
+  _(LOADC_SEQ, "CI") /* LOADC X, then run the N-1 loads that follow */      \
+  _(OP_STORE, "O") /* invoke operator X, then run the STORE that follows */ \
+  _(OP_JF, "O") /* invoke operator X, then run the JF that follows */
 
 enum OpCode : uint8_t {
 #define DEFINE_OP(op, _) op,
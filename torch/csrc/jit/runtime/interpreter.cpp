@@ -20,8 +20,10 @@
 #include <torch/csrc/jit/runtime/operator.h>
 #include <torch/csrc/jit/runtime/vararg_functions.h>
 
+#include <atomic>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -54,6 +56,11 @@ namespace jit {
 //   indicating whether this is the last use of the value. The interpreter
 //   should generate a move rather than a copy in this case.
 
+std::atomic<bool>& getInterpreterSuperinstructions() {
+  static std::atomic<bool> superinstructions{true};
+  return superinstructions;
+}
+
 TensorTypePtr tensorTypeInCurrentExecutionContext(const at::Tensor& t) {
   if (!t.defined()) {
     return TensorType::get()->withUndefined();
@@ -352,6 +359,10 @@ struct CodeImpl {
   // instruction to be emitted?
   std::vector<Node*> instructions_source_;
 
+  // same length as instructions.
+  // the instructions the interpreter runs, see insertSuperinstructions
+  std::vector<Instruction> run_instructions_;
+
   std::vector<IValue> constant_table_;
   std::vector<Operation> operator_table_;
   std::vector<Function*> function_table_;
@@ -413,6 +424,7 @@ struct CodeImpl {
     // we deferred the emission of bailout blocks so they appear at the end
     // emit them now and patch up the jumps
     insertBailoutBlocks();
+    insertSuperinstructions();
   }
 
   const std::vector<c10::IValue>& constant_table() const {
@@ -428,6 +440,7 @@ struct CodeImpl {
         if (count-- == 0) {
           // patching GUARD to FAIL_GUARD
           instructions_[instr_index].op = FAIL_GUARD;
+          run_instructions_[instr_index].op = FAIL_GUARD;
           GRAPH_DEBUG(
               "Added a bailout request for ",
               index,
@@ -447,6 +460,10 @@ struct CodeImpl {
     return instructions_source_;
   }
 
+  const std::vector<Instruction>& run_instructions() const {
+    return run_instructions_;
+  }
+
   void insertInstruction(OpCode op, int64_t X = 0, uint64_t N = 0) {
     instructions_.emplace_back(op, X, N);
     instructions_source_.emplace_back(current_node_);
@@ -696,6 +713,80 @@ struct CodeImpl {
           instructions_source_[block.jf_instruction_index]);
     }
   }
+
+  // Each instruction costs the interpreter a dispatch, which for cheap
+  // instructions like LOAD or STORE takes longer than the instruction itself.
+  // So in the instructions we run, the first instruction of common sequences
+  // is replaced by a superinstruction that runs the whole sequence:
+  // *  LOAD_SEQ, MOVE_SEQ, LOADC_SEQ: a run of N LOAD, MOVE or LOADC, which
+  //    is how the inputs of an operator are pushed.
+  // *  OP_STORE: an OP whose output is stored to a register.
+  // *  OP_JF: an OP computing the condition of an If.
+  // The rest of a sequence is left in place, as superinstructions read their
+  // other operands from it, so instructions keep their index. Jumps into the
+  // middle of a sequence, and instructions_source_ and request_bailout, which
+  // work with these indices, are unaffected.
+  //
+  // A STORE r directly followed by a MOVE r round trips a value through a
+  // register for nothing, so the STORE is replaced by a jump over both and
+  // the value stays on the stack, unless something jumps to the MOVE.
+  void insertSuperinstructions() {
+    run_instructions_ = instructions_;
+    if (!getInterpreterSuperinstructions()) {
+      return;
+    }
+    const size_t size = instructions_.size();
+    std::vector<bool> is_jump_target(size + 1, false);
+    for (size_t i = 0; i < size; ++i) {
+      const Instruction& inst = instructions_[i];
+      if (inst.op == JF || inst.op == JMP || inst.op == LOOP) {
+        is_jump_target.at(i + inst.X) = true;
+      }
+    }
+    auto is_load = [&](size_t i) {
+      OpCode op = instructions_[i].op;
+      return op == LOAD || op == MOVE || op == LOADC;
+    };
+    auto is_store_move = [&](size_t i) {
+      return instructions_[i].op == STORE && i + 1 < size &&
+          instructions_[i + 1].op == MOVE &&
+          instructions_[i + 1].X == instructions_[i].X &&
+          !is_jump_target[i + 1];
+    };
+
+    size_t i = 0;
+    while (i < size) {
+      const Instruction& inst = instructions_[i];
+      if (is_store_move(i)) {
+        run_instructions_[i] = Instruction(JMP, 2, 0);
+        i += 2;
+      } else if (is_load(i)) {
+        size_t end = i + 1;
+        while (end < size && is_load(end) &&
+               end - i < std::numeric_limits<uint16_t>::max()) {
+          ++end;
+        }
+        if (end - i > 1) {
+          OpCode op = inst.op == LOAD ? LOAD_SEQ
+                                      : inst.op == MOVE ? MOVE_SEQ : LOADC_SEQ;
+          run_instructions_[i] = Instruction(op, inst.X, end - i);
+        }
+        i = end;
+      } else if (inst.op == OP && i + 1 < size && !is_store_move(i + 1)) {
+        OpCode next = instructions_[i + 1].op;
+        if (next == STORE || next == JF) {
+          run_instructions_[i] =
+              Instruction(next == STORE ? OP_STORE : OP_JF, inst.X, 0);
+          i += 2;
+        } else {
+          ++i;
+        }
+      } else {
+        ++i;
+      }
+    }
+  }
+
   void emitInterfaceCall(
       std::string method_name_str,
       c10::ArrayRef<Value*> inputs) {
@@ -870,6 +961,26 @@ struct CodeImpl {
   }
 };
 
+// With GCC and clang, every instruction jumps directly to the code of the
+// next one through a table of label addresses, rather than through the single
+// indirect branch of the switch, which lets the branch predictor learn which
+// instruction tends to follow which.
+#if defined(__GNUC__) || defined(__clang__)
+#define JIT_USE_COMPUTED_GOTO
+#endif
+
+#ifdef JIT_USE_COMPUTED_GOTO
+#define INST(NAME) \
+  case NAME:       \
+  label_##NAME:
+#define DISPATCH()                 \
+  inst = af.instructions[af.pc];   \
+  goto* dispatch_table[inst.op]
+#else
+#define INST(NAME) case NAME:
+#define DISPATCH() break
+#endif
+
 // InterpreterState state that and used to compute a Code
 struct InterpreterStateImpl : c10::intrusive_ptr_target {
   InterpreterStateImpl(const Code& code) {
@@ -923,7 +1034,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
     ActiveFrame(const Frame& frame)
         : pc(frame.pc),
-          instructions(frame.function->instructions_.data()),
+          instructions(frame.function->run_instructions_.data()),
           constants(frame.function->constant_table_.data()),
           operators(frame.function->operator_table_.data()),
           functions(frame.function->function_table_.data()),
@@ -989,6 +1100,22 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
     *af = ActiveFrame(frames.back());
   }
 
+  // Runs the loads that follow the first one of a LOAD_SEQ, MOVE_SEQ or
+  // LOADC_SEQ of n loads, and moves past the sequence.
+  void runLoads(Stack& stack, ActiveFrame& af, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+      const Instruction& load = af.instructions[af.pc + i];
+      if (load.op == LOAD) {
+        stack.emplace_back(reg(load.X));
+      } else if (load.op == MOVE) {
+        stack.emplace_back(std::move(reg(load.X)));
+      } else {
+        stack.emplace_back(af.constants[load.X]);
+      }
+    }
+    af.pc += n;
+  }
+
   bool runImpl(Stack& stack) {
     // if we have never run before, then we might have to return the
     // stack when we suspend, record where it starts so we return the right
@@ -1004,69 +1131,76 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
     ActiveFrame af(frames.back());
     try {
+#ifdef JIT_USE_COMPUTED_GOTO
+      static void* dispatch_table[] = {
+#define DISPATCH_LABEL(op, _) &&label_##op,
+          FORALL_OPCODES(DISPATCH_LABEL)
+#undef DISPATCH_LABEL
+      };
+#endif
       while (true) {
         // std::cout << "RUNNING ";
         // frames.back().function->dump(std::cout, af.pc);
         Instruction inst = af.instructions[af.pc];
         switch (inst.op) {
-          case OP:
+          INST(OP)
             af.operators[inst.X](stack);
             ++af.pc;
-            break;
-          case OPN:
+            DISPATCH();
+          INST(OPN)
             stack.push_back(inst.N);
             af.operators[inst.X](stack);
             ++af.pc;
-            break;
-          case LOAD:
+            DISPATCH();
+          INST(LOAD)
             stack.emplace_back(reg(inst.X));
             ++af.pc;
-            break;
-          case MOVE:
+            DISPATCH();
+          INST(MOVE)
             stack.emplace_back(std::move(reg(inst.X)));
             ++af.pc;
-            break;
-          case STORE:
+            DISPATCH();
+          INST(STORE)
             reg(inst.X) = pop(stack);
             ++af.pc;
-            break;
-          case STOREN:
+            DISPATCH();
+          INST(STOREN)
             for (size_t i = inst.N; i > 0; --i) {
               reg(inst.X + i - 1) = pop(stack);
             }
             ++af.pc;
-            break;
-          case DROP:
+            DISPATCH();
+          INST(DROP)
             pop(stack);
             ++af.pc;
-            break;
-          case DROPR:
+            DISPATCH();
+          INST(DROPR)
             reg(inst.X) = IValue();
             ++af.pc;
-            break;
-          case LOADC:
+            DISPATCH();
+          INST(LOADC)
             stack.emplace_back(af.constants[inst.X]);
             ++af.pc;
-            break;
-          case GET_ATTR: {
+            DISPATCH();
+          INST(GET_ATTR) {
             auto userObj = pop(stack).toObject();
             auto value = userObj->getSlot(inst.X);
             push(stack, std::move(value));
             ++af.pc;
-          } break;
-          case SET_ATTR: {
+          } DISPATCH();
+          INST(SET_ATTR) {
             auto v = pop(stack);
             auto userObj = pop(stack).toObject();
             userObj->setSlot(inst.X, std::move(v));
             ++af.pc;
-          } break;
-          case JF:
+          } DISPATCH();
+          INST(JF)
             af.pc += (pop(stack).toBool()) ? 1 : inst.X;
-            break;
-          case JMP:
+            DISPATCH();
+          INST(JMP)
             af.pc += inst.X;
-            break;
-          case LOOP: {
+            DISPATCH();
+          INST(LOOP) {
             // stack: iteration_count, max_iter, cond, loop_carried_deps...
             auto frame = stack.end() - (inst.N + 1);
             int64_t trip_count = frame[0].toInt();
@@ -1084,16 +1218,16 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               drop(stack, 3); // iteration_count, max_iter, cond
               af.pc += inst.X;
             }
-          } break;
-          case CALL: {
+          } DISPATCH();
+          INST(CALL) {
             Function* fn = af.functions[inst.X];
             if (!fn->isGraphFunction()) {
               runBuiltinFunction(stack, fn, &af);
             } else {
               runGraphFunction(stack, fn, &af);
             }
-          } break;
-          case INTERFACE_CALL: {
+          } DISPATCH();
+          INST(INTERFACE_CALL) {
             // note the hash table lookup to find the function
             // this can be more optimized if necessary, caching parts
             // of the hashing computation or storing the offset when
@@ -1115,12 +1249,12 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             } else {
               runGraphFunction(stack, function, &af);
             }
-          } break;
-          case RET:
+          } DISPATCH();
+          INST(RET)
             if (frames.size() > 1) {
               leaveFrame();
               af = ActiveFrame(frames.back());
-              break;
+              DISPATCH();
             }
             if (future_) {
               auto num_outputs = frames.back().function->n_outputs;
@@ -1132,7 +1266,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               }
             }
             return false;
-          case WAIT: {
+          INST(WAIT) {
             auto future = stack.back().toFuture();
             if (!future->completed()) {
               getOrCreateFuture();
@@ -1179,17 +1313,19 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             stack.pop_back();
             stack.emplace_back(future->value());
             ++af.pc;
-          } break;
-          case FAIL_GUARD: {
+          } DISPATCH();
+          INST(FAIL_GUARD) {
             // patch FAIL_GUARD back to GUARD
             GRAPH_DEBUG(
                 "Bailout ", inst.X, " triggered via bailout_requests_!");
+            // in both copies of the instructions, see request_bailout
             af.instructions[af.pc].op = GUARD;
+            frames.back().function->instructions_[af.pc].op = GUARD;
             push(stack, false);
             ++af.pc;
-            break;
+            DISPATCH();
           }
-          case GUARD: {
+          INST(GUARD) {
             if (!stack.back().isTensor()) {
               // stack.back() is an Uninitialized IValue and this is a guard
               // on a block output. Uninitialized IValues are never used
@@ -1200,11 +1336,14 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               const TypePtr& expected = af.types[inst.X];
               bool comp = expected->cast<TensorType>()
                               ->isCompatibleWithInCurrentExecutionContext(t);
+              if (!comp) {
+                recordGuardFailure();
+              }
               push(stack, comp);
             }
             ++af.pc;
-          } break;
-          case TAIL_CALL: {
+          } DISPATCH();
+          INST(TAIL_CALL) {
             GRAPH_DEBUG("running TAIL_CALL for ", inst.X);
             af.functions[inst.X]->ensure_defined();
             size_t remaining_bailout_depth =
@@ -1227,46 +1366,46 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             leaveFrame();
             enterFrame(code, base_pointer);
             af = ActiveFrame(frames.back());
-          } break;
-          case LIST_UNPACK: {
+          } DISPATCH();
+          INST(LIST_UNPACK) {
             listUnpack(stack, inst.X);
             ++af.pc;
-          } break;
-          case TUPLE_CONSTRUCT: {
+          } DISPATCH();
+          INST(TUPLE_CONSTRUCT) {
             tupleConstruct(stack, inst.X);
             ++af.pc;
-          } break;
-          case TUPLE_SLICE: {
+          } DISPATCH();
+          INST(TUPLE_SLICE) {
             tupleSlice(stack, inst.X, inst.X + inst.N);
             ++af.pc;
-          } break;
-          case NAMED_TUPLE_CONSTRUCT: {
+          } DISPATCH();
+          INST(NAMED_TUPLE_CONSTRUCT) {
             auto type = af.types[inst.X]->expect<TupleType>();
             namedTupleConstruct(stack, type, inst.N);
             ++af.pc;
-          } break;
-          case LIST_CONSTRUCT: {
+          } DISPATCH();
+          INST(LIST_CONSTRUCT) {
             auto type = af.types[inst.X]->expect<ListType>();
             listConstruct(stack, type, inst.N);
             ++af.pc;
-          } break;
-          case DICT_CONSTRUCT: {
+          } DISPATCH();
+          INST(DICT_CONSTRUCT) {
             auto type = af.types[inst.X]->expect<DictType>();
             dictConstruct(stack, type, inst.N);
             ++af.pc;
-          } break;
-          case CREATE_OBJECT: {
+          } DISPATCH();
+          INST(CREATE_OBJECT) {
             auto type = af.types[inst.X]->expect<ClassType>();
             createObject(stack, type);
             ++af.pc;
-          } break;
-          case ISINSTANCE: {
+          } DISPATCH();
+          INST(ISINSTANCE) {
             at::ArrayRef<TypePtr> types(
                 af.types + inst.X, af.types + inst.X + inst.N);
             isinstance(stack, types);
             ++af.pc;
-          } break;
-          case FORK: {
+          } DISPATCH();
+          INST(FORK) {
             // Move inputs to a separate stack
             InterpreterState forked_interpreter(
                 frames.back().function->code_table_.at(inst.X));
@@ -1278,8 +1417,8 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             push(stack, forked_interpreter.getFuture());
             at::launch(std::move(continuation));
             ++af.pc;
-          } break;
-          case WARN: {
+          } DISPATCH();
+          INST(WARN) {
             Node* node = frames.back().function->instructions_source_.at(af.pc);
             auto range = node->sourceRange().source();
             if (range->filename()) {
@@ -1293,7 +1432,29 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               TORCH_WARN(pop(stack).toStringRef());
             }
             ++af.pc;
-          } break;
+          } DISPATCH();
+          INST(LOAD_SEQ) {
+            stack.emplace_back(reg(inst.X));
+            runLoads(stack, af, inst.N);
+          } DISPATCH();
+          INST(MOVE_SEQ) {
+            stack.emplace_back(std::move(reg(inst.X)));
+            runLoads(stack, af, inst.N);
+          } DISPATCH();
+          INST(LOADC_SEQ) {
+            stack.emplace_back(af.constants[inst.X]);
+            runLoads(stack, af, inst.N);
+          } DISPATCH();
+          INST(OP_STORE) {
+            af.operators[inst.X](stack);
+            reg(af.instructions[af.pc + 1].X) = pop(stack);
+            af.pc += 2;
+          } DISPATCH();
+          INST(OP_JF) {
+            af.operators[inst.X](stack);
+            ++af.pc;
+            af.pc += (pop(stack).toBool()) ? 1 : af.instructions[af.pc].X;
+          } DISPATCH();
         }
       }
     } catch (std::exception& e) {
@@ -1374,6 +1535,9 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
   }
 };
 
+#undef INST
+#undef DISPATCH
+
 std::ostream& operator<<(std::ostream& out, const Code& code) {
   out << *code.pImpl->graph_ << "\n";
   code.pImpl->dump(out);
@@ -1418,6 +1582,10 @@ const std::vector<Instruction>& Code::instructions() const {
   return pImpl->instructions();
 }
 
+const std::vector<Instruction>& Code::run_instructions() const {
+  return pImpl->run_instructions();
+}
+
 const std::vector<Node*>& Code::instructions_source() const {
   return pImpl->instructions_source();
 }
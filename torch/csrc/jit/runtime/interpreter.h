@@ -1,5 +1,6 @@
 #pragma once
 #include <c10/util/Optional.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -54,6 +55,9 @@ struct TORCH_API Code {
   const std::vector<c10::IValue>& constant_table() const;
   const std::vector<c10::TypePtr>& type_table() const;
   const std::vector<Instruction>& instructions() const;
+  // The instructions the interpreter runs: instructions() with common
+  // sequences fused into superinstructions.
+  const std::vector<Instruction>& run_instructions() const;
   const std::vector<Node*>& instructions_source() const;
   void request_bailout(size_t index);
   size_t register_size() const;
@@ -110,6 +114,11 @@ struct InterpreterContinuation {
   torch::ThreadLocalState thread_local_state;
 };
 
+// Whether newly created Code fuses common instruction sequences into
+// superinstructions. On by default, turning it off is mostly useful to
+// measure what they save.
+TORCH_API std::atomic<bool>& getInterpreterSuperinstructions();
+
 // what is the tensors type, including state from the current execution context
 // that modifies how the tensor behaves. For instance if no_grad is enabled
 // this will cause the TensorType to have requires_grad=False.
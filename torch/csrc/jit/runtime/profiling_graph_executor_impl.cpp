@@ -34,6 +34,10 @@ static std::atomic<bool> profiling_mode{true};
 
 static std::atomic<size_t> num_profiled_runs{1};
 static std::atomic<size_t> bailout_depth{1};
+static std::atomic<bool> dynamic_shapes_mode{false};
+
+static std::atomic<uint64_t> num_guard_failures{0};
+static std::atomic<uint64_t> num_optimized_graphs{0};
 
 std::atomic<bool>& getProfilingMode() {
   return profiling_mode;
@@ -50,6 +54,26 @@ std::atomic<size_t>& getBailoutDepth() {
   return bailout_depth;
 }
 
+std::atomic<bool>& getDynamicShapesMode() {
+  return dynamic_shapes_mode;
+}
+
+GuardStats getGuardStats() {
+  GuardStats stats;
+  stats.guard_failures = num_guard_failures.load();
+  stats.optimized_graphs = num_optimized_graphs.load();
+  return stats;
+}
+
+void resetGuardStats() {
+  num_guard_failures = 0;
+  num_optimized_graphs = 0;
+}
+
+void recordGuardFailure() {
+  ++num_guard_failures;
+}
+
 static bool needsGradientInProfilingMode(Block* b) {
   for (auto n : b->nodes()) {
     if (n->kind() == prim::BailOut) {
@@ -155,6 +179,7 @@ ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(
     auto copy = graph->copy();
     runProfilingInsensitiveOptimizations(copy);
     GRAPH_DUMP("Optimized SimpleExecutor Graph : ", copy);
+    ++num_optimized_graphs;
     optimized_plan_ = ExecutionPlan(copy, function_name_);
     return *optimized_plan_;
   }
@@ -177,6 +202,7 @@ ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(
 
   auto copy = pr_->graph()->copy();
   runProfilingOptimizations(copy);
+  ++num_optimized_graphs;
   // cache
   optimized_plan_ =
       ExecutionPlan(copy, function_name_, remaining_bailout_depth);
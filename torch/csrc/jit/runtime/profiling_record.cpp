@@ -47,6 +47,39 @@ static void unprofileBlock(Block* start_block) {
   }
 }
 
+// Keeps the dimensions of size 1, which decide how a tensor broadcasts, and
+// drops the sizes of all others together with the strides that depend on
+// them. Only the unit stride of the innermost dimension that is not 1 is kept,
+// as it does not depend on any size. Profiles of different runs merge as
+// usual, so a dimension that is 1 in some runs only is dropped as well.
+static TensorTypePtr symbolicShapeType(const TensorTypePtr& type) {
+  const auto& sizes = type->sizes().sizes();
+  const auto& strides = type->strides().sizes();
+  if (!sizes || !strides || sizes->size() != strides->size()) {
+    return type;
+  }
+  c10::VaryingShape::ListOfOptionalInts symbolic_sizes(sizes->size());
+  c10::VaryingShape::ListOfOptionalInts symbolic_strides(sizes->size());
+  bool innermost = true;
+  for (size_t i = sizes->size(); i-- > 0;) {
+    if ((*sizes)[i] == 1) {
+      symbolic_sizes[i] = 1;
+    } else {
+      if (innermost && (*strides)[i] == 1) {
+        symbolic_strides[i] = 1;
+      }
+      innermost = false;
+    }
+  }
+  return TensorType::create(
+      type->scalarType(),
+      type->device(),
+      c10::VaryingShape(std::move(symbolic_sizes)),
+      c10::VaryingShape(std::move(symbolic_strides)),
+      type->requiresGrad(),
+      type->undefined());
+}
+
 void ProfilingRecord::insertShapeProfile(Node* n, Value* i) {
   auto pn = createProfileNode(nullptr, {i});
   auto pno = pn->addOutput();
@@ -59,6 +92,9 @@ void ProfilingRecord::insertShapeProfile(Node* n, Value* i) {
         if (t.isTensor()) {
           if (t.toTensor().defined()) {
             auto pttp = tensorTypeInCurrentExecutionContext(t.toTensor());
+            if (getDynamicShapesMode()) {
+              pttp = symbolicShapeType(pttp);
+            }
             std::lock_guard<std::mutex> lock(this->mutex_);
             if (auto type = pno->type()->cast<TensorType>()) {
               if (!first) {
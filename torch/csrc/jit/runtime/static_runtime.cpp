@@ -0,0 +1,481 @@
+#include <torch/csrc/jit/runtime/static_runtime.h>
+
+#include <ATen/ATen.h>
+#include <ATen/core/grad_mode.h>
+#include <c10/core/CPUAllocator.h>
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/ir/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/constant_propagation.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include <torch/csrc/jit/passes/freeze_module.h>
+#include <torch/csrc/jit/passes/inliner.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+inline const IValue& input(ProcessedNode& pn, IValue* slots, size_t i) {
+  return slots[pn.inputs[i]];
+}
+
+inline IValue& output(ProcessedNode& pn, IValue* slots) {
+  return slots[pn.outputs[0]];
+}
+
+inline at::Tensor optionalTensor(const IValue& v) {
+  return v.isNone() ? at::Tensor() : v.toTensor();
+}
+
+// Writes the result into the tensor left in the output slot by the previous
+// run if the node may reuse it and it has the dtype and device the result
+// will have; stores a newly allocated result otherwise.
+template <typename Functional, typename OutVariant>
+inline void runOutVariant(
+    ProcessedNode& pn,
+    IValue* slots,
+    at::ScalarType dtype,
+    at::Device device,
+    Functional functional,
+    OutVariant out_variant) {
+  IValue& out = output(pn, slots);
+  if (pn.reuse_output && out.isTensor()) {
+    at::Tensor result = out.toTensor();
+    if (result.scalar_type() == dtype && result.device() == device) {
+      out_variant(result);
+      return;
+    }
+  }
+  out = functional();
+}
+
+struct KernelEntry {
+  // Schema in the form accepted by Node::matches.
+  const char* schema;
+  StaticKernel kernel;
+  // Whether the kernel goes through runOutVariant.
+  bool has_out_variant;
+};
+
+const std::vector<KernelEntry>& kernelTable() {
+  static const std::vector<KernelEntry> table = {
+      {"aten::add(Tensor self, Tensor other, *, Scalar alpha) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto other = input(pn, slots, 1).toTensor();
+         auto alpha = input(pn, slots, 2).toScalar();
+         runOutVariant(
+             pn, slots, at::result_type(self, other), self.device(),
+             [&] { return at::add(self, other, alpha); },
+             [&](at::Tensor& out) { at::add_out(out, self, other, alpha); });
+       },
+       true},
+      {"aten::sub(Tensor self, Tensor other, *, Scalar alpha) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto other = input(pn, slots, 1).toTensor();
+         auto alpha = input(pn, slots, 2).toScalar();
+         runOutVariant(
+             pn, slots, at::result_type(self, other), self.device(),
+             [&] { return at::sub(self, other, alpha); },
+             [&](at::Tensor& out) { at::sub_out(out, self, other, alpha); });
+       },
+       true},
+      {"aten::mul(Tensor self, Tensor other) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto other = input(pn, slots, 1).toTensor();
+         runOutVariant(
+             pn, slots, at::result_type(self, other), self.device(),
+             [&] { return at::mul(self, other); },
+             [&](at::Tensor& out) { at::mul_out(out, self, other); });
+       },
+       true},
+      {"aten::div(Tensor self, Tensor other) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto other = input(pn, slots, 1).toTensor();
+         runOutVariant(
+             pn, slots, at::result_type(self, other), self.device(),
+             [&] { return at::div(self, other); },
+             [&](at::Tensor& out) { at::div_out(out, self, other); });
+       },
+       true},
+      {"aten::mm(Tensor self, Tensor mat2) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto mat2 = input(pn, slots, 1).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::mm(self, mat2); },
+             [&](at::Tensor& out) { at::mm_out(out, self, mat2); });
+       },
+       true},
+      {"aten::bmm(Tensor self, Tensor mat2) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto mat2 = input(pn, slots, 1).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::bmm(self, mat2); },
+             [&](at::Tensor& out) { at::bmm_out(out, self, mat2); });
+       },
+       true},
+      {"aten::matmul(Tensor self, Tensor other) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto other = input(pn, slots, 1).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::matmul(self, other); },
+             [&](at::Tensor& out) { at::matmul_out(out, self, other); });
+       },
+       true},
+      {"aten::addmm(Tensor self, Tensor mat1, Tensor mat2, *, Scalar beta, Scalar alpha) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto mat1 = input(pn, slots, 1).toTensor();
+         auto mat2 = input(pn, slots, 2).toTensor();
+         auto beta = input(pn, slots, 3).toScalar();
+         auto alpha = input(pn, slots, 4).toScalar();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::addmm(self, mat1, mat2, beta, alpha); },
+             [&](at::Tensor& out) {
+               at::addmm_out(out, self, mat1, mat2, beta, alpha);
+             });
+       },
+       true},
+      // relu is threshold(self, 0, 0), which has an out= variant.
+      {"aten::relu(Tensor self) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::relu(self); },
+             [&](at::Tensor& out) { at::threshold_out(out, self, 0, 0); });
+       },
+       true},
+      {"aten::sigmoid(Tensor self) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::sigmoid(self); },
+             [&](at::Tensor& out) { at::sigmoid_out(out, self); });
+       },
+       true},
+      {"aten::tanh(Tensor self) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::tanh(self); },
+             [&](at::Tensor& out) { at::tanh_out(out, self); });
+       },
+       true},
+      {"aten::adaptive_avg_pool2d(Tensor self, int[] output_size) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         auto self = input(pn, slots, 0).toTensor();
+         auto output_size = input(pn, slots, 1).toIntVector();
+         runOutVariant(
+             pn, slots, self.scalar_type(), self.device(),
+             [&] { return at::adaptive_avg_pool2d(self, output_size); },
+             [&](at::Tensor& out) {
+               at::adaptive_avg_pool2d_out(out, self, output_size);
+             });
+       },
+       true},
+      {"aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::linear(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toTensor(),
+             optionalTensor(input(pn, slots, 2)));
+       },
+       false},
+      {"aten::gelu(Tensor self) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::gelu(input(pn, slots, 0).toTensor());
+       },
+       false},
+      {"aten::softmax(Tensor self, int dim, ScalarType? dtype) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         const IValue& dtype = input(pn, slots, 2);
+         output(pn, slots) = at::softmax(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toInt(),
+             dtype.isNone()
+                 ? c10::optional<at::ScalarType>()
+                 : c10::optional<at::ScalarType>(dtype.toScalarType()));
+       },
+       false},
+      {"aten::layer_norm(Tensor input, int[] normalized_shape, Tensor? weight, Tensor? bias, float eps, bool cudnn_enable) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::layer_norm(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toIntVector(),
+             optionalTensor(input(pn, slots, 2)),
+             optionalTensor(input(pn, slots, 3)),
+             input(pn, slots, 4).toDouble(),
+             input(pn, slots, 5).toBool());
+       },
+       false},
+      {"aten::conv2d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::conv2d(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toTensor(),
+             optionalTensor(input(pn, slots, 2)),
+             input(pn, slots, 3).toIntVector(),
+             input(pn, slots, 4).toIntVector(),
+             input(pn, slots, 5).toIntVector(),
+             input(pn, slots, 6).toInt());
+       },
+       false},
+      {"aten::batch_norm(Tensor input, Tensor? weight, Tensor? bias, Tensor? running_mean, Tensor? running_var, bool training, float momentum, float eps, bool cudnn_enabled) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::batch_norm(
+             input(pn, slots, 0).toTensor(),
+             optionalTensor(input(pn, slots, 1)),
+             optionalTensor(input(pn, slots, 2)),
+             optionalTensor(input(pn, slots, 3)),
+             optionalTensor(input(pn, slots, 4)),
+             input(pn, slots, 5).toBool(),
+             input(pn, slots, 6).toDouble(),
+             input(pn, slots, 7).toDouble(),
+             input(pn, slots, 8).toBool());
+       },
+       false},
+      {"aten::max_pool2d(Tensor self, int[] kernel_size, int[] stride, int[] padding, int[] dilation, bool ceil_mode) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::max_pool2d(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toIntVector(),
+             input(pn, slots, 2).toIntVector(),
+             input(pn, slots, 3).toIntVector(),
+             input(pn, slots, 4).toIntVector(),
+             input(pn, slots, 5).toBool());
+       },
+       false},
+      {"aten::flatten(Tensor self, int start_dim, int end_dim) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::flatten(
+             input(pn, slots, 0).toTensor(),
+             input(pn, slots, 1).toInt(),
+             input(pn, slots, 2).toInt());
+       },
+       false},
+      {"aten::t(Tensor self) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = input(pn, slots, 0).toTensor().t();
+       },
+       false},
+      {"aten::transpose(Tensor self, int dim0, int dim1) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = input(pn, slots, 0).toTensor().transpose(
+             input(pn, slots, 1).toInt(), input(pn, slots, 2).toInt());
+       },
+       false},
+      {"aten::permute(Tensor self, int[] dims) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = input(pn, slots, 0).toTensor().permute(
+             input(pn, slots, 1).toIntVector());
+       },
+       false},
+      {"aten::view(Tensor self, int[] size) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = input(pn, slots, 0).toTensor().view(
+             input(pn, slots, 1).toIntVector());
+       },
+       false},
+      {"aten::reshape(Tensor self, int[] shape) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = input(pn, slots, 0).toTensor().reshape(
+             input(pn, slots, 1).toIntVector());
+       },
+       false},
+      {"aten::cat(Tensor[] tensors, int dim) -> Tensor",
+       [](ProcessedNode& pn, IValue* slots) {
+         output(pn, slots) = at::cat(
+             input(pn, slots, 0).toTensorVector(), input(pn, slots, 1).toInt());
+       },
+       false},
+  };
+  return table;
+}
+
+} // namespace
+
+StaticRuntime::StaticRuntime(const Module& module) {
+  Module frozen = freeze_module(module);
+  graph_ = frozen.get_method("forward").graph()->copy();
+  Inline(*graph_);
+  TORCH_CHECK(
+      !graph_->inputs().at(0)->hasUses(),
+      "StaticRuntime requires a module whose forward does not access ",
+      "attributes after freezing");
+  graph_->eraseInput(0);
+  prepare(/*plan_memory=*/false);
+}
+
+StaticRuntime::StaticRuntime(std::shared_ptr<Graph> graph, bool plan_memory)
+    : graph_(graph->copy()) {
+  Inline(*graph_);
+  prepare(plan_memory);
+}
+
+void StaticRuntime::prepare(bool plan_memory) {
+  ConstantPropagation(graph_);
+  EliminateDeadCode(graph_);
+  if (plan_memory) {
+    PlanMemory(graph_);
+  }
+  AliasDb alias_db(graph_);
+
+  std::unordered_map<Value*, size_t> slot;
+  auto addSlot = [&](Value* v) { slot.emplace(v, slot.size()); };
+  for (Value* v : graph_->inputs()) {
+    addSlot(v);
+  }
+  for (Node* n : graph_->nodes()) {
+    TORCH_CHECK(
+        n->blocks().empty(),
+        "StaticRuntime only supports graphs without control flow, found ",
+        n->kind().toQualString());
+    TORCH_CHECK(
+        n->kind() != prim::GetAttr && n->kind() != prim::SetAttr &&
+            n->kind() != prim::CallMethod && n->kind() != prim::CallFunction,
+        "StaticRuntime does not support ",
+        n->kind().toQualString());
+    for (Value* v : n->outputs()) {
+      addSlot(v);
+    }
+  }
+  slots_.resize(slot.size());
+
+  // Constants, planned tensors and reused outputs stay in their slots between
+  // runs.
+  std::unordered_set<size_t> persistent;
+  for (Node* n : graph_->nodes()) {
+    if (n->kind() == prim::Constant) {
+      size_t i = slot.at(n->output());
+      slots_[i] = *toIValue(n->output());
+      persistent.insert(i);
+      continue;
+    }
+    // The runtime owns the arena, so it is allocated and the planned tensors
+    // are created once here rather than by their nodes on every run.
+    if (IsMemoryPlanArena(n)) {
+      arena_bytes_ = ArenaBytes(n);
+      arena_ = c10::GetCPUAllocator()->allocate(arena_bytes_);
+      continue;
+    }
+    if (IsPlannedTensor(n)) {
+      size_t i = slot.at(n->output());
+      slots_[i] = PlannedTensorIn(n, arena_.get());
+      persistent.insert(i);
+      continue;
+    }
+    ProcessedNode pn;
+    pn.node = n;
+    for (Value* v : n->inputs()) {
+      pn.inputs.push_back(slot.at(v));
+    }
+    for (Value* v : n->outputs()) {
+      pn.outputs.push_back(slot.at(v));
+    }
+    for (const auto& entry : kernelTable()) {
+      if (n->matches(entry.schema)) {
+        pn.kernel = entry.kernel;
+        pn.reuse_output = entry.has_out_variant &&
+            !alias_db.mayContainAlias({n->output()}, graph_->outputs());
+        break;
+      }
+    }
+    if (pn.reuse_output) {
+      persistent.insert(pn.outputs[0]);
+    }
+    if (!pn.kernel) {
+      GRAPH_DEBUG("No unboxed kernel for ", *n);
+      pn.op = n->getOperation();
+    }
+    nodes_.push_back(std::move(pn));
+  }
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (!persistent.count(i)) {
+      transient_slots_.push_back(i);
+    }
+  }
+  for (Value* v : graph_->outputs()) {
+    output_slots_.push_back(slot.at(v));
+  }
+  GRAPH_DEBUG(
+      "StaticRuntime: ", num_unboxed_nodes(), " unboxed and ",
+      num_boxed_nodes(), " boxed nodes");
+}
+
+size_t StaticRuntime::num_unboxed_nodes() const {
+  return std::count_if(
+      nodes_.begin(), nodes_.end(), [](const ProcessedNode& pn) {
+        return pn.kernel != nullptr;
+      });
+}
+
+IValue StaticRuntime::run(std::vector<IValue> inputs) {
+  TORCH_CHECK(
+      inputs.size() == graph_->inputs().size(),
+      "Expected ",
+      graph_->inputs().size(),
+      " inputs but got ",
+      inputs.size());
+  // Out= variants do not support autograd, and this is an inference runtime.
+  at::NoGradGuard no_grad;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    slots_[i] = std::move(inputs[i]);
+  }
+  IValue* slots = slots_.data();
+  stack_.clear();
+  for (ProcessedNode& pn : nodes_) {
+    if (pn.kernel) {
+      pn.kernel(pn, slots);
+      continue;
+    }
+    for (size_t i : pn.inputs) {
+      stack_.push_back(slots[i]);
+    }
+    pn.op(stack_);
+    const size_t num_outputs = pn.outputs.size();
+    for (size_t i = 0; i < num_outputs; ++i) {
+      slots[pn.outputs[i]] = std::move(stack_[stack_.size() - num_outputs + i]);
+    }
+    drop(stack_, num_outputs);
+  }
+
+  IValue result;
+  if (output_slots_.size() == 1) {
+    result = slots[output_slots_[0]];
+  } else {
+    std::vector<IValue> outputs;
+    for (size_t i : output_slots_) {
+      outputs.push_back(slots[i]);
+    }
+    result = c10::ivalue::Tuple::create(std::move(outputs));
+  }
+  for (size_t i : transient_slots_) {
+    slots[i] = IValue();
+  }
+  return result;
+}
+
+IValue StaticRuntime::run(const std::vector<at::Tensor>& inputs) {
+  return run(std::vector<IValue>(inputs.begin(), inputs.end()));
+}
+
+} // namespace jit
+} // namespace torch
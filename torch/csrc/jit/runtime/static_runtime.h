@@ -0,0 +1,96 @@
+/** \brief An executor for frozen, straight-line inference graphs.
+ *
+ * Most models are a straight sequence of tensor ops once frozen, yet running
+ * them through the GraphExecutor pays for the interpreter's stack machine on
+ * every node: inputs are pushed as boxed IValues, the op is called through
+ * its Operation and outputs are popped into registers.
+ *
+ * StaticRuntime instead resolves every node once, when it is created. Each
+ * value gets a fixed slot, constants are loaded into their slots up front,
+ * and ops with a known signature call the unboxed ATen entry point directly
+ * on the slots. Where the op has an out= variant and its output never leaves
+ * the graph, the tensor from the previous run is reused as the output, so a
+ * steady-state run makes no allocations for those intermediates. All other
+ * ops fall back to their boxed Operation.
+ *
+ * With plan_memory, a graph whose intermediates have complete types (e.g. from
+ * _jit_pass_complete_shape_analysis) goes through PlanMemory: the planned
+ * intermediates are placed in one arena that is allocated with the runtime and
+ * reused by every run. Inputs must then keep the shapes planned for.
+ *
+ * Graphs with control flow, or modules that still access attributes after
+ * freezing, are rejected. A StaticRuntime holds per-run state and must not be
+ * run from several threads at once; create one per thread instead.
+ */
+#pragma once
+
+#include <torch/csrc/jit/api/module.h>
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+struct ProcessedNode;
+
+// Runs the node on the value slots of the runtime.
+using StaticKernel = void (*)(ProcessedNode&, IValue* slots);
+
+struct ProcessedNode {
+  Node* node;
+  std::vector<size_t> inputs;
+  std::vector<size_t> outputs;
+  // Unboxed kernel, or nullptr to run the boxed Operation below.
+  StaticKernel kernel = nullptr;
+  Operation op;
+  // Whether the output may be kept across runs and written to again by an
+  // out= kernel, i.e. it does not alias anything leaving the graph.
+  bool reuse_output = false;
+};
+
+class TORCH_API StaticRuntime {
+ public:
+  // Freezes a copy of the module (which must be in eval mode) and prepares
+  // its forward method.
+  explicit StaticRuntime(const Module& module);
+  // graph must not take the module as an input.
+  explicit StaticRuntime(
+      std::shared_ptr<Graph> graph,
+      bool plan_memory = false);
+
+  IValue run(std::vector<IValue> inputs);
+  IValue run(const std::vector<at::Tensor>& inputs);
+
+  const std::shared_ptr<Graph>& graph() const {
+    return graph_;
+  }
+
+  // Number of nodes that dispatch to an unboxed kernel, and that fall back to
+  // their boxed Operation.
+  size_t num_unboxed_nodes() const;
+  size_t num_boxed_nodes() const {
+    return nodes_.size() - num_unboxed_nodes();
+  }
+
+  // Size of the memory planning arena, 0 if no values were planned.
+  size_t arena_bytes() const {
+    return arena_bytes_;
+  }
+
+ private:
+  void prepare(bool plan_memory);
+
+  std::shared_ptr<Graph> graph_;
+  // Slots of all values; the first ones hold the graph inputs.
+  std::vector<IValue> slots_;
+  // Slots to clear after a run so that no references are held between runs.
+  std::vector<size_t> transient_slots_;
+  std::vector<size_t> output_slots_;
+  std::vector<ProcessedNode> nodes_;
+  Stack stack_;
+  // Memory of the planned values, which live in persistent slots.
+  at::DataPtr arena_;
+  size_t arena_bytes_ = 0;
+};
+
+} // namespace jit
+} // namespace torch
@@ -71,6 +71,17 @@ TORCH_API void ExportModule(
     const ExtraFilesMap& metadata = ExtraFilesMap(),
     bool bytecode_format = false);
 
+// Compiles the TensorExpr fusion groups that running method_name on each of
+// example_inputs creates, so that the archives module is exported to hold
+// their object code. Loading such an archive links the kernels instead of
+// compiling them, as long as the inputs have the example shapes, strides,
+// dtypes and grad mode and the host has the same CPU. Returns the number of
+// kernels.
+TORCH_API size_t CompileTensorExprAot(
+    const Module& module,
+    const std::string& method_name,
+    const std::vector<Stack>& example_inputs);
+
 // Write the bytes of a pickle archive and the tensors referenced inside that
 // archive
 TORCH_API void writeArchiveAndTensors(
@@ -2,16 +2,21 @@
 
 #include <c10/util/Exception.h>
 #include <torch/csrc/jit/passes/inliner.h>
+#include <torch/csrc/jit/passes/tensorexpr_fuser.h>
+#include <torch/csrc/jit/runtime/graph_executor.h>
 #include <torch/csrc/jit/runtime/instruction.h>
+#include <torch/csrc/jit/serialization/import.h>
 #include <torch/csrc/jit/serialization/import_export_helpers.h>
 #include <torch/csrc/jit/serialization/pickle.h>
 #include <torch/csrc/jit/serialization/python_print.h>
 #include <torch/csrc/jit/serialization/source_range_serialization.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 
 #include <caffe2/serialize/inline_container.h>
 
 #include <ATen/ATen.h>
 
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -183,6 +188,7 @@ class ScriptModuleSerializer {
     if (bytecode_format) {
       writeByteCode(module);
     }
+    writeTensorExprKernels(module);
   }
 
  private:
@@ -268,6 +274,24 @@ class ScriptModuleSerializer {
     }
   }
 
+  // See CompileTensorExprAot.
+  void writeTensorExprKernels(const Module& module) {
+    auto kernels = tensorexpr::getAttachedAotKernels(module.type());
+    if (kernels.empty()) {
+      return;
+    }
+    const std::string target = tensorexpr::aotTarget();
+    writer_.writeRecord("tensorexpr/target", target.data(), target.size());
+    for (size_t i = 0; i < kernels.size(); ++i) {
+      const std::string prefix = "tensorexpr/" + c10::to_string(i);
+      const auto& kernel = kernels[i];
+      writer_.writeRecord(
+          prefix + ".key", kernel.key.data(), kernel.key.size(), true);
+      writer_.writeRecord(
+          prefix + ".o", kernel.objectCode.data(), kernel.objectCode.size());
+    }
+  }
+
   void writeByteCode(const Module& module) {
     std::vector<c10::IValue> elements;
     moduleMethodsTuple(module, elements);
@@ -332,5 +356,48 @@ void ExportModule(
   serializer.serialize(module, extra_files, bytecode_format);
 }
 
+size_t CompileTensorExprAot(
+    const Module& module,
+    const std::string& method_name,
+    const std::vector<Stack>& example_inputs) {
+  TORCH_CHECK(
+      getExecutorMode(),
+      "Ahead-of-time compilation of TensorExpr kernels needs the profiling executor");
+  TORCH_CHECK(
+      !tensorexpr::aotTarget().empty(),
+      "Ahead-of-time compilation of TensorExpr kernels needs LLVM");
+
+  // Fusion groups are keyed on their subgraphs, so record them by running a
+  // copy loaded from the archive, whose graphs match the ones the loader
+  // will see.
+  std::stringstream archive;
+  ExportModule(module, archive);
+  Module loaded = load(archive);
+
+  const bool fuser_enabled = tensorExprFuserEnabled();
+  setTensorExprFuserEnabled(true);
+  std::vector<tensorexpr::AotKernel> kernels;
+  try {
+    tensorexpr::AotKernelRecorder recorder;
+    auto method = loaded.get_method(method_name);
+    // The profiled runs specialize the graph, the next one compiles it.
+    const size_t runs = getNumProfiledRuns() + 2;
+    for (const auto& inputs : example_inputs) {
+      for (size_t i = 0; i < runs; ++i) {
+        method(inputs);
+      }
+    }
+    kernels = recorder.kernels();
+  } catch (...) {
+    setTensorExprFuserEnabled(fuser_enabled);
+    throw;
+  }
+  setTensorExprFuserEnabled(fuser_enabled);
+
+  const size_t num_kernels = kernels.size();
+  tensorexpr::attachAotKernels(module.type(), std::move(kernels));
+  return num_kernels;
+}
+
 } // namespace jit
 } // namespace torch
@@ -11,6 +11,7 @@
 #include <torch/csrc/jit/serialization/pickle.h>
 #include <torch/csrc/jit/serialization/source_range_serialization.h>
 #include <torch/csrc/jit/serialization/unpickler.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 
 #include "caffe2/serialize/file_adapter.h"
 #include "caffe2/serialize/inline_container.h"
@@ -124,6 +125,7 @@ class ScriptModuleDeserializer final {
 
  private:
   IValue readArchive(const std::string& archive_name);
+  void readTensorExprKernels(const Module& module);
 
   std::shared_ptr<CompilationUnit> compilation_unit_;
   std::unique_ptr<PyTorchStreamReader> reader_;
@@ -179,6 +181,32 @@ IValue ScriptModuleDeserializer::readArchive(const std::string& archive_name) {
       archive_name, type_resolver, obj_loader, device_, *reader_.get());
 }
 
+// Attaches the kernels CompileTensorExprAot stored in the archive to the
+// loaded module, if loading them is enabled. They are dropped if they were
+// compiled for another target.
+void ScriptModuleDeserializer::readTensorExprKernels(const Module& module) {
+  if (!tensorexpr::aotKernelLoadingEnabled() ||
+      !reader_->hasRecord("tensorexpr/target")) {
+    return;
+  }
+  auto readRecord = [&](const std::string& name) {
+    at::DataPtr data;
+    size_t size;
+    std::tie(data, size) = reader_->getRecord(name);
+    return std::string(static_cast<char*>(data.get()), size);
+  };
+  const std::string target = readRecord("tensorexpr/target");
+  std::vector<tensorexpr::AotKernel> kernels;
+  for (size_t i = 0;; ++i) {
+    const std::string prefix = "tensorexpr/" + c10::to_string(i);
+    if (!reader_->hasRecord(prefix + ".key")) {
+      break;
+    }
+    kernels.push_back({readRecord(prefix + ".key"), readRecord(prefix + ".o")});
+  }
+  tensorexpr::loadAotKernels(module.type(), target, std::move(kernels));
+}
+
 Module ScriptModuleDeserializer::deserialize(
     c10::optional<at::Device> device,
     ExtraFilesMap& extra_files) {
@@ -207,7 +235,9 @@ Module ScriptModuleDeserializer::deserialize(
   for (auto constant : tuple->elements()) {
     constants_table_.push_back(constant.toTensor());
   }
-  return Module(readArchive("data").toObject());
+  Module module(readArchive("data").toObject());
+  readTensorExprKernels(module);
+  return module;
 }
 
 } // namespace
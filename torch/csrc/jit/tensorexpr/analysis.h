@@ -4,6 +4,8 @@
 #include <torch/csrc/jit/tensorexpr/ir_visitor.h>
 #include <torch/csrc/jit/tensorexpr/stmt.h>
 
+#include <unordered_set>
+
 namespace torch {
 namespace jit {
 namespace tensorexpr {
@@ -28,6 +30,29 @@ class HasRand : public IRVisitor {
   Stmt* stmt_;
   bool has_rand_ = false;
 };
+
+// Collects the variables an expression or a statement refers to.
+class VarFinder : public IRVisitor {
+ public:
+  explicit VarFinder(Stmt* stmt) {
+    stmt->accept(this);
+  }
+
+  explicit VarFinder(const Expr* expr) {
+    expr->accept(this);
+  }
+
+  const std::unordered_set<const Var*>& vars() const {
+    return vars_;
+  }
+
+ private:
+  void visit(const Var* v) override {
+    vars_.insert(v);
+  }
+
+  std::unordered_set<const Var*> vars_;
+};
 } // namespace tensorexpr
 } // namespace jit
 } // namespace torch
@@ -0,0 +1,238 @@
+#include <torch/csrc/jit/tensorexpr/aot.h>
+
+#include <ATen/core/jit_type.h>
+#include <c10/util/Exception.h>
+#include <c10/util/string_utils.h>
+#include <torch/csrc/jit/ir/ir.h>
+#include <torch/csrc/jit/passes/canonicalize.h>
+#include <torch/csrc/jit/tensorexpr/kernel.h>
+#include <torch/csrc/jit/tensorexpr/llvm_codegen.h>
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+namespace tensorexpr {
+
+namespace {
+
+// Version of the calling convention and runtime of compiled kernels. Must be
+// bumped whenever object code saved by earlier builds can't be linked and
+// called the same way anymore, e.g. when the parameters of kernels or the
+// runtime functions they call change.
+constexpr int kAotFormatVersion = 1;
+
+std::mutex aot_mutex;
+std::atomic<bool> recording{false};
+std::vector<AotKernel> recorded_kernels;
+std::atomic<bool> loading_enabled{false};
+
+struct AttachedKernels {
+  std::weak_ptr<c10::ClassType> type;
+  std::shared_ptr<const std::vector<AotKernel>> kernels;
+};
+std::unordered_map<const c10::ClassType*, AttachedKernels> attached_kernels;
+// Size of attached_kernels, so that AotKernelScope doesn't lock aot_mutex
+// when no kernels are attached at all.
+std::atomic<size_t> num_attached{0};
+
+// Kernels of the innermost AotKernelScope of this thread.
+thread_local std::shared_ptr<const std::vector<AotKernel>> current_kernels;
+
+std::atomic<uint64_t> num_registered{0};
+std::atomic<uint64_t> num_rejected{0};
+std::atomic<uint64_t> num_hits{0};
+std::atomic<uint64_t> num_misses{0};
+
+} // namespace
+
+std::string aotKernelKey(
+    const std::shared_ptr<Graph>& subgraph,
+    c10::Device device) {
+  std::ostringstream key;
+  key << Canonicalize(subgraph, /*keep_unique_names=*/false)
+             ->toString(/*print_source_locations=*/false)
+      << "device " << device << "\n"
+      // Lowering options that change the schedule of the kernel.
+      << "cpu_parallel_loops " << getTECPUParallelLoops();
+  return key.str();
+}
+
+std::string aotTarget() {
+#ifdef TORCH_ENABLE_LLVM
+  return "v" + c10::to_string(kAotFormatVersion) + ";" + llvmHostTarget();
+#else
+  return "";
+#endif
+}
+
+AotKernelRecorder::AotKernelRecorder() {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  TORCH_CHECK(!recording, "Already recording TensorExpr kernels");
+  recorded_kernels.clear();
+  recording = true;
+}
+
+AotKernelRecorder::~AotKernelRecorder() {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  recording = false;
+  recorded_kernels.clear();
+}
+
+std::vector<AotKernel> AotKernelRecorder::kernels() const {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  return recorded_kernels;
+}
+
+bool isRecordingAotKernels() {
+  return recording;
+}
+
+void recordAotKernel(const std::string& key, std::string objectCode) {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  if (!recording) {
+    return;
+  }
+  for (const auto& kernel : recorded_kernels) {
+    if (kernel.key == key) {
+      return;
+    }
+  }
+  recorded_kernels.push_back({key, std::move(objectCode)});
+}
+
+void setAotKernelLoadingEnabled(bool enabled) {
+  loading_enabled = enabled;
+}
+
+bool aotKernelLoadingEnabled() {
+  return loading_enabled;
+}
+
+// Drops the kernels of types that no longer exist, as their address may be
+// reused by a new type. Must hold aot_mutex.
+static void dropExpiredKernels() {
+  for (auto it = attached_kernels.begin(); it != attached_kernels.end();) {
+    if (it->second.type.expired()) {
+      it = attached_kernels.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Must hold aot_mutex.
+static const AttachedKernels* findAttached(
+    const std::shared_ptr<c10::ClassType>& type) {
+  auto it = attached_kernels.find(type.get());
+  if (it == attached_kernels.end() || it->second.type.lock() != type) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void loadAotKernels(
+    const std::shared_ptr<c10::ClassType>& type,
+    const std::string& target,
+    std::vector<AotKernel> kernels) {
+  if (target.empty() || target != aotTarget()) {
+    num_rejected += kernels.size();
+    return;
+  }
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  dropExpiredKernels();
+  if (kernels.empty() || findAttached(type)) {
+    num_attached = attached_kernels.size();
+    return;
+  }
+  num_registered += kernels.size();
+  attached_kernels[type.get()] = {
+      type,
+      std::make_shared<const std::vector<AotKernel>>(std::move(kernels))};
+  num_attached = attached_kernels.size();
+}
+
+AotKernelScope::AotKernelScope(const std::shared_ptr<c10::ClassType>& type) {
+  if (num_attached == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  const AttachedKernels* attached = findAttached(type);
+  if (!attached) {
+    return;
+  }
+  active_ = true;
+  previous_ = std::move(current_kernels);
+  current_kernels = attached->kernels;
+}
+
+AotKernelScope::~AotKernelScope() {
+  if (active_) {
+    current_kernels = std::move(previous_);
+  }
+}
+
+bool hasAotKernels() {
+  return current_kernels != nullptr;
+}
+
+c10::optional<std::string> findAotKernel(const std::string& key) {
+  if (current_kernels) {
+    for (const auto& kernel : *current_kernels) {
+      if (kernel.key == key) {
+        ++num_hits;
+        return kernel.objectCode;
+      }
+    }
+  }
+  ++num_misses;
+  return c10::nullopt;
+}
+
+AotKernelStats getAotKernelStats() {
+  AotKernelStats stats;
+  stats.registered = num_registered.load();
+  stats.rejected = num_rejected.load();
+  stats.hits = num_hits.load();
+  stats.misses = num_misses.load();
+  return stats;
+}
+
+void resetAotKernelStats() {
+  num_registered = 0;
+  num_rejected = 0;
+  num_hits = 0;
+  num_misses = 0;
+}
+
+void attachAotKernels(
+    const std::shared_ptr<c10::ClassType>& type,
+    std::vector<AotKernel> kernels) {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  dropExpiredKernels();
+  if (kernels.empty()) {
+    attached_kernels.erase(type.get());
+  } else {
+    attached_kernels[type.get()] = {
+        type,
+        std::make_shared<const std::vector<AotKernel>>(std::move(kernels))};
+  }
+  num_attached = attached_kernels.size();
+}
+
+std::vector<AotKernel> getAttachedAotKernels(
+    const std::shared_ptr<c10::ClassType>& type) {
+  std::lock_guard<std::mutex> guard(aot_mutex);
+  const AttachedKernels* attached = findAttached(type);
+  if (!attached) {
+    return {};
+  }
+  return *attached->kernels;
+}
+
+} // namespace tensorexpr
+} // namespace jit
+} // namespace torch
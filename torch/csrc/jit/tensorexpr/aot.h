@@ -0,0 +1,130 @@
+#pragma once
+
+#include <c10/core/Device.h>
+#include <c10/util/Optional.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c10 {
+struct ClassType;
+} // namespace c10
+
+namespace torch {
+namespace jit {
+
+struct Graph;
+
+namespace tensorexpr {
+
+// Ahead-of-time compiled TensorExpr kernels.
+//
+// A fusion group is compiled for the shapes, strides and dtypes its subgraph
+// was specialized to by the profiling executor. Its kernel is keyed on the
+// canonicalized subgraph, which spells out these types, together with the
+// device and the lowering options of the process, so a kernel is only reused
+// for the inputs and options it was compiled for: any other input shape
+// specializes a different subgraph, misses, and is compiled by the JIT as
+// usual.
+//
+// Object code is only valid for the target it was compiled for, which is
+// the format version of compiled kernels together with llvmHostTarget().
+// Kernels registered for another target are dropped.
+//
+// Kernels belong to the module type they were compiled or loaded for, and are
+// only used while a method of a module of that type runs, see
+// AotKernelScope. Loading an archive only links its kernels if loading AOT
+// kernels was enabled with setAotKernelLoadingEnabled(), as they are native
+// code run as is.
+//
+// Only the LLVM backend supports AOT compilation, so without LLVM no kernels
+// are ever recorded and every lookup misses.
+
+struct AotKernel {
+  std::string key;
+  std::string objectCode;
+};
+
+struct AotKernelStats {
+  uint64_t registered = 0;
+  // Kernels dropped because they were compiled for another target.
+  uint64_t rejected = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+TORCH_API std::string aotKernelKey(
+    const std::shared_ptr<Graph>& subgraph,
+    c10::Device device);
+
+// The target kernels of this process are compiled for, empty if none.
+TORCH_API std::string aotTarget();
+
+// While an AotKernelRecorder is alive, every TensorExpr kernel compiled with
+// LLVM keeps its object code and adds it to the recorder, instead of being
+// looked up in the registry. Recorders do not nest.
+class TORCH_API AotKernelRecorder {
+ public:
+  AotKernelRecorder();
+  ~AotKernelRecorder();
+
+  AotKernelRecorder(const AotKernelRecorder&) = delete;
+  AotKernelRecorder& operator=(const AotKernelRecorder&) = delete;
+
+  std::vector<AotKernel> kernels() const;
+};
+
+TORCH_API bool isRecordingAotKernels();
+TORCH_API void recordAotKernel(const std::string& key, std::string objectCode);
+
+// Whether torch.jit.load attaches the kernels of an archive to the loaded
+// module. Off by default.
+TORCH_API void setAotKernelLoadingEnabled(bool enabled);
+TORCH_API bool aotKernelLoadingEnabled();
+
+// Attaches kernels loaded from an archive to the type of the loaded module,
+// unless they were compiled for another target or the type already has
+// kernels.
+TORCH_API void loadAotKernels(
+    const std::shared_ptr<c10::ClassType>& type,
+    const std::string& target,
+    std::vector<AotKernel> kernels);
+
+// While an AotKernelScope is alive, TensorExpr kernels compiled on this thread
+// look up the kernels attached to type. Scopes for types without kernels
+// keep the kernels of the enclosing scope, so that submodules run with the
+// kernels of the module they were saved with.
+class TORCH_API AotKernelScope {
+ public:
+  explicit AotKernelScope(const std::shared_ptr<c10::ClassType>& type);
+  ~AotKernelScope();
+
+  AotKernelScope(const AotKernelScope&) = delete;
+  AotKernelScope& operator=(const AotKernelScope&) = delete;
+
+ private:
+  bool active_ = false;
+  std::shared_ptr<const std::vector<AotKernel>> previous_;
+};
+
+// Lookups in the kernels of the current AotKernelScope.
+TORCH_API bool hasAotKernels();
+TORCH_API c10::optional<std::string> findAotKernel(const std::string& key);
+
+TORCH_API AotKernelStats getAotKernelStats();
+TORCH_API void resetAotKernelStats();
+
+// Kernels compiled for a module type, written into the archive when a module
+// of that type is saved, and used when its methods run.
+TORCH_API void attachAotKernels(
+    const std::shared_ptr<c10::ClassType>& type,
+    std::vector<AotKernel> kernels);
+TORCH_API std::vector<AotKernel> getAttachedAotKernels(
+    const std::shared_ptr<c10::ClassType>& type);
+
+} // namespace tensorexpr
+} // namespace jit
+} // namespace torch
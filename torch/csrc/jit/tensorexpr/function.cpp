@@ -106,6 +106,28 @@ Tensor* Compute(
   return new Tensor(func, 0);
 }
 
+Tensor* Reduce(
+    const std::string& func_name,
+    const std::vector<DimArg>& dim_args,
+    const Reducer& reducer,
+    const std::function<ExprHandle(const std::vector<VarHandle>&)>& body_func,
+    const std::vector<DimArg>& reduce_args) {
+  std::vector<const Expr*> dims;
+  std::vector<const Var*> args;
+  unpack_dim_args(dim_args, &dims, &args);
+  std::vector<const Expr*> reduce_dims;
+  std::vector<const Var*> reduce_vars;
+  unpack_dim_args(reduce_args, &reduce_dims, &reduce_vars);
+
+  std::vector<const Var*> all_vars(args);
+  all_vars.insert(all_vars.end(), reduce_vars.begin(), reduce_vars.end());
+  const Expr* body =
+      reducer.promote(body_func(VarVectorToVarHandleVector(all_vars))).node();
+  Function* func = new Function(
+      func_name, dims, args, body, reduce_dims, reduce_vars, reducer);
+  return new Tensor(func, 0);
+}
+
 Stmt* Function::ElementStmt(size_t index) {
   std::vector<ExprHandle> strides(dims_.size());
   for (size_t i = 0; i < strides.size(); i++) {
@@ -132,9 +154,29 @@ Stmt* Function::ElementStmt(size_t index) {
 
   const Expr* mask = new IntImm(1);
 
-  Stmt* update_stmt =
-      new Store(func_var(index), total_index.node(), body(index), mask);
-  return update_stmt;
+  if (!is_reduction()) {
+    Stmt* update_stmt =
+        new Store(func_var(index), total_index.node(), body(index), mask);
+    return update_stmt;
+  }
+
+  // The element is accumulated in place:
+  //   f[i] = init
+  //   for r: f[i] = reducer(f[i], body)
+  const Expr* accum =
+      new Load(body(index)->dtype(), func_var(index), total_index.node(), mask);
+  Stmt* reduce_stmt = new Store(
+      func_var(index),
+      total_index.node(),
+      (*reducer_)(ExprHandle(accum), ExprHandle(body(index))).node(),
+      mask);
+  for (size_t i = reduce_dims_.size(); i > 0; i--) {
+    reduce_stmt = new For(
+        reduce_args_[i - 1], new IntImm(0), reduce_dims_[i - 1], reduce_stmt);
+  }
+  Stmt* init_stmt = new Store(
+      func_var(index), total_index.node(), reducer_->initializer(), mask);
+  return new Block({init_stmt, reduce_stmt});
 }
 
 } // namespace tensorexpr
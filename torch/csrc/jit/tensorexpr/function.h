@@ -3,8 +3,11 @@
 #include <functional>
 #include <vector>
 
+#include <c10/util/Optional.h>
+
 #include <torch/csrc/jit/tensorexpr/expr.h>
 #include <torch/csrc/jit/tensorexpr/ir.h>
+#include <torch/csrc/jit/tensorexpr/reduction.h>
 
 namespace torch {
 namespace jit {
@@ -21,6 +24,22 @@ class Function : public KernelScopedObject {
         dims_(dims),
         args_(args),
         bodies_({body}) {}
+  // A reduction of body over the reduce_args, for every point of args.
+  Function(
+      const std::string& func_name,
+      const std::vector<const Expr*>& dims,
+      const std::vector<const Var*>& args,
+      const Expr* body,
+      const std::vector<const Expr*>& reduce_dims,
+      const std::vector<const Var*>& reduce_args,
+      const Reducer& reducer)
+      : func_vars_({VarHandle(func_name, kHandle).node()}),
+        dims_(dims),
+        args_(args),
+        bodies_({body}),
+        reduce_dims_(reduce_dims),
+        reduce_args_(reduce_args),
+        reducer_(reducer) {}
   Function(
       const std::vector<std::string>& func_names,
       const std::vector<const Expr*>& dims,
@@ -80,6 +99,18 @@ class Function : public KernelScopedObject {
     return func_vars_[index];
   }
 
+  bool is_reduction() const {
+    return reducer_.has_value();
+  }
+  const std::vector<const Expr*>& reduce_dims() const {
+    return reduce_dims_;
+  }
+  const std::vector<const Var*>& reduce_args() const {
+    return reduce_args_;
+  }
+
+  // Computes the element of the function at args. The element of a reduction
+  // is computed by a loop nest over the reduce_args.
   Stmt* ElementStmt(size_t index);
 
  private:
@@ -87,6 +118,9 @@ class Function : public KernelScopedObject {
   std::vector<const Expr*> dims_;
   std::vector<const Var*> args_;
   std::vector<const Expr*> bodies_;
+  std::vector<const Expr*> reduce_dims_;
+  std::vector<const Var*> reduce_args_;
+  c10::optional<Reducer> reducer_;
 };
 
 } // namespace tensorexpr
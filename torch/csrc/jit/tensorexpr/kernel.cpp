@@ -1,11 +1,16 @@
 #include <torch/csrc/jit/tensorexpr/kernel.h>
 
+#include <ATen/Parallel.h>
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/tensorexpr/analysis.h>
+#include <torch/csrc/jit/tensorexpr/aot.h>
 #include <torch/csrc/jit/tensorexpr/ir_printer.h>
 #include <torch/csrc/jit/tensorexpr/ir_simplifier.h>
+#include <torch/csrc/jit/tensorexpr/llvm_codegen.h>
 #include <torch/csrc/jit/tensorexpr/loopnest.h>
 
+#include <atomic>
+
 using namespace torch::jit;
 using namespace torch::jit::tensorexpr;
 
@@ -16,6 +21,10 @@ namespace tensorexpr {
 static int te_cuda_pointwise_loop_levels = -1;
 static int te_cuda_pointwise_block_count = -1;
 static int te_cuda_pointwise_block_size = -1;
+static bool te_cpu_parallel_loops = true;
+
+static std::atomic<uint64_t> num_compilations{0};
+static std::atomic<uint64_t> num_shape_mismatches{0};
 
 int& getTECudaPointwiseLoopLevels() {
   return te_cuda_pointwise_loop_levels;
@@ -29,6 +38,22 @@ int& getTECudaPointwiseBlockSize() {
   return te_cuda_pointwise_block_size;
 }
 
+bool& getTECPUParallelLoops() {
+  return te_cpu_parallel_loops;
+}
+
+TEKernelStats getTEKernelStats() {
+  TEKernelStats stats;
+  stats.compilations = num_compilations.load();
+  stats.shape_mismatches = num_shape_mismatches.load();
+  return stats;
+}
+
+void resetTEKernelStats() {
+  num_compilations = 0;
+  num_shape_mismatches = 0;
+}
+
 } // namespace tensorexpr
 } // namespace jit
 } // namespace torch
@@ -38,9 +63,13 @@ static at::ScalarType tensorType(Tensor* t) {
 }
 
 static std::vector<ExprHandle> texprSizes(const c10::VaryingShape& shape) {
+  auto sizes = shape.concrete_sizes();
+  if (!sizes) {
+    throw malformed_input("shape is not known at compile time");
+  }
   std::vector<ExprHandle> dims;
-  for (size_t i = 0; i < *shape.size(); i++) {
-    dims.push_back(IntImm::make(*shape[i]));
+  for (int64_t size : *sizes) {
+    dims.push_back(IntImm::make(size));
   }
   return dims;
 }
@@ -167,7 +196,11 @@ static bool isOne(ExprHandle e) {
   return n->value() == 1;
 }
 
+// Broadcasts the shapes a and b. Dimensions that are not known to be 1 are
+// assumed to be equal; sizeChecks gets the pairs of them whose sizes are only
+// known at runtime.
 static std::pair<std::vector<ExprHandle>, bool> broadcastShapes(
+    std::vector<std::pair<const Expr*, const Expr*>>& sizeChecks,
     const std::vector<ExprHandle>& a,
     const std::vector<ExprHandle>& b) {
   bool broadcast = false;
@@ -185,15 +218,16 @@ static std::pair<std::vector<ExprHandle>, bool> broadcastShapes(
       ret.push_back(*at++);
       continue;
     }
-    // TODO: if neither *at nor *bt is 1, ensure they are identical
-    // expressions.  Nb: `==` doesn't work since that simply produces a new
-    // ExprHandle.
     ExprHandle dim = *at;
     if (isOne(*at)) {
       if (!isOne(*bt)) {
         dim = *bt;
         broadcast = true;
       }
+    } else if (
+        !isOne(*bt) && at->node() != bt->node() &&
+        !(at->AsNode<IntImm>() && bt->AsNode<IntImm>())) {
+      sizeChecks.emplace_back(at->node(), bt->node());
     }
     ret.push_back(dim);
     at++;
@@ -205,11 +239,12 @@ static std::pair<std::vector<ExprHandle>, bool> broadcastShapes(
 
 template <typename... Args>
 static std::pair<std::vector<ExprHandle>, bool> broadcastShapes(
+    std::vector<std::pair<const Expr*, const Expr*>>& sizeChecks,
     const std::vector<ExprHandle>& a,
     const std::vector<ExprHandle>& b,
     Args... args) {
-  auto const& res = broadcastShapes(a, b);
-  auto const& res2 = broadcastShapes(res.first, args...);
+  auto const& res = broadcastShapes(sizeChecks, a, b);
+  auto const& res2 = broadcastShapes(sizeChecks, res.first, args...);
   return {res2.first, res.second || res2.second};
 }
 
@@ -248,8 +283,8 @@ Tensor* TensorExprKernel::computeTwoOperand(
     const std::function<ExprHandle(const ExprHandle&, const ExprHandle&)>&
         innerExpr) {
   auto const& n = v->node();
-  auto const& res =
-      broadcastShapes(valueShape(n->inputs()[0]), valueShape(n->inputs()[1]));
+  auto const& res = broadcastShapes(
+      sizeChecks_, valueShape(n->inputs()[0]), valueShape(n->inputs()[1]));
   auto const& shape = res.first;
   hasBroadcast_ |= res.second;
   return Compute(
@@ -274,8 +309,8 @@ Tensor* TensorExprKernel::computeTwoOperandWithAlpha(
     const std::function<ExprHandle(const ExprHandle&, const ExprHandle&)>&
         innerExpr) {
   auto const& n = v->node();
-  auto const& res =
-      broadcastShapes(valueShape(n->inputs()[0]), valueShape(n->inputs()[1]));
+  auto const& res = broadcastShapes(
+      sizeChecks_, valueShape(n->inputs()[0]), valueShape(n->inputs()[1]));
   auto const& shape = res.first;
   hasBroadcast_ |= res.second;
   return Compute(
@@ -303,6 +338,7 @@ Tensor* TensorExprKernel::computeConditionWithTwoOperand(
         innerExpr) {
   auto const& n = v->node();
   auto const& res = broadcastShapes(
+      sizeChecks_,
       valueShape(n->inputs()[0]),
       valueShape(n->inputs()[1]),
       valueShape(n->inputs()[2]));
@@ -334,6 +370,7 @@ Tensor* TensorExprKernel::computeThreeOperand(
         innerExpr) {
   auto const& n = v->node();
   auto const& res = broadcastShapes(
+      sizeChecks_,
       valueShape(n->inputs()[0]),
       valueShape(n->inputs()[1]),
       valueShape(n->inputs()[2]));
@@ -366,6 +403,7 @@ Tensor* TensorExprKernel::computeFourOperand(
         const ExprHandle&)>& innerExpr) {
   auto const& n = v->node();
   auto const& res = broadcastShapes(
+      sizeChecks_,
       valueShape(n->inputs()[0]),
       valueShape(n->inputs()[1]),
       valueShape(n->inputs()[2]),
@@ -391,6 +429,270 @@ Tensor* TensorExprKernel::computeFourOperand(
       });
 }
 
+// The type reductions of values of dtype accumulate in, as in at::acc_type on
+// the CPU.
+static Dtype accumulationDtype(Dtype dtype) {
+  switch (dtype.scalar_type()) {
+    case ScalarType::Half:
+      return kFloat;
+    case ScalarType::Float:
+    case ScalarType::Double:
+      return kDouble;
+    default:
+      return kLong;
+  }
+}
+
+static size_t normalizeAxis(int64_t axis, size_t rank) {
+  if (axis < 0) {
+    axis += rank;
+  }
+  if (axis < 0 || axis >= static_cast<int64_t>(rank)) {
+    throw malformed_input("invalid reduction axis");
+  }
+  return axis;
+}
+
+// Drops the reduced axes from the indices of an element of a reduction input,
+// which gives the indices of the reduction it contributes to.
+template <typename T>
+static std::vector<ExprHandle> reducedIndices(
+    const std::vector<T>& indices,
+    const std::vector<size_t>& axes) {
+  std::vector<ExprHandle> result;
+  for (size_t i = 0; i < indices.size(); i++) {
+    if (std::find(axes.begin(), axes.end(), i) == axes.end()) {
+      result.push_back(indices[i]);
+    }
+  }
+  return result;
+}
+
+Tensor* TensorExprKernel::computeReduction(
+    const std::string& name,
+    const torch::jit::Value* input,
+    const std::vector<size_t>& axes,
+    bool keepdim,
+    const Reducer& reducer,
+    const std::function<ExprHandle(const std::vector<ExprHandle>&)>& body) {
+  auto const& shape = valueShape(input);
+  std::vector<DimArg> outputDims;
+  std::vector<DimArg> reduceDims;
+  for (size_t i = 0; i < shape.size(); i++) {
+    if (!shape[i].AsNode<IntImm>()) {
+      throw malformed_input("reductions need static shapes");
+    }
+    if (std::find(axes.begin(), axes.end(), i) != axes.end()) {
+      reduceDims.emplace_back(shape[i], "r" + std::to_string(i));
+      if (keepdim) {
+        outputDims.emplace_back(IntImm::make(1), "i" + std::to_string(i));
+      }
+    } else {
+      outputDims.emplace_back(shape[i], "i" + std::to_string(i));
+    }
+  }
+
+  const size_t nOutputDims = outputDims.size();
+  Tensor* t = Reduce(
+      name,
+      outputDims,
+      reducer,
+      [&](const std::vector<VarHandle>& vars) {
+        // Rebuild the indices of the input from the output and reduction
+        // variables.
+        std::vector<ExprHandle> indices;
+        size_t outputIdx = 0;
+        size_t reduceIdx = nOutputDims;
+        for (size_t i = 0; i < shape.size(); i++) {
+          if (std::find(axes.begin(), axes.end(), i) != axes.end()) {
+            indices.push_back(vars[reduceIdx++]);
+            outputIdx += keepdim ? 1 : 0;
+          } else {
+            indices.push_back(vars[outputIdx++]);
+          }
+        }
+        return body(indices);
+      },
+      reduceDims);
+  reductions_.push_back(t);
+  return t;
+}
+
+// aten::sum and aten::mean, over all axes or over a constant list of axes.
+// As in aten, an empty list of axes reduces over all axes.
+Tensor* TensorExprKernel::computeSum(const torch::jit::Value* v, bool mean) {
+  auto const& n = v->node();
+  const torch::jit::Value* input = n->inputs()[0];
+  Tensor* inputTensor = tensors_.at(input->unique());
+  const size_t rank = inputTensor->ndim();
+
+  std::vector<size_t> axes;
+  bool keepdim = false;
+  if (n->inputs().size() == 4) {
+    for (int64_t axis : toIValue(n->inputs()[1])->toIntVector()) {
+      size_t normalized = normalizeAxis(axis, rank);
+      if (std::find(axes.begin(), axes.end(), normalized) != axes.end()) {
+        throw malformed_input("reduction axis appears multiple times");
+      }
+      axes.push_back(normalized);
+    }
+    keepdim = toIValue(n->inputs()[2])->toBool();
+  }
+  if (axes.empty()) {
+    for (size_t i = 0; i < rank; i++) {
+      axes.push_back(i);
+    }
+  }
+
+  Dtype accDtype = accumulationDtype(inputTensor->body()->dtype());
+  Tensor* sum = computeReduction(
+      mean ? "aten_mean_sum" : "aten_sum_acc",
+      input,
+      axes,
+      keepdim,
+      Sum(accDtype),
+      [this, input](const std::vector<ExprHandle>& indices) {
+        return tensorOrConstant(input, indices);
+      });
+  int64_t count = 1;
+  for (const Expr* dim : sum->function()->reduce_dims()) {
+    count *= dynamic_cast<const IntImm*>(dim)->value();
+  }
+  return Compute(
+      mean ? "aten_mean" : "aten_sum",
+      texprDims(v),
+      [this, v, sum, mean, count, accDtype](
+          const std::vector<VarHandle>& axes) {
+        ExprHandle result = sum->call(axes);
+        if (mean) {
+          result = result / getImmediateByType(accDtype, count);
+        }
+        return demoteOutput(result, v);
+      });
+}
+
+// aten::softmax and aten::log_softmax are computed in three passes over the
+// input: its maximum along dim, the sum of the exponentials of the input
+// shifted by that maximum, and the result.
+Tensor* TensorExprKernel::computeSoftmax(
+    const torch::jit::Value* v,
+    bool logSoftmax) {
+  auto const& n = v->node();
+  const torch::jit::Value* input = n->inputs()[0];
+  Tensor* inputTensor = tensors_.at(input->unique());
+  const std::vector<size_t> axes = {normalizeAxis(
+      toIValue(n->inputs()[1])->toInt(), inputTensor->ndim())};
+
+  Dtype dtype = inputTensor->body()->dtype();
+  Dtype accDtype = accumulationDtype(dtype);
+  Tensor* max = computeReduction(
+      "aten_softmax_max",
+      input,
+      axes,
+      false,
+      Maximum(dtype),
+      [this, input](const std::vector<ExprHandle>& indices) {
+        return tensorOrConstant(input, indices);
+      });
+  Tensor* sum = computeReduction(
+      "aten_softmax_sum",
+      input,
+      axes,
+      false,
+      Sum(accDtype),
+      [this, input, max, axes](const std::vector<ExprHandle>& indices) {
+        return exp(
+            tensorOrConstant(input, indices) -
+            max->call(reducedIndices(indices, axes)));
+      });
+  return Compute(
+      logSoftmax ? "aten_log_softmax" : "aten_softmax",
+      texprDims(v),
+      [this, v, input, max, sum, axes, dtype, accDtype, logSoftmax](
+          const std::vector<VarHandle>& indices) {
+        ExprHandle shifted = tensorOrConstant(input, indices) -
+            max->call(reducedIndices(indices, axes));
+        ExprHandle denominator = sum->call(reducedIndices(indices, axes));
+        ExprHandle result = logSoftmax
+            ? Cast::make(accDtype, shifted) - log(denominator)
+            : exp(shifted) / Cast::make(dtype, denominator);
+        return demoteOutput(result, v);
+      });
+}
+
+// aten::layer_norm computes the mean and the variance of the normalized axes
+// in two passes over the input, so that the variance does not suffer from
+// cancellation, and normalizes the input in a third one.
+Tensor* TensorExprKernel::computeLayerNorm(const torch::jit::Value* v) {
+  auto const& n = v->node();
+  const torch::jit::Value* input = n->inputs()[0];
+  const torch::jit::Value* weight = n->inputs()[2];
+  const torch::jit::Value* bias = n->inputs()[3];
+  Tensor* inputTensor = tensors_.at(input->unique());
+  const size_t rank = inputTensor->ndim();
+  const size_t normalizedRank =
+      toIValue(n->inputs()[1])->toIntVector().size();
+  if (normalizedRank > rank) {
+    throw malformed_input("invalid normalized_shape");
+  }
+
+  std::vector<size_t> axes;
+  for (size_t i = rank - normalizedRank; i < rank; i++) {
+    axes.push_back(i);
+  }
+
+  Dtype accDtype = accumulationDtype(inputTensor->body()->dtype());
+  Tensor* sum = computeReduction(
+      "aten_layer_norm_sum",
+      input,
+      axes,
+      false,
+      Sum(accDtype),
+      [this, input](const std::vector<ExprHandle>& indices) {
+        return tensorOrConstant(input, indices);
+      });
+  int64_t count = 1;
+  for (const Expr* dim : sum->function()->reduce_dims()) {
+    count *= dynamic_cast<const IntImm*>(dim)->value();
+  }
+  ExprHandle countImm = getImmediateByType(accDtype, count);
+  ExprHandle eps =
+      getImmediateByType(accDtype, toIValue(n->inputs()[4])->toDouble());
+  Tensor* sqsum = computeReduction(
+      "aten_layer_norm_sqsum",
+      input,
+      axes,
+      false,
+      Sum(accDtype),
+      [this, input, sum, axes, accDtype, countImm](
+          const std::vector<ExprHandle>& indices) {
+        ExprHandle centered =
+            Cast::make(accDtype, tensorOrConstant(input, indices)) -
+            sum->call(reducedIndices(indices, axes)) / countImm;
+        return centered * centered;
+      });
+  return Compute(
+      "aten_layer_norm",
+      texprDims(v),
+      [this, v, input, weight, bias, sum, sqsum, axes, accDtype, countImm, eps](
+          const std::vector<VarHandle>& indices) {
+        auto const& reduced = reducedIndices(indices, axes);
+        ExprHandle result =
+            (Cast::make(accDtype, tensorOrConstant(input, indices)) -
+             sum->call(reduced) / countImm) *
+            rsqrt(sqsum->call(reduced) / countImm + eps);
+        if (weight->type()->kind() != TypeKind::NoneType) {
+          result =
+              result * Cast::make(accDtype, tensorOrConstant(weight, indices));
+        }
+        if (bias->type()->kind() != TypeKind::NoneType) {
+          result =
+              result + Cast::make(accDtype, tensorOrConstant(bias, indices));
+        }
+        return demoteOutput(result, v);
+      });
+}
+
 Tensor* TensorExprKernel::computeValue(const torch::jit::Value* v) {
   switch (v->node()->kind()) {
     case aten::add: {
@@ -924,6 +1226,33 @@ Tensor* TensorExprKernel::computeValue(const torch::jit::Value* v) {
           });
     }
 
+    case aten::gelu: {
+      return computeOneOperand("aten_gelu", v, [](const ExprHandle& a) {
+        return a * ExprHandle(0.5f) *
+            (ExprHandle(1.0f) + erf(a * ExprHandle(0.70710678118654752f)));
+      });
+    } break;
+
+    case aten::sum: {
+      return computeSum(v, /*mean=*/false);
+    } break;
+
+    case aten::mean: {
+      return computeSum(v, /*mean=*/true);
+    } break;
+
+    case aten::softmax: {
+      return computeSoftmax(v, /*logSoftmax=*/false);
+    } break;
+
+    case aten::log_softmax: {
+      return computeSoftmax(v, /*logSoftmax=*/true);
+    } break;
+
+    case aten::layer_norm: {
+      return computeLayerNorm(v);
+    } break;
+
     case aten::_sigmoid_backward: {
       return computeTwoOperand(
           "aten_sigmoid_backward",
@@ -948,6 +1277,144 @@ Tensor* TensorExprKernel::computeValue(const torch::jit::Value* v) {
   }
 }
 
+#ifdef TORCH_ENABLE_LLVM
+// Loads the kernel of subgraph from the AOT kernels if there is one, and keeps
+// the object code of kernels compiled while recording AOT kernels.
+static std::unique_ptr<CodeGen> createLLVMCodeGen(
+    const std::shared_ptr<Graph>& subgraph,
+    Stmt* stmt,
+    const std::vector<CodeGen::BufferArg>& params,
+    at::Device device) {
+  if (!isRecordingAotKernels() && !hasAotKernels()) {
+    return std::make_unique<LLVMCodeGen>(stmt, params, device);
+  }
+  const std::string key = aotKernelKey(subgraph, device);
+  if (isRecordingAotKernels()) {
+    auto codegen = std::make_unique<LLVMCodeGen>(
+        stmt, params, device, kInt, /*keepObjectCode=*/true);
+    recordAotKernel(key, codegen->getObjectCode());
+    return codegen;
+  }
+  if (auto objectCode = findAotKernel(key)) {
+    try {
+      return std::make_unique<LLVMCodeGen>(*objectCode, stmt, params, device);
+    } catch (const std::exception& e) {
+      GRAPH_DEBUG("Failed to load AOT kernel, compiling it: ", e.what());
+    }
+  }
+  return std::make_unique<LLVMCodeGen>(stmt, params, device);
+}
+#endif
+
+// Number of elements a loop nest must compute for running it on the thread
+// pool to pay off, as for at::parallel_for in ATen kernels.
+static constexpr int64_t kParallelGrainSize = at::internal::GRAIN_SIZE;
+
+// Side of the square tiles that loop nests reading a transposed input are
+// split into, so that the rows of the tile of each operand stay in L1.
+static constexpr int kTileSize = 32;
+
+static c10::optional<int64_t> constantTripCount(const For* f) {
+  auto start = dynamic_cast<const IntImm*>(f->start());
+  auto stop = dynamic_cast<const IntImm*>(f->stop());
+  if (!start || !stop) {
+    return c10::nullopt;
+  }
+  return stop->value() - start->value();
+}
+
+// Whether the innermost loop of an output walks some input with a large
+// stride, as it does for the transpose of a contiguous tensor.
+static bool hasTransposedInput(const std::vector<TypePtr>& inputTypes) {
+  for (const auto& type : inputTypes) {
+    auto tt = type->cast<TensorType>();
+    if (!tt) {
+      continue;
+    }
+    auto strides = tt->strides().concrete_sizes();
+    if (strides && strides->size() >= 2 && strides->back() != 1 &&
+        (*strides)[strides->size() - 2] == 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Runs the outermost loop of tensor that has more than one iteration on the
+// thread pool, if computing the tensor takes enough work. The work of a
+// reduction includes its reduction axes.
+static void parallelizeOuterLoop(LoopNest& l, Tensor* tensor) {
+  std::vector<For*> loops = l.getLoopStmtsFor(tensor);
+  int64_t work = 1;
+  For* parallelLoop = nullptr;
+  for (For* loop : loops) {
+    auto tripCount = constantTripCount(loop);
+    if (!tripCount) {
+      return;
+    }
+    work *= *tripCount;
+    if (!parallelLoop && *tripCount > 1) {
+      parallelLoop = loop;
+    }
+  }
+  for (const Expr* dim : tensor->function()->reduce_dims()) {
+    auto size = dynamic_cast<const IntImm*>(dim);
+    if (!size) {
+      return;
+    }
+    work *= size->value();
+  }
+  if (parallelLoop && work >= kParallelGrainSize) {
+    l.setParallel(parallelLoop);
+  }
+}
+
+// Schedules the loop nests of the outputs and reductions for the CPU: the
+// outermost loop that does enough work runs on the thread pool, and the two
+// innermost loops of outputs are tiled when an input is read transposed. The
+// innermost loops are vectorized later, once the nest is flattened.
+static void scheduleForCPU(
+    LoopNest& l,
+    const std::vector<Tensor*>& tensorOutputs,
+    const std::vector<Tensor*>& reductions,
+    const std::vector<TypePtr>& inputTypes,
+    bool hasRandom) {
+  // Random numbers are drawn from a generator that is not thread safe.
+  const bool parallel = getTECPUParallelLoops() && !hasRandom;
+  if (parallel) {
+    for (Tensor* tensor : reductions) {
+      if (l.hasLoopBodyFor(tensor) && !l.getLoopStmtsFor(tensor).empty()) {
+        parallelizeOuterLoop(l, tensor);
+      }
+    }
+  }
+
+  const bool tile = hasTransposedInput(inputTypes);
+  for (Tensor* tensor : tensorOutputs) {
+    std::vector<For*> loops = l.getLoopStmtsFor(tensor);
+    if (loops.empty()) {
+      continue;
+    }
+
+    if (parallel && !tensor->function()->is_reduction()) {
+      parallelizeOuterLoop(l, tensor);
+    }
+
+    if (tile && loops.size() >= 2) {
+      For* outer = loops[loops.size() - 2];
+      For* inner = loops.back();
+      auto outerTripCount = constantTripCount(outer);
+      auto innerTripCount = constantTripCount(inner);
+      if (outerTripCount && innerTripCount &&
+          *outerTripCount % kTileSize == 0 &&
+          *innerTripCount % kTileSize == 0 &&
+          (*outerTripCount > kTileSize || *innerTripCount > kTileSize)) {
+        l.tile(outer, inner, kTileSize, kTileSize);
+      }
+    }
+  }
+}
+
 void TensorExprKernel::lowerToBackend(BackendType backendType) {
   std::vector<Tensor*> tensorOutputs(tensorOutputs_);
 
@@ -992,9 +1459,10 @@ void TensorExprKernel::lowerToBackend(BackendType backendType) {
 
   torch::jit::tensorexpr::LoopNest l(tensorOutputs);
 
-  // Compute non-output tensors_ inline
+  // Compute non-output tensors_ inline, except for reductions, which are
+  // computed into intermediate buffers.
   for (auto& p : tensors_) {
-    if (!l.hasLoopBodyFor(p.second)) {
+    if (!l.hasLoopBodyFor(p.second) || p.second->function()->is_reduction()) {
       continue;
     }
     Stmt* loop = l.getLoopBodyFor(p.second);
@@ -1048,6 +1516,7 @@ void TensorExprKernel::lowerToBackend(BackendType backendType) {
       }
     }
   } else if (backendType == kLLVMCodeGen) {
+    scheduleForCPU(l, tensorOutputs, reductions_, inputTypes_, hasRandom_);
     l.prepareForCodegen();
 
     std::vector<For*> innerLoops;
@@ -1149,6 +1618,14 @@ void TensorExprKernel::lowerToBackend(BackendType backendType) {
           std::to_string(static_cast<int>(backendType_)));
   }
 
+#ifdef TORCH_ENABLE_LLVM
+  if (backendType_ == kLLVMCodeGen) {
+    codegenCache_.emplace(
+        torch::get_hash(device_),
+        createLLVMCodeGen(graph_, stmt, params, device_));
+    return;
+  }
+#endif
   codegenCache_.emplace(
       torch::get_hash(device_),
       CreateCodeGen(codegenName, stmt, params, device_));
@@ -1270,6 +1747,7 @@ void TensorExprKernel::pickAndCheckBackendType(
     backendType_ = backendType;
     device_ = device;
     lowerToBackend(backendType);
+    ++num_compilations;
   } else if (backendType_ != backendType) {
     // TODO: if we have to support muliptole backends with the same subgraph,
     // we need to add kernel caching.
@@ -1293,103 +1771,45 @@ void TensorExprKernel::codeGenRun(
   }
 }
 
-ExprHandle TensorExprKernel::createInputIndexExpr(
-    const Buffer& buffer,
-    const std::vector<VarHandle>& axes,
-    const c10::VaryingShape& sizes,
-    const c10::VaryingStrides& strides,
-    const c10::VaryingStrides& contiguity,
-    const std::unordered_map<int64_t, VarHandle>& sizeVars) {
-  if (axes.size() != strides.size()) {
-    throw malformed_input();
-  }
-
-  std::vector<ShapeArg> strideArgs;
-  std::vector<ShapeArg> sizeArgs;
-  ExprHandle stride = 1;
-  ExprHandle index = 0;
-
-  if (axes.size() == 0) {
-    throw malformed_input();
-  }
-  size_t n = axes.size() - 1;
-
-  for (size_t i = 0; i < axes.size(); i++) {
-    // For discontiguous tensors, create a parameter to represent stride.
-    if (!*contiguity[i]) {
-      VarHandle v = VarHandle{
-          "stride_" + buffer.data()->name_hint() + "_" + std::to_string(i),
-          kInt};
-      strideArgs.emplace_back(n - i, v);
-      stride = v;
-    }
-
-    // If size is dynamic (indicated by negative value) create a size param.
-    ExprHandle size;
-    auto sizeVal = *sizes[n - i];
-    if (sizeVal < 0) {
-      auto it = sizeVars.find(sizeVal);
-      if (it == sizeVars.end()) {
-        throw malformed_input();
-      }
-
-      auto const& v = it->second;
-      sizeArgs.emplace_back(n - i, v);
-      size = v;
-    } else {
-      size = static_cast<int32_t>(sizeVal);
-    }
-
-    index = index + axes[n - i] * stride;
-    stride = stride * size;
-  }
-
-  kernelArgs_.emplace_back(buffer, std::move(sizeArgs), std::move(strideArgs));
-  return buffer(index);
-}
-
 void TensorExprKernel::bindInput(const torch::jit::Value* input) {
   auto const& t = input->type();
   switch (t->kind()) {
     case TypeKind::TensorType: {
       auto tt = input->type()->cast<TensorType>();
+      if (!tt->scalarType() || !tt->sizes().size() || !tt->strides().size()) {
+        throw malformed_input("input " + input->debugName());
+      }
       Buffer inBuffer(
           "t" + input->debugName(),
           ToDtype(static_cast<ScalarType>(*tt->scalarType())),
           {0});
+      // Sizes and strides that are only known at runtime are passed to the
+      // kernel as arguments.
       std::vector<DimArg> inputTensorDims;
-      std::unordered_map<int64_t, VarHandle> sizeVars;
+      std::vector<ExprHandle> strides;
+      std::vector<ShapeArg> sizeArgs;
+      std::vector<ShapeArg> strideArgs;
       for (size_t i = 0; i < *tt->sizes().size(); i++) {
-        auto const& size = *tt->sizes()[i];
-        if (size < 0) {
+        auto const& size = tt->sizes()[i];
+        if (size) {
+          inputTensorDims.emplace_back(
+              DimArg(IntImm::make(*size), "i" + std::to_string(i)));
+        } else {
           VarHandle v(
-              "size_" + std::to_string(input->unique()) + "_" +
-                  std::to_string(i),
-              kInt);
-          sizeVars.emplace(size, v);
-          inputTensorDims.emplace_back(v);
+              "size_" + input->debugName() + "_" + std::to_string(i), kInt);
+          sizeArgs.emplace_back(i, v);
+          inputTensorDims.emplace_back(DimArg(v, "i" + std::to_string(i)));
+        }
+        auto const& stride = tt->strides()[i];
+        if (stride) {
+          strides.push_back(IntImm::make(*stride));
         } else {
-          inputTensorDims.emplace_back(
-              DimArg(IntImm::make(size), "i" + std::to_string(i)));
+          VarHandle v(
+              "stride_" + input->debugName() + "_" + std::to_string(i), kInt);
+          strideArgs.emplace_back(i, v);
+          strides.push_back(v);
         }
       }
-#ifdef DYNAMIC_SHAPES
-      tensors_.emplace(
-          input->unique(),
-          Compute(
-              "input",
-              inputTensorDims,
-              [&](const std::vector<VarHandle>& axes) {
-                return createInputIndexExpr(
-                    inBuffer,
-                    axes,
-                    tt->sizes(),
-                    tt->strides(),
-                    tt->contiguity(),
-                    sizeVars);
-              }));
-#else
-      auto const& strides = tt->strides();
       tensors_.emplace(
           input->unique(),
           Compute(
@@ -1398,13 +1818,12 @@ void TensorExprKernel::bindInput(const torch::jit::Value* input) {
               [&](const std::vector<VarHandle>& axes) {
                 ExprHandle idx = 0;
                 for (size_t i = 0; i < axes.size(); i++) {
-                  idx = idx + axes[i] * IntImm::make(*strides[i]);
+                  idx = idx + axes[i] * strides[i];
                 }
                 return inBuffer(idx);
               }));
       kernelArgs_.emplace_back(
-          inBuffer, std::vector<ShapeArg>(), std::vector<ShapeArg>());
-#endif
+          inBuffer, std::move(sizeArgs), std::move(strideArgs));
       break;
     }
     case TypeKind::FloatType: {
@@ -1485,6 +1904,28 @@ void TensorExprKernel::run(Stack& stack) {
   }
 }
 
+bool TensorExprKernel::checkSizes(
+    const std::map<const Expr*, int32_t>& varToSize) const {
+  auto sizeOf = [&varToSize](const Expr* e) -> c10::optional<int64_t> {
+    if (auto imm = dynamic_cast<const IntImm*>(e)) {
+      return imm->value();
+    }
+    auto it = varToSize.find(e);
+    if (it == varToSize.end()) {
+      return c10::nullopt;
+    }
+    return it->second;
+  };
+  for (auto const& check : sizeChecks_) {
+    auto a = sizeOf(check.first);
+    auto b = sizeOf(check.second);
+    if (!a || !b || *a != *b) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void TensorExprKernel::runKernel(Stack& stack) {
   KernelScope kernelScope(&kernelArena_);
   // Set up arguments (inputs, then outputs) for kernel call.
@@ -1515,6 +1956,12 @@ void TensorExprKernel::runKernel(Stack& stack) {
     }
   }
 
+  if (!checkSizes(varToSize)) {
+    ++num_shape_mismatches;
+    fallback(stack);
+    return;
+  }
+
   std::vector<at::Tensor> outputs;
   for (auto& o : tensorOutputs_) {
     std::vector<int64_t> tensorSize;
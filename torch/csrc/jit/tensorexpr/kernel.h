@@ -13,8 +13,11 @@ template <typename T>
 inline std::vector<int64_t> bufferSizes(const T& t) {
   std::vector<int64_t> sizes;
   for (int i = 0; i < t->function()->ndim(); i++) {
-    sizes.push_back(
-        dynamic_cast<const IntImm*>(t->function()->dim(i))->value());
+    auto size = dynamic_cast<const IntImm*>(t->function()->dim(i));
+    if (!size) {
+      throw malformed_input(t->function()->dim(i));
+    }
+    sizes.push_back(size->value());
   }
   return sizes;
 }
@@ -152,6 +155,20 @@ class TensorExprKernel {
           const ExprHandle&,
           const ExprHandle&)>& innerExpr);
 
+  Tensor* computeReduction(
+      const std::string& name,
+      const torch::jit::Value* input,
+      const std::vector<size_t>& axes,
+      bool keepdim,
+      const Reducer& reducer,
+      const std::function<ExprHandle(const std::vector<ExprHandle>&)>& body);
+
+  Tensor* computeSum(const torch::jit::Value* v, bool mean);
+
+  Tensor* computeSoftmax(const torch::jit::Value* v, bool logSoftmax);
+
+  Tensor* computeLayerNorm(const torch::jit::Value* v);
+
   Tensor* computeValue(const torch::jit::Value* v);
 
   void lowerToBackend(BackendType backendType);
@@ -162,13 +179,9 @@ class TensorExprKernel {
 
   void bindInput(const torch::jit::Value* input);
 
-  ExprHandle createInputIndexExpr(
-      const Buffer& buffer,
-      const std::vector<VarHandle>& axes,
-      const c10::VaryingShape& sizes,
-      const c10::VaryingStrides& strides,
-      const c10::VaryingStrides& contiguity,
-      const std::unordered_map<int64_t, VarHandle>& sizeVars);
+  // Whether the sizes the kernel is called with broadcast the way it was
+  // compiled for.
+  bool checkSizes(const std::map<const Expr*, int32_t>& varToSize) const;
 
  private:
   struct ShapeArg {
@@ -208,6 +221,8 @@ class TensorExprKernel {
   int64_t nInputs_ = 0;
   std::vector<KernelArg> kernelArgs_;
   std::vector<Tensor*> tensorOutputs_;
+  std::vector<Tensor*> reductions_;
+  std::vector<std::pair<const Expr*, const Expr*>> sizeChecks_;
   std::unordered_map<int64_t, Tensor*> tensors_;
   std::unordered_map<int64_t, VarHandle> scalars_;
   std::unordered_map<size_t, std::unique_ptr<CodeGen>> codegenCache_;
@@ -225,6 +240,19 @@ class TensorExprKernel {
 TORCH_API int& getTECudaPointwiseLoopLevels();
 TORCH_API int& getTECudaPointwiseBlockCount();
 TORCH_API int& getTECudaPointwiseBlockSize();
+TORCH_API bool& getTECPUParallelLoops();
+
+// Counters for diagnosing recompilations of fusion groups. A kernel is
+// compiled once per fusion group and serves inputs of any size the types of
+// its inputs allow. Inputs whose sizes do not broadcast the way the kernel
+// assumes are shape mismatches and run in the interpreter instead.
+struct TEKernelStats {
+  uint64_t compilations = 0;
+  uint64_t shape_mismatches = 0;
+};
+
+TORCH_API TEKernelStats getTEKernelStats();
+TORCH_API void resetTEKernelStats();
 
 } // namespace tensorexpr
 } // namespace jit
@@ -3,6 +3,7 @@
 #include <torch/csrc/jit/tensorexpr/llvm_codegen.h>
 #include <torch/csrc/jit/tensorexpr/llvm_jit.h>
 
+#include <algorithm>
 #include <memory>
 
 #include <llvm/Analysis/TargetTransformInfo.h>
@@ -15,6 +16,7 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 
+#include <torch/csrc/jit/tensorexpr/analysis.h>
 #include <torch/csrc/jit/tensorexpr/buffer.h>
 #include <torch/csrc/jit/tensorexpr/execution_counter.h>
 #include <torch/csrc/jit/tensorexpr/ir.h>
@@ -42,6 +44,7 @@ class LLVMCodeGenImpl : public IRVisitor {
   llvm::BasicBlock* bb_;
   llvm::Value* value_;
   llvm::JITTargetAddress kernelAddress_;
+  std::string objectCode_;
 
 #define LLVM_TYPE_DECLARE(_1, Name) llvm::Type* Name##Ty_;
   AT_FORALL_SCALAR_TYPES_AND2(Bool, Half, LLVM_TYPE_DECLARE);
@@ -56,16 +59,22 @@ class LLVMCodeGenImpl : public IRVisitor {
   llvm::Type* dtypeToLLVMPtr(Dtype dtype);
   void emitWrapper(const std::vector<llvm::Type*>& params);
   void emitKernel(Stmt* stmt, const std::vector<llvm::Type*>& params);
+  std::string emitObjectCode();
+  void emitParallelFor(const For* v);
+  void addObjectCode(const std::string& objectCode);
 
  public:
   LLVMCodeGenImpl(
       Stmt* stmt,
       const std::vector<CodeGen::BufferArg>& args,
       at::Device device,
-      Dtype dtype);
+      Dtype dtype,
+      bool keepObjectCode);
+  explicit LLVMCodeGenImpl(const std::string& objectCode);
   ~LLVMCodeGenImpl() = default;
 
   llvm::JITTargetAddress getKernelAddress() const;
+  const std::string& getObjectCode() const;
 
   void visit(const Add* v) override;
   void visit(const Sub* v) override;
@@ -121,6 +130,18 @@ class LLVMCodeGenImpl : public IRVisitor {
 } // namespace jit
 } // namespace torch
 
+static std::vector<std::string> hostCPUFeatures() {
+  llvm::StringMap<bool> FeatureMap;
+  llvm::sys::getHostCPUFeatures(FeatureMap);
+  std::vector<std::string> features;
+  for (auto& Feature : FeatureMap) {
+    features.push_back((Feature.second ? "+" : "-") + Feature.first().str());
+  }
+  // StringMap iteration order is unspecified.
+  std::sort(features.begin(), features.end());
+  return features;
+}
+
 static llvm::orc::JITTargetMachineBuilder makeTargetMachineBuilder() {
 #if 0
   // FIXME: Switch to using detectHost() rather than setting up the JTMB manually
@@ -134,10 +155,8 @@ static llvm::orc::JITTargetMachineBuilder makeTargetMachineBuilder() {
   // Relocation model, code model and codegen opt level are kept to default
   // values.
   llvm::SubtargetFeatures SubtargetFeatures;
-  llvm::StringMap<bool> FeatureMap;
-  llvm::sys::getHostCPUFeatures(FeatureMap);
-  for (auto& Feature : FeatureMap) {
-    SubtargetFeatures.AddFeature(Feature.first(), Feature.second);
+  for (const auto& Feature : hostCPUFeatures()) {
+    SubtargetFeatures.AddFeature(Feature);
   }
 
   JTMB.setCodeGenOptLevel(llvm::CodeGenOpt::Default);
@@ -148,6 +167,15 @@ static llvm::orc::JITTargetMachineBuilder makeTargetMachineBuilder() {
 #endif
 }
 
+std::string llvmHostTarget() {
+  std::string target = llvm::sys::getProcessTriple() + ";" +
+      llvm::sys::getHostCPUName().str() + ";";
+  for (const auto& Feature : hostCPUFeatures()) {
+    target += Feature + ",";
+  }
+  return target;
+}
+
 LLVMCodeGen::~LLVMCodeGen() = default;
 
 LLVMCodeGen::LLVMCodeGen(Stmt* stmt)
@@ -157,9 +185,27 @@ LLVMCodeGen::LLVMCodeGen(
     Stmt* stmt,
     const std::vector<BufferArg>& args,
     at::Device device,
-    Dtype dtype)
+    Dtype dtype,
+    bool keepObjectCode)
     : CodeGen(stmt, args, device),
-      impl_(std::make_unique<LLVMCodeGenImpl>(stmt, args, device, dtype)) {}
+      impl_(std::make_unique<LLVMCodeGenImpl>(
+          stmt,
+          args,
+          device,
+          dtype,
+          keepObjectCode)) {}
+
+LLVMCodeGen::LLVMCodeGen(
+    const std::string& objectCode,
+    Stmt* stmt,
+    const std::vector<BufferArg>& args,
+    at::Device device)
+    : CodeGen(stmt, args, device),
+      impl_(std::make_unique<LLVMCodeGenImpl>(objectCode)) {}
+
+const std::string& LLVMCodeGen::getObjectCode() const {
+  return impl_->getObjectCode();
+}
 
 static void* argToPtr(
     const CodeGen::BufferArg& bufferArg,
@@ -206,11 +252,16 @@ llvm::JITTargetAddress LLVMCodeGenImpl::getKernelAddress() const {
   return kernelAddress_;
 }
 
+const std::string& LLVMCodeGenImpl::getObjectCode() const {
+  return objectCode_;
+}
+
 LLVMCodeGenImpl::LLVMCodeGenImpl(
     Stmt* stmt,
     const std::vector<CodeGen::BufferArg>& args,
     at::Device device,
-    Dtype dtype)
+    Dtype dtype,
+    bool keepObjectCode)
     : context_(std::make_unique<llvm::LLVMContext>()), irb_(getContext()) {
   // Manually map types to LLVM types.
   ByteTy_ = llvm::Type::getInt8Ty(getContext());
@@ -257,14 +308,60 @@ LLVMCodeGenImpl::LLVMCodeGenImpl(
   emitWrapper(params);
   emitKernel(stmt, params);
 
-  cantFail(jit_->addModule(
-      llvm::orc::ThreadSafeModule(std::move(module_), context_)));
-  auto sym = jit_->findSymbol("wrapper");
-  kernelAddress_ = cantFail(sym.getAddress());
+  if (keepObjectCode) {
+    // Link the emitted object rather than the module, so that the kernel runs
+    // the same code as a kernel later loaded from it.
+    objectCode_ = emitObjectCode();
+    addObjectCode(objectCode_);
+  } else {
+    cantFail(jit_->addModule(
+        llvm::orc::ThreadSafeModule(std::move(module_), context_)));
+    auto sym = jit_->findSymbol("wrapper");
+    kernelAddress_ = cantFail(sym.getAddress());
+  }
 
   USE_TRIGGER(llvm_codegen_created);
 }
 
+LLVMCodeGenImpl::LLVMCodeGenImpl(const std::string& objectCode)
+    : context_(std::make_unique<llvm::LLVMContext>()),
+      irb_(getContext()),
+      objectCode_(objectCode) {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  jit_ = std::make_unique<llvm::orc::PytorchLLVMJIT>();
+  addObjectCode(objectCode_);
+
+  USE_TRIGGER(llvm_codegen_created);
+}
+
+std::string LLVMCodeGenImpl::emitObjectCode() {
+  llvm::SmallVector<char, 0> objBuffer;
+  llvm::raw_svector_ostream objStream(objBuffer);
+  llvm::legacy::PassManager PM;
+  if (TM_->addPassesToEmitFile(
+          PM,
+          objStream,
+          nullptr,
+          llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile)) {
+    throw std::runtime_error("Target can not emit object files");
+  }
+  PM.run(*module_);
+  return std::string(objBuffer.begin(), objBuffer.end());
+}
+
+void LLVMCodeGenImpl::addObjectCode(const std::string& objectCode) {
+  auto err = jit_->addObjectFile(llvm::MemoryBuffer::getMemBufferCopy(
+      llvm::StringRef(objectCode.data(), objectCode.size()), "pytorch"));
+  if (err) {
+    throw std::runtime_error(
+        "Failed to link kernel object code: " + llvm::toString(std::move(err)));
+  }
+  auto sym = jit_->findSymbol("wrapper");
+  kernelAddress_ = cantFail(sym.getAddress());
+}
+
 llvm::LLVMContext& LLVMCodeGenImpl::getContext() {
   return *context_.getContext();
 }
@@ -898,6 +995,11 @@ void LLVMCodeGenImpl::visit(const Load* v) {
 }
 
 void LLVMCodeGenImpl::visit(const For* v) {
+  if (v->loop_options().is_parallel()) {
+    emitParallelFor(v);
+    return;
+  }
+
   // Create "start" and "stop" values.
   v->start()->accept(this);
   auto start = this->value_;
@@ -941,6 +1043,101 @@ void LLVMCodeGenImpl::visit(const For* v) {
   value_ = llvm::ConstantInt::get(IntTy_, 0);
 }
 
+// Outlines the body of a parallel loop into a function taking the loop index
+// and an array of pointers to the values the body uses from the enclosing
+// function, and calls it through nnc_parallel_for, which distributes the
+// iterations over the intra-op thread pool.
+void LLVMCodeGenImpl::emitParallelFor(const For* v) {
+  v->start()->accept(this);
+  auto start = this->value_;
+  v->stop()->accept(this);
+  auto stop = this->value_;
+
+  std::vector<const Var*> captured;
+  std::vector<llvm::Value*> capturedVals;
+  for (const Var* var : VarFinder(v->body()).vars()) {
+    if (varToArg_.count(var)) {
+      captured.push_back(var);
+      capturedVals.push_back(fn_->arg_begin() + varToArg_.at(var));
+    } else if (varToVal_.count(var) && var != v->var()) {
+      captured.push_back(var);
+      capturedVals.push_back(varToVal_.at(var));
+    }
+  }
+
+  // Pack the captured values. The stack slots go in the entry block so that
+  // a parallel loop nested in a serial loop does not grow the stack.
+  auto i8PtrTy = llvm::Type::getInt8PtrTy(getContext());
+  auto envTy = i8PtrTy->getPointerTo();
+  llvm::IRBuilder<> entryIrb(
+      &fn_->getEntryBlock(), fn_->getEntryBlock().getFirstInsertionPt());
+  auto env = entryIrb.CreateAlloca(
+      i8PtrTy, llvm::ConstantInt::getSigned(IntTy_, capturedVals.size()));
+  for (size_t i = 0; i < capturedVals.size(); i++) {
+    llvm::Value* val = capturedVals[i];
+    llvm::Value* slot = nullptr;
+    if (val->getType()->isPointerTy()) {
+      slot = irb_.CreatePointerCast(val, i8PtrTy);
+    } else {
+      auto valSlot = entryIrb.CreateAlloca(val->getType());
+      irb_.CreateStore(val, valSlot);
+      slot = irb_.CreatePointerCast(valSlot, i8PtrTy);
+    }
+    irb_.CreateStore(
+        slot, irb_.CreateGEP(env, llvm::ConstantInt::getSigned(IntTy_, i)));
+  }
+
+  auto bodyFn = llvm::Function::Create(
+      llvm::FunctionType::get(
+          llvm::Type::getVoidTy(getContext()), {IntTy_, envTy}, false),
+      llvm::Function::PrivateLinkage,
+      "parallel_body",
+      module_.get());
+
+  // Emit the body into bodyFn, where the captured values are loaded from the
+  // array.
+  auto savedIP = irb_.saveIP();
+  auto savedFn = fn_;
+  auto savedVarToArg = std::move(varToArg_);
+  auto savedVarToVal = std::move(varToVal_);
+  varToArg_.clear();
+  varToVal_.clear();
+  fn_ = bodyFn;
+  irb_.SetInsertPoint(llvm::BasicBlock::Create(getContext(), "entry", fn_));
+  auto index = fn_->arg_begin();
+  auto envArg = fn_->arg_begin() + 1;
+  for (size_t i = 0; i < captured.size(); i++) {
+    auto slot = irb_.CreateLoad(
+        irb_.CreateGEP(envArg, llvm::ConstantInt::getSigned(IntTy_, i)));
+    auto type = capturedVals[i]->getType();
+    if (type->isPointerTy()) {
+      varToVal_.emplace(captured[i], irb_.CreatePointerCast(slot, type));
+    } else {
+      varToVal_.emplace(
+          captured[i],
+          irb_.CreateLoad(irb_.CreatePointerCast(slot, type->getPointerTo())));
+    }
+  }
+  varToVal_.emplace(v->var(), index);
+  v->body()->accept(this);
+  irb_.CreateRetVoid();
+
+  fn_ = savedFn;
+  varToArg_ = std::move(savedVarToArg);
+  varToVal_ = std::move(savedVarToVal);
+  irb_.restoreIP(savedIP);
+
+  auto parallelFor = module_->getOrInsertFunction(
+      "nnc_parallel_for",
+      llvm::FunctionType::get(
+          llvm::Type::getVoidTy(getContext()),
+          {bodyFn->getType(), IntTy_, IntTy_, envTy},
+          false),
+      {});
+  irb_.CreateCall(parallelFor, {bodyFn, start, stop, env});
+  value_ = llvm::ConstantInt::get(IntTy_, 0);
+}
+
 void LLVMCodeGenImpl::visit(const Block* v) {
   for (Stmt* s : v->stmts()) {
     s->accept(this);
@@ -1448,12 +1645,45 @@ void LLVMCodeGenImpl::visit(const FunctionCall* v) {
   throw unimplemented_lowering(v);
 }
 
+// Intermediate buffers are allocated on the heap by nnc_aligned_alloc, which
+// returns memory that aliases nothing else in the kernel.
 void LLVMCodeGenImpl::visit(const Allocate* v) {
-  throw unimplemented_lowering(v);
+  llvm::Value* size =
+      llvm::ConstantInt::getSigned(LongTy_, v->dtype().byte_size());
+  for (const Expr* dim : v->dims()) {
+    dim->accept(this);
+    size = irb_.CreateMul(size, irb_.CreateIntCast(value_, LongTy_, true));
+  }
+
+  auto i8PtrTy = llvm::Type::getInt8PtrTy(getContext());
+  auto allocFn = module_->getOrInsertFunction(
+      "nnc_aligned_alloc",
+      llvm::FunctionType::get(i8PtrTy, {LongTy_}, false),
+      llvm::AttributeList().addAttribute(
+          getContext(),
+          llvm::AttributeList::ReturnIndex,
+          llvm::Attribute::NoAlias));
+  auto buffer = irb_.CreateCall(allocFn, {size});
+  varToVal_[v->buffer_var()] =
+      irb_.CreatePointerCast(buffer, dtypeToLLVMPtr(v->dtype()));
+  value_ = llvm::ConstantInt::get(IntTy_, 0);
 }
 
 void LLVMCodeGenImpl::visit(const Free* v) {
-  throw unimplemented_lowering(v);
+  auto it = varToVal_.find(v->buffer_var());
+  if (it == varToVal_.end()) {
+    throw malformed_input(v);
+  }
+
+  auto i8PtrTy = llvm::Type::getInt8PtrTy(getContext());
+  auto freeFn = module_->getOrInsertFunction(
+      "nnc_aligned_free",
+      llvm::FunctionType::get(
+          llvm::Type::getVoidTy(getContext()), {i8PtrTy}, false),
+      {});
+  irb_.CreateCall(freeFn, {irb_.CreatePointerCast(it->second, i8PtrTy)});
+  varToVal_.erase(it);
+  value_ = llvm::ConstantInt::get(IntTy_, 0);
 }
 
 void LLVMCodeGenImpl::visit(const Cond* v) {
@@ -7,6 +7,7 @@
 #include <torch/csrc/jit/tensorexpr/ir.h>
 #include <torch/csrc/jit/tensorexpr/ir_visitor.h>
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -22,14 +23,28 @@ class TORCH_API LLVMCodeGen : public CodeGen {
       Stmt* stmt,
       const std::vector<BufferArg>& args,
       at::Device device = at::kCPU,
-      Dtype dtype = kInt);
+      Dtype dtype = kInt,
+      bool keepObjectCode = false);
   explicit LLVMCodeGen(Stmt* stmt);
 
+  // Loads a kernel from the object code that an LLVMCodeGen constructed with
+  // keepObjectCode emitted for the same stmt and args, instead of compiling
+  // stmt again. Throws if the object code can not be linked.
+  LLVMCodeGen(
+      const std::string& objectCode,
+      Stmt* stmt,
+      const std::vector<BufferArg>& args,
+      at::Device device = at::kCPU);
+
   LLVMCodeGen() = delete;
   ~LLVMCodeGen() override;
 
   TORCH_API void call(const std::vector<CallArg>& args) override;
 
+  // The object code of the kernel, empty unless it was compiled with
+  // keepObjectCode or loaded from object code.
+  const std::string& getObjectCode() const;
+
   template <typename T>
   T value() {
     std::vector<void*> args;
@@ -49,6 +64,10 @@ class TORCH_API LLVMCodeGen : public CodeGen {
   std::unique_ptr<LLVMCodeGenImpl> impl_;
 };
 
+// Describes the target LLVMCodeGen compiles for: the host triple, CPU and CPU
+// features. Object code is only valid on a host with the same target.
+TORCH_API std::string llvmHostTarget();
+
 } // namespace tensorexpr
 } // namespace jit
 } // namespace torch
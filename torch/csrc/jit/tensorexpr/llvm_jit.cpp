@@ -2,6 +2,8 @@
 
 #include <torch/csrc/jit/tensorexpr/llvm_jit.h>
 
+#include <ATen/Parallel.h>
+#include <c10/core/CPUAllocator.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
 #include <sleef.h>
 #include <algorithm>
@@ -9,6 +11,29 @@
 #include <string>
 #include <vector>
 
+// Runs body(i, env) for every i in [start, stop) on the intra-op thread pool.
+// Parallel loops of LLVMCodeGen kernels are lowered to calls of this.
+static void nnc_parallel_for(
+    void (*body)(int32_t, void**),
+    int32_t start,
+    int32_t stop,
+    void** env) {
+  at::parallel_for(start, stop, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      body(static_cast<int32_t>(i), env);
+    }
+  });
+}
+
+// Allocate and free the intermediate buffers of LLVMCodeGen kernels.
+static void* nnc_aligned_alloc(int64_t nbytes) {
+  return c10::alloc_cpu(nbytes);
+}
+
+static void nnc_aligned_free(void* data) {
+  c10::free_cpu(data);
+}
+
 namespace llvm {
 namespace orc {
 
@@ -28,6 +53,16 @@ class TORCH_API PytorchLLVMJITImpl {
     // Handle platform-specific symbol mangling
     MangleAndInterner Mangle(LLJ->getExecutionSession(), LLJ->getDataLayout());
 
+    cantFail(LLJ->defineAbsolute(
+        *Mangle("nnc_parallel_for"),
+        {llvm::pointerToJITTargetAddress(&nnc_parallel_for), {}}));
+    cantFail(LLJ->defineAbsolute(
+        *Mangle("nnc_aligned_alloc"),
+        {llvm::pointerToJITTargetAddress(&nnc_aligned_alloc), {}}));
+    cantFail(LLJ->defineAbsolute(
+        *Mangle("nnc_aligned_free"),
+        {llvm::pointerToJITTargetAddress(&nnc_aligned_free), {}}));
+
     // Register implementations of intrinsics
     cantFail(LLJ->defineAbsolute(
         *Mangle("log10f"), {llvm::pointerToJITTargetAddress(&log10f), {}}));
@@ -425,6 +460,10 @@ class TORCH_API PytorchLLVMJITImpl {
     return Error::success();
   }
 
+  Error addObjectFile(std::unique_ptr<MemoryBuffer> Obj) {
+    return LLJ->addObjectFile(std::move(Obj));
+  }
+
   JITSymbol findSymbol(const std::string Name) {
     return cantFail(LLJ->lookup(Name));
   }
@@ -443,6 +482,10 @@ Error PytorchLLVMJIT::addModule(ThreadSafeModule M) {
   return impl_->addModule(std::move(M));
 }
 
+Error PytorchLLVMJIT::addObjectFile(std::unique_ptr<MemoryBuffer> Obj) {
+  return impl_->addObjectFile(std::move(Obj));
+}
+
 JITSymbol PytorchLLVMJIT::findSymbol(const std::string Name) {
   return impl_->findSymbol(std::move(Name));
 }
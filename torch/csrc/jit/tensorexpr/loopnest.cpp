@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <c10/util/Logging.h>
+#include <torch/csrc/jit/tensorexpr/analysis.h>
 #include <torch/csrc/jit/tensorexpr/eval.h>
 #include <torch/csrc/jit/tensorexpr/expr.h>
 #include <torch/csrc/jit/tensorexpr/ir.h>
@@ -206,6 +207,12 @@ class Vectorizer : public IRMutator {
   Stmt* mutate(const Store* v) override {
     const Var* base_handle = v->base_handle();
     std::vector<const Expr*> inputs = {v->index(), v->value(), v->mask()};
+    // All lanes would store to the same element, as in the loop over the
+    // reduction axis of a reduction.
+    if (v->index()->accept_mutator(this) == v->index() &&
+        v->value()->accept_mutator(this) != v->value()) {
+      throw std::runtime_error("Can't vectorize a loop-invariant Store!");
+    }
     return try_vectorize(v, inputs, [&]() {
       return Store::make(
           VarHandle(base_handle),
@@ -671,11 +678,19 @@ Stmt* LoopNest::lowerToStmt(Tensor* t) {
 
 void LoopNest::computeInline(Stmt* s) {
   // TODO: check if `s` is a body of a loop
-  inlined_functions_.insert(stmt_to_tensor_.at(s)->function());
+  Function* f = stmt_to_tensor_.at(s)->function();
+  if (f->is_reduction()) {
+    throw malformed_input("Cannot inline a reduction");
+  }
+  inlined_functions_.insert(f);
 }
 
 void LoopNest::computeInlineWithRandom(Stmt* s) {
-  inlined_random_functions_.insert(stmt_to_tensor_.at(s)->function());
+  Function* f = stmt_to_tensor_.at(s)->function();
+  if (f->is_reduction()) {
+    throw malformed_input("Cannot inline a reduction");
+  }
+  inlined_random_functions_.insert(f);
 }
 
 Stmt* LoopNest::insertAllocFree(Stmt* stmt) {
@@ -769,7 +784,8 @@ void LoopNest::splitWithTail(
       Substitute(Stmt::clone(f->body()), {{f->var(), combined_index1}});
 
   *inner = new For(i_inner, new IntImm(0), factor_expr, body_inner);
-  *outer = new For(i_outer, new IntImm(0), split_count, *inner);
+  *outer = new For(
+      i_outer, new IntImm(0), split_count, *inner, f->loop_options());
 
   // TODO: cleanup API for adding/removing statements
   p->replace_stmt(f, *outer);
@@ -843,7 +859,8 @@ void LoopNest::splitWithMask(For* f, int factor, For** outer, For** inner) {
   body_inner = Substitute(body_inner, {{f->var(), combined_index}});
 
   *inner = new For(i_inner, new IntImm(0), factor_expr, body_inner);
-  *outer = new For(i_outer, new IntImm(0), split_count, *inner);
+  *outer = new For(
+      i_outer, new IntImm(0), split_count, *inner, f->loop_options());
 
   // TODO: cleanup API for adding/removing statements
   p->replace_stmt(f, *outer);
@@ -851,6 +868,65 @@ void LoopNest::splitWithMask(For* f, int factor, For** outer, For** inner) {
   // TODO: record history of transformations
 }
 
+void LoopNest::reorderAxis(For* a, For* b) {
+  Block* p = dynamic_cast<Block*>(a->get_parent());
+  if (!p) {
+    throw malformed_input(a);
+  }
+  if (a->body()->nstmts() != 1 || a->body()->stmts().front() != b) {
+    throw malformed_input("reorderAxis needs perfectly nested loops");
+  }
+  if (VarFinder(b->start()).vars().count(a->var()) ||
+      VarFinder(b->stop()).vars().count(a->var())) {
+    throw malformed_input("reorderAxis needs loop bounds independent of a");
+  }
+
+  For* new_a = new For(
+      a->var(),
+      a->start(),
+      a->stop(),
+      Stmt::clone(b->body()),
+      a->loop_options());
+  For* new_b =
+      new For(b->var(), b->start(), b->stop(), new_a, b->loop_options());
+  p->replace_stmt(a, new_b);
+}
+
+static bool hasConstantTripCountMultipleOf(const For* f, int factor) {
+  const IntImm* start = dynamic_cast<const IntImm*>(f->start());
+  const IntImm* stop = dynamic_cast<const IntImm*>(f->stop());
+  return start && stop && (stop->value() - start->value()) % factor == 0;
+}
+
+void LoopNest::tile(
+    For* outer,
+    For* inner,
+    int outer_factor,
+    int inner_factor) {
+  if (outer->body()->nstmts() != 1 || outer->body()->stmts().front() != inner) {
+    throw malformed_input("tile needs perfectly nested loops");
+  }
+  if (!hasConstantTripCountMultipleOf(outer, outer_factor) ||
+      !hasConstantTripCountMultipleOf(inner, inner_factor)) {
+    throw malformed_input("tile factors must divide the loop trip counts");
+  }
+
+  For* outer_tiles;
+  For* outer_tile;
+  For* outer_tail;
+  splitWithTail(outer, outer_factor, &outer_tiles, &outer_tile, &outer_tail);
+  // Splitting cloned the body of outer, which now holds a copy of inner.
+  For* inner_copy = dynamic_cast<For*>(outer_tile->body()->stmts().front());
+  For* inner_tiles;
+  For* inner_tile;
+  For* inner_tail;
+  splitWithTail(
+      inner_copy, inner_factor, &inner_tiles, &inner_tile, &inner_tail);
+  // outer_tiles { outer_tile { inner_tiles { inner_tile } } } becomes
+  // outer_tiles { inner_tiles { outer_tile { inner_tile } } }.
+  reorderAxis(outer_tile, inner_tiles);
+}
+
 std::vector<For*> LoopNest::getLoopStmtsFor(Tensor* t) const {
   std::vector<For*> result;
   Stmt* cur_stmt = tensor_to_stmt_.at(t);
@@ -871,6 +947,10 @@ void LoopNest::setGPUThreadIndex(For* f, int thread_index) {
   f->set_gpu_thread_index(thread_index);
 }
 
+void LoopNest::setParallel(For* f) {
+  f->set_parallel();
+}
+
 Stmt* LoopNest::getLoopBodyFor(Tensor* t) const {
   return tensor_to_stmt_.at(t);
 }
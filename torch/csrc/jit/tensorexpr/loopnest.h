@@ -38,8 +38,19 @@ class TORCH_API LoopNest {
   void splitWithTail(For* f, int factor, For** outer, For** inner, For** tail);
   void splitWithMask(For* f, int factor, For** outer, For** inner);
 
+  // Interchanges loop a with loop b, which must be the only statement in the
+  // body of a and have bounds that do not depend on a.
+  void reorderAxis(For* a, For* b);
+
+  // Splits the perfectly nested loops outer and inner into tiles of
+  // outer_factor x inner_factor iterations, so the tile loops are the
+  // innermost ones. The factors must divide the constant trip counts of the
+  // loops.
+  void tile(For* outer, For* inner, int outer_factor, int inner_factor);
+
   void setGPUBlockIndex(For* f, int idx);
   void setGPUThreadIndex(For* f, int idx);
+  void setParallel(For* f);
 
  private:
   std::vector<Tensor*> findAllNeededTensors(
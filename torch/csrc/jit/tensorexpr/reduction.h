@@ -0,0 +1,115 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/tensorexpr/expr.h>
+#include <torch/csrc/jit/tensorexpr/ir.h>
+
+namespace torch {
+namespace jit {
+namespace tensorexpr {
+
+// A Reducer combines the values of a reduction into an accumulator, which
+// starts out as the initializer. The dtype of the initializer is the
+// accumulation type: values are cast to it before being combined, and the
+// reduced tensor holds values of that type.
+class TORCH_API Reducer {
+ public:
+  using Interaction =
+      std::function<ExprHandle(const ExprHandle&, const ExprHandle&)>;
+
+  Reducer(const ExprHandle& init, Interaction interaction)
+      : init_(init.node()), interaction_(std::move(interaction)) {}
+
+  const Expr* initializer() const {
+    return init_;
+  }
+
+  Dtype dtype() const {
+    return init_->dtype();
+  }
+
+  // Casts a value of the reduction to the accumulation type.
+  ExprHandle promote(const ExprHandle& value) const {
+    if (value.dtype() == dtype()) {
+      return value;
+    }
+    return Cast::make(dtype(), value);
+  }
+
+  ExprHandle operator()(const ExprHandle& accum, const ExprHandle& value)
+      const {
+    return interaction_(accum, promote(value));
+  }
+
+ private:
+  const Expr* init_;
+  Interaction interaction_;
+};
+
+class Sum : public Reducer {
+ public:
+  explicit Sum(Dtype dtype)
+      : Reducer(
+            getImmediateByType(dtype, 0),
+            [](const ExprHandle& a, const ExprHandle& b) { return a + b; }) {}
+};
+
+// The lowest and highest values of a dtype, infinite for floating point types.
+inline ExprHandle minimumValue(Dtype dtype) {
+  switch (dtype.scalar_type()) {
+#define TYPE_CASE(Type, Name)                             \
+  case ScalarType::Name:                                  \
+    return Name##Imm::make(                               \
+        std::numeric_limits<Type>::has_infinity           \
+            ? static_cast<Type>(                          \
+                  -std::numeric_limits<Type>::infinity()) \
+            : std::numeric_limits<Type>::lowest());
+    AT_FORALL_SCALAR_TYPES(TYPE_CASE);
+#undef TYPE_CASE
+    default:
+      throw unsupported_dtype();
+  }
+}
+
+inline ExprHandle maximumValue(Dtype dtype) {
+  switch (dtype.scalar_type()) {
+#define TYPE_CASE(Type, Name)                             \
+  case ScalarType::Name:                                  \
+    return Name##Imm::make(                               \
+        std::numeric_limits<Type>::has_infinity           \
+            ? std::numeric_limits<Type>::infinity()       \
+            : std::numeric_limits<Type>::max());
+    AT_FORALL_SCALAR_TYPES(TYPE_CASE);
+#undef TYPE_CASE
+    default:
+      throw unsupported_dtype();
+  }
+}
+
+// Maximum and Minimum propagate NaNs, as torch.max and torch.min do.
+class Maximum : public Reducer {
+ public:
+  explicit Maximum(Dtype dtype)
+      : Reducer(
+            minimumValue(dtype),
+            [](const ExprHandle& a, const ExprHandle& b) {
+              return Max::make(a, b, true);
+            }) {}
+};
+
+class Minimum : public Reducer {
+ public:
+  explicit Minimum(Dtype dtype)
+      : Reducer(
+            maximumValue(dtype),
+            [](const ExprHandle& a, const ExprHandle& b) {
+              return Min::make(a, b, true);
+            }) {}
+};
+
+} // namespace tensorexpr
+} // namespace jit
+} // namespace torch
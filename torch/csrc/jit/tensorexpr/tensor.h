@@ -108,6 +108,16 @@ TORCH_API Tensor* Compute(
     const std::vector<DimArg>& dim_args,
     const std::function<ExprHandle(const std::vector<VarHandle>&)>& body_func);
 
+// Reduces body_func over reduce_args with reducer, for every point of
+// dim_args. body_func takes the variables of dim_args followed by those of
+// reduce_args. The resulting tensor has the accumulation type of the reducer.
+TORCH_API Tensor* Reduce(
+    const std::string& func_name,
+    const std::vector<DimArg>& dim_args,
+    const Reducer& reducer,
+    const std::function<ExprHandle(const std::vector<VarHandle>&)>& body_func,
+    const std::vector<DimArg>& reduce_args);
+
 class FunctionCall : public CallNode<FunctionCall> {
  public:
   using BaseClass = CallNode<FunctionCall>;
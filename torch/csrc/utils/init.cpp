@@ -15,12 +15,26 @@ void initThroughputBenchmarkBindings(PyObject* module) {
       .def_readwrite(
           "num_calling_threads", &BenchmarkConfig::num_calling_threads)
       .def_readwrite("num_worker_threads", &BenchmarkConfig::num_worker_threads)
+      .def_readwrite(
+          "num_intra_op_threads", &BenchmarkConfig::num_intra_op_threads)
       .def_readwrite("num_warmup_iters", &BenchmarkConfig::num_warmup_iters)
-      .def_readwrite("num_iters", &BenchmarkConfig::num_iters);
+      .def_readwrite("num_iters", &BenchmarkConfig::num_iters)
+      .def_readwrite("profile_ops", &BenchmarkConfig::profile_ops);
+
+  py::class_<OpExecutionStats>(m, "OpExecutionStats")
+      .def_readonly("name", &OpExecutionStats::name)
+      .def_readonly("num_calls", &OpExecutionStats::num_calls)
+      .def_readonly("total_time_ms", &OpExecutionStats::total_time_ms)
+      .def_readonly("self_time_ms", &OpExecutionStats::self_time_ms);
 
   py::class_<BenchmarkExecutionStats>(m, "BenchmarkExecutionStats")
       .def_readonly("latency_avg_ms", &BenchmarkExecutionStats::latency_avg_ms)
-      .def_readonly("num_iters", &BenchmarkExecutionStats::num_iters);
+      .def_readonly("latency_p50_ms", &BenchmarkExecutionStats::latency_p50_ms)
+      .def_readonly("latency_p90_ms", &BenchmarkExecutionStats::latency_p90_ms)
+      .def_readonly("latency_p99_ms", &BenchmarkExecutionStats::latency_p99_ms)
+      .def_readonly("total_time_ms", &BenchmarkExecutionStats::total_time_ms)
+      .def_readonly("num_iters", &BenchmarkExecutionStats::num_iters)
+      .def_readonly("op_stats", &BenchmarkExecutionStats::op_stats);
 
   py::class_<ThroughputBenchmark>(m, "ThroughputBenchmark", py::dynamic_attr())
       .def(py::init<jit::Module>())
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <numeric>
 #include <random>
 #include <thread>
 
+#include <ATen/Parallel.h>
+
 #include <torch/csrc/utils/pybind.h>
 #include <torch/csrc/jit/python/pybind_utils.h>
 
@@ -15,8 +22,11 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     const BenchmarkConfig& config) const {
   CHECK(initialized_);
   TORCH_CHECK(
-      config.num_worker_threads == 1,
-      "Only parallelization by callers is supported");
+      config.num_calling_threads > 0,
+      "Expected a positive number of calling threads");
+  TORCH_CHECK(
+      config.num_worker_threads >= 0,
+      "Expected a non-negative number of worker threads");
 
   // We pre-generate inputs here for each of the threads. This allows us to
   // safely move inputs out for each of the threads independently and thus avoid
@@ -43,6 +53,76 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     }
   }
 
+  using Clock = std::chrono::high_resolution_clock;
+  using TimePoint = std::chrono::time_point<Clock>;
+  auto elapsed_ms = [](TimePoint start, TimePoint end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+               .count() /
+        1000.0 / 1000.0;
+  };
+  auto init_intra_op_threads = [&]() {
+    at::init_num_threads();
+    if (config.num_intra_op_threads > 0) {
+      at::set_num_threads(config.num_intra_op_threads);
+    }
+  };
+
+  // Requests issued by the calling threads, served by the worker threads.
+  // Inputs stay owned by the calling threads.
+  struct Request {
+    Input* input;
+    std::promise<void> served;
+  };
+  // queue and shutdown are only read or written with queue_m held. Workers
+  // wait on queue_cv for either to change; the queue is drained before they
+  // exit on shutdown.
+  std::mutex queue_m;
+  std::condition_variable queue_cv;
+  std::deque<Request*> queue;
+  bool shutdown{false};
+  std::vector<std::thread> workers;
+
+  for (auto worker_id = 0; worker_id < config.num_worker_threads;
+       ++worker_id) {
+    workers.emplace_back([&]() {
+      init_intra_op_threads();
+      while (true) {
+        Request* request;
+        {
+          std::unique_lock<std::mutex> lock(queue_m);
+          queue_cv.wait(lock, [&]() { return shutdown || !queue.empty(); });
+          if (queue.empty()) {
+            return;
+          }
+          request = queue.front();
+          queue.pop_front();
+        }
+        try {
+          runOnce(std::move(*request->input));
+          request->served.set_value();
+        } catch (...) {
+          request->served.set_exception(std::current_exception());
+        }
+      }
+    });
+  }
+
+  // Runs input on the calling thread, or on a worker thread if there are any
+  auto serve = [&](Input& input) {
+    if (workers.empty()) {
+      runOnce(std::move(input));
+      return;
+    }
+    Request request{&input, {}};
+    auto served = request.served.get_future();
+    {
+      std::lock_guard<std::mutex> lock(queue_m);
+      queue.push_back(&request);
+    }
+    queue_cv.notify_one();
+    served.get();
+  };
+
   std::mutex m;
   std::condition_variable worker_main_cv;
   std::condition_variable main_worker_cv;
@@ -52,16 +132,22 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
   bool start{false};
   std::atomic<int64_t> num_attempted_iters{0};
   std::vector<std::thread> callers;
+  std::vector<std::vector<float>> thread_latencies(config.num_calling_threads);
 
   for (auto thread_id = 0; thread_id < config.num_calling_threads;
        ++thread_id) {
     callers.emplace_back([&, thread_id]() {
+      if (workers.empty()) {
+        init_intra_op_threads();
+      }
       // We use conditional variable as a barrier to make sure each thread
       // performs required warmeup iterations before we start measuring
       for (auto j = 0; j < config.num_warmup_iters; ++j) {
-        runOnce(std::move(thread_inputs[thread_id][input_iters[thread_id]]));
+        serve(thread_inputs[thread_id][input_iters[thread_id]]);
         ++input_iters[thread_id];
       }
+      auto& latencies = thread_latencies[thread_id];
+      latencies.reserve(config.num_iters);
       {
         std::unique_lock<std::mutex> lock(m);
         ++initialized;
@@ -72,7 +158,9 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
       }
       LOG(INFO) << "Starting forward thread " << thread_id;
       while (num_attempted_iters.fetch_add(1) < config.num_iters) {
-        runOnce(std::move(thread_inputs[thread_id][input_iters[thread_id]]));
+        TimePoint request_start = Clock::now();
+        serve(thread_inputs[thread_id][input_iters[thread_id]]);
+        latencies.push_back(elapsed_ms(request_start, Clock::now()));
         ++input_iters[thread_id];
       }
 
@@ -87,15 +175,19 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     });
   }
 
-  using Clock = std::chrono::high_resolution_clock;
-  using TimePoint = std::chrono::time_point<Clock>;
   TimePoint start_time;
+  std::unique_ptr<OpStatsRecorder> op_stats_recorder;
 
   {
     std::unique_lock<std::mutex> lock(m);
     while (initialized != config.num_calling_threads) {
       worker_main_cv.wait(lock);
     }
+    // All calling threads wait for start and all workers wait for requests,
+    // so no op is running
+    if (config.profile_ops) {
+      op_stats_recorder = std::make_unique<OpStatsRecorder>();
+    }
     LOG(INFO) << "Starting threads";
     start = true;
     start_time = Clock::now();
@@ -107,24 +199,46 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     worker_main_cv.wait(
         lock, [&]() { return finished == config.num_calling_threads; });
   }
-  auto end_time = std::chrono::high_resolution_clock::now();
+  auto end_time = Clock::now();
   LOG(INFO) << "Finished benchmark";
 
   BenchmarkExecutionStats stats;
-  float total_time_ms = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                            end_time - start_time)
-                            .count() /
-      1000.0 / 1000.0;
-  // We use config.num_iters instead of num_attempted_iters as it is
-  // repsesatative of the real work done. Last attempted iteration on each
-  // calling threads doesn't represent the real work (i.e. running the model)
-  stats.latency_avg_ms =
-      total_time_ms * config.num_calling_threads / config.num_iters;
-  stats.num_iters = config.num_iters;
+  if (op_stats_recorder) {
+    stats.op_stats = op_stats_recorder->stats();
+    op_stats_recorder.reset();
+  }
 
   for (auto& t : callers) {
     t.join();
   }
+  {
+    std::lock_guard<std::mutex> lock(queue_m);
+    shutdown = true;
+  }
+  queue_cv.notify_all();
+  for (auto& t : workers) {
+    t.join();
+  }
+
+  // Exactly config.num_iters requests were served after the warmup, the last
+  // attempted iteration on each calling thread doesn't run the model
+  std::vector<float> latencies;
+  latencies.reserve(config.num_iters);
+  for (const auto& thread_latency : thread_latencies) {
+    latencies.insert(
+        latencies.end(), thread_latency.begin(), thread_latency.end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  if (!latencies.empty()) {
+    stats.latency_avg_ms =
+        std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+        latencies.size();
+    stats.latency_p50_ms = percentile(latencies, 50);
+    stats.latency_p90_ms = percentile(latencies, 90);
+    stats.latency_p99_ms = percentile(latencies, 99);
+  }
+  stats.total_time_ms = elapsed_ms(start_time, end_time);
+  stats.num_iters = config.num_iters;
   return stats;
 }
 
@@ -1,8 +1,15 @@
 #include <torch/csrc/utils/throughput_benchmark.h>
 
 #include <pybind11/pybind11.h>
+#include <torch/csrc/autograd/record_function.h>
 #include <torch/csrc/jit/python/pybind_utils.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
 namespace torch {
 namespace throughput_benchmark {
 
@@ -123,6 +130,104 @@ ScriptModuleInput cloneInput<ScriptModuleInput>(
   return input;
 }
 
+float percentile(const std::vector<float>& sorted, double p) {
+  size_t rank = std::ceil(p / 100 * sorted.size());
+  return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct OpFrame {
+  Clock::time_point start;
+  double children_ms;
+};
+
+struct ThreadOpTimes {
+  // Ops of this thread that have started and not ended yet, innermost last
+  std::vector<OpFrame> frames;
+  std::unordered_map<std::string, OpExecutionStats> ops;
+};
+
+namespace {
+std::atomic<uint64_t> next_recorder_id{1};
+} // namespace
+
+OpStatsRecorder::OpStatsRecorder() : id_(next_recorder_id++) {
+  using autograd::profiler::RecordFunction;
+  autograd::profiler::pushCallback(
+      [this](const RecordFunction&) {
+        threadTimes().frames.push_back({Clock::now(), 0});
+      },
+      [this](const RecordFunction& fn) {
+        ThreadOpTimes& times = threadTimes();
+        // Async ops may end on another thread than they started on, which
+        // has no frame for them
+        if (times.frames.empty()) {
+          return;
+        }
+        OpFrame frame = times.frames.back();
+        times.frames.pop_back();
+        double elapsed_ms =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - frame.start)
+                .count() /
+            1000.0 / 1000.0;
+        if (!times.frames.empty()) {
+          times.frames.back().children_ms += elapsed_ms;
+        }
+        OpExecutionStats& op = times.ops[fn.name().str()];
+        ++op.num_calls;
+        op.total_time_ms += elapsed_ms;
+        op.self_time_ms += elapsed_ms - frame.children_ms;
+      });
+}
+
+OpStatsRecorder::~OpStatsRecorder() {
+  autograd::profiler::popCallback();
+}
+
+ThreadOpTimes& OpStatsRecorder::threadTimes() {
+  // Threads outlive recorders, so remember which recorder the times of this
+  // thread belong to
+  thread_local uint64_t recorder_id = 0;
+  thread_local ThreadOpTimes* times = nullptr;
+  if (recorder_id != id_) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    threads_.push_back(std::make_unique<ThreadOpTimes>());
+    times = threads_.back().get();
+    recorder_id = id_;
+  }
+  return *times;
+}
+
+std::vector<OpExecutionStats> OpStatsRecorder::stats() const {
+  std::unordered_map<std::string, OpExecutionStats> ops;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& times : threads_) {
+      for (const auto& kv : times->ops) {
+        OpExecutionStats& op = ops[kv.first];
+        op.num_calls += kv.second.num_calls;
+        op.total_time_ms += kv.second.total_time_ms;
+        op.self_time_ms += kv.second.self_time_ms;
+      }
+    }
+  }
+  std::vector<OpExecutionStats> result;
+  result.reserve(ops.size());
+  for (auto& kv : ops) {
+    kv.second.name = kv.first;
+    result.push_back(std::move(kv.second));
+  }
+  std::sort(
+      result.begin(),
+      result.end(),
+      [](const OpExecutionStats& a, const OpExecutionStats& b) {
+        return a.self_time_ms > b.self_time_ms;
+      });
+  return result;
+}
+
 } // namespace detail
 
 } // namespace throughput_benchmark
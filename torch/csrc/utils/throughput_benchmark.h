@@ -6,21 +6,46 @@
 
 #include <torch/csrc/jit/python/pybind_utils.h>
 
-#include <vector>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace py = pybind11;
 
 namespace torch {
 namespace throughput_benchmark {
 
+/**
+ * Time spent in one op, which is anything recorded with RECORD_FUNCTION.
+ */
+struct OpExecutionStats {
+  std::string name;
+  int64_t num_calls{0};
+  // Time from the start to the end of the op, including the ops it calls.
+  double total_time_ms{0};
+  // Same as total_time_ms but excluding the ops it calls, so the self times of
+  // all the ops add up to the time spent in ops.
+  double self_time_ms{0};
+};
+
 /**
  * The struct is used to provide results of a benchmark to the caller
  * In the future all additional statics should be added here.
  */
 struct BenchmarkExecutionStats {
+  // Latencies are measured on the calling threads, from the moment a request
+  // is issued until it has been served, queueing included.
   float latency_avg_ms{-1};
+  float latency_p50_ms{-1};
+  float latency_p90_ms{-1};
+  float latency_p99_ms{-1};
+  // Wall time of the measured iterations, across all calling threads.
+  float total_time_ms{-1};
   int64_t num_iters{-1};
+  // Only collected with BenchmarkConfig::profile_ops, sorted by decreasing
+  // self time.
+  std::vector<OpExecutionStats> op_stats;
 };
 
 /**
@@ -35,13 +60,19 @@ struct BenchmarkExecutionStats {
 struct BenchmarkConfig {
  public:
   // Calling threads are those threads that are calling into a module in
-  // parallel.
+  // parallel. Each of them issues one request at a time and waits for it to
+  // be served before issuing the next one.
   int num_calling_threads{1};
-  // Worker threads are not supported yet. This is just an example that we plan
-  // to support some sort of multi-threaded forward calls. We may change this
-  // setting in the future to support different intra and inter op parallelizm
-  // which is not available in PyTorch yet
-  int num_worker_threads{1};
+  // Worker threads serve the requests of the calling threads, taking them
+  // from a queue shared by all workers, the way an inference server does.
+  // With 0 worker threads, calling threads run the module themselves.
+  int num_worker_threads{0};
+  // Number of intra-op threads of each thread that runs the module, see
+  // at::set_num_threads. 0 keeps the current setting. With the OpenMP backend
+  // every thread has its own setting. With the native backend there is a
+  // single intra-op pool, which can only be sized before parallel work has
+  // started.
+  int num_intra_op_threads{0};
   // Warmup iters are used to make sure we run a module a few times before
   // actually measuring things. This way we avoid cold caches and any other
   // similar problems
@@ -49,6 +80,9 @@ struct BenchmarkConfig {
   // Number of iterations the benchmark should run with. This number is separate
   // from the warmup iterations
   int64_t num_iters{100};
+  // Whether to measure the time spent in each op during the measured
+  // iterations. This adds some overhead to every op.
+  bool profile_ops{false};
 };
 
 namespace detail {
@@ -103,6 +137,35 @@ typedef at::IValue ScriptModuleOutput;
 template<class Input>
 Input cloneInput(const Input& input);
 
+// Nearest-rank percentile p of a non-empty sorted vector.
+float percentile(const std::vector<float>& sorted, double p);
+
+struct ThreadOpTimes;
+
+/**
+ * While alive, accumulates the time every thread spends in each op. The
+ * RecordFunction callbacks it uses can't be added or removed while ops run,
+ * so it must be created and destroyed while the threads running the module
+ * are idle.
+ */
+class C10_HIDDEN OpStatsRecorder {
+ public:
+  OpStatsRecorder();
+  ~OpStatsRecorder();
+
+  OpStatsRecorder(const OpStatsRecorder&) = delete;
+  OpStatsRecorder& operator=(const OpStatsRecorder&) = delete;
+
+  std::vector<OpExecutionStats> stats() const;
+
+ private:
+  ThreadOpTimes& threadTimes();
+
+  const uint64_t id_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadOpTimes>> threads_;
+};
+
 typedef BenchmarkHelper<
     ScriptModuleInput,
     at::IValue,
@@ -144,9 +207,9 @@ void ModuleBenchmark::addInput(py::args&& args, py::kwargs&& kwargs);
 /**
  * This class is a small c++ component responsible for executing a PyTorch
  * module under an inference server like load. It can emulate multiple calling
- * threads to a single module provided. In the future we plan to enhance this
- * component to support inter and intra-op parallelism as well as multiple
- * models running in a single process.
+ * threads to a single module provided, whose requests are either run by the
+ * calling threads themselves or served by a pool of worker threads, each with
+ * its own intra-op parallelism.
  *
  * For current available configurations refer to the BenchmkarConfig
  * documentation
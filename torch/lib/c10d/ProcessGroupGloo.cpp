@@ -17,6 +17,7 @@
 #include <gloo/gather.h>
 #include <gloo/reduce.h>
 #include <gloo/scatter.h>
+#include <gloo/types.h>
 
 #include <ATen/SparseTensorUtils.h>
 
@@ -388,7 +389,10 @@ void ProcessGroupGloo::RecvWork::abort() {
 }
 
 ProcessGroupGloo::Options::Options()
-    : timeout(std::chrono::milliseconds(10 * 1000)), threads(2) {}
+    : timeout(std::chrono::milliseconds(10 * 1000)),
+      threads(2),
+      ringAllreduceMinBytes(1 << 20),
+      ringSegmentBytes(1 << 18) {}
 
 namespace {
 
@@ -506,7 +510,9 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
-      collectiveCounter_(0) {
+      collectiveCounter_(0),
+      ringAllreduceMinBytes_(options.ringAllreduceMinBytes),
+      ringSegmentBytes_(options.ringSegmentBytes) {
   auto& devices = options.devices;
   if (devices.empty()) {
     throw std::runtime_error("No device(s) specified");
@@ -754,6 +760,246 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::broadcast(
 
 namespace {
 
+template <typename T>
+void setReduceFunction(ReduceFunc& fn, const ReduceOp op) {
+  fn = toFunction<T>(op);
+}
+
+// Reduces `input` into `output`, which must be contiguous; both have the same
+// type and size. Sums go through ATen, whose CPU kernels are vectorized
+// (Vec256) and split large tensors across the intra-op thread pool. Other
+// reductions, and sums of fp16 tensors, use the Gloo reduction functions on
+// raw pointers, so a non-contiguous `input` is reduced from a contiguous copy.
+void reduceInto(at::Tensor& output, const at::Tensor& input, ReduceOp op) {
+  TORCH_INTERNAL_ASSERT(output.is_contiguous());
+  if (op == ReduceOp::SUM && output.scalar_type() != at::kHalf) {
+    output.add_(input);
+    return;
+  }
+  const auto contiguousInput = input.contiguous();
+  ReduceFunc fn;
+  GENERATE_ALL_TYPES(output.scalar_type(), setReduceFunction, fn, op);
+  fn(output.data_ptr(),
+     output.data_ptr(),
+     contiguousInput.data_ptr(),
+     output.numel());
+}
+
+// Slot prefixes for the ring below, distinct from the ones of the Gloo
+// collectives and from the (zero) prefix of send/recv tags.
+constexpr uint8_t kRingReduceScatterSlotPrefix = 0x40;
+constexpr uint8_t kRingAllgatherSlotPrefix = 0x41;
+
+// Bandwidth-optimal ring collectives on a flat, contiguous CPU tensor that
+// is split into one chunk per rank. In every step of the ring, a rank sends
+// one chunk to its right neighbor and receives one from its left neighbor,
+// so that every rank sends and receives (size - 1) / size of the tensor per
+// phase, regardless of the number of ranks.
+//
+// Chunks are sent in segments of at most `segmentBytes`, and a segment is
+// passed on to the next step as soon as it has been received (and reduced),
+// so that the transfers of one segment overlap with those of the others and
+// with the local reductions.
+//
+// Segments between a pair of ranks are sent and received in the same order
+// on both ends and use a single slot per phase, so receives complete in the
+// order they are posted.
+class SegmentedRing {
+ public:
+  SegmentedRing(
+      const std::shared_ptr<gloo::Context>& context,
+      uint32_t tag,
+      at::Tensor& tensor,
+      std::vector<int64_t> chunkOffsets,
+      size_t segmentBytes)
+      : context_(context),
+        tag_(tag),
+        tensor_(tensor),
+        chunkOffsets_(std::move(chunkOffsets)),
+        rank_(context->rank),
+        size_(context->size),
+        elementSize_(tensor.element_size()) {
+    TORCH_INTERNAL_ASSERT(tensor_.is_contiguous() && tensor_.dim() == 1);
+    TORCH_INTERNAL_ASSERT(chunkOffsets_.size() == static_cast<size_t>(size_) + 1);
+    segmentLength_ =
+        std::max<int64_t>(1, segmentBytes / elementSize_);
+    int64_t maxChunkLength = 0;
+    for (int i = 0; i < size_; i++) {
+      maxChunkLength = std::max(maxChunkLength, chunkLength(i));
+    }
+    numSegments_ = (maxChunkLength + segmentLength_ - 1) / segmentLength_;
+  }
+
+  // Afterwards, chunk i of rank i holds the reduction of chunk i of all
+  // ranks. Other chunks hold partial reductions.
+  void reduceScatter(ReduceOp op) {
+    if (size_ == 1 || numSegments_ == 0) {
+      return;
+    }
+    const auto slot = gloo::Slot::build(kRingReduceScatterSlotPrefix, tag_);
+    auto scratch = at::empty({numSegments_ * segmentLength_}, tensor_.options());
+    auto buffer = context_->createUnboundBuffer(
+        tensor_.data_ptr(), tensor_.numel() * elementSize_);
+    auto scratchBuffer = context_->createUnboundBuffer(
+        scratch.data_ptr(), scratch.numel() * elementSize_);
+
+    // In step s, rank r sends chunk r - s - 1 and reduces chunk r - s - 2
+    // into its own, which it then sends in step s + 1. The chunk it ends
+    // up with, after size - 1 steps, is chunk r.
+    size_t sends = 0;
+    auto send = [&](int step, int64_t segment) {
+      const auto range = segmentRange(chunk(rank_ - step - 1), segment);
+      if (range.second > 0) {
+        buffer->send(
+            right(),
+            slot,
+            range.first * elementSize_,
+            range.second * elementSize_);
+        sends++;
+      }
+    };
+    auto recv = [&](int step, int64_t segment) {
+      const auto range = segmentRange(chunk(rank_ - step - 2), segment);
+      if (range.second > 0) {
+        scratchBuffer->recv(
+            left(),
+            slot,
+            segment * segmentLength_ * elementSize_,
+            range.second * elementSize_);
+      }
+    };
+
+    for (int64_t segment = 0; segment < numSegments_; segment++) {
+      recv(0, segment);
+      send(0, segment);
+    }
+    for (int step = 0; step < size_ - 1; step++) {
+      for (int64_t segment = 0; segment < numSegments_; segment++) {
+        // Chunks differ in length, so the segment received in this step may
+        // be empty while the one received in the next step is not.
+        const auto range = segmentRange(chunk(rank_ - step - 2), segment);
+        if (range.second > 0) {
+          scratchBuffer->waitRecv(context_->getTimeout());
+          auto output = tensor_.narrow(0, range.first, range.second);
+          reduceInto(
+              output,
+              scratch.narrow(0, segment * segmentLength_, range.second),
+              op);
+        }
+        if (step + 1 < size_ - 1) {
+          recv(step + 1, segment);
+          send(step + 1, segment);
+        }
+      }
+    }
+
+    // The allgather that may follow overwrites the chunks sent here.
+    for (size_t i = 0; i < sends; i++) {
+      buffer->waitSend(context_->getTimeout());
+    }
+  }
+
+  // Afterwards, chunk i of all ranks holds chunk i of rank i.
+  void allgather() {
+    if (size_ == 1 || numSegments_ == 0) {
+      return;
+    }
+    const auto slot = gloo::Slot::build(kRingAllgatherSlotPrefix, tag_);
+    auto buffer = context_->createUnboundBuffer(
+        tensor_.data_ptr(), tensor_.numel() * elementSize_);
+
+    // In step s, rank r sends chunk r - s and receives chunk r - s - 1,
+    // which it then sends in step s + 1.
+    size_t sends = 0;
+    auto send = [&](int step, int64_t segment) {
+      const auto range = segmentRange(chunk(rank_ - step), segment);
+      if (range.second > 0) {
+        buffer->send(
+            right(),
+            slot,
+            range.first * elementSize_,
+            range.second * elementSize_);
+        sends++;
+      }
+    };
+    auto recv = [&](int step, int64_t segment) {
+      const auto range = segmentRange(chunk(rank_ - step - 1), segment);
+      if (range.second > 0) {
+        buffer->recv(
+            left(),
+            slot,
+            range.first * elementSize_,
+            range.second * elementSize_);
+      }
+    };
+
+    for (int64_t segment = 0; segment < numSegments_; segment++) {
+      recv(0, segment);
+      send(0, segment);
+    }
+    for (int step = 0; step < size_ - 1; step++) {
+      for (int64_t segment = 0; segment < numSegments_; segment++) {
+        const auto range = segmentRange(chunk(rank_ - step - 1), segment);
+        if (range.second > 0) {
+          buffer->waitRecv(context_->getTimeout());
+        }
+        if (step + 1 < size_ - 1) {
+          recv(step + 1, segment);
+          send(step + 1, segment);
+        }
+      }
+    }
+    for (size_t i = 0; i < sends; i++) {
+      buffer->waitSend(context_->getTimeout());
+    }
+  }
+
+  // Splits `numel` elements into `size` chunks whose lengths differ by at
+  // most one.
+  static std::vector<int64_t> evenChunkOffsets(int64_t numel, int size) {
+    std::vector<int64_t> offsets(size + 1);
+    for (int i = 0; i <= size; i++) {
+      offsets[i] = numel * i / size;
+    }
+    return offsets;
+  }
+
+ private:
+  int chunk(int index) const {
+    return ((index % size_) + size_) % size_;
+  }
+
+  int left() const {
+    return chunk(rank_ - 1);
+  }
+
+  int right() const {
+    return chunk(rank_ + 1);
+  }
+
+  int64_t chunkLength(int chunk) const {
+    return chunkOffsets_[chunk + 1] - chunkOffsets_[chunk];
+  }
+
+  // Offset and length, in elements, of a segment of a chunk. The length is
+  // zero for segments past the end of a shorter chunk.
+  std::pair<int64_t, int64_t> segmentRange(int chunk, int64_t segment) const {
+    const auto begin = segment * segmentLength_;
+    const auto length = std::min(segmentLength_, chunkLength(chunk) - begin);
+    return {chunkOffsets_[chunk] + begin, std::max<int64_t>(0, length)};
+  }
+
+  std::shared_ptr<gloo::Context> context_;
+  const uint32_t tag_;
+  at::Tensor tensor_;
+  const std::vector<int64_t> chunkOffsets_;
+  const int rank_;
+  const int size_;
+  const int64_t elementSize_;
+  int64_t segmentLength_;
+  int64_t numSegments_;
+};
+
 class AsyncAllreduceWork : public ProcessGroupGloo::AsyncWork {
  public:
   AsyncAllreduceWork(
@@ -803,6 +1049,45 @@ class AsyncAllreduceWork : public ProcessGroupGloo::AsyncWork {
   }
 };
 
+// Allreduce of a large dense CPU tensor as a SegmentedRing reduce-scatter
+// followed by an allgather.
+class AsyncRingAllreduceWork : public AsyncAllreduceWork {
+ public:
+  AsyncRingAllreduceWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      size_t segmentBytes)
+      : AsyncAllreduceWork(context, inputs, reduceOp, tag),
+        segmentBytes(segmentBytes) {}
+
+  const size_t segmentBytes;
+
+  void run() override {
+    // The ring runs on a single tensor per process, so local tensors are
+    // reduced first.
+    auto& tensor = inputs[0];
+    for (size_t i = 1; i < inputs.size(); i++) {
+      reduceInto(tensor, inputs[i], reduceOp);
+    }
+
+    auto flat = tensor.view({-1});
+    SegmentedRing ring(
+        context,
+        tag,
+        flat,
+        SegmentedRing::evenChunkOffsets(flat.numel(), context->size),
+        segmentBytes);
+    ring.reduceScatter(reduceOp);
+    ring.allgather();
+
+    for (size_t i = 1; i < inputs.size(); i++) {
+      inputs[i].copy_(tensor);
+    }
+  }
+};
+
 class AsyncAllreduceCoalescedWork : public AsyncAllreduceWork {
  public:
   AsyncAllreduceCoalescedWork(
@@ -1267,7 +1552,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
   auto tag = nextTag();
   auto context = getContext(tag);
   if (device.type() == at::kCPU) {
-    if (layout == c10::kStrided) {
+    // The ring works in place on the memory of the first input. The other
+    // inputs are only read through reduceInto and written through copy_, so
+    // they may have any strides.
+    const auto bytes = inputs[0].numel() * inputs[0].element_size();
+    if (layout == c10::kStrided && size_ > 1 &&
+        bytes >= ringAllreduceMinBytes_ && inputs[0].is_contiguous()) {
+      work = std::make_shared<AsyncRingAllreduceWork>(
+          std::move(context), inputs, opts.reduceOp, tag, ringSegmentBytes_);
+    } else if (layout == c10::kStrided) {
       work = std::make_shared<AsyncAllreduceWork>(
           std::move(context), inputs, opts.reduceOp, tag);
     } else if (layout == c10::kSparse) {
@@ -1839,12 +2132,69 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather_coalesced(
   return work;
 }
 
+namespace {
+
+class AsyncAllgatherBaseWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncAllgatherBaseWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor& outputBuffer,
+      at::Tensor& inputBuffer,
+      uint32_t tag)
+      : context(context),
+        outputBuffer(outputBuffer),
+        inputBuffer(inputBuffer),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  at::Tensor outputBuffer;
+  at::Tensor inputBuffer;
+  const uint32_t tag;
+
+  void run() override {
+    // Gather straight into the output buffer, without the copies that
+    // allgather makes to flatten its output tensors.
+    const auto& scalarType = inputBuffer.scalar_type();
+    gloo::AllgatherOptions opts(context);
+    opts.setTag(tag);
+    GENERATE_ALL_TYPES(scalarType, setInput, opts, inputBuffer);
+    GENERATE_ALL_TYPES(scalarType, setOutput, opts, outputBuffer);
+    gloo::allgather(opts);
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather_base(
-    at::Tensor& /*unused */,
-    at::Tensor& /*unused */,
+    at::Tensor& outputBuffer,
+    at::Tensor& inputBuffer,
     const AllgatherOptions& /*unused */) {
-  throw std::runtime_error(
-      "no support for allgather_base in Gloo process group");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::allgather_base: " + msg);
+  };
+
+  assertDense(invalidArgument, {outputBuffer});
+  assertDense(invalidArgument, {inputBuffer});
+  assertCPU(invalidArgument, {outputBuffer});
+  assertCPU(invalidArgument, {inputBuffer});
+  if (!outputBuffer.options().type_equal(inputBuffer.options())) {
+    invalidArgument("output and input buffers must have the same type");
+  }
+  if (!outputBuffer.is_contiguous() || !inputBuffer.is_contiguous()) {
+    invalidArgument("output and input buffers must be contiguous");
+  }
+  if (outputBuffer.numel() != inputBuffer.numel() * getSize()) {
+    invalidArgument(
+        "output buffer must hold world size (" + std::to_string(getSize()) +
+        ") times the elements of the input buffer");
+  }
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncAllgatherBaseWork>(
+      std::move(context), outputBuffer, inputBuffer, tag);
+  enqueue(work);
+  return work;
 }
 
 namespace {
@@ -2237,11 +2587,84 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::scatter(
   return work;
 }
 
+namespace {
+
+class AsyncReduceScatterWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncReduceScatterWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      size_t segmentBytes)
+      : context(context),
+        outputs(outputs),
+        inputs(inputs),
+        reduceOp(reduceOp),
+        tag(tag),
+        segmentBytes(segmentBytes) {}
+
+  std::shared_ptr<gloo::Context> context;
+  std::vector<at::Tensor> outputs;
+  std::vector<std::vector<at::Tensor>> inputs;
+  const ReduceOp reduceOp;
+  const uint32_t tag;
+  const size_t segmentBytes;
+
+  void run() override {
+    // Chunk i of the ring is the input for rank i. The concatenation is
+    // always a copy, so the inputs are left untouched.
+    auto flat = at::cat(::c10d::fmap(inputs[0], [](const at::Tensor& t) {
+      return t.contiguous().view({-1});
+    }));
+    const auto numel = outputs[0].numel();
+    std::vector<int64_t> chunkOffsets(context->size + 1);
+    for (int i = 0; i <= context->size; i++) {
+      chunkOffsets[i] = numel * i;
+    }
+    SegmentedRing ring(
+        context, tag, flat, std::move(chunkOffsets), segmentBytes);
+    ring.reduceScatter(reduceOp);
+    outputs[0].copy_(
+        flat.narrow(0, numel * context->rank, numel).view(outputs[0].sizes()));
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce_scatter(
     std::vector<at::Tensor>& outputs,
     std::vector<std::vector<at::Tensor>>& inputs,
     const ReduceScatterOptions& opts) {
-  throw std::runtime_error("ProcessGroupGloo does not support reduce_scatter");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::reduce_scatter: " + msg);
+  };
+
+  assertSingleElementOutput(invalidArgument, outputs);
+  if (inputs.size() != 1) {
+    invalidArgument("requires a single-element input list");
+  }
+  if (inputs[0].size() != static_cast<size_t>(getSize())) {
+    invalidArgument(
+        "requires an input tensor for every rank (expected " +
+        std::to_string(getSize()) + ", got " +
+        std::to_string(inputs[0].size()) + ")");
+  }
+  assertDense(invalidArgument, outputs);
+  assertCPU(invalidArgument, outputs);
+  assertDense(invalidArgument, inputs[0]);
+  assertCPU(invalidArgument, inputs[0]);
+  assertTypeAndSizesMatch(
+      invalidArgument, inputs[0], outputs[0].options(), outputs[0].sizes());
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncReduceScatterWork>(
+      std::move(context), outputs, inputs, opts.reduceOp, tag,
+      ringSegmentBytes_);
+  enqueue(work);
+  return work;
 }
 
 at::Tensor& checkSingleTensor(std::vector<at::Tensor>& tensors) {
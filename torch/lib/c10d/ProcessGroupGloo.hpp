@@ -129,6 +129,14 @@ class ProcessGroupGloo : public ProcessGroup {
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Allreduces of dense CPU tensors of at least this many bytes run as a
+    // ring reduce-scatter followed by a ring allgather, sending segments of
+    // at most `ringSegmentBytes` at a time. Segments are passed on as soon
+    // as they arrive, overlapping the transfers with each other and with the
+    // local reductions. reduce_scatter always uses the ring.
+    size_t ringAllreduceMinBytes;
+    size_t ringSegmentBytes;
   };
 
   // Helper functions to create a new device object.
@@ -240,6 +248,10 @@ class ProcessGroupGloo : public ProcessGroup {
   // Returns next collective tag to use (uses collectiveCounter_).
   uint32_t nextTag();
 
+  // See Options.
+  const size_t ringAllreduceMinBytes_;
+  const size_t ringSegmentBytes_;
+
   // Returns the context to use for the specified tag.
   // With `nextTag` returning an increasing number, this should lead
   // to contexts being used in a round-robin fashion.
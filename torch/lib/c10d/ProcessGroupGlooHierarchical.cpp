@@ -0,0 +1,548 @@
+#include <c10d/ProcessGroupGlooHierarchical.hpp>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <system_error>
+
+#include <c10d/PrefixStore.hpp>
+#include <c10d/Utils.hpp>
+
+namespace c10d {
+
+namespace {
+
+constexpr size_t kCacheLineBytes = 64;
+
+// waitFor() yields this many times before it starts sleeping, which covers
+// the other processes on the host doing their share of a chunk.
+constexpr size_t kSpinIterations = 1024;
+
+// Longest sleep in waitFor(), bounding the latency it adds once the counter
+// is reached, e.g. while the leader allreduces across hosts.
+constexpr auto kMaxBackoff = std::chrono::microseconds(100);
+
+size_t alignUp(size_t value) {
+  return (value + kCacheLineBytes - 1) / kCacheLineBytes * kCacheLineBytes;
+}
+
+std::string getHostname() {
+  char hostname[HOST_NAME_MAX + 1] = {0};
+  SYSCHECK_ERR_RETURN_NEG1(gethostname(hostname, HOST_NAME_MAX));
+  return hostname;
+}
+
+std::vector<uint8_t> toBytes(const std::string& s) {
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+std::string fromBytes(const std::vector<uint8_t>& bytes) {
+  return std::string(bytes.begin(), bytes.end());
+}
+
+// Reductions that are run through shared memory.
+bool isSupportedOp(ReduceOp op) {
+  switch (op) {
+    case ReduceOp::SUM:
+    case ReduceOp::PRODUCT:
+    case ReduceOp::MIN:
+    case ReduceOp::MAX:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Reduces `input` into `output`, using the vectorized ATen kernels.
+void reduceInto(at::Tensor& output, const at::Tensor& input, ReduceOp op) {
+  switch (op) {
+    case ReduceOp::SUM:
+      output.add_(input);
+      break;
+    case ReduceOp::PRODUCT:
+      output.mul_(input);
+      break;
+    case ReduceOp::MIN:
+      at::min_out(output, output, input);
+      break;
+    case ReduceOp::MAX:
+      at::max_out(output, output, input);
+      break;
+    default:
+      TORCH_INTERNAL_ASSERT(false, "Unsupported reduce op");
+  }
+}
+
+class AsyncAllreduceWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  using Func = std::function<void(std::vector<at::Tensor>&)>;
+
+  AsyncAllreduceWork(std::vector<at::Tensor>& tensors, Func fn)
+      : tensors(tensors), fn(std::move(fn)) {}
+
+  std::vector<at::Tensor> tensors;
+  Func fn;
+
+  void run() override {
+    fn(tensors);
+  }
+};
+
+class AsyncBarrierWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  explicit AsyncBarrierWork(std::shared_ptr<ProcessGroup::Work> globalWork)
+      : globalWork(std::move(globalWork)) {}
+
+  std::shared_ptr<ProcessGroup::Work> globalWork;
+
+  void run() override {
+    // Hierarchical work issued before this barrier has completed, because it
+    // runs on the same thread. The barrier of the global process group
+    // covers everything else.
+    globalWork->wait();
+  }
+};
+
+} // namespace
+
+ProcessGroupGlooHierarchical::Options::Options()
+    : bufferBytes(4 * 1024 * 1024) {}
+
+ProcessGroupGlooHierarchical::SharedMemory::SharedMemory(
+    const std::string& name,
+    size_t size,
+    bool create)
+    : name_(name), size_(size), data_(nullptr), linked_(create) {
+  int fd;
+  if (create) {
+    SYSCHECK_ERR_RETURN_NEG1(
+        fd = shm_open(
+            name_.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR));
+    if (ftruncate(fd, size_) == -1) {
+      auto err = errno;
+      ::close(fd);
+      shm_unlink(name_.c_str());
+      throw std::system_error(err, std::system_category());
+    }
+  } else {
+    SYSCHECK_ERR_RETURN_NEG1(fd = shm_open(name_.c_str(), O_RDWR, 0));
+  }
+  data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto err = errno;
+  ::close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    if (create) {
+      unlink();
+    }
+    throw std::system_error(err, std::system_category());
+  }
+}
+
+ProcessGroupGlooHierarchical::SharedMemory::~SharedMemory() {
+  // Still linked if the process group failed to set up, e.g. because a
+  // process on this host never mapped the segment.
+  unlink();
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+void ProcessGroupGlooHierarchical::SharedMemory::unlink() {
+  if (linked_) {
+    shm_unlink(name_.c_str());
+    linked_ = false;
+  }
+}
+
+ProcessGroupGlooHierarchical::ProcessGroupGlooHierarchical(
+    const std::shared_ptr<Store>& store,
+    int rank,
+    int size,
+    Options options)
+    : ProcessGroup(rank, size),
+      store_(std::make_shared<PrefixStore>("hierarchical", store)),
+      bufferBytes_(alignUp(options.bufferBytes)),
+      timeout_(options.gloo.timeout),
+      localStates_(nullptr),
+      sharedState_(nullptr),
+      slots_(nullptr),
+      sequence_(0),
+      stop_(false) {
+  if (bufferBytes_ == 0) {
+    throw std::invalid_argument("bufferBytes must be positive");
+  }
+  if (options.host.empty()) {
+    options.host = getHostname();
+  }
+
+  // Find the other processes on this host. Hosts are numbered in the order
+  // of their lowest rank, which is their leader.
+  store_->set("host/" + std::to_string(rank), toBytes(options.host));
+  std::vector<std::string> hosts;
+  std::vector<int> localRanks;
+  for (int i = 0; i < size; i++) {
+    const auto host = fromBytes(store_->get("host/" + std::to_string(i)));
+    if (host == options.host) {
+      localRanks.push_back(i);
+    }
+    if (std::find(hosts.begin(), hosts.end(), host) == hosts.end()) {
+      hosts.push_back(host);
+    }
+  }
+  localSize_ = localRanks.size();
+  localRank_ =
+      std::find(localRanks.begin(), localRanks.end(), rank) -
+      localRanks.begin();
+  numHosts_ = hosts.size();
+  hostIndex_ =
+      std::find(hosts.begin(), hosts.end(), options.host) - hosts.begin();
+
+  global_ = std::make_shared<ProcessGroupGloo>(
+      std::make_shared<PrefixStore>("global", store_),
+      rank,
+      size,
+      options.gloo);
+  if (localRank_ == 0 && numHosts_ > 1) {
+    leaders_ = std::make_shared<ProcessGroupGloo>(
+        std::make_shared<PrefixStore>("leaders", store_),
+        hostIndex_,
+        numHosts_,
+        options.gloo);
+  }
+
+  if (localSize_ > 1) {
+    const auto stateBytes =
+        sizeof(SharedState) + localSize_ * sizeof(LocalState);
+    const auto segmentBytes = stateBytes + localSize_ * bufferBytes_;
+    const auto prefix = "shm/" + std::to_string(hostIndex_);
+
+    // The leader creates the segment and publishes its name. It is unlinked
+    // as soon as every process on the host has mapped it, so that it doesn't
+    // outlive the processes.
+    if (localRank_ == 0) {
+      static std::atomic<uint64_t> counter(0);
+      const auto name = "/torch_c10d_" + std::to_string(getpid()) + "_" +
+          std::to_string(counter++);
+      sharedMemory_ = std::unique_ptr<SharedMemory>(
+          new SharedMemory(name, segmentBytes, /* create */ true));
+      auto data = static_cast<uint8_t*>(sharedMemory_->data());
+      new (data) SharedState();
+      for (int i = 0; i < localSize_; i++) {
+        new (data + sizeof(SharedState) + i * sizeof(LocalState)) LocalState();
+      }
+      store_->set(prefix, toBytes(name));
+
+      std::vector<std::string> keys;
+      for (int i = 1; i < localSize_; i++) {
+        keys.push_back(prefix + "/mapped/" + std::to_string(i));
+      }
+      store_->wait(keys, timeout_);
+      sharedMemory_->unlink();
+    } else {
+      const auto name = fromBytes(store_->get(prefix));
+      sharedMemory_ = std::unique_ptr<SharedMemory>(
+          new SharedMemory(name, segmentBytes, /* create */ false));
+      store_->set(prefix + "/mapped/" + std::to_string(localRank_), {1});
+    }
+
+    auto data = static_cast<uint8_t*>(sharedMemory_->data());
+    sharedState_ = reinterpret_cast<SharedState*>(data);
+    localStates_ = reinterpret_cast<LocalState*>(data + sizeof(SharedState));
+    slots_ = data + stateBytes;
+  }
+
+  thread_ = std::thread(&ProcessGroupGlooHierarchical::runLoop, this);
+}
+
+ProcessGroupGlooHierarchical::~ProcessGroupGlooHierarchical() {
+  std::unique_lock<std::mutex> lock(workMutex_);
+  workConsumeCV_.wait(lock, [&] { return workQueue_.empty(); });
+
+  // Queue is empty, signal stop
+  stop_ = true;
+
+  // Release lock to allow the thread to terminate
+  lock.unlock();
+
+  workProduceCV_.notify_all();
+  thread_.join();
+}
+
+void ProcessGroupGlooHierarchical::runLoop() {
+  std::unique_lock<std::mutex> lock(workMutex_);
+
+  while (!stop_) {
+    if (workQueue_.empty()) {
+      workProduceCV_.wait(lock);
+      continue;
+    }
+
+    auto work = std::move(workQueue_.front());
+    workQueue_.pop_front();
+    lock.unlock();
+
+    // Notify after releasing the lock so that the waiter
+    // does not immediately block.
+    workConsumeCV_.notify_one();
+
+    AsyncWork::execute(std::move(work));
+    lock.lock();
+  }
+}
+
+void ProcessGroupGlooHierarchical::enqueue(std::shared_ptr<AsyncWork> work) {
+  std::unique_lock<std::mutex> lock(workMutex_);
+  workQueue_.push_back(std::move(work));
+  lock.unlock();
+
+  // Notify after releasing the lock so that the waiter
+  // does not immediately block.
+  workProduceCV_.notify_one();
+}
+
+at::Tensor ProcessGroupGlooHierarchical::slot(
+    int localRank,
+    at::ScalarType type) const {
+  const auto elementSize = c10::elementSize(type);
+  return at::from_blob(
+      slots_ + localRank * bufferBytes_,
+      {static_cast<int64_t>(bufferBytes_ / elementSize)},
+      at::TensorOptions().dtype(type));
+}
+
+void ProcessGroupGlooHierarchical::waitFor(
+    const std::atomic<uint64_t>& counter,
+    uint64_t sequence) const {
+  const auto deadline = std::chrono::steady_clock::now() + timeout_;
+  auto backoff = std::chrono::microseconds(1);
+  for (size_t i = 0; counter.load(std::memory_order_acquire) < sequence; i++) {
+    if (i < kSpinIterations) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw std::runtime_error(
+          "Timed out waiting for the other processes on this host");
+    }
+    std::this_thread::sleep_for(backoff);
+    backoff = std::min(backoff * 2, kMaxBackoff);
+  }
+}
+
+// The processes on a host go through the following steps for every chunk,
+// numbered by the sequence number of the chunk:
+//
+// 1. Copy the chunk into their slot, and mark it as arrived.
+// 2. Once all have arrived, reduce their slice of the chunk from all slots
+//    into the slot of the leader, and mark it as reduced.
+// 3. The leader waits for all slices to be reduced, allreduces its slot with
+//    the other leaders, and marks the chunk as done.
+// 4. Copy the result out of the slot of the leader, and mark it as consumed.
+//
+// A process can only start on the next chunk once the leader marked the
+// previous one as done, at which point no process reads its slot anymore.
+// The leader also waits for the previous chunk to be consumed by everyone
+// before overwriting its slot.
+void ProcessGroupGlooHierarchical::allreduceChunk(
+    at::Tensor& chunk,
+    const AllreduceOptions& opts) {
+  const auto sequence = ++sequence_;
+  const auto type = chunk.scalar_type();
+  const auto numel = chunk.numel();
+
+  if (localRank_ == 0) {
+    for (int i = 0; i < localSize_; i++) {
+      waitFor(localStates_[i].consumed, sequence - 1);
+    }
+  }
+  slot(localRank_, type).narrow(0, 0, numel).copy_(chunk);
+  localStates_[localRank_].arrived.store(sequence, std::memory_order_release);
+
+  for (int i = 0; i < localSize_; i++) {
+    waitFor(localStates_[i].arrived, sequence);
+  }
+  const auto begin = numel * localRank_ / localSize_;
+  const auto end = numel * (localRank_ + 1) / localSize_;
+  if (end > begin) {
+    auto output = slot(0, type).narrow(0, begin, end - begin);
+    for (int i = 1; i < localSize_; i++) {
+      reduceInto(
+          output, slot(i, type).narrow(0, begin, end - begin), opts.reduceOp);
+    }
+  }
+  localStates_[localRank_].reduced.store(sequence, std::memory_order_release);
+
+  if (localRank_ == 0) {
+    for (int i = 0; i < localSize_; i++) {
+      waitFor(localStates_[i].reduced, sequence);
+    }
+    if (leaders_) {
+      std::vector<at::Tensor> tensors = {slot(0, type).narrow(0, 0, numel)};
+      leaders_->allreduce(tensors, opts)->wait();
+    }
+    sharedState_->done.store(sequence, std::memory_order_release);
+  } else {
+    // The leader may be busy with other hosts for a while.
+    waitFor(sharedState_->done, sequence);
+  }
+
+  chunk.copy_(slot(0, type).narrow(0, 0, numel));
+  localStates_[localRank_].consumed.store(sequence, std::memory_order_release);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::broadcast(
+    std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) {
+  return global_->broadcast(tensors, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument(
+        "ProcessGroupGlooHierarchical::allreduce: " + msg);
+  };
+
+  assertNonEmpty(invalidArgument, tensors);
+  assertLayoutMatch(invalidArgument, tensors);
+  assertTypeAndSizesMatch(invalidArgument, tensors);
+
+  const auto& first = tensors[0];
+  const bool hierarchical = first.device().is_cpu() &&
+      first.layout() == c10::kStrided && first.scalar_type() != at::kHalf &&
+      isSupportedOp(opts.reduceOp) &&
+      std::all_of(tensors.begin(), tensors.end(), [](const at::Tensor& t) {
+        return t.device().is_cpu() && t.is_contiguous();
+      });
+  if (!hierarchical) {
+    return global_->allreduce(tensors, opts);
+  }
+
+  auto work = std::make_shared<AsyncAllreduceWork>(
+      tensors, [this, opts](std::vector<at::Tensor>& tensors) {
+        // Reduce the local tensors first, so that a single tensor per
+        // process goes through shared memory.
+        auto& tensor = tensors[0];
+        for (size_t i = 1; i < tensors.size(); i++) {
+          reduceInto(tensor, tensors[i], opts.reduceOp);
+        }
+
+        auto flat = tensor.view({-1});
+        if (localSize_ == 1) {
+          if (leaders_) {
+            std::vector<at::Tensor> inputs = {flat};
+            leaders_->allreduce(inputs, opts)->wait();
+          }
+        } else {
+          const auto chunkNumel =
+              static_cast<int64_t>(bufferBytes_ / flat.element_size());
+          for (int64_t offset = 0; offset < flat.numel();
+               offset += chunkNumel) {
+            auto chunk = flat.narrow(
+                0, offset, std::min(chunkNumel, flat.numel() - offset));
+            allreduceChunk(chunk, opts);
+          }
+        }
+
+        for (size_t i = 1; i < tensors.size(); i++) {
+          tensors[i].copy_(tensor);
+        }
+      });
+  enqueue(work);
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::
+    allreduce_coalesced(
+        std::vector<at::Tensor>& tensors,
+        const AllreduceCoalescedOptions& opts) {
+  return global_->allreduce_coalesced(tensors, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::reduce(
+    std::vector<at::Tensor>& tensors,
+    const ReduceOptions& opts) {
+  return global_->reduce(tensors, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::allgather(
+    std::vector<std::vector<at::Tensor>>& outputs,
+    std::vector<at::Tensor>& inputs,
+    const AllgatherOptions& opts) {
+  return global_->allgather(outputs, inputs, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::
+    allgather_base(
+        at::Tensor& outputBuffer,
+        at::Tensor& inputBuffer,
+        const AllgatherOptions& opts) {
+  return global_->allgather_base(outputBuffer, inputBuffer, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::
+    allgather_coalesced(
+        std::vector<std::vector<at::Tensor>>& outputTensorLists,
+        std::vector<at::Tensor>& inputTensors,
+        const AllgatherOptions& opts) {
+  return global_->allgather_coalesced(outputTensorLists, inputTensors, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::gather(
+    std::vector<std::vector<at::Tensor>>& outputs,
+    std::vector<at::Tensor>& inputs,
+    const GatherOptions& opts) {
+  return global_->gather(outputs, inputs, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::scatter(
+    std::vector<at::Tensor>& outputs,
+    std::vector<std::vector<at::Tensor>>& inputs,
+    const ScatterOptions& opts) {
+  return global_->scatter(outputs, inputs, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::
+    reduce_scatter(
+        std::vector<at::Tensor>& outputs,
+        std::vector<std::vector<at::Tensor>>& inputs,
+        const ReduceScatterOptions& opts) {
+  return global_->reduce_scatter(outputs, inputs, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::send(
+    std::vector<at::Tensor>& tensors,
+    int dstRank,
+    int tag) {
+  return global_->send(tensors, dstRank, tag);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::recv(
+    std::vector<at::Tensor>& tensors,
+    int srcRank,
+    int tag) {
+  return global_->recv(tensors, srcRank, tag);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::
+    recvAnysource(std::vector<at::Tensor>& tensors, int tag) {
+  return global_->recvAnysource(tensors, tag);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGlooHierarchical::barrier(
+    const BarrierOptions& opts) {
+  auto work = std::make_shared<AsyncBarrierWork>(global_->barrier(opts));
+  enqueue(work);
+  return work;
+}
+
+} // namespace c10d
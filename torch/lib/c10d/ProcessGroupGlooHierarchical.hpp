@@ -0,0 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <c10d/ProcessGroup.hpp>
+#include <c10d/ProcessGroupGloo.hpp>
+#include <c10d/Store.hpp>
+#include <c10d/Types.hpp>
+
+namespace c10d {
+
+// ProcessGroupGlooHierarchical runs allreduces in two levels, for jobs that
+// run many processes per host.
+//
+// Processes on the same host reduce their tensors through a POSIX shared
+// memory segment, every process reducing a slice of it. One process per host
+// (the leader, the lowest rank on the host) then allreduces the result with
+// the leaders of the other hosts over a ProcessGroupGloo, and the processes
+// on the host copy the result out of the shared memory. Compared to a flat
+// Gloo allreduce, data between local processes is not sent over loopback and
+// only one process per host talks to the network.
+//
+// Processes are grouped by the `host` option, which defaults to the hostname.
+// Setting it explicitly simulates multiple hosts on a single machine.
+//
+// Allreduces of dense, contiguous CPU tensors are hierarchical. All other
+// operations, as well as allreduces of other tensors and of the bitwise
+// reduce ops, are run by a flat ProcessGroupGloo over all processes.
+//
+// As with ProcessGroupGloo, all functions must be called in the same order
+// across processes. An error during a hierarchical allreduce leaves the
+// shared memory in an unknown state, after which the process group must not
+// be used anymore.
+//
+class ProcessGroupGlooHierarchical : public ProcessGroup {
+ public:
+  struct Options {
+    explicit Options();
+
+    // Options of the underlying Gloo process groups. The timeout also
+    // bounds how long a process waits for the other processes on its host.
+    ProcessGroupGloo::Options gloo;
+
+    // Processes with the same host share memory. Defaults to the hostname.
+    std::string host;
+
+    // Size of the shared memory for every process on a host. Larger tensors
+    // are reduced in chunks of this size.
+    size_t bufferBytes;
+  };
+
+  explicit ProcessGroupGlooHierarchical(
+      const std::shared_ptr<Store>& store,
+      int rank,
+      int size,
+      Options options = Options());
+
+  virtual ~ProcessGroupGlooHierarchical();
+
+  // Number of processes on this host, and the index of this process among
+  // them.
+  int getLocalSize() const {
+    return localSize_;
+  }
+
+  int getLocalRank() const {
+    return localRank_;
+  }
+
+  // Number of distinct hosts, and the index of this host among them.
+  int getNumHosts() const {
+    return numHosts_;
+  }
+
+  int getHostIndex() const {
+    return hostIndex_;
+  }
+
+  std::shared_ptr<ProcessGroup::Work> broadcast(
+      std::vector<at::Tensor>& tensors,
+      const BroadcastOptions& opts = BroadcastOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts = AllreduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce_coalesced(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceCoalescedOptions& opts =
+          AllreduceCoalescedOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce(
+      std::vector<at::Tensor>& tensors,
+      const ReduceOptions& opts = ReduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather(
+      std::vector<std::vector<at::Tensor>>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather_base(
+      at::Tensor& outputBuffer,
+      at::Tensor& inputBuffer,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather_coalesced(
+      std::vector<std::vector<at::Tensor>>& outputTensorLists,
+      std::vector<at::Tensor>& inputTensors,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> gather(
+      std::vector<std::vector<at::Tensor>>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const GatherOptions& opts = GatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> scatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      const ScatterOptions& opts = ScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce_scatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> send(
+      std::vector<at::Tensor>& tensors,
+      int dstRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recvAnysource(
+      std::vector<at::Tensor>& tensors,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> barrier(
+      const BarrierOptions& opts = BarrierOptions()) override;
+
+  // The synchronization state of the processes on a host, at the start of
+  // the shared memory. Every process advances its own counters to the
+  // sequence number of the chunk it is working on.
+  struct alignas(64) LocalState {
+    // Copied its chunk into its slot.
+    std::atomic<uint64_t> arrived{0};
+    // Reduced its slice of the chunk into the slot of the leader.
+    std::atomic<uint64_t> reduced{0};
+    // Copied the result out of the slot of the leader.
+    std::atomic<uint64_t> consumed{0};
+  };
+
+  struct alignas(64) SharedState {
+    // Set by the leader once the chunk has been reduced across hosts.
+    std::atomic<uint64_t> done{0};
+  };
+
+  // Shared memory segment, mapped for the lifetime of the process group.
+  class SharedMemory {
+   public:
+    SharedMemory(const std::string& name, size_t size, bool create);
+    ~SharedMemory();
+
+    // Removes the name, once all processes have mapped the segment. Only the
+    // process that created the segment removes it; the destructor does so
+    // if it hasn't been removed yet.
+    void unlink();
+
+    void* data() const {
+      return data_;
+    }
+
+   protected:
+    std::string name_;
+    size_t size_;
+    void* data_;
+    bool linked_;
+  };
+
+ protected:
+  using AsyncWork = ProcessGroupGloo::AsyncWork;
+
+  // Reduces a chunk of at most `bufferBytes` across all processes. Runs on
+  // the worker thread.
+  void allreduceChunk(at::Tensor& chunk, const AllreduceOptions& opts);
+
+  // Returns the slot of the process with the given local rank, as a flat
+  // tensor of the given type.
+  at::Tensor slot(int localRank, at::ScalarType type) const;
+
+  // Waits until `counter` reaches `sequence`, up to the timeout. Yields at
+  // first, then sleeps with exponential backoff.
+  void waitFor(const std::atomic<uint64_t>& counter, uint64_t sequence) const;
+
+  // Entrypoint for the worker thread.
+  void runLoop();
+
+  // Queue work to run on the worker thread.
+  void enqueue(std::shared_ptr<AsyncWork> work);
+
+  std::shared_ptr<Store> store_;
+  const size_t bufferBytes_;
+  const std::chrono::milliseconds timeout_;
+
+  int localRank_;
+  int localSize_;
+  int hostIndex_;
+  int numHosts_;
+
+  // All processes.
+  std::shared_ptr<ProcessGroupGloo> global_;
+
+  // The leaders of all hosts. Only set on leaders, if there are multiple
+  // hosts.
+  std::shared_ptr<ProcessGroupGloo> leaders_;
+
+  // Only set if there are multiple processes on this host.
+  std::unique_ptr<SharedMemory> sharedMemory_;
+  LocalState* localStates_;
+  SharedState* sharedState_;
+  uint8_t* slots_;
+
+  // Sequence number of the last chunk reduced through shared memory.
+  uint64_t sequence_;
+
+  // Hierarchical work runs on a single thread, in the order it was issued,
+  // because the protocol in shared memory handles one chunk at a time.
+  std::thread thread_;
+  bool stop_;
+  std::deque<std::shared_ptr<AsyncWork>> workQueue_;
+  std::mutex workMutex_;
+  std::condition_variable workProduceCV_;
+  std::condition_variable workConsumeCV_;
+};
+
+} // namespace c10d
@@ -94,7 +94,8 @@ class CollectiveTest {
  public:
   static std::vector<CollectiveTest> initialize(
       const std::string& path,
-      int num) {
+      int num,
+      bool useRing = false) {
     std::vector<CollectiveTest> tests;
     for (auto i = 0; i < num; i++) {
       tests.push_back(CollectiveTest(path));
@@ -103,7 +104,9 @@ class CollectiveTest {
     std::vector<std::thread> threads;
     for (auto i = 0; i < num; i++) {
       threads.push_back(
-          std::thread([i, &tests] { tests[i].start(i, tests.size()); }));
+          std::thread([i, &tests, useRing] {
+            tests[i].start(i, tests.size(), useRing);
+          }));
     }
     for (auto& thread : threads) {
       thread.join();
@@ -123,7 +126,7 @@ class CollectiveTest {
     return *pg_;
   }
 
-  void start(int rank, int size) {
+  void start(int rank, int size, bool useRing = false) {
     auto store = std::make_shared<::c10d::FileStore>(path_, size);
 
     // Set a timeout that is small enough to make this test run fast, but also
@@ -133,6 +136,12 @@ class CollectiveTest {
     options.devices.push_back(
         ::c10d::ProcessGroupGloo::createDeviceForHostname("127.0.0.1"));
 
+    // Run every allreduce on the ring, in many small segments.
+    if (useRing) {
+      options.ringAllreduceMinBytes = 0;
+      options.ringSegmentBytes = 64;
+    }
+
     pg_ = std::unique_ptr<::c10d::ProcessGroupGloo>(
         new ::c10d::ProcessGroupGloo(store, rank, size, options));
   }
@@ -190,6 +199,100 @@ void testAllreduce(const std::string& path, const at::DeviceType b) {
   }
 }
 
+void testRingAllreduce(const std::string& path, at::IntArrayRef shape) {
+  const auto size = 3;
+  auto tests = CollectiveTest::initialize(path, size, /* useRing */ true);
+
+  // Two tensors per process.
+  std::vector<std::vector<at::Tensor>> inputs(size);
+  for (auto i = 0; i < size; i++) {
+    inputs[i] = std::vector<at::Tensor>(
+        {at::ones(shape) * i, at::ones(shape) * (2 * i)});
+  }
+
+  std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+  for (auto i = 0; i < size; i++) {
+    work[i] = tests[i].getProcessGroup().allreduce(inputs[i]);
+  }
+  for (auto i = 0; i < size; i++) {
+    work[i]->wait();
+  }
+
+  const auto expected = 3 * (size * (size - 1)) / 2;
+  for (auto i = 0; i < size; i++) {
+    for (auto& tensor : inputs[i]) {
+      auto data = tensor.data_ptr<float>();
+      for (auto j = 0; j < tensor.numel(); j++) {
+        EXPECT_EQ(data[j], expected);
+      }
+    }
+  }
+}
+
+void testReduceScatter(const std::string& path) {
+  const auto size = 3;
+  auto tests = CollectiveTest::initialize(path, size);
+
+  // Process i contributes i * size + j to the output of process j.
+  std::vector<std::vector<std::vector<at::Tensor>>> inputs(size);
+  std::vector<std::vector<at::Tensor>> outputs(size);
+  for (auto i = 0; i < size; i++) {
+    std::vector<at::Tensor> input;
+    for (auto j = 0; j < size; j++) {
+      input.push_back(at::ones({5, 7}) * (i * size + j));
+    }
+    inputs[i] = {input};
+    outputs[i] = {at::empty({5, 7})};
+  }
+
+  std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+  for (auto i = 0; i < size; i++) {
+    work[i] = tests[i].getProcessGroup().reduce_scatter(outputs[i], inputs[i]);
+  }
+  for (auto i = 0; i < size; i++) {
+    work[i]->wait();
+  }
+
+  for (auto i = 0; i < size; i++) {
+    const auto expected = size * (size * (size - 1)) / 2 + size * i;
+    auto& tensor = outputs[i][0];
+    auto data = tensor.data_ptr<float>();
+    for (auto j = 0; j < tensor.numel(); j++) {
+      EXPECT_EQ(data[j], expected);
+    }
+    // The inputs are left untouched.
+    EXPECT_EQ(inputs[i][0][0].data_ptr<float>()[0], i * size);
+  }
+}
+
+void testAllgatherBase(const std::string& path) {
+  const auto size = 3;
+  const auto numel = 4;
+  auto tests = CollectiveTest::initialize(path, size);
+
+  std::vector<at::Tensor> inputs(size);
+  std::vector<at::Tensor> outputs(size);
+  for (auto i = 0; i < size; i++) {
+    inputs[i] = at::ones({numel}) * i;
+    outputs[i] = at::empty({size * numel});
+  }
+
+  std::vector<std::shared_ptr<::c10d::ProcessGroup::Work>> work(size);
+  for (auto i = 0; i < size; i++) {
+    work[i] = tests[i].getProcessGroup().allgather_base(outputs[i], inputs[i]);
+  }
+  for (auto i = 0; i < size; i++) {
+    work[i]->wait();
+  }
+
+  for (auto i = 0; i < size; i++) {
+    auto data = outputs[i].data_ptr<float>();
+    for (auto j = 0; j < size * numel; j++) {
+      EXPECT_EQ(data[j], j / numel);
+    }
+  }
+}
+
 void testBroadcast(const std::string& path, const at::DeviceType b) {
   const auto size = 2;
   const auto stride = 2;
@@ -382,6 +485,38 @@ TEST(ProcessGroupGlooTest, testAllReduceCPU) {
   }
 }
 
+TEST(ProcessGroupGlooTest, testRingAllReduceCPU) {
+  {
+    TemporaryFile file;
+    // The number of elements is neither a multiple of the number of
+    // processes nor of the segment size.
+    testRingAllreduce(file.path, {10, 101});
+  }
+}
+
+TEST(ProcessGroupGlooTest, testRingAllReduceSegmentMultipleCPU) {
+  {
+    TemporaryFile file;
+    // Chunks of 32, 33 and 33 elements. The short chunk is exactly two
+    // segments of 16 floats, the others need a third, partial one.
+    testRingAllreduce(file.path, {98});
+  }
+}
+
+TEST(ProcessGroupGlooTest, testReduceScatterCPU) {
+  {
+    TemporaryFile file;
+    testReduceScatter(file.path);
+  }
+}
+
+TEST(ProcessGroupGlooTest, testAllgatherBaseCPU) {
+  {
+    TemporaryFile file;
+    testAllgatherBase(file.path);
+  }
+}
+
 TEST(ProcessGroupGlooTest, testBroadcastCPU) {
   {
     TemporaryFile file;
@@ -192,7 +192,10 @@ class DistributedDataParallel(Module):
                        multiple buckets so that gradient reduction of each
                        bucket can potentially overlap with backward computation.
                        :attr:`bucket_cap_mb` controls the bucket size in MegaBytes (MB)
-                       (default: 25)
+                       (default: 25). Buckets are initially assigned in the
+                       reverse order of the parameters, and are rebuilt once,
+                       after the first iteration, in the order in which their
+                       gradients were ready.
         find_unused_parameters (bool): Traverse the autograd graph of all tensors
                                        contained in the return value of the wrapped
                                        module's ``forward`` function.
@@ -437,10 +440,34 @@ class DistributedDataParallel(Module):
         finally:
             self.require_backward_grad_sync = old_require_backward_grad_sync
 
+    def register_comm_hook(self, hook):
+        r"""
+        Registers a communication hook, which takes over the reduction of
+        dense gradient buckets, e.g. to compress gradients before they are
+        communicated. Built-in hooks are
+        :class:`torch.distributed.FP16CompressHook`,
+        :class:`torch.distributed.TopKCompressHook` (with error feedback) and
+        :class:`torch.distributed.PowerSGDHook`. The last two only support
+        single device modules. A hook can only be registered once, before the
+        first backward pass, and is not kept when the module is pickled.
+
+        Example::
+
+            >>> ddp = torch.nn.DistributedDataParallel(model, pg)
+            >>> ddp.register_comm_hook(
+            ...     torch.distributed.PowerSGDHook(pg, matrix_approximation_rank=4))
+        """
+        self.reducer.register_comm_hook(hook)
+
     def forward(self, *inputs, **kwargs):
         if self.require_forward_param_sync:
             self._sync_params()
 
+        # The reducer records the order in which gradients are ready in the
+        # first iteration that reduces them; rebuild buckets to match it once.
+        if torch.is_grad_enabled() and self.require_backward_grad_sync:
+            self.reducer.rebuild_buckets([1024 * 1024, self.bucket_bytes_cap])
+
         if self.device_ids:
             inputs, kwargs = self.scatter(inputs, kwargs, self.device_ids)
             if len(self.device_ids) == 1:
@@ -1,4 +1,5 @@
 import concurrent.futures
+import os
 import sys
 import time
 import unittest
@@ -1486,6 +1487,61 @@ class RpcTest(RpcAgentTestFixture):
         # add a barrier to make sure SHUTDOWN message is not sent
         dist.barrier()
 
+    def _shared_memory_segments(self):
+        prefix = "torch_rpc_%d_" % os.getpid()
+        return [name for name in os.listdir("/dev/shm") if name.startswith(prefix)]
+
+    @dist_init
+    @requires_process_group_agent("PROCESS_GROUP rpc backend specific test, skip")
+    @unittest.skipIf(not sys.platform.startswith("linux"), "needs /dev/shm")
+    def test_process_group_shared_memory(self):
+        initialize_pg(self.init_method, self.rank, self.world_size)
+        # All workers run on this host, so tensors this large are passed
+        # through shared memory, both in the request and in the response.
+        a = torch.arange(400 * 1024, dtype=torch.float32)
+        b = torch.ones(400 * 1024)
+        self.assertGreaterEqual(a.numel() * a.element_size(), 1024 * 1024)
+        dst_rank = (self.rank + 1) % self.world_size
+        ret = rpc.rpc_sync(worker_name(dst_rank), my_tensor_function, args=(a, b))
+        self.assertEqual(ret, a + b)
+
+        # The receivers have mapped, and so unlinked, all our segments once
+        # everyone got their response.
+        dist.barrier()
+        info = rpc.api._get_current_rpc_agent().get_debug_info()
+        self.assertGreaterEqual(int(info["agent.shared_memory_buffers"]), 2)
+        self.assertEqual(int(info["agent.shared_memory_fallbacks"]), 0)
+        self.assertEqual([], self._shared_memory_segments())
+
+    @dist_init
+    @requires_process_group_agent("PROCESS_GROUP rpc backend specific test, skip")
+    @unittest.skipIf(not sys.platform.startswith("linux"), "needs /dev/shm")
+    def test_process_group_shared_memory_fallback(self):
+        initialize_pg(self.init_method, self.rank, self.world_size)
+        # Taking the names of the first segments of this process makes
+        # creating them fail, so the tensors are sent inline instead.
+        taken = []
+        for i in range(64):
+            path = "/dev/shm/torch_rpc_%d_%d" % (os.getpid(), i)
+            os.close(os.open(path, os.O_CREAT | os.O_EXCL | os.O_RDWR, 0o600))
+            taken.append(path)
+        try:
+            dist.barrier()
+            a = torch.arange(400 * 1024, dtype=torch.float32)
+            b = torch.ones(400 * 1024)
+            dst_rank = (self.rank + 1) % self.world_size
+            ret = rpc.rpc_sync(worker_name(dst_rank), my_tensor_function, args=(a, b))
+            self.assertEqual(ret, a + b)
+
+            dist.barrier()
+            info = rpc.api._get_current_rpc_agent().get_debug_info()
+            self.assertEqual(int(info["agent.shared_memory_buffers"]), 0)
+            self.assertGreaterEqual(int(info["agent.shared_memory_fallbacks"]), 2)
+        finally:
+            for path in taken:
+                os.unlink(path)
+        self.assertEqual([], self._shared_memory_segments())
+
     @dist_init(setup_rpc=False)
     @requires_process_group_agent("PROCESS_GROUP rpc backend specific test, skip")
     def test_local_shutdown(self):
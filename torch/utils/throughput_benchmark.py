@@ -33,10 +33,32 @@ class ExecutionStats(object):
     def latency_avg_ms(self):
         return self._c_stats.latency_avg_ms
 
+    @property
+    def latency_p50_ms(self):
+        return self._c_stats.latency_p50_ms
+
+    @property
+    def latency_p90_ms(self):
+        return self._c_stats.latency_p90_ms
+
+    @property
+    def latency_p99_ms(self):
+        return self._c_stats.latency_p99_ms
+
     @property
     def num_iters(self):
         return self._c_stats.num_iters
 
+    @property
+    def op_stats(self):
+        '''
+        Returns the time spent in each op, sorted by decreasing self time, if
+        the benchmark was run with profile_ops=True. Every entry has the fields
+        name, num_calls, total_time_ms (including the ops it calls) and
+        self_time_ms (excluding them).
+        '''
+        return self._c_stats.op_stats
+
     @property
     def iters_per_second(self):
         '''
@@ -46,17 +68,27 @@ class ExecutionStats(object):
 
     @property
     def total_time_seconds(self):
-        return self.num_iters * (
-            self.latency_avg_ms / 1000.0) / self.benchmark_config.num_calling_threads
+        return self._c_stats.total_time_ms / 1000.0
 
 
     def __str__(self):
-        return '\n'.join([
+        lines = [
             "Average latency per example: " + format_time(time_ms=self.latency_avg_ms),
+            "Latency percentiles: p50 {}, p90 {}, p99 {}".format(
+                format_time(time_ms=self.latency_p50_ms),
+                format_time(time_ms=self.latency_p90_ms),
+                format_time(time_ms=self.latency_p99_ms)),
             "Total number of iterations: {}".format(self.num_iters),
             "Total number of iterations per second (across all threads): {:.2f}".format(self.iters_per_second),
             "Total time: " + format_time(time_s=self.total_time_seconds)
-        ])
+        ]
+        if self.op_stats:
+            lines.append("Time per op (calls, self time, total time):")
+            for op in self.op_stats:
+                lines.append("  {}: {}, {}, {}".format(
+                    op.name, op.num_calls, format_time(time_ms=op.self_time_ms),
+                    format_time(time_ms=op.total_time_ms)))
+        return '\n'.join(lines)
 
 
 class ThroughputBenchmark(object):
@@ -64,9 +96,9 @@ class ThroughputBenchmark(object):
     This class is a wrapper around a c++ component throughput_benchmark::ThroughputBenchmark
     responsible for executing a PyTorch module (nn.Module or ScriptModule)
     under an inference server like load. It can emulate multiple calling threads
-    to a single module provided. In the future we plan to enhance this component
-    to support inter and intra-op parallelism as well as multiple models
-    running in a single process.
+    to a single module provided, whose requests are either run by the calling
+    threads themselves or served by a pool of worker threads, each with its own
+    intra-op parallelism.
 
     Please note that even though nn.Module is supported, it might incur an overhead
     from the need to hold GIL every time we execute Python code or pass around
@@ -117,9 +149,14 @@ class ThroughputBenchmark(object):
         '''
         self._benchmark.add_input(*args, **kwargs)
 
-    def benchmark(self, num_calling_threads=1, num_warmup_iters=10, num_iters=100):
+    def benchmark(self, num_calling_threads=1, num_warmup_iters=10, num_iters=100,
+                  num_worker_threads=0, num_intra_op_threads=0, profile_ops=False):
         '''
         Args:
+            num_calling_threads (int): Number of threads calling into the module in
+                parallel. Each of them issues one request at a time and waits for it
+                to be served before issuing the next one.
+
             num_warmup_iters (int): Warmup iters are used to make sure we run a module
                 a few times before actually measuring things. This way we avoid cold
                 caches and any other similar problems. This is the number of warmup
@@ -132,14 +169,49 @@ class ThroughputBenchmark(object):
                 iterations might be slightly larger. Which is reported as
                 stats.num_iters where stats is the result of this function
 
-        This function returns BenchmarkExecutionStats object which is defined via pybind11.
-        It currently has two fields:
+            num_worker_threads (int): Number of worker threads serving the requests
+                of the calling threads from a shared queue, the way an inference
+                server does. With 0, calling threads run the module themselves.
+
+            num_intra_op_threads (int): Number of intra-op threads of each thread
+                running the module, see torch.set_num_threads. 0 keeps the current
+                setting. Only the OpenMP backend supports a different setting per
+                thread, with the native backend the intra-op pool is shared and can
+                only be sized before any parallel work.
+
+            profile_ops (bool): Whether to measure the time spent in each op, which
+                adds some overhead to every op.
+
+        This function returns ExecutionStats object which wraps the
+        BenchmarkExecutionStats defined via pybind11. It has the fields:
             - num_iters - number of actual iterations the benchmark have made
-            - avg_latency_ms - average time it took to infer on one input example in milliseconds
+            - latency_avg_ms, latency_p50_ms, latency_p90_ms, latency_p99_ms -
+              latency of one input example in milliseconds, queueing included
+            - total_time_seconds and iters_per_second
+            - op_stats - time spent in each op, with profile_ops=True
         '''
         config = torch._C.BenchmarkConfig()
         config.num_calling_threads = num_calling_threads
         config.num_warmup_iters = num_warmup_iters
         config.num_iters = num_iters
+        config.num_worker_threads = num_worker_threads
+        config.num_intra_op_threads = num_intra_op_threads
+        config.profile_ops = profile_ops
         c_stats = self._benchmark.benchmark(config)
         return ExecutionStats(c_stats, config)
+
+    def benchmark_concurrency(self, concurrency_levels, **kwargs):
+        '''
+        Runs the benchmark once for each number of calling threads in
+        concurrency_levels, which gives throughput and latency as a function of
+        the load. The other arguments are passed to benchmark().
+
+        Returns a list of (num_calling_threads, ExecutionStats) pairs.
+
+        Example::
+
+            >>> for n, stats in bench.benchmark_concurrency([1, 2, 4, 8], num_worker_threads=4):
+                    print(n, stats.iters_per_second, stats.latency_p99_ms)
+        '''
+        return [(n, self.benchmark(num_calling_threads=n, **kwargs))
+                for n in concurrency_levels]